@@ -0,0 +1,187 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BenchmarkSuite_h
+#define TrenchBroom_BenchmarkSuite_h
+
+#include "Utility/String.h"
+
+#include <wx/stopwatch.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+namespace TrenchBroom {
+    class BenchmarkOptions {
+    public:
+        size_t iterations;
+        size_t brushCount;
+        size_t entityCount;
+        size_t rayCount;
+        size_t textureCount;
+        unsigned int seed;
+        
+        BenchmarkOptions() :
+        iterations(10),
+        brushCount(10000),
+        entityCount(1000),
+        rayCount(10000),
+        textureCount(256),
+        seed(1) {}
+    };
+    
+    class BenchmarkResult {
+    public:
+        String suite;
+        String name;
+        size_t iterations;
+        size_t items;
+        double min;  // microseconds
+        double mean; // microseconds
+        double max;  // microseconds
+        
+        BenchmarkResult(const String& i_suite, const String& i_name, size_t i_iterations, size_t i_items, double i_min, double i_mean, double i_max) :
+        suite(i_suite),
+        name(i_name),
+        iterations(i_iterations),
+        items(i_items),
+        min(i_min),
+        mean(i_mean),
+        max(i_max) {}
+    };
+    
+    class BenchmarkResults {
+    public:
+        typedef std::vector<BenchmarkResult> List;
+    private:
+        List m_results;
+    public:
+        inline void add(const BenchmarkResult& result) {
+            m_results.push_back(result);
+        }
+        
+        inline const List& results() const {
+            return m_results;
+        }
+        
+        void writeJson(const BenchmarkOptions& options, std::ostream& stream) const {
+            stream.setf(std::ios::fixed);
+            stream.precision(3);
+            stream << "{\n";
+            stream << "  \"options\": {\"iterations\": " << options.iterations << ", \"brushes\": " << options.brushCount << ", \"entities\": " << options.entityCount << ", \"rays\": " << options.rayCount << ", \"textures\": " << options.textureCount << ", \"seed\": " << options.seed << "},\n";
+            stream << "  \"results\": [";
+            for (size_t i = 0; i < m_results.size(); i++) {
+                const BenchmarkResult& result = m_results[i];
+                const double itemsPerSecond = result.mean > 0.0 ? static_cast<double>(result.items) / (result.mean / 1000000.0) : 0.0;
+                if (i > 0)
+                    stream << ",";
+                stream << "\n    {\"suite\": \"" << result.suite << "\", \"name\": \"" << result.name << "\", ";
+                stream << "\"iterations\": " << result.iterations << ", \"items\": " << result.items << ", ";
+                stream << "\"min_us\": " << result.min << ", \"mean_us\": " << result.mean << ", \"max_us\": " << result.max << ", ";
+                stream << "\"items_per_second\": " << itemsPerSecond << "}";
+            }
+            stream << "\n  ]\n}\n";
+        }
+    };
+    
+    /**
+     * Runs every registered benchmark case for the configured number of iterations. setup() and teardown() are
+     * called around each iteration and are not included in the measured time. A case reports the number of items it
+     * processed per iteration via setItems() so that the results contain the throughput.
+     */
+    template <class SubClass>
+    class BenchmarkSuite {
+    private:
+        typedef std::mem_fun_t<void, SubClass> BenchmarkCase;
+        
+        class BenchmarkEntry {
+        public:
+            String name;
+            BenchmarkCase benchmarkCase;
+            
+            BenchmarkEntry(const String& i_name, BenchmarkCase i_benchmarkCase) :
+            name(i_name),
+            benchmarkCase(i_benchmarkCase) {}
+        };
+        
+        typedef std::vector<BenchmarkEntry> BenchmarkEntryList;
+        
+        String m_name;
+        BenchmarkEntryList m_benchmarkCases;
+        size_t m_items;
+    protected:
+        const BenchmarkOptions& m_options;
+        
+        inline void registerBenchmarkCase(const String& name, void (SubClass::*f)()) {
+            m_benchmarkCases.push_back(BenchmarkEntry(name, std::mem_fun(f)));
+        }
+        
+        inline void setItems(size_t items) {
+            m_items = items;
+        }
+        
+        virtual void registerBenchmarkCases() {};
+        virtual void setup() {}
+        virtual void teardown() {}
+    public:
+        BenchmarkSuite(const String& name, const BenchmarkOptions& options) :
+        m_name(name),
+        m_items(0),
+        m_options(options) {}
+        
+        virtual ~BenchmarkSuite() {}
+        
+        inline void run(BenchmarkResults& results) {
+            registerBenchmarkCases();
+            
+            typename BenchmarkEntryList::iterator it, end;
+            for (it = m_benchmarkCases.begin(), end = m_benchmarkCases.end(); it != end; ++it) {
+                BenchmarkEntry& entry = *it;
+                const size_t iterations = std::max(m_options.iterations, static_cast<size_t>(1));
+                
+                double min = 0.0;
+                double max = 0.0;
+                double total = 0.0;
+                m_items = 0;
+                
+                for (size_t i = 0; i < iterations; i++) {
+                    setup();
+                    
+                    wxStopWatch watch;
+                    entry.benchmarkCase(static_cast<SubClass*>(this));
+                    const double time = watch.TimeInMicro().ToDouble();
+                    
+                    teardown();
+                    
+                    min = i == 0 ? time : std::min(min, time);
+                    max = std::max(max, time);
+                    total += time;
+                }
+                
+                const double mean = total / static_cast<double>(iterations);
+                results.add(BenchmarkResult(m_name, entry.name, iterations, m_items, min, mean, max));
+                std::cerr << m_name << "." << entry.name << ": " << mean / 1000.0 << "ms" << std::endl;
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_MapParserBenchmark_h
+#define TrenchBroom_MapParserBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "IO/MapParser.h"
+#include "Model/Map.h"
+#include "Utility/Console.h"
+
+namespace TrenchBroom {
+    namespace IO {
+        class MapParserBenchmark : public BenchmarkSuite<MapParserBenchmark> {
+        private:
+            SyntheticData m_data;
+            String m_mapText;
+            Utility::Console m_console;
+            Model::Map* m_map;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("parseMap", &MapParserBenchmark::benchmarkParseMap);
+            }
+            
+            void setup() {
+                m_map = new Model::Map(m_data.worldBounds(), false);
+            }
+            
+            void teardown() {
+                delete m_map;
+                m_map = NULL;
+            }
+        public:
+            MapParserBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<MapParserBenchmark>("MapParser", options),
+            m_data(options.seed),
+            m_map(NULL) {
+                m_mapText = m_data.createMapText(m_options.brushCount, m_options.entityCount);
+            }
+            
+            void benchmarkParseMap() {
+                MapParser parser(m_mapText, m_console);
+                parser.parseMap(*m_map, NULL);
+                setItems(m_mapText.size());
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_MapWriterBenchmark_h
+#define TrenchBroom_MapWriterBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "IO/MapWriter.h"
+#include "Model/Map.h"
+
+namespace TrenchBroom {
+    namespace IO {
+        class MapWriterBenchmark : public BenchmarkSuite<MapWriterBenchmark> {
+        private:
+            SyntheticData m_data;
+            Model::Map* m_map;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("writeToStream", &MapWriterBenchmark::benchmarkWriteToStream);
+            }
+        public:
+            MapWriterBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<MapWriterBenchmark>("MapWriter", options),
+            m_data(options.seed),
+            m_map(NULL) {
+                m_map = m_data.createMap(m_options.brushCount, m_options.entityCount);
+            }
+            
+            ~MapWriterBenchmark() {
+                delete m_map;
+                m_map = NULL;
+            }
+            
+            void benchmarkWriteToStream() {
+                StringStream stream;
+                MapWriter writer;
+                writer.writeToStream(*m_map, stream);
+                setItems(stream.str().size());
+            }
+        };
+    }
+}
+
+#endif
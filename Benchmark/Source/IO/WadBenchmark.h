@@ -0,0 +1,72 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_WadBenchmark_h
+#define TrenchBroom_WadBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "IO/FileManager.h"
+#include "IO/Wad.h"
+#include "Utility/List.h"
+
+#include <cstdio>
+#include <iostream>
+
+namespace TrenchBroom {
+    namespace IO {
+        class WadBenchmark : public BenchmarkSuite<WadBenchmark> {
+        private:
+            SyntheticData m_data;
+            String m_path;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("index", &WadBenchmark::benchmarkIndex);
+                registerBenchmarkCase("loadMips", &WadBenchmark::benchmarkLoadMips);
+            }
+        public:
+            WadBenchmark(const BenchmarkOptions& options, const String& directory) :
+            BenchmarkSuite<WadBenchmark>("Wad", options),
+            m_data(options.seed) {
+                FileManager fileManager;
+                m_path = fileManager.appendPath(directory, "benchmark.wad");
+                if (!m_data.writeWad(m_path, m_options.textureCount, 64))
+                    std::cerr << "Unable to write " << m_path << std::endl;
+            }
+            
+            ~WadBenchmark() {
+                std::remove(m_path.c_str());
+            }
+            
+            void benchmarkIndex() {
+                Wad wad(m_path);
+                setItems(m_options.textureCount);
+            }
+            
+            void benchmarkLoadMips() {
+                Wad wad(m_path);
+                Mip::List mips = wad.loadMips(1);
+                setItems(mips.size());
+                Utility::deleteAll(mips);
+            }
+        };
+    }
+}
+
+#endif
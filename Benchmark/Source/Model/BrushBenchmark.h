@@ -0,0 +1,145 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushBenchmark_h
+#define TrenchBroom_BrushBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Utility/List.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        class BrushBenchmark : public BenchmarkSuite<BrushBenchmark> {
+        private:
+            typedef std::vector<BBoxf> BoundsList;
+            
+            static const size_t DragBrushCount = 5000;
+            static const size_t DragSteps = 16;
+            
+            SyntheticData m_data;
+            BoundsList m_bounds;
+            BrushList m_brushes;
+            BrushList m_createdBrushes;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("createFromBounds", &BrushBenchmark::benchmarkCreateFromBounds);
+                registerBenchmarkCase("createFromTemplate", &BrushBenchmark::benchmarkCreateFromTemplate);
+                registerBenchmarkCase("moveVertices", &BrushBenchmark::benchmarkMoveVertices);
+                registerBenchmarkCase("dragBrushes", &BrushBenchmark::benchmarkDragBrushes);
+                registerBenchmarkCase("rebuildGeometry", &BrushBenchmark::benchmarkRebuildGeometry);
+            }
+            
+            void teardown() {
+                Utility::deleteAll(m_createdBrushes);
+            }
+        public:
+            BrushBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<BrushBenchmark>("Brush", options),
+            m_data(options.seed) {
+                const BBoxf contentBounds = m_data.contentBounds(m_options.brushCount);
+                m_bounds.reserve(m_options.brushCount);
+                for (size_t i = 0; i < m_options.brushCount; i++)
+                    m_bounds.push_back(m_data.randomBrushBounds(contentBounds));
+                m_brushes = m_data.createBrushes(m_options.brushCount);
+            }
+            
+            ~BrushBenchmark() {
+                Utility::deleteAll(m_brushes);
+            }
+            
+            void benchmarkCreateFromBounds() {
+                m_createdBrushes.reserve(m_bounds.size());
+                BoundsList::const_iterator it, end;
+                for (it = m_bounds.begin(), end = m_bounds.end(); it != end; ++it)
+                    m_createdBrushes.push_back(new Brush(m_data.worldBounds(), false, *it, NULL));
+                setItems(m_bounds.size());
+            }
+            
+            void benchmarkCreateFromTemplate() {
+                m_createdBrushes.reserve(m_brushes.size());
+                BrushList::const_iterator it, end;
+                for (it = m_brushes.begin(), end = m_brushes.end(); it != end; ++it)
+                    m_createdBrushes.push_back(new Brush(m_data.worldBounds(), false, **it));
+                setItems(m_brushes.size());
+            }
+            
+            /**
+             * Moves one vertex of every brush towards the brush center and back again, which exercises the convex hull
+             * update in BrushGeometry twice per brush.
+             */
+            void benchmarkMoveVertices() {
+                size_t moves = 0;
+                BrushList::const_iterator it, end;
+                for (it = m_brushes.begin(), end = m_brushes.end(); it != end; ++it) {
+                    Brush& brush = **it;
+                    const Vec3f position = brush.vertices().front()->position;
+                    const Vec3f delta = (brush.center() - position).normalized() * 4.0f;
+                    
+                    Vec3f::List positions;
+                    positions.push_back(position);
+                    BrushEdit edit;
+                    if (brush.prepareMoveVertices(positions, delta, edit)) {
+                        brush.commitEdit(edit);
+                        positions = edit.vertices;
+                        moves++;
+                        
+                        BrushEdit back;
+                        if (!positions.empty() && brush.prepareMoveVertices(positions, delta * -1.0f, back)) {
+                            brush.commitEdit(back);
+                            moves++;
+                        }
+                    }
+                }
+                setItems(moves);
+            }
+            
+            /**
+             * Drags up to 5000 brushes across the grid and back again like the move tool does, one grid step per
+             * transformation. Translations keep the brush geometry, so this should be much faster than rebuilding it.
+             */
+            void benchmarkDragBrushes() {
+                const size_t count = std::min(static_cast<size_t>(DragBrushCount), m_brushes.size());
+                const Mat4f forward = translationMatrix(Vec3f(16.0f, 0.0f, 0.0f));
+                const Mat4f backward = translationMatrix(Vec3f(-16.0f, 0.0f, 0.0f));
+                
+                for (size_t step = 0; step < 2 * DragSteps; step++) {
+                    const Mat4f& pointTransform = step < DragSteps ? forward : backward;
+                    for (size_t i = 0; i < count; i++)
+                        m_brushes[i]->transform(pointTransform, Mat4f::Identity, false, false);
+                }
+                setItems(2 * DragSteps * count);
+            }
+            
+            void benchmarkRebuildGeometry() {
+                const size_t count = std::min(static_cast<size_t>(DragBrushCount), m_brushes.size());
+                for (size_t i = 0; i < count; i++)
+                    m_brushes[i]->rebuildGeometry();
+                setItems(count);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_EditStateBenchmark_h
+#define TrenchBroom_EditStateBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "Model/Brush.h"
+#include "Model/EditStateManager.h"
+#include "Utility/List.h"
+
+namespace TrenchBroom {
+    namespace Model {
+        class EditStateBenchmark : public BenchmarkSuite<EditStateBenchmark> {
+        private:
+            static const size_t SelectionCount = 100000;
+            
+            SyntheticData m_data;
+            BrushList m_brushes;
+            BrushList m_firstHalf;
+            BrushList m_secondHalf;
+            EditStateManager* m_editStateManager;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("selectAll", &EditStateBenchmark::benchmarkSelectAll);
+                registerBenchmarkCase("deselectAll", &EditStateBenchmark::benchmarkDeselectAll);
+                registerBenchmarkCase("deselectEach", &EditStateBenchmark::benchmarkDeselectEach);
+                registerBenchmarkCase("hideUnselected", &EditStateBenchmark::benchmarkHideUnselected);
+                registerBenchmarkCase("replaceSelection", &EditStateBenchmark::benchmarkReplaceSelection);
+            }
+            
+            void setup() {
+                m_editStateManager = new EditStateManager();
+                m_editStateManager->setEditState(m_firstHalf, EditState::Selected);
+            }
+            
+            void teardown() {
+                m_editStateManager->deselectAll();
+                m_editStateManager->unhideAll();
+                m_editStateManager->unlockAll();
+                delete m_editStateManager;
+                m_editStateManager = NULL;
+            }
+        public:
+            EditStateBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<EditStateBenchmark>("EditState", options),
+            m_data(options.seed),
+            m_editStateManager(NULL) {
+                m_brushes = m_data.createBrushes(SelectionCount);
+                
+                const size_t half = m_brushes.size() / 2;
+                m_firstHalf.insert(m_firstHalf.end(), m_brushes.begin(), m_brushes.begin() + static_cast<BrushList::difference_type>(half));
+                m_secondHalf.insert(m_secondHalf.end(), m_brushes.begin() + static_cast<BrushList::difference_type>(half), m_brushes.end());
+            }
+            
+            ~EditStateBenchmark() {
+                Utility::deleteAll(m_brushes);
+            }
+            
+            void benchmarkSelectAll() {
+                m_editStateManager->setEditState(m_brushes, EditState::Selected);
+                setItems(m_brushes.size());
+            }
+            
+            void benchmarkDeselectAll() {
+                m_editStateManager->deselectAll();
+                setItems(m_firstHalf.size());
+            }
+            
+            void benchmarkDeselectEach() {
+                m_editStateManager->setEditState(m_brushes, EditState::Selected);
+                
+                // deselect in reverse order so that every brush is searched for at the end of the selection
+                BrushList brush(1);
+                BrushList::const_reverse_iterator it, end;
+                for (it = m_brushes.rbegin(), end = m_brushes.rend(); it != end; ++it) {
+                    brush[0] = *it;
+                    m_editStateManager->setEditState(brush, EditState::Default);
+                }
+                setItems(2 * m_brushes.size());
+            }
+            
+            void benchmarkHideUnselected() {
+                m_editStateManager->setEditState(m_secondHalf, EditState::Hidden);
+                setItems(m_secondHalf.size());
+            }
+            
+            void benchmarkReplaceSelection() {
+                m_editStateManager->setEditState(m_brushes, EditState::Selected, true);
+                m_editStateManager->setEditState(m_secondHalf, EditState::Selected, true);
+                setItems(m_brushes.size() + m_secondHalf.size());
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_FacePointBenchmark_h
+#define TrenchBroom_FacePointBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "Model/Brush.h"
+#include "Model/Entity.h"
+#include "Model/Map.h"
+
+#include <algorithm>
+
+namespace TrenchBroom {
+    namespace Model {
+        class FacePointBenchmark : public BenchmarkSuite<FacePointBenchmark> {
+        private:
+            static const size_t ConversionBrushCount = 20000;
+            static const size_t AngleCount = 8;
+            
+            SyntheticData m_data;
+            Map* m_map;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("convertToInteger", &FacePointBenchmark::benchmarkConvertToInteger);
+            }
+            
+            /**
+             * Creates a map whose brushes are rotated about the origin by one of a few angles, so that most face
+             * planes are not axis aligned. Brushes which share a bounds coordinate and an angle share a plane, like
+             * the pieces of a sloped floor.
+             */
+            void setup() {
+                const size_t count = std::min(static_cast<size_t>(ConversionBrushCount), m_options.brushCount);
+                m_map = m_data.createMap(count, 0);
+                
+                const BrushList& brushes = m_map->worldspawn()->brushes();
+                for (size_t i = 0; i < brushes.size(); i++) {
+                    const float angle = static_cast<float>(i % AngleCount + 1) * Math<float>::Pi / 36.0f;
+                    const Mat4f rotation = rotationMatrix(angle, Vec3f::PosZ) * rotationMatrix(angle / 2.0f, Vec3f::PosX);
+                    brushes[i]->transform(rotation, rotation, false, false);
+                }
+            }
+            
+            void teardown() {
+                delete m_map;
+                m_map = NULL;
+            }
+        public:
+            FacePointBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<FacePointBenchmark>("FacePoint", options),
+            m_data(options.seed),
+            m_map(NULL) {}
+            
+            void benchmarkConvertToInteger() {
+                size_t failedCount = 0;
+                m_map->setForceIntegerFacePoints(true, NULL, failedCount);
+                setItems(m_map->worldspawn()->brushes().size());
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_OctreeBenchmark_h
+#define TrenchBroom_OctreeBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "Model/Map.h"
+#include "Model/MapObject.h"
+#include "Model/Octree.h"
+
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        class OctreeBenchmark : public BenchmarkSuite<OctreeBenchmark> {
+        private:
+            typedef std::vector<Rayf> RayList;
+            
+            SyntheticData m_data;
+            Map* m_map;
+            Octree* m_octree;
+            Octree* m_loadedOctree;
+            RayList m_rays;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("loadMap", &OctreeBenchmark::benchmarkLoadMap);
+                registerBenchmarkCase("intersect", &OctreeBenchmark::benchmarkIntersect);
+            }
+            
+            void setup() {
+                m_octree = new Octree(*m_map);
+            }
+            
+            void teardown() {
+                delete m_octree;
+                m_octree = NULL;
+            }
+        public:
+            OctreeBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<OctreeBenchmark>("Octree", options),
+            m_data(options.seed),
+            m_map(NULL),
+            m_octree(NULL),
+            m_loadedOctree(NULL) {
+                m_map = m_data.createMap(m_options.brushCount, m_options.entityCount);
+                m_loadedOctree = new Octree(*m_map);
+                m_loadedOctree->loadMap();
+                
+                const BBoxf bounds = m_data.contentBounds(m_options.brushCount);
+                m_rays.reserve(m_options.rayCount);
+                for (size_t i = 0; i < m_options.rayCount; i++)
+                    m_rays.push_back(m_data.randomRay(bounds));
+            }
+            
+            ~OctreeBenchmark() {
+                delete m_loadedOctree;
+                m_loadedOctree = NULL;
+                delete m_map;
+                m_map = NULL;
+            }
+            
+            void benchmarkLoadMap() {
+                m_octree->loadMap();
+                setItems(m_options.brushCount + m_options.entityCount);
+            }
+            
+            void benchmarkIntersect() {
+                RayList::const_iterator it, end;
+                for (it = m_rays.begin(), end = m_rays.end(); it != end; ++it)
+                    m_loadedOctree->intersect(*it);
+                setItems(m_rays.size());
+            }
+        };
+    }
+}
+
+#endif
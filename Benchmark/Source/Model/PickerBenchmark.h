@@ -0,0 +1,85 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_PickerBenchmark_h
+#define TrenchBroom_PickerBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "Model/Map.h"
+#include "Model/Octree.h"
+#include "Model/Picker.h"
+
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        class PickerBenchmark : public BenchmarkSuite<PickerBenchmark> {
+        private:
+            typedef std::vector<Rayf> RayList;
+            
+            SyntheticData m_data;
+            Map* m_map;
+            Octree* m_octree;
+            Picker* m_picker;
+            RayList m_rays;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("pick", &PickerBenchmark::benchmarkPick);
+            }
+        public:
+            PickerBenchmark(const BenchmarkOptions& options) :
+            BenchmarkSuite<PickerBenchmark>("Picker", options),
+            m_data(options.seed),
+            m_map(NULL),
+            m_octree(NULL),
+            m_picker(NULL) {
+                m_map = m_data.createMap(m_options.brushCount, m_options.entityCount);
+                m_octree = new Octree(*m_map);
+                m_octree->loadMap();
+                m_picker = new Picker(*m_octree);
+                
+                const BBoxf bounds = m_data.contentBounds(m_options.brushCount);
+                m_rays.reserve(m_options.rayCount);
+                for (size_t i = 0; i < m_options.rayCount; i++)
+                    m_rays.push_back(m_data.randomRay(bounds));
+            }
+            
+            ~PickerBenchmark() {
+                delete m_picker;
+                m_picker = NULL;
+                delete m_octree;
+                m_octree = NULL;
+                delete m_map;
+                m_map = NULL;
+            }
+            
+            void benchmarkPick() {
+                RayList::const_iterator it, end;
+                for (it = m_rays.begin(), end = m_rays.end(); it != end; ++it) {
+                    PickResult* result = m_picker->pick(*it);
+                    delete result;
+                }
+                setItems(m_rays.size());
+            }
+        };
+    }
+}
+
+#endif
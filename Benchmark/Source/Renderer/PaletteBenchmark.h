@@ -0,0 +1,81 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_PaletteBenchmark_h
+#define TrenchBroom_PaletteBenchmark_h
+
+#include "BenchmarkSuite.h"
+#include "SyntheticData.h"
+#include "IO/FileManager.h"
+#include "Renderer/Palette.h"
+#include "Utility/Color.h"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class PaletteBenchmark : public BenchmarkSuite<PaletteBenchmark> {
+        private:
+            static const size_t TextureSize = 64;
+            
+            SyntheticData m_data;
+            String m_path;
+            Palette* m_palette;
+            std::vector<unsigned char> m_indexedImages;
+            std::vector<unsigned char> m_rgbImage;
+        protected:
+            void registerBenchmarkCases() {
+                registerBenchmarkCase("indexedToRgb", &PaletteBenchmark::benchmarkIndexedToRgb);
+            }
+        public:
+            PaletteBenchmark(const BenchmarkOptions& options, const String& directory) :
+            BenchmarkSuite<PaletteBenchmark>("Palette", options),
+            m_data(options.seed),
+            m_palette(NULL) {
+                IO::FileManager fileManager;
+                m_path = fileManager.appendPath(directory, "benchmark.lmp");
+                if (!m_data.writePalette(m_path))
+                    std::cerr << "Unable to write " << m_path << std::endl;
+                m_palette = new Palette(m_path);
+                
+                m_indexedImages.resize(m_options.textureCount * TextureSize * TextureSize);
+                for (size_t i = 0; i < m_indexedImages.size(); i++)
+                    m_indexedImages[i] = static_cast<unsigned char>(m_data.next() & 0xFF);
+                m_rgbImage.resize(3 * TextureSize * TextureSize);
+            }
+            
+            ~PaletteBenchmark() {
+                delete m_palette;
+                m_palette = NULL;
+                std::remove(m_path.c_str());
+            }
+            
+            void benchmarkIndexedToRgb() {
+                Color averageColor;
+                for (size_t i = 0; i < m_options.textureCount; i++)
+                    m_palette->indexedToRgb(&m_indexedImages[i * TextureSize * TextureSize], &m_rgbImage[0], TextureSize * TextureSize, averageColor);
+                setItems(m_options.textureCount * TextureSize * TextureSize);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_SyntheticData_h
+#define TrenchBroom_SyntheticData_h
+
+#include "IO/MapWriter.h"
+#include "Model/Brush.h"
+#include "Model/Entity.h"
+#include "Model/Map.h"
+#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifdef _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    /**
+     * Generates reproducible synthetic maps, rays and texture files for the benchmarks. A linear congruential generator
+     * is used instead of rand() so that the same seed yields the same data on every platform.
+     */
+    class SyntheticData {
+    private:
+        uint32_t m_state;
+        BBoxf m_worldBounds;
+        
+        inline static void writeInt(std::ostream& stream, int32_t value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(int32_t));
+        }
+    public:
+        SyntheticData(unsigned int seed) :
+        m_state(seed),
+        m_worldBounds(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f)) {}
+        
+        inline const BBoxf& worldBounds() const {
+            return m_worldBounds;
+        }
+        
+        inline uint32_t next() {
+            m_state = m_state * 1664525u + 1013904223u;
+            return m_state >> 8;
+        }
+        
+        inline float random(float min, float max) {
+            return min + (max - min) * static_cast<float>(next() & 0xFFFF) / static_cast<float>(0xFFFF);
+        }
+        
+        inline float randomOnGrid(float min, float max, float gridSize) {
+            return gridSize * std::floor(random(min, max) / gridSize);
+        }
+        
+        /**
+         * Returns the region that the generated objects are placed in. It grows with the number of brushes so that the
+         * density of the generated map stays roughly the same.
+         */
+        inline BBoxf contentBounds(size_t brushCount) const {
+            const float extent = std::min(8192.0f, 128.0f * std::ceil(std::pow(static_cast<float>(std::max(brushCount, static_cast<size_t>(1))), 1.0f / 3.0f)));
+            return BBoxf(Vec3f(-extent, -extent, -extent), Vec3f(extent, extent, extent));
+        }
+        
+        BBoxf randomBrushBounds(const BBoxf& contentBounds) {
+            Vec3f min, max;
+            for (size_t i = 0; i < 3; i++) {
+                const float size = randomOnGrid(16.0f, 256.0f, 16.0f) + 16.0f;
+                min[i] = randomOnGrid(contentBounds.min[i], contentBounds.max[i] - size, 16.0f);
+                max[i] = min[i] + size;
+            }
+            return BBoxf(min, max);
+        }
+        
+        Model::BrushList createBrushes(size_t brushCount) {
+            const BBoxf bounds = contentBounds(brushCount);
+            Model::BrushList brushes;
+            brushes.reserve(brushCount);
+            for (size_t i = 0; i < brushCount; i++)
+                brushes.push_back(new Model::Brush(m_worldBounds, false, randomBrushBounds(bounds), NULL));
+            return brushes;
+        }
+        
+        Model::Map* createMap(size_t brushCount, size_t entityCount) {
+            Model::Map* map = new Model::Map(m_worldBounds, false);
+            
+            Model::Entity* worldspawn = new Model::Entity(m_worldBounds);
+            worldspawn->setProperty(Model::Entity::ClassnameKey, Model::Entity::WorldspawnClassname);
+            worldspawn->addBrushes(createBrushes(brushCount));
+            map->addEntity(*worldspawn);
+            
+            const BBoxf bounds = contentBounds(brushCount);
+            for (size_t i = 0; i < entityCount; i++) {
+                Model::Entity* entity = new Model::Entity(m_worldBounds);
+                entity->setProperty(Model::Entity::ClassnameKey, "light");
+                entity->setProperty("light", static_cast<int>(random(100.0f, 500.0f)));
+                entity->setProperty(Model::Entity::OriginKey, Vec3f(randomOnGrid(bounds.min.x(), bounds.max.x(), 8.0f),
+                                                                     randomOnGrid(bounds.min.y(), bounds.max.y(), 8.0f),
+                                                                     randomOnGrid(bounds.min.z(), bounds.max.z(), 8.0f)), true);
+                map->addEntity(*entity);
+            }
+            
+            return map;
+        }
+        
+        String createMapText(size_t brushCount, size_t entityCount) {
+            Model::Map* map = createMap(brushCount, entityCount);
+            StringStream stream;
+            IO::MapWriter writer;
+            writer.writeToStream(*map, stream);
+            delete map;
+            return stream.str();
+        }
+        
+        /**
+         * Returns a ray that starts outside of the given bounds and points to a random point within them.
+         */
+        Rayf randomRay(const BBoxf& bounds) {
+            const Vec3f center = bounds.center();
+            const float radius = bounds.size().length();
+            
+            Vec3f direction(random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f));
+            if (direction.lengthSquared() < 0.01f)
+                direction = Vec3f::PosX;
+            direction.normalize();
+            
+            const Vec3f target(random(bounds.min.x(), bounds.max.x()),
+                               random(bounds.min.y(), bounds.max.y()),
+                               random(bounds.min.z(), bounds.max.z()));
+            const Vec3f origin = center - radius * direction;
+            return Rayf(origin, (target - origin).normalized());
+        }
+        
+        /**
+         * Writes a wad file containing the given number of random mip textures with the given size.
+         */
+        bool writeWad(const String& path, size_t textureCount, unsigned int size) {
+            std::fstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream.is_open())
+                return false;
+            
+            static const unsigned int HeaderSize = 12;
+            static const unsigned int MipHeaderSize = 40;
+            const unsigned int pixelCount = size * size + (size / 2) * (size / 2) + (size / 4) * (size / 4) + (size / 8) * (size / 8);
+            const unsigned int entrySize = MipHeaderSize + pixelCount;
+            const unsigned int directoryAddress = HeaderSize + static_cast<unsigned int>(textureCount) * entrySize;
+            
+            stream.write("WAD2", 4);
+            writeInt(stream, static_cast<int32_t>(textureCount));
+            writeInt(stream, static_cast<int32_t>(directoryAddress));
+            
+            std::vector<char> pixels(pixelCount);
+            for (size_t i = 0; i < textureCount; i++) {
+                char name[16];
+                memset(name, 0, sizeof(name));
+                StringStream nameStream;
+                nameStream << "tex" << i;
+                strncpy(name, nameStream.str().c_str(), sizeof(name) - 1);
+                
+                stream.write(name, sizeof(name));
+                writeInt(stream, static_cast<int32_t>(size));
+                writeInt(stream, static_cast<int32_t>(size));
+                writeInt(stream, static_cast<int32_t>(MipHeaderSize));
+                writeInt(stream, static_cast<int32_t>(MipHeaderSize + size * size));
+                writeInt(stream, static_cast<int32_t>(MipHeaderSize + size * size + (size / 2) * (size / 2)));
+                writeInt(stream, static_cast<int32_t>(MipHeaderSize + size * size + (size / 2) * (size / 2) + (size / 4) * (size / 4)));
+                
+                for (size_t j = 0; j < pixels.size(); j++)
+                    pixels[j] = static_cast<char>(next() & 0xFF);
+                stream.write(&pixels[0], static_cast<std::streamsize>(pixels.size()));
+            }
+            
+            for (size_t i = 0; i < textureCount; i++) {
+                char name[16];
+                memset(name, 0, sizeof(name));
+                StringStream nameStream;
+                nameStream << "tex" << i;
+                strncpy(name, nameStream.str().c_str(), sizeof(name) - 1);
+                
+                writeInt(stream, static_cast<int32_t>(HeaderSize + i * entrySize));
+                writeInt(stream, static_cast<int32_t>(entrySize));
+                writeInt(stream, static_cast<int32_t>(entrySize));
+                const char type[4] = {'D', 0, 0, 0};
+                stream.write(type, 4);
+                stream.write(name, sizeof(name));
+            }
+            
+            return stream.good();
+        }
+        
+        bool writePalette(const String& path) {
+            std::fstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream.is_open())
+                return false;
+            
+            for (size_t i = 0; i < 768; i++) {
+                const char c = static_cast<char>(next() & 0xFF);
+                stream.write(&c, 1);
+            }
+            return stream.good();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <wx/filename.h>
+#include <wx/init.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "BenchmarkSuite.h"
+#include "IO/MapParserBenchmark.h"
+#include "IO/MapWriterBenchmark.h"
+#include "IO/WadBenchmark.h"
+#include "Model/BrushBenchmark.h"
+#include "Model/EditStateBenchmark.h"
+#include "Model/FacePointBenchmark.h"
+#include "Model/OctreeBenchmark.h"
+#include "Model/PickerBenchmark.h"
+#include "Renderer/PaletteBenchmark.h"
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--iterations n] [--brushes n] [--entities n] [--rays n] [--textures n] [--seed n] [--output file]" << std::endl;
+}
+
+static bool parseSize(const char* value, size_t& result) {
+    char* end = NULL;
+    const long number = std::strtol(value, &end, 10);
+    if (end == value || *end != '\0' || number <= 0)
+        return false;
+    result = static_cast<size_t>(number);
+    return true;
+}
+
+int main(int argc, const char * argv[]) {
+    using namespace TrenchBroom;
+    
+    BenchmarkOptions options;
+    String outputPath;
+    
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        
+        const char* value = argv[++i];
+        bool valid = true;
+        if (std::strcmp(arg, "--iterations") == 0) {
+            valid = parseSize(value, options.iterations);
+        } else if (std::strcmp(arg, "--brushes") == 0) {
+            valid = parseSize(value, options.brushCount);
+        } else if (std::strcmp(arg, "--entities") == 0) {
+            valid = parseSize(value, options.entityCount);
+        } else if (std::strcmp(arg, "--rays") == 0) {
+            valid = parseSize(value, options.rayCount);
+        } else if (std::strcmp(arg, "--textures") == 0) {
+            valid = parseSize(value, options.textureCount);
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            size_t seed = 0;
+            valid = parseSize(value, seed);
+            options.seed = static_cast<unsigned int>(seed);
+        } else if (std::strcmp(arg, "--output") == 0) {
+            outputPath = value;
+        } else {
+            valid = false;
+        }
+        
+        if (!valid) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // no GUI is created, but the file system and string helpers need wxWidgets to be initialized
+    wxInitializer initializer;
+    if (!initializer.IsOk()) {
+        std::cerr << "Unable to initialize wxWidgets" << std::endl;
+        return 1;
+    }
+    
+    const String tempDirectory = wxFileName::GetTempDir().ToStdString();
+    BenchmarkResults results;
+    
+    {
+        IO::MapParserBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        IO::MapWriterBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        IO::WadBenchmark benchmark(options, tempDirectory);
+        benchmark.run(results);
+    }
+    {
+        Model::BrushBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        Model::EditStateBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        Model::FacePointBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        Model::OctreeBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        Model::PickerBenchmark benchmark(options);
+        benchmark.run(results);
+    }
+    {
+        Renderer::PaletteBenchmark benchmark(options, tempDirectory);
+        benchmark.run(results);
+    }
+    
+    if (outputPath.empty()) {
+        results.writeJson(options, std::cout);
+    } else {
+        std::ofstream stream(outputPath.c_str());
+        if (!stream.is_open()) {
+            std::cerr << "Unable to open " << outputPath << std::endl;
+            return 1;
+        }
+        results.writeJson(options, stream);
+    }
+    
+    return 0;
+}
@@ -43,6 +43,17 @@ namespace TrenchBroom {
             return appendPath(appDirectory(), "Resources");
         }
 
+        String LinuxFileManager::cacheDirectory() {
+            char* cacheHome = std::getenv("XDG_CACHE_HOME");
+            if (cacheHome != NULL && *cacheHome != 0)
+                return appendPath(cacheHome, "trenchbroom");
+            
+            char* homeDirectory = std::getenv("HOME");
+            if (homeDirectory == NULL)
+                return "";
+            return appendPath(appendPath(homeDirectory, ".cache"), "trenchbroom");
+        }
+
         String LinuxFileManager::resolveFontPath(const String& fontName) {
             String fontDirectoryPath = "/usr/share/fonts/truetype/";
             String extensions[2] = {".ttf", ".ttc"};
@@ -30,6 +30,7 @@ namespace TrenchBroom {
         public:
             String logDirectory();
             String resourceDirectory();
+            String cacheDirectory();
             String resolveFontPath(const String& fontName);
         };
     }
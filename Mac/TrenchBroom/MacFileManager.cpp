@@ -21,6 +21,7 @@
 
 #include "CoreFoundation/CoreFoundation.h"
 
+#include <cstdlib>
 #include <fstream>
 
 namespace TrenchBroom {
@@ -63,6 +64,13 @@ namespace TrenchBroom {
             return result.str();
         }
 
+        String MacFileManager::cacheDirectory() {
+            char* homeDirectory = std::getenv("HOME");
+            if (homeDirectory == NULL)
+                return "";
+            return appendPath(appendPath(appendPath(homeDirectory, "Library"), "Caches"), "TrenchBroom");
+        }
+        
         String MacFileManager::resolveFontPath(const String& fontName) {
             String fontDirectoryPaths[2] = {"/System/Library/Fonts/", "/Library/Fonts/"};
             String extensions[2] = {".ttf", ".ttc"};
@@ -0,0 +1,104 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushEditTask_h
+#define TrenchBroom_BrushEditTask_h
+
+#include "Model/Brush.h"
+#include "Model/BrushTypes.h"
+#include "Utility/Profiler.h"
+#include "Utility/VecMath.h"
+#include "Utility/WorkerPool.h"
+
+#include <cassert>
+#include <map>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Controller {
+        /**
+         * Prepares a vertex operation for several brushes on the shared worker pool. The edits are kept in the order
+         * of the given brushes, so the results do not depend on how the brushes were scheduled.
+         */
+        template <typename Arguments>
+        class BrushEditTask : public Utility::ParallelTask {
+        public:
+            typedef std::map<Model::Brush*, Arguments> ArgumentMap;
+            typedef bool (Model::Brush::*PrepareFunction)(const Arguments& arguments, const Vec3f& delta, Model::BrushEdit& edit);
+        private:
+            const Model::BrushList& m_brushes;
+            const ArgumentMap& m_arguments;
+            PrepareFunction m_prepare;
+            Vec3f m_delta;
+            Model::BrushEdit::List m_edits;
+        public:
+            BrushEditTask(const Model::BrushList& brushes, const ArgumentMap& arguments, PrepareFunction prepare, const Vec3f& delta) :
+            m_brushes(brushes),
+            m_arguments(arguments),
+            m_prepare(prepare),
+            m_delta(delta),
+            m_edits(brushes.size()) {}
+            
+            ~BrushEditTask() {
+                for (size_t i = 0; i < m_edits.size(); i++)
+                    if (m_edits[i].prepared())
+                        m_brushes[i]->discardEdit(m_edits[i]);
+            }
+            
+            void run(size_t index) {
+                Model::Brush* brush = m_brushes[index];
+                typename ArgumentMap::const_iterator it = m_arguments.find(brush);
+                assert(it != m_arguments.end());
+                (brush->*m_prepare)(it->second, m_delta, m_edits[index]);
+            }
+            
+            /**
+             * Prepares the edits of all brushes. If any brush cannot be edited, all edits are discarded and false is
+             * returned.
+             */
+            bool prepare() {
+                Utility::ScopedTimer timer("BrushEditTask::prepare");
+                Utility::WorkerPool::execute(*this, m_brushes.size());
+                
+                for (size_t i = 0; i < m_edits.size(); i++) {
+                    if (!m_edits[i].prepared()) {
+                        for (size_t j = 0; j < m_edits.size(); j++)
+                            if (m_edits[j].prepared())
+                                m_brushes[j]->discardEdit(m_edits[j]);
+                        return false;
+                    }
+                }
+                return true;
+            }
+            
+            void commit() {
+                for (size_t i = 0; i < m_edits.size(); i++)
+                    m_brushes[i]->commitEdit(m_edits[i]);
+            }
+            
+            inline const Model::BrushEdit& edit(size_t index) const {
+                assert(index < m_edits.size());
+                return m_edits[index];
+            }
+        };
+    }
+}
+
+#endif
@@ -428,21 +428,22 @@ namespace TrenchBroom {
                     Renderer::VertexArray* linesArray = NULL;
                     Renderer::VertexArray* triangleArray = NULL;
                     
-                    Renderer::SetVboState mapVbo(vbo, Renderer::Vbo::VboMapped);
+                    Renderer::Vbo& streamVbo = renderContext.streamVbo();
+                    Renderer::SetVboState mapVbo(streamVbo, Renderer::Vbo::VboMapped);
                     
-                    linesArray = new Renderer::VertexArray(vbo, GL_LINE_LOOP, m_numPoints,
+                    linesArray = new Renderer::VertexArray(streamVbo, GL_LINE_LOOP, m_numPoints,
                                                            Renderer::Attribute::position3f());
                     for (unsigned int i = 0; i < m_numPoints; i++)
                         linesArray->addAttribute(m_points[i]);
                     
                     if (m_numPoints == 3) {
-                        triangleArray = new Renderer::VertexArray(vbo, GL_TRIANGLES, m_numPoints,
+                        triangleArray = new Renderer::VertexArray(streamVbo, GL_TRIANGLES, m_numPoints,
                                                                   Renderer::Attribute::position3f());
                         for (unsigned int i = 0; i < m_numPoints; i++)
                             triangleArray->addAttribute(m_points[i]);
                     }
                     
-                    Renderer::SetVboState activateVbo(vbo, Renderer::Vbo::VboActive);
+                    Renderer::SetVboState activateVbo(streamVbo, Renderer::Vbo::VboActive);
                     glDisable(GL_DEPTH_TEST);
                     planeShader.setUniformVariable("Color", prefs.getColor(Preferences::OccludedClipHandleColor));
                     linesArray->render();
@@ -32,6 +32,7 @@ namespace TrenchBroom {
         public:
             typedef enum {
                 LoadMap,
+                LoadMapBatch,
                 ClearMap,
                 ChangeGrid,
                 ChangeEditState,
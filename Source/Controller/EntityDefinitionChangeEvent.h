@@ -0,0 +1,43 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__EntityDefinitionChangeEvent__
+#define __TrenchBroom__EntityDefinitionChangeEvent__
+
+#include "Controller/Command.h"
+#include "Model/EntityTypes.h"
+
+namespace TrenchBroom {
+    namespace Controller {
+        class EntityDefinitionChangeEvent : public Command {
+        private:
+            Model::EntityList m_changedEntities;
+        public:
+            EntityDefinitionChangeEvent(const Model::EntityList& changedEntities);
+            virtual ~EntityDefinitionChangeEvent() {}
+            
+            /**
+             * Returns the entities whose bounds, color or model may have changed due to the new definitions.
+             */
+            const Model::EntityList& changedEntities() const;
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__EntityDefinitionChangeEvent__) */
@@ -0,0 +1,152 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HandleGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace TrenchBroom {
+    namespace Controller {
+        HandleGrid::Cell HandleGrid::cell(const Vec3f& position) const {
+            return Cell(static_cast<int>(std::floor(position[0] / m_cellSize)),
+                        static_cast<int>(std::floor(position[1] / m_cellSize)),
+                        static_cast<int>(std::floor(position[2] / m_cellSize)));
+        }
+        
+        void HandleGrid::collect(const CellRange& range, const CellRange* skip, Vec3f::List& result) const {
+            for (int x = range.min.x; x <= range.max.x; x++) {
+                for (int y = range.min.y; y <= range.max.y; y++) {
+                    for (int z = range.min.z; z <= range.max.z; z++) {
+                        if (skip != NULL && skip->contains(x, y, z))
+                            continue;
+                        
+                        CellMap::const_iterator it = m_cells.find(Cell(x, y, z));
+                        if (it != m_cells.end())
+                            result.insert(result.end(), it->second.begin(), it->second.end());
+                    }
+                }
+            }
+        }
+
+        HandleGrid::HandleGrid(float cellSize) :
+        m_cellSize(cellSize),
+        m_count(0) {
+            assert(m_cellSize > 0.0f);
+        }
+        
+        void HandleGrid::add(const Vec3f& position) {
+            m_cells[cell(position)].push_back(position);
+            if (m_count == 0)
+                m_bounds = BBoxf(position, position);
+            else
+                m_bounds.mergeWith(position);
+            m_count++;
+        }
+        
+        bool HandleGrid::remove(const Vec3f& position) {
+            CellMap::iterator cellIt = m_cells.find(cell(position));
+            if (cellIt == m_cells.end())
+                return false;
+            
+            Vec3f::List& positions = cellIt->second;
+            Vec3f::List::iterator it = std::find(positions.begin(), positions.end(), position);
+            if (it == positions.end())
+                return false;
+            
+            *it = positions.back();
+            positions.pop_back();
+            if (positions.empty())
+                m_cells.erase(cellIt);
+            
+            assert(m_count > 0);
+            m_count--;
+            return true;
+        }
+        
+        void HandleGrid::clear() {
+            m_cells.clear();
+            m_count = 0;
+        }
+        
+        void HandleGrid::findHandles(const Rayf& ray, float radius, float scalingFactor, float maxDistance, Vec3f::List& result) const {
+            if (m_count == 0)
+                return;
+            
+            // a handle at distance d from the origin has radius k * d, so it can only be hit if its distance from the
+            // ray is at most spread times its distance along the ray
+            const float k = radius * scalingFactor;
+            if (k >= 1.0f) {
+                CellMap::const_iterator it, end;
+                for (it = m_cells.begin(), end = m_cells.end(); it != end; ++it)
+                    result.insert(result.end(), it->second.begin(), it->second.end());
+                return;
+            }
+            const float spread = k / std::sqrt(1.0f - k * k);
+            
+            // clip the ray against the bounds of all handles, the bounds are only reset when the grid is emptied
+            const BBoxf bounds = m_bounds.expanded(spread * maxDistance + m_cellSize);
+            float tMin = 0.0f;
+            float tMax = maxDistance;
+            for (size_t i = 0; i < 3; i++) {
+                if (Math<float>::zero(ray.direction[i])) {
+                    if (ray.origin[i] < bounds.min[i] || ray.origin[i] > bounds.max[i])
+                        return;
+                } else {
+                    float t0 = (bounds.min[i] - ray.origin[i]) / ray.direction[i];
+                    float t1 = (bounds.max[i] - ray.origin[i]) / ray.direction[i];
+                    if (t0 > t1)
+                        std::swap(t0, t1);
+                    tMin = std::max(tMin, t0);
+                    tMax = std::min(tMax, t1);
+                }
+            }
+            if (tMin > tMax)
+                return;
+            
+            // walk the ray in steps of one cell and visit the cells around each step which were not visited by the
+            // previous step; the ranges of all other previous steps cannot contain any cells of the current range
+            CellRange previous;
+            bool first = true;
+            for (float t = tMin; t <= tMax; t += m_cellSize) {
+                const float next = std::min(t + m_cellSize, tMax);
+                const Vec3f start = ray.pointAtDistance(t);
+                const Vec3f end = ray.pointAtDistance(next);
+                const float distance = spread * next;
+                
+                Vec3f min, max;
+                for (size_t i = 0; i < 3; i++) {
+                    min[i] = std::min(start[i], end[i]) - distance;
+                    max[i] = std::max(start[i], end[i]) + distance;
+                }
+                
+                CellRange range;
+                range.min = cell(min);
+                range.max = cell(max);
+                collect(range, first ? NULL : &previous, result);
+                
+                previous = range;
+                first = false;
+                if (next >= tMax)
+                    break;
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__HandleGrid__
+#define __TrenchBroom__HandleGrid__
+
+#include "Utility/UnorderedMap.h"
+#include "Utility/VecMath.h"
+
+#include <cstddef>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Controller {
+        /**
+         * A hashed grid of handle positions which finds the handles that may be hit by a ray without testing every
+         * handle. Each position must be added at most once.
+         */
+        class HandleGrid {
+        private:
+            class Cell {
+            public:
+                int x, y, z;
+                
+                Cell() :
+                x(0),
+                y(0),
+                z(0) {}
+                
+                Cell(int i_x, int i_y, int i_z) :
+                x(i_x),
+                y(i_y),
+                z(i_z) {}
+                
+                inline bool operator== (const Cell& other) const {
+                    return x == other.x && y == other.y && z == other.z;
+                }
+            };
+            
+            class CellHash {
+            public:
+                inline size_t operator() (const Cell& cell) const {
+                    return (static_cast<size_t>(cell.x) * 73856093u) ^ (static_cast<size_t>(cell.y) * 19349663u) ^ (static_cast<size_t>(cell.z) * 83492791u);
+                }
+            };
+            
+            class CellRange {
+            public:
+                Cell min;
+                Cell max;
+                
+                inline bool contains(int x, int y, int z) const {
+                    return (x >= min.x && x <= max.x &&
+                            y >= min.y && y <= max.y &&
+                            z >= min.z && z <= max.z);
+                }
+            };
+            
+            typedef std::tr1::unordered_map<Cell, Vec3f::List, CellHash> CellMap;
+            
+            float m_cellSize;
+            CellMap m_cells;
+            size_t m_count;
+            BBoxf m_bounds;
+            
+            Cell cell(const Vec3f& position) const;
+            void collect(const CellRange& range, const CellRange* skip, Vec3f::List& result) const;
+        public:
+            HandleGrid(float cellSize = 64.0f);
+            
+            inline size_t size() const {
+                return m_count;
+            }
+            
+            inline bool empty() const {
+                return m_count == 0;
+            }
+            
+            void add(const Vec3f& position);
+            bool remove(const Vec3f& position);
+            void clear();
+            
+            /**
+             * Adds every position which might be hit by the given ray to the given list. The parameters are those
+             * of Rayf::intersectWithSphere, so the handles are spheres which grow with their distance from the ray
+             * origin. The result is a superset of the handles hit; the caller must still test each of them.
+             */
+            void findHandles(const Rayf& ray, float radius, float scalingFactor, float maxDistance, Vec3f::List& result) const;
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__HandleGrid__) */
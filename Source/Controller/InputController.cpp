@@ -330,10 +330,15 @@ namespace TrenchBroom {
             updateViews();
         }
 
+        bool InputController::dragging() const {
+            return m_dragTool != NULL && m_dragTool->dragType() == Tool::DTDrag;
+        }
+        
         void InputController::cancelDrag() {
             if (m_dragTool != NULL) {
                 m_dragTool->cancelDrag(m_inputState);
                 m_dragTool = NULL;
+                m_cancelledDrag = true;
                 m_inputState.mouseUp(m_inputState.mouseButtons());
             }
 
@@ -476,8 +481,15 @@ namespace TrenchBroom {
                 editStateManager.hasSelectedObjects()) {
                 Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
 
+                // follow the selection while a drag is previewed by the renderer
+                const BBoxf bounds = editStateManager.bounds().transformed(m_documentViewHolder.view().renderer().selectionTransformation());
+                if (m_selectionGuideRenderer != NULL && !(m_selectionGuideRenderer->bounds() == bounds)) {
+                    delete m_selectionGuideRenderer;
+                    m_selectionGuideRenderer = NULL;
+                }
+                
                 if (m_selectionGuideRenderer == NULL)
-                    m_selectionGuideRenderer = new Renderer::BoxGuideRenderer(editStateManager.bounds(),
+                    m_selectionGuideRenderer = new Renderer::BoxGuideRenderer(bounds,
                                                                               m_documentViewHolder.document().picker(),
                                                                               m_documentViewHolder.view().filter(),
                                                                               m_documentViewHolder.document().sharedResources().fontManager());
@@ -110,6 +110,7 @@ namespace TrenchBroom {
             bool mouseDClick(int x, int y, MouseButtonState mouseButton);
             void mouseMove(int x, int y);
             void scroll(float x, float y);
+            bool dragging() const;
             void cancelDrag();
             void endDrag();
 
@@ -0,0 +1,44 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__LoadMapBatchEvent__
+#define __TrenchBroom__LoadMapBatchEvent__
+
+#include "Controller/Command.h"
+#include "Model/EntityTypes.h"
+
+namespace TrenchBroom {
+    namespace Controller {
+        class LoadMapBatchEvent : public Command {
+        private:
+            Model::EntityList m_addedEntities;
+        public:
+            LoadMapBatchEvent(const Model::EntityList& addedEntities);
+            virtual ~LoadMapBatchEvent() {}
+            
+            /**
+             * Returns the entities which have been loaded since the previous batch. Brushes are added to their
+             * entities while the map is loading and are not listed individually.
+             */
+            const Model::EntityList& addedEntities() const;
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__LoadMapBatchEvent__) */
@@ -17,6 +17,7 @@
  along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "Controller/BrushEditTask.h"
 #include "Controller/VertexHandleManager.h"
 #include "MoveEdgesCommand.h"
 #include "Model/Brush.h"
@@ -27,35 +28,34 @@
 namespace TrenchBroom {
     namespace Controller {
         bool MoveEdgesCommand::performDo() {
-            if (!canDo())
+            BrushEditTask<Model::EdgeInfoList> task(m_brushes, m_brushEdges, &Model::Brush::prepareMoveEdges, m_delta);
+            if (!task.prepare())
                 return false;
 
-            m_handleManager.remove(m_brushes);
             makeSnapshots(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
+            task.commit();
+
             m_edgesAfter.clear();
-            
-            Model::BrushEdgesMap::const_iterator it, end;
-            for (it = m_brushEdges.begin(), end = m_brushEdges.end(); it != end; ++it) {
-                Model::Brush* brush = it->first;
-                const Model::EdgeInfoList& edgeInfos = it->second;
-                const Model::EdgeInfoList newEdgeInfos = brush->moveEdges(edgeInfos, m_delta);
+            for (size_t i = 0; i < m_brushes.size(); i++) {
+                const Model::EdgeInfoList& newEdgeInfos = task.edit(i).edges;
                 m_edgesAfter.insert(m_edgesAfter.end(), newEdgeInfos.begin(), newEdgeInfos.end());
             }
 
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectEdgeHandles(m_edgesAfter);
 
             return true;
         }
 
         bool MoveEdgesCommand::performUndo() {
-            m_handleManager.remove(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
             restoreSnapshots(m_brushes);
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectEdgeHandles(m_edgesBefore);
             
             return true;
@@ -90,16 +90,5 @@ namespace TrenchBroom {
         MoveEdgesCommand* MoveEdgesCommand::moveEdges(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta) {
             return new MoveEdgesCommand(document, handleManager.selectedEdgeHandles().size() == 1 ? wxT("Move Edge") : wxT("Move Edges"), handleManager, delta);
         }
-
-        bool MoveEdgesCommand::canDo() const {
-            Model::BrushEdgesMap::const_iterator it, end;
-            for (it = m_brushEdges.begin(), end = m_brushEdges.end(); it != end; ++it) {
-                Model::Brush* brush = it->first;
-                const Model::EdgeInfoList& edges = it->second;
-                if (!brush->canMoveEdges(edges, m_delta))
-                    return false;
-            }
-            return true;
-        }
     }
 }
@@ -49,8 +49,6 @@ namespace TrenchBroom {
             MoveEdgesCommand(Model::MapDocument& document, const wxString& name, VertexHandleManager& handleManager, const Vec3f& delta);
         public:
             static MoveEdgesCommand* moveEdges(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta);
-
-            bool canDo() const;
         };
     }
 }
@@ -17,6 +17,7 @@
  along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "Controller/BrushEditTask.h"
 #include "Controller/VertexHandleManager.h"
 #include "MoveFacesCommand.h"
 #include "Model/Brush.h"
@@ -26,35 +27,34 @@
 namespace TrenchBroom {
     namespace Controller {
         bool MoveFacesCommand::performDo() {
-            if (!canDo())
+            BrushEditTask<Model::FaceInfoList> task(m_brushes, m_brushFaces, &Model::Brush::prepareMoveFaces, m_delta);
+            if (!task.prepare())
                 return false;
 
-            m_handleManager.remove(m_brushes);
             makeSnapshots(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
-            m_facesAfter.clear();
+            task.commit();
 
-            Model::BrushFacesMap::const_iterator it, end;
-            for (it = m_brushFaces.begin(), end = m_brushFaces.end(); it != end; ++it) {
-                Model::Brush* brush = it->first;
-                const Model::FaceInfoList& faceInfos = it->second;
-                const Model::FaceInfoList newFaces = brush->moveFaces(faceInfos, m_delta);
-                m_facesAfter.insert(m_facesAfter.end(), newFaces.begin(), newFaces.end());
+            m_facesAfter.clear();
+            for (size_t i = 0; i < m_brushes.size(); i++) {
+                const Model::FaceInfoList& newFaceInfos = task.edit(i).faces;
+                m_facesAfter.insert(m_facesAfter.end(), newFaceInfos.begin(), newFaceInfos.end());
             }
 
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectFaceHandles(m_facesAfter);
 
             return true;
         }
 
         bool MoveFacesCommand::performUndo() {
-            m_handleManager.remove(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
             restoreSnapshots(m_brushes);
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectFaceHandles(m_facesBefore);
             
             return true;
@@ -89,16 +89,5 @@ namespace TrenchBroom {
         MoveFacesCommand* MoveFacesCommand::moveFaces(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta) {
             return new MoveFacesCommand(document, handleManager.selectedFaceHandles().size() == 1 ? wxT("Move Face") : wxT("Move Faces"), handleManager, delta);
         }
-
-        bool MoveFacesCommand::canDo() const {
-            Model::BrushFacesMap::const_iterator it, end;
-            for (it = m_brushFaces.begin(), end = m_brushFaces.end(); it != end; ++it) {
-                Model::Brush* brush = it->first;
-                const Model::FaceInfoList& faces = it->second;
-                if (!brush->canMoveFaces(faces, m_delta))
-                    return false;
-            }
-            return true;
-        }
     }
 }
@@ -50,8 +50,6 @@ namespace TrenchBroom {
             MoveFacesCommand(Model::MapDocument& document, const wxString& name, VertexHandleManager& handleManager, const Vec3f& delta);
         public:
             static MoveFacesCommand* moveFaces(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta);
-
-            bool canDo() const;
         };
     }
 }
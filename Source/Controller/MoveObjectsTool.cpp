@@ -25,13 +25,35 @@
 #include "Model/EditStateManager.h"
 #include "Model/Map.h"
 #include "Model/MapDocument.h"
+#include "Model/Picker.h"
+#include "Renderer/MapRenderer.h"
 #include "View/EditorFrame.h"
+#include "View/EditorView.h"
 #include "View/FlashSelectionAnimation.h"
 
 #include <cassert>
 
 namespace TrenchBroom {
     namespace Controller {
+        void MoveObjectsTool::updatePreview() {
+            Model::EditStateManager& editStateManager = document().editStateManager();
+            const Model::EntityList& entities = editStateManager.selectedEntities();
+            const Model::BrushList& brushes = editStateManager.selectedBrushes();
+            
+            Model::MapObjectList objects;
+            objects.reserve(entities.size() + brushes.size());
+            objects.insert(objects.end(), entities.begin(), entities.end());
+            objects.insert(objects.end(), brushes.begin(), brushes.end());
+            
+            document().picker().setTranslatedObjects(objects, m_totalDelta);
+            view().renderer().setSelectionTransformation(translationMatrix(m_totalDelta));
+        }
+        
+        void MoveObjectsTool::clearPreview() {
+            document().picker().clearTranslatedObjects();
+            view().renderer().clearSelectionTransformation();
+        }
+        
         bool MoveObjectsTool::isApplicable(InputState& inputState, Vec3f& hitPoint) {
             if (inputState.mouseButtons() == MouseButtons::MBLeft &&
                 (inputState.modifierKeys() == ModifierKeys::MKNone ||
@@ -72,6 +94,7 @@ namespace TrenchBroom {
             const Model::EntityList& entities = editStateManager.selectedEntities();
             const Model::BrushList& brushes = editStateManager.selectedBrushes();
 
+            m_totalDelta = Vec3f::Null;
             if ((inputState.modifierKeys() & ModifierKeys::MKCtrlCmd)) {
                 m_mode = MMDuplicate;
                 beginCommandGroup(Command::makeObjectActionName(wxT("Duplicate"), entities, brushes));
@@ -84,27 +107,48 @@ namespace TrenchBroom {
 
         MoveTool::MoveResult MoveObjectsTool::performMove(const Vec3f& delta) {
             Model::EditStateManager& editStateManager = document().editStateManager();
-            const Model::EntityList& entities = editStateManager.selectedEntities();
-            const Model::BrushList& brushes = editStateManager.selectedBrushes();
             
             BBoxf bounds = editStateManager.bounds();
-            bounds.translate(delta);
+            bounds.translate(m_totalDelta + delta);
             if (!document().map().worldBounds().contains(bounds))
                 return Deny;
             
-            TransformObjectsCommand* command = TransformObjectsCommand::translateObjects(document(), entities, brushes, delta);
-            submitCommand(command);
+            // only preview the move until the drag ends
+            m_totalDelta += delta;
+            updatePreview();
             
             return Continue;
         }
 
         void MoveObjectsTool::endDrag(InputState& inputState) {
+            clearPreview();
+            
+            if (!m_totalDelta.null()) {
+                Model::EditStateManager& editStateManager = document().editStateManager();
+                const Model::EntityList& entities = editStateManager.selectedEntities();
+                const Model::BrushList& brushes = editStateManager.selectedBrushes();
+                
+                TransformObjectsCommand* command = TransformObjectsCommand::translateObjects(document(), entities, brushes, m_totalDelta);
+                submitCommand(command);
+                m_totalDelta = Vec3f::Null;
+            }
+            
+            endCommandGroup();
+        }
+        
+        void MoveObjectsTool::cancelDrag(InputState& inputState) {
+            clearPreview();
+            m_totalDelta = Vec3f::Null;
+            
+            // undo the duplication, if any
+            rollbackCommandGroup();
             endCommandGroup();
         }
 
         MoveObjectsTool::MoveObjectsTool(View::DocumentViewHolder& documentViewHolder, InputController& inputController) :
         MoveTool(documentViewHolder, inputController, true),
         m_filter(Model::SelectedFilter(view().filter())),
-        m_mode(MMMove) {}
+        m_mode(MMMove),
+        m_totalDelta(Vec3f::Null) {}
     }
 }
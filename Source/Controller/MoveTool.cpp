@@ -135,6 +135,11 @@ namespace TrenchBroom {
             endCommandGroup();
             endDrag(inputState);
         }
+        
+        void MoveTool::handleCancelDrag(InputState& inputState) {
+            endCommandGroup();
+            cancelDrag(inputState);
+        }
 
         MoveTool::MoveTool(View::DocumentViewHolder& documentViewHolder, InputController& inputController, bool activatable) :
         PlaneDragTool(documentViewHolder, inputController, activatable),
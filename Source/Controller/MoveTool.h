@@ -46,6 +46,7 @@ namespace TrenchBroom {
             virtual void snapDragDelta(InputState& inputState, Vec3f& delta);
             virtual MoveResult performMove(const Vec3f& delta) = 0;
             virtual void endDrag(InputState& inputState) {}
+            virtual void cancelDrag(InputState& inputState) { endDrag(inputState); }
             
             virtual void handleRender(InputState& inputState, Renderer::Vbo& vbo, Renderer::RenderContext& renderContext);
             virtual void handleFreeRenderResources();
@@ -56,6 +57,7 @@ namespace TrenchBroom {
             virtual void handleResetPlane(InputState& inputState, Planef& plane, Vec3f& initialPoint);
             virtual bool handlePlaneDrag(InputState& inputState, const Vec3f& lastPoint, const Vec3f& curPoint, Vec3f& refPoint);
             virtual void handleEndPlaneDrag(InputState& inputState);
+            virtual void handleCancelDrag(InputState& inputState);
         private:
             Renderer::MovementIndicator* m_indicator;
         public:
@@ -19,6 +19,7 @@
 
 #include "MoveVerticesCommand.h"
 
+#include "Controller/BrushEditTask.h"
 #include "Controller/VertexHandleManager.h"
 #include "Model/Brush.h"
 #include "Model/BrushGeometry.h"
@@ -30,36 +31,34 @@
 namespace TrenchBroom {
     namespace Controller {
         bool MoveVerticesCommand::performDo() {
-            if (!canDo())
+            BrushEditTask<Vec3f::List> task(m_brushes, m_brushVertices, &Model::Brush::prepareMoveVertices, m_delta);
+            if (!task.prepare())
                 return false;
             
-            m_handleManager.remove(m_brushes);
             makeSnapshots(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
-            m_verticesAfter.clear();
+            task.commit();
 
-            BrushVerticesMap::const_iterator mapIt, mapEnd;
-            for (mapIt = m_brushVertices.begin(), mapEnd = m_brushVertices.end(); mapIt != mapEnd; ++mapIt) {
-                Model::Brush* brush = mapIt->first;
-                const Vec3f::List& oldVertexPositions = mapIt->second;
-                const Vec3f::List newVertexPositions = brush->moveVertices(oldVertexPositions, m_delta);
-                
+            m_verticesAfter.clear();
+            for (size_t i = 0; i < m_brushes.size(); i++) {
+                const Vec3f::List& newVertexPositions = task.edit(i).vertices;
                 m_verticesAfter.insert(newVertexPositions.begin(), newVertexPositions.end());
             }
             
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectVertexHandles(m_verticesAfter);
 
             return true;
         }
         
         bool MoveVerticesCommand::performUndo() {
-            m_handleManager.remove(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
             restoreSnapshots(m_brushes);
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectVertexHandles(m_verticesBefore);
 
             return true;
@@ -93,17 +92,6 @@ namespace TrenchBroom {
             return new MoveVerticesCommand(document, handleManager.selectedVertexHandles().size() == 1 ? wxT("Move Vertex") : wxT("Move Vertices"), handleManager, delta);
         }
 
-        bool MoveVerticesCommand::canDo() const {
-            BrushVerticesMap::const_iterator it, end;
-            for (it = m_brushVertices.begin(), end = m_brushVertices.end(); it != end; ++it) {
-                Model::Brush* brush = it->first;
-                const Vec3f::List& vertices = it->second;
-                if (!brush->canMoveVertices(vertices, m_delta))
-                    return false;
-            }
-            return true;
-        }
-
         bool MoveVerticesCommand::hasRemainingVertices() const {
             if (state() == Done)
                 return !m_verticesAfter.empty();
@@ -54,7 +54,6 @@ namespace TrenchBroom {
         public:
             static MoveVerticesCommand* moveVertices(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta);
             
-            bool canDo() const;
             bool hasRemainingVertices() const;
         };
     }
@@ -145,8 +145,9 @@ namespace TrenchBroom {
             }
 
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
-            Renderer::VertexArray edgeArray(vbo, GL_LINES, vertexCount, Renderer::Attribute::position3f());
-            Renderer::SetVboState mapVbo(vbo, Renderer::Vbo::VboMapped);
+            Renderer::Vbo& streamVbo = renderContext.streamVbo();
+            Renderer::VertexArray edgeArray(streamVbo, GL_LINES, vertexCount, Renderer::Attribute::position3f());
+            Renderer::SetVboState mapVbo(streamVbo, Renderer::Vbo::VboMapped);
 
             for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
                 Model::Face& face = **faceIt;
@@ -161,7 +162,7 @@ namespace TrenchBroom {
 
             Renderer::glSetEdgeOffset(0.3f);
 
-            Renderer::SetVboState activateVbo(vbo, Renderer::Vbo::VboActive);
+            Renderer::SetVboState activateVbo(streamVbo, Renderer::Vbo::VboActive);
             Renderer::ActivateShader shader(renderContext.shaderManager(), Renderer::Shaders::EdgeShader);
 
             glDisable(GL_DEPTH_TEST);
@@ -23,91 +23,116 @@
 #include "Model/Entity.h"
 #include "Model/EntityDefinitionManager.h"
 #include "Model/Face.h"
+#include "Utility/CommandProcessor.h"
 #include "Utility/Map.h"
 
 #include <cassert>
 
 namespace TrenchBroom {
     namespace Controller {
-        
-        EntitySnapshot::EntitySnapshot(const Model::Entity& entity) {
-            m_uniqueId = entity.uniqueId();
-            m_properties = entity.properties();
+        static void restoreAttributes(const FaceAttributeRecord& record, Model::Face& face) {
+            face.setXOffset(record.xOffset);
+            face.setYOffset(record.yOffset);
+            face.setRotation(record.rotation);
+            face.setXScale(record.xScale);
+            face.setYScale(record.yScale);
+            face.setTexture(record.texture);
+            if (record.texture == NULL)
+                face.setTextureName(record.textureName);
         }
         
+        EntitySnapshot::EntitySnapshot(SnapshotStore& store, const Model::Entity& entity) :
+        m_uniqueId(entity.uniqueId()),
+        m_properties(store.propertyRecord(entity.uniqueId(), entity.properties())) {}
+        
         unsigned int EntitySnapshot::uniqueId() {
             return m_uniqueId;
         }
         
         void EntitySnapshot::restore(Model::Entity& entity) {
-            entity.setProperties(m_properties, true);
+            Model::PropertyList properties;
+            m_properties->materialize(properties);
+            entity.setProperties(properties, true);
         }
         
-        BrushSnapshot::BrushSnapshot(const Model::Brush& brush) {
-            m_uniqueId = brush.uniqueId();
+        BrushSnapshot::BrushSnapshot(SnapshotStore& store, const Model::Brush& brush) :
+        m_uniqueId(brush.uniqueId()) {
             const Model::FaceList& brushFaces = brush.faces();
-            for (unsigned int i = 0; i < brushFaces.size(); i++) {
-                Model::Face* snapshot = new Model::Face(*brushFaces[i]);
-                m_faces.push_back(snapshot);
+            m_faces.resize(brushFaces.size());
+            for (size_t i = 0; i < brushFaces.size(); i++) {
+                const Model::Face& face = *brushFaces[i];
+                FaceRecord& record = m_faces[i];
+                record.faceId = face.faceId();
+                record.filePosition = face.filePosition();
+                record.plane = store.planeRecord(face);
+                record.attributes = store.attributeRecord(face);
             }
         }
         
-        BrushSnapshot::~BrushSnapshot() {
-            // must not delete the face snapshots because they are now in use by the original brush!
-        }
-        
         unsigned int BrushSnapshot::uniqueId() {
             return m_uniqueId;
         }
         
         void BrushSnapshot::restore(Model::Brush& brush) {
-            brush.restore(m_faces);
+            Model::FaceList faces;
+            faces.reserve(m_faces.size());
+            
+            FaceRecordList::const_iterator it, end;
+            for (it = m_faces.begin(), end = m_faces.end(); it != end; ++it) {
+                const FaceRecord& record = *it;
+                Model::Face* face = new Model::Face(brush.worldBounds(), brush.forceIntegerFacePoints(), record.faceId, record.plane->points, record.plane->boundary);
+                restoreAttributes(*record.attributes, *face);
+                face->setFilePosition(record.filePosition);
+                faces.push_back(face);
+            }
+            
+            brush.restore(faces);
         }
         
-        FaceSnapshot::FaceSnapshot(const Model::Face& face) {
-            m_faceId = face.faceId();
-            m_xOffset = face.xOffset();
-            m_yOffset = face.yOffset();
-            m_xScale = face.xScale();
-            m_yScale = face.yScale();
-            m_rotation = face.rotation();
-            m_texture = face.texture();
-            m_textureName = face.textureName();
-        }
+        FaceSnapshot::FaceSnapshot(SnapshotStore& store, const Model::Face& face) :
+        m_faceId(face.faceId()),
+        m_attributes(store.attributeRecord(face)) {}
         
         unsigned int FaceSnapshot::faceId() {
             return m_faceId;
         }
         
         void FaceSnapshot::restore(Model::Face& face) {
-            face.setXOffset(m_xOffset);
-            face.setYOffset(m_yOffset);
-            face.setRotation(m_rotation);
-            face.setXScale(m_xScale);
-            face.setYScale(m_yScale);
-            face.setTexture(m_texture);
-            if (m_texture == NULL)
-                face.setTextureName(m_textureName);
+            restoreAttributes(*m_attributes, face);
+        }
+        
+        SnapshotStore& SnapshotCommand::snapshotStore() const {
+            CommandProcessor* commandProcessor = static_cast<CommandProcessor*>(document().GetCommandProcessor());
+            return commandProcessor->snapshotStore();
         }
         
         void SnapshotCommand::makeSnapshots(const Model::EntityList& entities) {
+            SnapshotStore& store = snapshotStore();
             for (unsigned int i = 0; i < entities.size(); i++) {
                 Model::Entity& entity = *entities[i];
-                m_entities[entity.uniqueId()] = new EntitySnapshot(entity);
+                EntitySnapshot*& snapshot = m_entities[entity.uniqueId()];
+                delete snapshot;
+                snapshot = new EntitySnapshot(store, entity);
             }
         }
         
         void SnapshotCommand::makeSnapshots(const Model::BrushList& brushes) {
+            SnapshotStore& store = snapshotStore();
             for (unsigned int i = 0; i < brushes.size(); i++) {
                 Model::Brush& brush = *brushes[i];
-                m_brushes[brush.uniqueId()] = new BrushSnapshot(brush);
+                BrushSnapshot*& snapshot = m_brushes[brush.uniqueId()];
+                delete snapshot;
+                snapshot = new BrushSnapshot(store, brush);
             }
         }
         
         void SnapshotCommand::makeSnapshots(const Model::FaceList& faces) {
+            SnapshotStore& store = snapshotStore();
             for (unsigned int i = 0; i < faces.size(); i++) {
                 Model::Face& face = *faces[i];
-                m_faces[face.faceId()] = new FaceSnapshot(face);
+                FaceSnapshot*& snapshot = m_faces[face.faceId()];
+                delete snapshot;
+                snapshot = new FaceSnapshot(store, face);
             }
         }
         
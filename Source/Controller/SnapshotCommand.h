@@ -21,6 +21,7 @@
 #define __TrenchBroom__SnapshotCommand__
 
 #include "Controller/Command.h"
+#include "Controller/SnapshotStore.h"
 
 #include "Model/BrushTypes.h"
 #include "Model/EntityProperty.h"
@@ -28,33 +29,42 @@
 #include "Model/FaceTypes.h"
 #include "Utility/String.h"
 
+#include <vector>
 
 namespace TrenchBroom {
     namespace Model {
         class Brush;
         class Entity;
         class Face;
-        class Texture;
     }
     
     namespace Controller {
         class EntitySnapshot {
         private:
             unsigned int m_uniqueId;
-            Model::PropertyList m_properties;
+            PropertyRecord::Ptr m_properties;
         public:
-            EntitySnapshot(const Model::Entity& entity);
+            EntitySnapshot(SnapshotStore& store, const Model::Entity& entity);
             unsigned int uniqueId();
             void restore(Model::Entity& entity);
         };
         
         class BrushSnapshot {
         private:
+            class FaceRecord {
+            public:
+                unsigned int faceId;
+                size_t filePosition;
+                FacePlaneRecord::Ptr plane;
+                FaceAttributeRecord::Ptr attributes;
+            };
+            
+            typedef std::vector<FaceRecord> FaceRecordList;
+            
             unsigned int m_uniqueId;
-            Model::FaceList m_faces;
+            FaceRecordList m_faces;
         public:
-            BrushSnapshot(const Model::Brush& brush);
-            ~BrushSnapshot();
+            BrushSnapshot(SnapshotStore& store, const Model::Brush& brush);
             unsigned int uniqueId();
             void restore(Model::Brush& brush);
         };
@@ -62,15 +72,9 @@ namespace TrenchBroom {
         class FaceSnapshot {
         private:
             unsigned int m_faceId;
-            float m_xOffset;
-            float m_yOffset;
-            float m_xScale;
-            float m_yScale;
-            float m_rotation;
-            Model::Texture* m_texture;
-            String m_textureName;
+            FaceAttributeRecord::Ptr m_attributes;
         public:
-            FaceSnapshot(const Model::Face& face);
+            FaceSnapshot(SnapshotStore& store, const Model::Face& face);
             unsigned int faceId();
             void restore(Model::Face& face);
         };
@@ -84,6 +88,8 @@ namespace TrenchBroom {
             EntitySnapshotMap m_entities;
             BrushSnapshotMap m_brushes;
             FaceSnapshotMap m_faces;
+            
+            SnapshotStore& snapshotStore() const;
         protected:
             void makeSnapshots(const Model::EntityList& entities);
             void makeSnapshots(const Model::BrushList& brushes);
@@ -0,0 +1,271 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SnapshotStore.h"
+
+#include "Model/Face.h"
+
+#include <algorithm>
+
+namespace TrenchBroom {
+    namespace Controller {
+        FacePlaneRecord::FacePlaneRecord(const Model::Face& face) :
+        boundary(face.boundary()) {
+            face.getPoints(points[0], points[1], points[2]);
+        }
+        
+        bool FacePlaneRecord::matches(const Model::Face& face) const {
+            const Planef& faceBoundary = face.boundary();
+            return (points[0] == face.point(0) &&
+                    points[1] == face.point(1) &&
+                    points[2] == face.point(2) &&
+                    boundary.normal == faceBoundary.normal &&
+                    boundary.distance == faceBoundary.distance);
+        }
+        
+        size_t FacePlaneRecord::memorySize() const {
+            return sizeof(FacePlaneRecord);
+        }
+        
+        FaceAttributeRecord::FaceAttributeRecord(const Model::Face& face) :
+        textureName(face.textureName()),
+        texture(face.texture()),
+        xOffset(face.xOffset()),
+        yOffset(face.yOffset()),
+        rotation(face.rotation()),
+        xScale(face.xScale()),
+        yScale(face.yScale()) {}
+        
+        bool FaceAttributeRecord::matches(const Model::Face& face) const {
+            return (texture == face.texture() &&
+                    xOffset == face.xOffset() &&
+                    yOffset == face.yOffset() &&
+                    rotation == face.rotation() &&
+                    xScale == face.xScale() &&
+                    yScale == face.yScale() &&
+                    textureName == face.textureName());
+        }
+        
+        size_t FaceAttributeRecord::memorySize() const {
+            return sizeof(FaceAttributeRecord) + textureName.capacity();
+        }
+        
+        bool PropertyRecord::equals(const Model::PropertyList& left, const Model::PropertyList& right) {
+            if (left.size() != right.size())
+                return false;
+            for (size_t i = 0; i < left.size(); i++)
+                if (left[i].key() != right[i].key() || left[i].value() != right[i].value())
+                    return false;
+            return true;
+        }
+        
+        bool PropertyRecord::makeDelta(const Model::PropertyList& properties) {
+            Model::PropertyList baseProperties;
+            m_base->materialize(baseProperties);
+            
+            Model::PropertyMap baseMap;
+            Model::PropertyList::const_iterator it, end;
+            for (it = baseProperties.begin(), end = baseProperties.end(); it != end; ++it)
+                baseMap[it->key()] = *it;
+            
+            Model::PropertyKeySet keys;
+            for (it = properties.begin(), end = properties.end(); it != end; ++it) {
+                const Model::Property& property = *it;
+                keys.insert(property.key());
+                Model::PropertyMap::const_iterator baseIt = baseMap.find(property.key());
+                if (baseIt == baseMap.end() || baseIt->second.value() != property.value())
+                    m_properties.push_back(property);
+            }
+            
+            for (it = baseProperties.begin(), end = baseProperties.end(); it != end; ++it)
+                if (keys.count(it->key()) == 0)
+                    m_removedKeys.push_back(it->key());
+            
+            // deltas cannot express reordered properties, so check that the delta reproduces the list exactly
+            Model::PropertyList restored;
+            materialize(restored);
+            return equals(restored, properties);
+        }
+        
+        size_t PropertyRecord::memorySize() const {
+            size_t size = sizeof(PropertyRecord) + m_properties.capacity() * sizeof(Model::Property) + m_removedKeys.capacity() * sizeof(Model::PropertyKey);
+            
+            Model::PropertyList::const_iterator it, end;
+            for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it)
+                size += it->key().capacity() + it->value().capacity();
+            
+            Model::PropertyKeyList::const_iterator keyIt, keyEnd;
+            for (keyIt = m_removedKeys.begin(), keyEnd = m_removedKeys.end(); keyIt != keyEnd; ++keyIt)
+                size += keyIt->capacity();
+            return size;
+        }
+        
+        PropertyRecord::PropertyRecord(const Model::PropertyList& properties, Ptr base) :
+        m_base(base),
+        m_depth(0) {
+            if (m_base.get() != NULL && m_base->m_depth < MaxDeltaDepth) {
+                m_depth = m_base->m_depth + 1;
+                if (!makeDelta(properties)) {
+                    Model::PropertyList().swap(m_properties);
+                    Model::PropertyKeyList().swap(m_removedKeys);
+                    m_base = Ptr();
+                }
+            } else {
+                m_base = Ptr();
+            }
+            
+            if (m_base.get() == NULL) {
+                m_depth = 0;
+                m_properties = properties;
+            }
+        }
+        
+        bool PropertyRecord::matches(const Model::PropertyList& properties) const {
+            if (m_base.get() == NULL)
+                return equals(m_properties, properties);
+            
+            Model::PropertyList restored;
+            materialize(restored);
+            return equals(restored, properties);
+        }
+        
+        void PropertyRecord::materialize(Model::PropertyList& properties) const {
+            if (m_base.get() == NULL) {
+                properties = m_properties;
+                return;
+            }
+            
+            m_base->materialize(properties);
+            
+            Model::PropertyKeyList::const_iterator keyIt, keyEnd;
+            for (keyIt = m_removedKeys.begin(), keyEnd = m_removedKeys.end(); keyIt != keyEnd; ++keyIt) {
+                const Model::PropertyKey& key = *keyIt;
+                Model::PropertyList::iterator propertyIt, propertyEnd;
+                for (propertyIt = properties.begin(), propertyEnd = properties.end(); propertyIt != propertyEnd; ++propertyIt) {
+                    if (propertyIt->key() == key) {
+                        properties.erase(propertyIt);
+                        break;
+                    }
+                }
+            }
+            
+            Model::PropertyList::const_iterator it, end;
+            for (it = m_properties.begin(), end = m_properties.end(); it != end; ++it) {
+                const Model::Property& property = *it;
+                Model::PropertyList::iterator propertyIt, propertyEnd;
+                for (propertyIt = properties.begin(), propertyEnd = properties.end(); propertyIt != propertyEnd; ++propertyIt) {
+                    if (propertyIt->key() == property.key()) {
+                        propertyIt->setValue(property.value());
+                        break;
+                    }
+                }
+                if (propertyIt == propertyEnd)
+                    properties.push_back(property);
+            }
+        }
+        
+        void SnapshotStore::pruneCaches() {
+            FacePlaneCache::iterator planeIt = m_planes.begin();
+            while (planeIt != m_planes.end()) {
+                if (planeIt->second.expired())
+                    m_planes.erase(planeIt++);
+                else
+                    ++planeIt;
+            }
+            
+            FaceAttributeCache::iterator attributeIt = m_attributes.begin();
+            while (attributeIt != m_attributes.end()) {
+                if (attributeIt->second.expired())
+                    m_attributes.erase(attributeIt++);
+                else
+                    ++attributeIt;
+            }
+            
+            PropertyCache::iterator propertyIt = m_properties.begin();
+            while (propertyIt != m_properties.end()) {
+                if (propertyIt->second.expired())
+                    m_properties.erase(propertyIt++);
+                else
+                    ++propertyIt;
+            }
+            
+            const size_t size = m_planes.size() + m_attributes.size() + m_properties.size();
+            m_pruneThreshold = std::max(static_cast<size_t>(1024), 2 * size);
+        }
+        
+        SnapshotStore::SnapshotStore() :
+        m_pruneThreshold(1024),
+        m_memoryUsage(0),
+        m_recordCount(0) {}
+        
+        SnapshotStore::~SnapshotStore() {
+            assert(m_recordCount == 0);
+        }
+        
+        FacePlaneRecord::Ptr SnapshotStore::planeRecord(const Model::Face& face) {
+            FacePlaneRef& ref = m_planes[face.faceId()];
+            FacePlaneRecord::Ptr record = ref.lock();
+            if (record.get() == NULL || !record->matches(face)) {
+                record = addRecord(new FacePlaneRecord(face));
+                ref = record;
+                if (m_planes.size() > m_pruneThreshold)
+                    pruneCaches();
+            }
+            return record;
+        }
+        
+        FaceAttributeRecord::Ptr SnapshotStore::attributeRecord(const Model::Face& face) {
+            FaceAttributeRef& ref = m_attributes[face.faceId()];
+            FaceAttributeRecord::Ptr record = ref.lock();
+            if (record.get() == NULL || !record->matches(face)) {
+                record = addRecord(new FaceAttributeRecord(face));
+                ref = record;
+                if (m_attributes.size() > m_pruneThreshold)
+                    pruneCaches();
+            }
+            return record;
+        }
+        
+        PropertyRecord::Ptr SnapshotStore::propertyRecord(unsigned int entityId, const Model::PropertyList& properties) {
+            PropertyRef& ref = m_properties[entityId];
+            PropertyRecord::Ptr record = ref.lock();
+            if (record.get() == NULL || !record->matches(properties)) {
+                record = addRecord(new PropertyRecord(properties, record));
+                ref = record;
+                if (m_properties.size() > m_pruneThreshold)
+                    pruneCaches();
+            }
+            return record;
+        }
+        
+        size_t SnapshotStore::trimHistory(SnapshotHistory& history, size_t budget) {
+            size_t dropped = 0;
+            while (m_memoryUsage > budget && history.canDropOldestLevel()) {
+                const size_t memoryUsage = m_memoryUsage;
+                history.dropOldestLevel();
+                dropped++;
+                
+                // the records of the dropped level are still used by newer levels, e.g. as the base of a delta chain
+                if (m_memoryUsage >= memoryUsage)
+                    break;
+            }
+            return dropped;
+        }
+    }
+}
@@ -0,0 +1,205 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__SnapshotStore__
+#define __TrenchBroom__SnapshotStore__
+
+#include "Model/EntityProperty.h"
+#include "Model/FaceTypes.h"
+#include "Utility/SharedPointer.h"
+#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <map>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class Face;
+        class Texture;
+    }
+    
+    namespace Controller {
+        /**
+         * The immutable plane of a face as recorded for undo. Records are reference counted and shared between all
+         * snapshots that were taken while the face had the same plane.
+         */
+        class FacePlaneRecord {
+        public:
+            typedef std::tr1::shared_ptr<const FacePlaneRecord> Ptr;
+            
+            Vec3f points[3];
+            Planef boundary;
+            
+            FacePlaneRecord(const Model::Face& face);
+            
+            bool matches(const Model::Face& face) const;
+            size_t memorySize() const;
+        };
+        
+        /**
+         * The immutable texture attributes of a face as recorded for undo, shared like the plane records.
+         */
+        class FaceAttributeRecord {
+        public:
+            typedef std::tr1::shared_ptr<const FaceAttributeRecord> Ptr;
+            
+            String textureName;
+            Model::Texture* texture;
+            float xOffset;
+            float yOffset;
+            float rotation;
+            float xScale;
+            float yScale;
+            
+            FaceAttributeRecord(const Model::Face& face);
+            
+            bool matches(const Model::Face& face) const;
+            size_t memorySize() const;
+        };
+        
+        /**
+         * The immutable properties of an entity as recorded for undo. A record either holds the complete property
+         * list or only the properties which differ from a base record.
+         */
+        class PropertyRecord {
+        public:
+            typedef std::tr1::shared_ptr<const PropertyRecord> Ptr;
+        private:
+            static const size_t MaxDeltaDepth = 16;
+            
+            Ptr m_base;
+            size_t m_depth;
+            Model::PropertyList m_properties;    // all properties, or the changed and added ones if there is a base
+            Model::PropertyKeyList m_removedKeys;
+            
+            static bool equals(const Model::PropertyList& left, const Model::PropertyList& right);
+            bool makeDelta(const Model::PropertyList& properties);
+        public:
+            PropertyRecord(const Model::PropertyList& properties, Ptr base);
+            
+            /**
+             * Returns the number of records in the delta chain which ends with this record, including this record.
+             */
+            inline size_t chainLength() const {
+                return m_depth + 1;
+            }
+            
+            bool matches(const Model::PropertyList& properties) const;
+            void materialize(Model::PropertyList& properties) const;
+            size_t memorySize() const;
+        };
+        
+        /**
+         * An undo history whose levels hold snapshot records. Levels are dropped oldest first to free their records.
+         */
+        class SnapshotHistory {
+        public:
+            virtual ~SnapshotHistory() {}
+            
+            virtual bool canDropOldestLevel() const = 0;
+            virtual void dropOldestLevel() = 0;
+        };
+        
+        /**
+         * Hands out the records for undo snapshots. Unchanged faces and entities share the record of the previous
+         * snapshot, and changed entities are stored as a delta against it. Also keeps track of the memory used by all
+         * live records so that the undo history can be kept within its budget. Every document has its own store, which
+         * must outlive all records it has handed out. Must only be used from the main thread.
+         */
+        class SnapshotStore {
+        private:
+            template <class Record>
+            class RecordDeleter {
+            public:
+                SnapshotStore* store;
+                size_t bytes;
+                
+                RecordDeleter(SnapshotStore* i_store, size_t i_bytes) :
+                store(i_store),
+                bytes(i_bytes) {}
+                
+                inline void operator()(const Record* record) const {
+                    store->removeRecord(bytes);
+                    delete record;
+                }
+            };
+            
+            typedef std::tr1::weak_ptr<const FacePlaneRecord> FacePlaneRef;
+            typedef std::tr1::weak_ptr<const FaceAttributeRecord> FaceAttributeRef;
+            typedef std::tr1::weak_ptr<const PropertyRecord> PropertyRef;
+            typedef std::map<unsigned int, FacePlaneRef> FacePlaneCache;
+            typedef std::map<unsigned int, FaceAttributeRef> FaceAttributeCache;
+            typedef std::map<unsigned int, PropertyRef> PropertyCache;
+            
+            FacePlaneCache m_planes;
+            FaceAttributeCache m_attributes;
+            PropertyCache m_properties;
+            size_t m_pruneThreshold;
+            size_t m_memoryUsage;
+            size_t m_recordCount;
+            
+            void pruneCaches();
+            
+            inline void removeRecord(size_t bytes) {
+                assert(m_memoryUsage >= bytes && m_recordCount > 0);
+                m_memoryUsage -= bytes;
+                m_recordCount--;
+            }
+            
+            template <class Record>
+            std::tr1::shared_ptr<const Record> addRecord(const Record* record) {
+                const size_t bytes = record->memorySize();
+                m_memoryUsage += bytes;
+                m_recordCount++;
+                return std::tr1::shared_ptr<const Record>(record, RecordDeleter<Record>(this, bytes));
+            }
+        public:
+            SnapshotStore();
+            ~SnapshotStore();
+            
+            FacePlaneRecord::Ptr planeRecord(const Model::Face& face);
+            FaceAttributeRecord::Ptr attributeRecord(const Model::Face& face);
+            PropertyRecord::Ptr propertyRecord(unsigned int entityId, const Model::PropertyList& properties);
+            
+            /**
+             * Drops the oldest levels of the given history until the live records use at most the given number of
+             * bytes. Since records are shared between levels, dropping a level may not free any memory, so trimming
+             * stops at the first level whose removal does not reduce the memory usage. Returns the number of dropped
+             * levels.
+             */
+            size_t trimHistory(SnapshotHistory& history, size_t budget);
+            
+            /**
+             * Returns the approximate number of bytes used by all records that are still referenced by a snapshot.
+             */
+            inline size_t memoryUsage() const {
+                return m_memoryUsage;
+            }
+            
+            inline size_t recordCount() const {
+                return m_recordCount;
+            }
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__SnapshotStore__) */
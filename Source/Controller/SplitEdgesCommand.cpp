@@ -19,6 +19,7 @@
 
 #include "SplitEdgesCommand.h"
 
+#include "Controller/BrushEditTask.h"
 #include "Controller/VertexHandleManager.h"
 #include "Model/Brush.h"
 #include "Model/BrushGeometry.h"
@@ -27,39 +28,34 @@
 namespace TrenchBroom {
     namespace Controller {
         bool SplitEdgesCommand::performDo() {
-            if (!canDo())
+            BrushEditTask<Model::EdgeInfoList> task(m_brushes, m_brushEdges, &Model::Brush::prepareSplitEdges, m_delta);
+            if (!task.prepare())
                 return false;
-            
-            m_handleManager.remove(m_brushes);
+
             makeSnapshots(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
-            m_verticesAfter.clear();
+            task.commit();
 
-            Model::BrushEdgesMap::const_iterator bIt, bEnd;
-            for (bIt = m_brushEdges.begin(), bEnd = m_brushEdges.end(); bIt != bEnd; ++bIt) {
-                Model::Brush* brush = bIt->first;
-                const Model::EdgeInfoList& edgeInfos = bIt->second;
-                Model::EdgeInfoList::const_iterator eIt, eEnd;
-                for (eIt = edgeInfos.begin(), eEnd = edgeInfos.end(); eIt != eEnd; ++eIt) {
-                    const Model::EdgeInfo& edgeInfo = *eIt;
-                    const Vec3f newVertexPosition = brush->splitEdge(edgeInfo, m_delta);
-                    m_verticesAfter.insert(newVertexPosition);
-                }
+            m_verticesAfter.clear();
+            for (size_t i = 0; i < m_brushes.size(); i++) {
+                const Vec3f::List& newVertexPositions = task.edit(i).vertices;
+                m_verticesAfter.insert(newVertexPositions.begin(), newVertexPositions.end());
             }
 
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectVertexHandles(m_verticesAfter);
 
             return true;
         }
-        
+
         bool SplitEdgesCommand::performUndo() {
-            m_handleManager.remove(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
             restoreSnapshots(m_brushes);
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectEdgeHandles(m_edgesBefore);
 
             return true;
@@ -91,20 +87,5 @@ namespace TrenchBroom {
         SplitEdgesCommand* SplitEdgesCommand::splitEdges(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta) {
             return new SplitEdgesCommand(document, handleManager.selectedEdgeHandles().size() == 1 ? wxT("Split Edge") : wxT("Split Edges"), handleManager, delta);
         }
-
-        bool SplitEdgesCommand::canDo() const {
-            Model::BrushEdgesMap::const_iterator bIt, bEnd;
-            for (bIt = m_brushEdges.begin(), bEnd = m_brushEdges.end(); bIt != bEnd; ++bIt) {
-                Model::Brush* brush = bIt->first;
-                const Model::EdgeInfoList& edgeInfos = bIt->second;
-                Model::EdgeInfoList::const_iterator eIt, eEnd;
-                for (eIt = edgeInfos.begin(), eEnd = edgeInfos.end(); eIt != eEnd; ++eIt) {
-                    const Model::EdgeInfo& edgeInfo = *eIt;
-                    if (!brush->canSplitEdge(edgeInfo, m_delta))
-                        return false;
-                }
-            }
-            return true;
-        }
     }
 }
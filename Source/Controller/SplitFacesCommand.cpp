@@ -19,6 +19,7 @@
 
 #include "SplitFacesCommand.h"
 
+#include "Controller/BrushEditTask.h"
 #include "Controller/VertexHandleManager.h"
 #include "Model/Brush.h"
 #include "Model/BrushGeometry.h"
@@ -27,39 +28,34 @@
 namespace TrenchBroom {
     namespace Controller {
         bool SplitFacesCommand::performDo() {
-            if (!canDo())
+            BrushEditTask<Model::FaceInfoList> task(m_brushes, m_brushFaces, &Model::Brush::prepareSplitFaces, m_delta);
+            if (!task.prepare())
                 return false;
-            
-            m_handleManager.remove(m_brushes);
+
             makeSnapshots(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
-            m_verticesAfter.clear();
+            task.commit();
 
-            Model::BrushFacesMap::const_iterator bIt, bEnd;
-            for (bIt = m_brushFaces.begin(), bEnd = m_brushFaces.end(); bIt != bEnd; ++bIt) {
-                Model::Brush* brush = bIt->first;
-                const Model::FaceInfoList& faceInfos = bIt->second;
-                Model::FaceInfoList::const_iterator fIt, fEnd;
-                for (fIt = faceInfos.begin(), fEnd = faceInfos.end(); fIt != fEnd; ++fIt) {
-                    const Model::FaceInfo& faceInfo = *fIt;
-                    Vec3f newVertexPosition = brush->splitFace(faceInfo, m_delta);
-                    m_verticesAfter.insert(newVertexPosition);
-                }
+            m_verticesAfter.clear();
+            for (size_t i = 0; i < m_brushes.size(); i++) {
+                const Vec3f::List& newVertexPositions = task.edit(i).vertices;
+                m_verticesAfter.insert(newVertexPositions.begin(), newVertexPositions.end());
             }
 
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectVertexHandles(m_verticesAfter);
 
             return true;
         }
-        
+
         bool SplitFacesCommand::performUndo() {
-            m_handleManager.remove(m_brushes);
+            m_handleManager.brushesWillChange(m_brushes);
             document().brushesWillChange(m_brushes);
             restoreSnapshots(m_brushes);
             document().brushesDidChange(m_brushes);
-            m_handleManager.add(m_brushes);
+            m_handleManager.brushesDidChange(m_brushes);
             m_handleManager.selectFaceHandles(m_facesBefore);
             
             return true;
@@ -94,20 +90,5 @@ namespace TrenchBroom {
         SplitFacesCommand* SplitFacesCommand::splitFaces(Model::MapDocument& document, VertexHandleManager& handleManager, const Vec3f& delta) {
             return new SplitFacesCommand(document, handleManager.selectedFaceHandles().size() == 1 ? wxT("Split Face") : wxT("Split Faces"), handleManager, delta);
         }
-
-        bool SplitFacesCommand::canDo() const {
-            Model::BrushFacesMap::const_iterator bIt, bEnd;
-            for (bIt = m_brushFaces.begin(), bEnd = m_brushFaces.end(); bIt != bEnd; ++bIt) {
-                Model::Brush* brush = bIt->first;
-                const Model::FaceInfoList& faceInfos = bIt->second;
-                Model::FaceInfoList::const_iterator fIt, fEnd;
-                for (fIt = faceInfos.begin(), fEnd = faceInfos.end(); fIt != fEnd; ++fIt) {
-                    const Model::FaceInfo& faceInfo = *fIt;
-                    if (!brush->canSplitFace(faceInfo, m_delta))
-                        return false;
-                }
-            }
-            return true;
-        }
     }
 }
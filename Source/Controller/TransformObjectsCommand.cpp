@@ -97,7 +97,10 @@ namespace TrenchBroom {
 
         TransformObjectsCommand* TransformObjectsCommand::rotateObjects(Model::MapDocument& document, const Model::EntityList& entities, const Model::BrushList& brushes, const Vec3f& axis, float angle, bool clockwise, const Vec3f& center) {
             const wxString commandName = Command::makeObjectActionName(wxT("Rotate"), entities, brushes);
-            const Mat4f vectorTransform = clockwise ? rotationMatrix(-angle, axis) : rotationMatrix(angle, axis);
+            Mat4f vectorTransform = clockwise ? rotationMatrix(-angle, axis) : rotationMatrix(angle, axis);
+            // remove rounding errors from quarter turns so that the brushes can keep their geometry
+            if (axisPermutationMatrix(vectorTransform))
+                vectorTransform.correct();
             const Mat4f pointTransform = translationMatrix(center) * vectorTransform * translationMatrix(-center);
             return new TransformObjectsCommand(document, entities, brushes, commandName, pointTransform, vectorTransform, false);
         }
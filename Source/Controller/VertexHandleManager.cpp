@@ -38,36 +38,164 @@ namespace TrenchBroom {
     }
 
     namespace Controller {
+        void VertexHandleManager::pickHandles(const Rayf& ray, const HandleGrid& grid, Model::HitType::Type type, Model::PickResult& pickResult) const {
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            float handleRadius = prefs.getFloat(Preferences::HandleRadius);
+            float scalingFactor = prefs.getFloat(Preferences::HandleScalingFactor);
+            float maxDistance = prefs.getFloat(Preferences::MaximumHandleDistance);
+
+            Vec3f::List positions;
+            grid.findHandles(ray, 2.0f * handleRadius, scalingFactor, maxDistance, positions);
+
+            Vec3f::List::const_iterator it, end;
+            for (it = positions.begin(), end = positions.end(); it != end; ++it) {
+                Model::VertexHandleHit* hit = pickHandle(ray, *it, type);
+                if (hit != NULL)
+                    pickResult.add(hit);
+            }
+        }
+
+        void VertexHandleManager::removeHandles(Model::Brush& brush) {
+            const Model::VertexList& brushVertices = brush.vertices();
+            Model::VertexList::const_iterator vIt, vEnd;
+            for (vIt = brushVertices.begin(), vEnd = brushVertices.end(); vIt != vEnd; ++vIt) {
+                const Model::Vertex& vertex = **vIt;
+                if (m_selectedVertexHandles.remove(vertex.position, brush)) {
+                    assert(m_selectedVertexCount > 0);
+                    m_selectedVertexCount--;
+                } else {
+                    m_unselectedVertexHandles.remove(vertex.position, brush);
+                }
+            }
+            assert(m_totalVertexCount >= brushVertices.size());
+            m_totalVertexCount -= brushVertices.size();
+
+            const Model::EdgeList& brushEdges = brush.edges();
+            Model::EdgeList::const_iterator eIt, eEnd;
+            for (eIt = brushEdges.begin(), eEnd = brushEdges.end(); eIt != eEnd; ++eIt) {
+                Model::Edge& edge = **eIt;
+                Vec3f position = edge.center();
+                if (m_selectedEdgeHandles.remove(position, edge)) {
+                    assert(m_selectedEdgeCount > 0);
+                    m_selectedEdgeCount--;
+                } else {
+                    m_unselectedEdgeHandles.remove(position, edge);
+                }
+            }
+            assert(m_totalEdgeCount >= brushEdges.size());
+            m_totalEdgeCount -= brushEdges.size();
+
+            const Model::FaceList& brushFaces = brush.faces();
+            Model::FaceList::const_iterator fIt, fEnd;
+            for (fIt = brushFaces.begin(), fEnd = brushFaces.end(); fIt != fEnd; ++fIt) {
+                Model::Face& face = **fIt;
+                Vec3f position = face.center();
+                if (m_selectedFaceHandles.remove(position, face)) {
+                    assert(m_selectedFaceCount > 0);
+                    m_selectedFaceCount--;
+                } else {
+                    m_unselectedFaceHandles.remove(position, face);
+                }
+            }
+            assert(m_totalFaceCount >= brushFaces.size());
+            m_totalFaceCount -= brushFaces.size();
+        }
+
+        void VertexHandleManager::addHandles(Model::Brush& brush) {
+            const Model::VertexList& brushVertices = brush.vertices();
+            Model::VertexList::const_iterator vIt, vEnd;
+            for (vIt = brushVertices.begin(), vEnd = brushVertices.end(); vIt != vEnd; ++vIt) {
+                const Model::Vertex& vertex = **vIt;
+                if (m_selectedVertexHandles.contains(vertex.position)) {
+                    m_selectedVertexHandles.add(vertex.position, brush);
+                    m_selectedVertexCount++;
+                } else {
+                    m_unselectedVertexHandles.add(vertex.position, brush);
+                }
+            }
+            m_totalVertexCount += brushVertices.size();
+
+            const Model::EdgeList& brushEdges = brush.edges();
+            Model::EdgeList::const_iterator eIt, eEnd;
+            for (eIt = brushEdges.begin(), eEnd = brushEdges.end(); eIt != eEnd; ++eIt) {
+                Model::Edge& edge = **eIt;
+                Vec3f position = edge.center();
+                if (m_selectedEdgeHandles.contains(position)) {
+                    m_selectedEdgeHandles.add(position, edge);
+                    m_selectedEdgeCount++;
+                } else {
+                    m_unselectedEdgeHandles.add(position, edge);
+                }
+            }
+            m_totalEdgeCount+= brushEdges.size();
+
+            const Model::FaceList& brushFaces = brush.faces();
+            Model::FaceList::const_iterator fIt, fEnd;
+            for (fIt = brushFaces.begin(), fEnd = brushFaces.end(); fIt != fEnd; ++fIt) {
+                Model::Face& face = **fIt;
+                Vec3f position = face.center();
+                if (m_selectedFaceHandles.contains(position)) {
+                    m_selectedFaceHandles.add(position, face);
+                    m_selectedFaceCount++;
+                } else {
+                    m_unselectedFaceHandles.add(position, face);
+                }
+            }
+            m_totalFaceCount += brushFaces.size();
+        }
+
         void VertexHandleManager::createRenderers() {
-            assert(m_selectedHandleRenderer == NULL);
             assert(m_unselectedVertexHandleRenderer == NULL);
+            assert(m_selectedVertexHandleRenderer == NULL);
             assert(m_unselectedEdgeHandleRenderer == NULL);
+            assert(m_selectedEdgeHandleRenderer == NULL);
             assert(m_unselectedFaceHandleRenderer == NULL);
+            assert(m_selectedFaceHandleRenderer == NULL);
             assert(m_selectedEdgeRenderer == NULL);
 
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             float handleRadius = prefs.getFloat(Preferences::HandleRadius);
             float scalingFactor = prefs.getFloat(Preferences::HandleScalingFactor);
             float maxDistance = prefs.getFloat(Preferences::MaximumHandleDistance);
-            m_selectedHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
             m_unselectedVertexHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
+            m_selectedVertexHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
             m_unselectedEdgeHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
+            m_selectedEdgeHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
             m_unselectedFaceHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
+            m_selectedFaceHandleRenderer = Renderer::PointHandleRenderer::create(handleRadius, 2, scalingFactor, maxDistance);
             m_selectedEdgeRenderer = new Renderer::LinesRenderer();
             
+            m_unselectedVertexHandles.setRenderer(m_unselectedVertexHandleRenderer);
+            m_selectedVertexHandles.setRenderer(m_selectedVertexHandleRenderer);
+            m_unselectedEdgeHandles.setRenderer(m_unselectedEdgeHandleRenderer);
+            m_selectedEdgeHandles.setRenderer(m_selectedEdgeHandleRenderer);
+            m_unselectedFaceHandles.setRenderer(m_unselectedFaceHandleRenderer);
+            m_selectedFaceHandles.setRenderer(m_selectedFaceHandleRenderer);
+
             m_renderStateValid = false;
             m_recreateRenderers = false;
         }
         
         void VertexHandleManager::destroyRenderers() {
+            m_unselectedVertexHandles.setRenderer(NULL);
+            m_selectedVertexHandles.setRenderer(NULL);
+            m_unselectedEdgeHandles.setRenderer(NULL);
+            m_selectedEdgeHandles.setRenderer(NULL);
+            m_unselectedFaceHandles.setRenderer(NULL);
+            m_selectedFaceHandles.setRenderer(NULL);
+
             delete m_unselectedVertexHandleRenderer;
             m_unselectedVertexHandleRenderer = NULL;
+            delete m_selectedVertexHandleRenderer;
+            m_selectedVertexHandleRenderer = NULL;
             delete m_unselectedEdgeHandleRenderer;
             m_unselectedEdgeHandleRenderer = NULL;
+            delete m_selectedEdgeHandleRenderer;
+            m_selectedEdgeHandleRenderer = NULL;
             delete m_unselectedFaceHandleRenderer;
             m_unselectedFaceHandleRenderer = NULL;
-            delete m_selectedHandleRenderer;
-            m_selectedHandleRenderer = NULL;
+            delete m_selectedFaceHandleRenderer;
+            m_selectedFaceHandleRenderer = NULL;
             delete m_selectedEdgeRenderer;
             m_selectedEdgeRenderer = NULL;
         }
@@ -79,89 +207,48 @@ namespace TrenchBroom {
         m_selectedEdgeCount(0),
         m_totalFaceCount(0),
         m_selectedFaceCount(0),
-        m_selectedHandleRenderer(NULL),
         m_unselectedVertexHandleRenderer(NULL),
+        m_selectedVertexHandleRenderer(NULL),
         m_unselectedEdgeHandleRenderer(NULL),
+        m_selectedEdgeHandleRenderer(NULL),
         m_unselectedFaceHandleRenderer(NULL),
+        m_selectedFaceHandleRenderer(NULL),
         m_selectedEdgeRenderer(NULL),
         m_renderStateValid(false),
         m_recreateRenderers(true) {}
         
         const Model::BrushList& VertexHandleManager::brushes(const Vec3f& handlePosition) const {
-            Model::VertexToBrushesMap::const_iterator mapIt = m_selectedVertexHandles.find(handlePosition);
-            if (mapIt != m_selectedVertexHandles.end())
+            Model::VertexToBrushesMap::const_iterator mapIt = m_selectedVertexHandles.handles().find(handlePosition);
+            if (mapIt != m_selectedVertexHandles.handles().end())
                 return mapIt->second;
-            mapIt = m_unselectedVertexHandles.find(handlePosition);
-            if (mapIt != m_unselectedVertexHandles.end())
+            mapIt = m_unselectedVertexHandles.handles().find(handlePosition);
+            if (mapIt != m_unselectedVertexHandles.handles().end())
                 return mapIt->second;
             return Model::EmptyBrushList;
         }
 
         const Model::EdgeList& VertexHandleManager::edges(const Vec3f& handlePosition) const {
-            Model::VertexToEdgesMap::const_iterator mapIt = m_selectedEdgeHandles.find(handlePosition);
-            if (mapIt != m_selectedEdgeHandles.end())
+            Model::VertexToEdgesMap::const_iterator mapIt = m_selectedEdgeHandles.handles().find(handlePosition);
+            if (mapIt != m_selectedEdgeHandles.handles().end())
                 return mapIt->second;
-            mapIt = m_unselectedEdgeHandles.find(handlePosition);
-            if (mapIt != m_unselectedEdgeHandles.end())
+            mapIt = m_unselectedEdgeHandles.handles().find(handlePosition);
+            if (mapIt != m_unselectedEdgeHandles.handles().end())
                 return mapIt->second;
             return Model::EmptyEdgeList;
         }
 
         const Model::FaceList& VertexHandleManager::faces(const Vec3f& handlePosition) const {
-            Model::VertexToFacesMap::const_iterator mapIt = m_selectedFaceHandles.find(handlePosition);
-            if (mapIt != m_selectedFaceHandles.end())
+            Model::VertexToFacesMap::const_iterator mapIt = m_selectedFaceHandles.handles().find(handlePosition);
+            if (mapIt != m_selectedFaceHandles.handles().end())
                 return mapIt->second;
-            mapIt = m_unselectedFaceHandles.find(handlePosition);
-            if (mapIt != m_unselectedFaceHandles.end())
+            mapIt = m_unselectedFaceHandles.handles().find(handlePosition);
+            if (mapIt != m_unselectedFaceHandles.handles().end())
                 return mapIt->second;
             return Model::EmptyFaceList;
         }
 
         void VertexHandleManager::add(Model::Brush& brush) {
-            const Model::VertexList& brushVertices = brush.vertices();
-            Model::VertexList::const_iterator vIt, vEnd;
-            for (vIt = brushVertices.begin(), vEnd = brushVertices.end(); vIt != vEnd; ++vIt) {
-                const Model::Vertex& vertex = **vIt;
-                Model::VertexToBrushesMap::iterator mapIt = m_selectedVertexHandles.find(vertex.position);
-                if (mapIt != m_selectedVertexHandles.end()) {
-                    mapIt->second.push_back(&brush);
-                    m_selectedVertexCount++;
-                } else {
-                    m_unselectedVertexHandles[vertex.position].push_back(&brush);
-                }
-            }
-            m_totalVertexCount += brushVertices.size();
-
-            const Model::EdgeList& brushEdges = brush.edges();
-            Model::EdgeList::const_iterator eIt, eEnd;
-            for (eIt = brushEdges.begin(), eEnd = brushEdges.end(); eIt != eEnd; ++eIt) {
-                Model::Edge& edge = **eIt;
-                Vec3f position = edge.center();
-                Model::VertexToEdgesMap::iterator mapIt = m_selectedEdgeHandles.find(position);
-                if (mapIt != m_selectedEdgeHandles.end()) {
-                    mapIt->second.push_back(&edge);
-                    m_selectedEdgeCount++;
-                } else {
-                    m_unselectedEdgeHandles[position].push_back(&edge);
-                }
-            }
-            m_totalEdgeCount+= brushEdges.size();
-
-            const Model::FaceList& brushFaces = brush.faces();
-            Model::FaceList::const_iterator fIt, fEnd;
-            for (fIt = brushFaces.begin(), fEnd = brushFaces.end(); fIt != fEnd; ++fIt) {
-                Model::Face& face = **fIt;
-                Vec3f position = face.center();
-                Model::VertexToFacesMap::iterator mapIt = m_selectedFaceHandles.find(position);
-                if (mapIt != m_selectedFaceHandles.end()) {
-                    mapIt->second.push_back(&face);
-                    m_selectedFaceCount++;
-                } else {
-                    m_unselectedFaceHandles[position].push_back(&face);
-                }
-            }
-            m_totalFaceCount += brushFaces.size();
-
+            addHandles(brush);
             m_renderStateValid = false;
         }
 
@@ -172,50 +259,7 @@ namespace TrenchBroom {
         }
 
         void VertexHandleManager::remove(Model::Brush& brush) {
-            const Model::VertexList& brushVertices = brush.vertices();
-            Model::VertexList::const_iterator vIt, vEnd;
-            for (vIt = brushVertices.begin(), vEnd = brushVertices.end(); vIt != vEnd; ++vIt) {
-                const Model::Vertex& vertex = **vIt;
-                if (removeHandle(vertex.position, brush, m_selectedVertexHandles)) {
-                    assert(m_selectedVertexCount > 0);
-                    m_selectedVertexCount--;
-                } else {
-                    removeHandle(vertex.position, brush, m_unselectedVertexHandles);
-                }
-            }
-            assert(m_totalVertexCount >= brushVertices.size());
-            m_totalVertexCount -= brushVertices.size();
-
-            const Model::EdgeList& brushEdges = brush.edges();
-            Model::EdgeList::const_iterator eIt, eEnd;
-            for (eIt = brushEdges.begin(), eEnd = brushEdges.end(); eIt != eEnd; ++eIt) {
-                Model::Edge& edge = **eIt;
-                Vec3f position = edge.center();
-                if (removeHandle(position, edge, m_selectedEdgeHandles)) {
-                    assert(m_selectedEdgeCount > 0);
-                    m_selectedEdgeCount--;
-                } else {
-                    removeHandle(position, edge, m_unselectedEdgeHandles);
-                }
-            }
-            assert(m_totalEdgeCount >= brushEdges.size());
-            m_totalEdgeCount -= brushEdges.size();
-
-            const Model::FaceList& brushFaces = brush.faces();
-            Model::FaceList::const_iterator fIt, fEnd;
-            for (fIt = brushFaces.begin(), fEnd = brushFaces.end(); fIt != fEnd; ++fIt) {
-                Model::Face& face = **fIt;
-                Vec3f position = face.center();
-                if (removeHandle(position, face, m_selectedFaceHandles)) {
-                    assert(m_selectedFaceCount > 0);
-                    m_selectedFaceCount--;
-                } else {
-                    removeHandle(position, face, m_unselectedFaceHandles);
-                }
-            }
-            assert(m_totalFaceCount >= brushFaces.size());
-            m_totalFaceCount -= brushFaces.size();
-
+            removeHandles(brush);
             m_renderStateValid = false;
         }
 
@@ -241,9 +285,38 @@ namespace TrenchBroom {
             m_renderStateValid = false;
         }
 
+        void VertexHandleManager::brushesWillChange(const Model::BrushList& brushes) {
+            m_unselectedVertexHandles.beginUpdate();
+            m_selectedVertexHandles.beginUpdate();
+            m_unselectedEdgeHandles.beginUpdate();
+            m_selectedEdgeHandles.beginUpdate();
+            m_unselectedFaceHandles.beginUpdate();
+            m_selectedFaceHandles.beginUpdate();
+            
+            Model::BrushList::const_iterator it, end;
+            for (it = brushes.begin(), end = brushes.end(); it != end; ++it)
+                removeHandles(**it);
+        }
+        
+        void VertexHandleManager::brushesDidChange(const Model::BrushList& brushes) {
+            Model::BrushList::const_iterator it, end;
+            for (it = brushes.begin(), end = brushes.end(); it != end; ++it)
+                addHandles(**it);
+            
+            m_unselectedVertexHandles.endUpdate();
+            m_selectedVertexHandles.endUpdate();
+            m_unselectedEdgeHandles.endUpdate();
+            m_selectedEdgeHandles.endUpdate();
+            m_unselectedFaceHandles.endUpdate();
+            m_selectedFaceHandles.endUpdate();
+            
+            // the edges of the brushes were replaced
+            m_renderStateValid = false;
+        }
+
         void VertexHandleManager::selectVertexHandle(const Vec3f& position) {
             size_t count = 0;
-            if ((count = moveHandle(position, m_unselectedVertexHandles, m_selectedVertexHandles)) > 0) {
+            if ((count = m_unselectedVertexHandles.moveTo(position, m_selectedVertexHandles)) > 0) {
                 m_selectedVertexCount += count;
                 m_renderStateValid = false;
             }
@@ -251,7 +324,7 @@ namespace TrenchBroom {
 
         void VertexHandleManager::deselectVertexHandle(const Vec3f& position) {
             size_t count = 0;
-            if ((count = moveHandle(position, m_selectedVertexHandles, m_unselectedVertexHandles)) > 0) {
+            if ((count = m_selectedVertexHandles.moveTo(position, m_unselectedVertexHandles)) > 0) {
                 assert(m_selectedVertexCount >= count);
                 m_selectedVertexCount -= count;
                 m_renderStateValid = false;
@@ -265,21 +338,14 @@ namespace TrenchBroom {
         }
 
         void VertexHandleManager::deselectVertexHandles() {
-            Model::VertexToBrushesMap::const_iterator vIt, vEnd;
-            for (vIt = m_selectedVertexHandles.begin(), vEnd = m_selectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                const Vec3f& position = vIt->first;
-                const Model::BrushList& selectedBrushes = vIt->second;
-                Model::BrushList& unselectedBrushes = m_unselectedVertexHandles[position];
-                unselectedBrushes.insert(unselectedBrushes.begin(), selectedBrushes.begin(), selectedBrushes.end());
-            }
-            m_selectedVertexHandles.clear();
+            m_selectedVertexHandles.moveAllTo(m_unselectedVertexHandles);
             m_selectedVertexCount = 0;
             m_renderStateValid = false;
         }
 
         void VertexHandleManager::selectEdgeHandle(const Vec3f& position) {
             size_t count = 0;
-            if ((count = moveHandle(position, m_unselectedEdgeHandles, m_selectedEdgeHandles)) > 0) {
+            if ((count = m_unselectedEdgeHandles.moveTo(position, m_selectedEdgeHandles)) > 0) {
                 m_selectedEdgeCount += count;
                 m_renderStateValid = false;
             }
@@ -287,7 +353,7 @@ namespace TrenchBroom {
 
         void VertexHandleManager::deselectEdgeHandle(const Vec3f& position) {
             size_t count = 0;
-            if ((count = moveHandle(position, m_selectedEdgeHandles, m_unselectedEdgeHandles)) > 0) {
+            if ((count = m_selectedEdgeHandles.moveTo(position, m_unselectedEdgeHandles)) > 0) {
                 assert(m_selectedEdgeCount >= count);
                 m_selectedEdgeCount -= count;
                 m_renderStateValid = false;
@@ -303,21 +369,14 @@ namespace TrenchBroom {
         }
 
         void VertexHandleManager::deselectEdgeHandles() {
-            Model::VertexToEdgesMap::const_iterator eIt, eEnd;
-            for (eIt = m_selectedEdgeHandles.begin(), eEnd = m_selectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                const Vec3f& position = eIt->first;
-                const Model::EdgeList& selectedEdges = eIt->second;
-                Model::EdgeList& unselectedEdges = m_unselectedEdgeHandles[position];
-                unselectedEdges.insert(unselectedEdges.begin(), selectedEdges.begin(), selectedEdges.end());
-            }
-            m_selectedEdgeHandles.clear();
+            m_selectedEdgeHandles.moveAllTo(m_unselectedEdgeHandles);
             m_selectedEdgeCount = 0;
             m_renderStateValid = false;
         }
 
         void VertexHandleManager::selectFaceHandle(const Vec3f& position) {
             size_t count = 0;
-            if ((count = moveHandle(position, m_unselectedFaceHandles, m_selectedFaceHandles)) > 0) {
+            if ((count = m_unselectedFaceHandles.moveTo(position, m_selectedFaceHandles)) > 0) {
                 m_selectedFaceCount += count;
                 m_renderStateValid = false;
             }
@@ -325,7 +384,7 @@ namespace TrenchBroom {
 
         void VertexHandleManager::deselectFaceHandle(const Vec3f& position) {
             size_t count = 0;
-            if ((count = moveHandle(position, m_selectedFaceHandles, m_unselectedFaceHandles)) > 0) {
+            if ((count = m_selectedFaceHandles.moveTo(position, m_unselectedFaceHandles)) > 0) {
                 assert(m_selectedFaceCount >= count);
                 m_selectedFaceCount -= count;
                 m_renderStateValid = false;
@@ -341,14 +400,7 @@ namespace TrenchBroom {
         }
 
         void VertexHandleManager::deselectFaceHandles() {
-            Model::VertexToFacesMap::const_iterator fIt, fEnd;
-            for (fIt = m_selectedFaceHandles.begin(), fEnd = m_selectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                const Vec3f& position = fIt->first;
-                const Model::FaceList& selectedFaces = fIt->second;
-                Model::FaceList& unselectedFaces = m_unselectedFaceHandles[position];
-                unselectedFaces.insert(unselectedFaces.begin(), selectedFaces.begin(), selectedFaces.end());
-            }
-            m_selectedFaceHandles.clear();
+            m_selectedFaceHandles.moveAllTo(m_unselectedFaceHandles);
             m_selectedFaceCount = 0;
             m_renderStateValid = false;
         }
@@ -360,99 +412,35 @@ namespace TrenchBroom {
         }
 
         void VertexHandleManager::pick(const Rayf& ray, Model::PickResult& pickResult, bool splitMode) const {
-            Model::VertexToBrushesMap::const_iterator vIt, vEnd;
-            Model::VertexToEdgesMap::const_iterator eIt, eEnd;
-            Model::VertexToFacesMap::const_iterator fIt, fEnd;
-
-            if ((m_selectedEdgeHandles.empty() && m_selectedFaceHandles.empty()) || splitMode) {
-                for (vIt = m_unselectedVertexHandles.begin(), vEnd = m_unselectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                    const Vec3f& position = vIt->first;
-                    Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::VertexHandleHit);
-                    if (hit != NULL)
-                        pickResult.add(hit);
-                }
-            }
+            const bool selectedVertices = !m_selectedVertexHandles.handles().empty();
+            const bool selectedEdges = !m_selectedEdgeHandles.handles().empty();
+            const bool selectedFaces = !m_selectedFaceHandles.handles().empty();
 
-            for (vIt = m_selectedVertexHandles.begin(), vEnd = m_selectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                const Vec3f& position = vIt->first;
-                Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::VertexHandleHit);
-                if (hit != NULL)
-                    pickResult.add(hit);
-            }
+            if ((!selectedEdges && !selectedFaces) || splitMode)
+                pickHandles(ray, m_unselectedVertexHandles.grid(), Model::HitType::VertexHandleHit, pickResult);
+            pickHandles(ray, m_selectedVertexHandles.grid(), Model::HitType::VertexHandleHit, pickResult);
 
-            if (m_selectedVertexHandles.empty() && m_selectedFaceHandles.empty() && !splitMode) {
-                for (eIt = m_unselectedEdgeHandles.begin(), eEnd = m_unselectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                    const Vec3f& position = eIt->first;
-                    Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::EdgeHandleHit);
-                    if (hit != NULL)
-                        pickResult.add(hit);
-                }
-            }
+            if (!selectedVertices && !selectedFaces && !splitMode)
+                pickHandles(ray, m_unselectedEdgeHandles.grid(), Model::HitType::EdgeHandleHit, pickResult);
+            pickHandles(ray, m_selectedEdgeHandles.grid(), Model::HitType::EdgeHandleHit, pickResult);
 
-            for (eIt = m_selectedEdgeHandles.begin(), eEnd = m_selectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                const Vec3f& position = eIt->first;
-                Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::EdgeHandleHit);
-                if (hit != NULL)
-                    pickResult.add(hit);
-            }
-
-            if (m_selectedVertexHandles.empty() && m_selectedEdgeHandles.empty() && !splitMode) {
-                for (fIt = m_unselectedFaceHandles.begin(), fEnd = m_unselectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                    const Vec3f& position = fIt->first;
-                    Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::FaceHandleHit);
-                    if (hit != NULL)
-                        pickResult.add(hit);
-                }
-            }
-
-            for (fIt = m_selectedFaceHandles.begin(), fEnd = m_selectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                const Vec3f& position = fIt->first;
-                Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::FaceHandleHit);
-                if (hit != NULL)
-                    pickResult.add(hit);
-            }
+            if (!selectedVertices && !selectedEdges && !splitMode)
+                pickHandles(ray, m_unselectedFaceHandles.grid(), Model::HitType::FaceHandleHit, pickResult);
+            pickHandles(ray, m_selectedFaceHandles.grid(), Model::HitType::FaceHandleHit, pickResult);
         }
 
         void VertexHandleManager::render(Renderer::Vbo& vbo, Renderer::RenderContext& renderContext, bool splitMode) {
-            if (!m_renderStateValid || m_recreateRenderers) {
-                if (m_recreateRenderers) {
-                    destroyRenderers();
-                    createRenderers();
-                }
-                
-                Model::VertexToBrushesMap::const_iterator vIt, vEnd;
-                Model::VertexToEdgesMap::const_iterator eIt, eEnd;
-                Model::VertexToFacesMap::const_iterator fIt, fEnd;
-
-                m_unselectedVertexHandleRenderer->clear();
-                m_unselectedEdgeHandleRenderer->clear();
-                m_unselectedFaceHandleRenderer->clear();
-                m_selectedHandleRenderer->clear();
+            if (m_recreateRenderers) {
+                destroyRenderers();
+                createRenderers();
+            }
+            
+            // the handle renderers are kept up to date by the handle sets, only the selected edges must be rebuilt
+            if (!m_renderStateValid) {
                 m_selectedEdgeRenderer->clear();
 
-                if ((m_selectedEdgeHandles.empty() && m_selectedFaceHandles.empty()) || splitMode) {
-                    for (vIt = m_unselectedVertexHandles.begin(), vEnd = m_unselectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                        const Vec3f& position = vIt->first;
-                        m_unselectedVertexHandleRenderer->add(position);
-                    }
-                }
-
-                for (vIt = m_selectedVertexHandles.begin(), vEnd = m_selectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                    const Vec3f& position = vIt->first;
-                    m_selectedHandleRenderer->add(position);
-                }
-
-                if (m_selectedVertexHandles.empty() && m_selectedFaceHandles.empty() && !splitMode) {
-                    for (eIt = m_unselectedEdgeHandles.begin(), eEnd = m_unselectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                        const Vec3f& position = eIt->first;
-                        m_unselectedEdgeHandleRenderer->add(position);
-                    }
-                }
-
-                for (eIt = m_selectedEdgeHandles.begin(), eEnd = m_selectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                    const Vec3f& position = eIt->first;
-                    m_selectedHandleRenderer->add(position);
-                    
+                Model::VertexToEdgesMap::const_iterator eIt, eEnd;
+                for (eIt = m_selectedEdgeHandles.handles().begin(), eEnd = m_selectedEdgeHandles.handles().end(); eIt != eEnd; ++eIt) {
                     const Model::EdgeList& edges = eIt->second;
                     Model::EdgeList::const_iterator edgeIt, edgeEnd;
                     for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
@@ -461,17 +449,8 @@ namespace TrenchBroom {
                     }
                 }
 
-                if (m_selectedVertexHandles.empty() && m_selectedEdgeHandles.empty() && !splitMode) {
-                    for (fIt = m_unselectedFaceHandles.begin(), fEnd = m_unselectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                        const Vec3f& position = fIt->first;
-                        m_unselectedFaceHandleRenderer->add(position);
-                    }
-                }
-
-                for (fIt = m_selectedFaceHandles.begin(), fEnd = m_selectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                    const Vec3f& position = fIt->first;
-                    m_selectedHandleRenderer->add(position);
-                    
+                Model::VertexToFacesMap::const_iterator fIt, fEnd;
+                for (fIt = m_selectedFaceHandles.handles().begin(), fEnd = m_selectedFaceHandles.handles().end(); fIt != fEnd; ++fIt) {
                     const Model::FaceList& faces = fIt->second;
                     Model::FaceList::const_iterator faceIt, faceEnd;
                     for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
@@ -488,9 +467,16 @@ namespace TrenchBroom {
                 m_renderStateValid = true;
             }
             
+            const bool selectedVertices = !m_selectedVertexHandles.handles().empty();
+            const bool selectedEdges = !m_selectedEdgeHandles.handles().empty();
+            const bool selectedFaces = !m_selectedFaceHandles.handles().empty();
+            const bool renderUnselectedVertices = (!selectedEdges && !selectedFaces) || splitMode;
+            const bool renderUnselectedEdges = !selectedVertices && !selectedFaces && !splitMode;
+            const bool renderUnselectedFaces = !selectedVertices && !selectedEdges && !splitMode;
+            
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
-            if (!m_selectedEdgeHandles.empty() || !m_selectedFaceHandles.empty()) {
-                if (!m_selectedEdgeHandles.empty())
+            if (selectedEdges || selectedFaces) {
+                if (selectedEdges)
                     m_selectedEdgeRenderer->setColor(prefs.getColor(Preferences::EdgeHandleColor), prefs.getColor(Preferences::OccludedEdgeHandleColor));
                 else
                     m_selectedEdgeRenderer->setColor(prefs.getColor(Preferences::FaceHandleColor), prefs.getColor(Preferences::OccludedFaceHandleColor));
@@ -498,32 +484,42 @@ namespace TrenchBroom {
                 m_selectedEdgeRenderer->render(vbo, renderContext);
             }
             
+            const Color& selectedColor = prefs.getColor(splitMode ? Preferences::SelectedSplitHandleColor : Preferences::SelectedVertexHandleColor);
             m_unselectedVertexHandleRenderer->setColor(prefs.getColor(Preferences::VertexHandleColor));
             m_unselectedEdgeHandleRenderer->setColor(prefs.getColor(Preferences::EdgeHandleColor));
             m_unselectedFaceHandleRenderer->setColor(prefs.getColor(Preferences::FaceHandleColor));
-            if (splitMode)
-                m_selectedHandleRenderer->setColor(prefs.getColor(Preferences::SelectedSplitHandleColor));
-            else
-                m_selectedHandleRenderer->setColor(prefs.getColor(Preferences::SelectedVertexHandleColor));
-
-            m_unselectedVertexHandleRenderer->render(vbo, renderContext);
-            m_unselectedEdgeHandleRenderer->render(vbo, renderContext);
-            m_unselectedFaceHandleRenderer->render(vbo, renderContext);
-            m_selectedHandleRenderer->render(vbo, renderContext);
-
+            m_selectedVertexHandleRenderer->setColor(selectedColor);
+            m_selectedEdgeHandleRenderer->setColor(selectedColor);
+            m_selectedFaceHandleRenderer->setColor(selectedColor);
+
+            if (renderUnselectedVertices)
+                m_unselectedVertexHandleRenderer->render(vbo, renderContext);
+            if (renderUnselectedEdges)
+                m_unselectedEdgeHandleRenderer->render(vbo, renderContext);
+            if (renderUnselectedFaces)
+                m_unselectedFaceHandleRenderer->render(vbo, renderContext);
+            m_selectedVertexHandleRenderer->render(vbo, renderContext);
+            m_selectedEdgeHandleRenderer->render(vbo, renderContext);
+            m_selectedFaceHandleRenderer->render(vbo, renderContext);
+
+            const Color& occludedSelectedColor = prefs.getColor(splitMode ? Preferences::OccludedSelectedSplitHandleColor : Preferences::OccludedSelectedVertexHandleColor);
             m_unselectedVertexHandleRenderer->setColor(prefs.getColor(Preferences::OccludedVertexHandleColor));
             m_unselectedEdgeHandleRenderer->setColor(prefs.getColor(Preferences::OccludedEdgeHandleColor));
             m_unselectedFaceHandleRenderer->setColor(prefs.getColor(Preferences::OccludedFaceHandleColor));
-            if (splitMode)
-                m_selectedHandleRenderer->setColor(prefs.getColor(Preferences::OccludedSelectedSplitHandleColor));
-            else
-                m_selectedHandleRenderer->setColor(prefs.getColor(Preferences::OccludedSelectedVertexHandleColor));
+            m_selectedVertexHandleRenderer->setColor(occludedSelectedColor);
+            m_selectedEdgeHandleRenderer->setColor(occludedSelectedColor);
+            m_selectedFaceHandleRenderer->setColor(occludedSelectedColor);
 
             glDisable(GL_DEPTH_TEST);
-            m_unselectedVertexHandleRenderer->render(vbo, renderContext);
-            m_unselectedEdgeHandleRenderer->render(vbo, renderContext);
-            m_unselectedFaceHandleRenderer->render(vbo, renderContext);
-            m_selectedHandleRenderer->render(vbo, renderContext);
+            if (renderUnselectedVertices)
+                m_unselectedVertexHandleRenderer->render(vbo, renderContext);
+            if (renderUnselectedEdges)
+                m_unselectedEdgeHandleRenderer->render(vbo, renderContext);
+            if (renderUnselectedFaces)
+                m_unselectedFaceHandleRenderer->render(vbo, renderContext);
+            m_selectedVertexHandleRenderer->render(vbo, renderContext);
+            m_selectedEdgeHandleRenderer->render(vbo, renderContext);
+            m_selectedFaceHandleRenderer->render(vbo, renderContext);
             glEnable(GL_DEPTH_TEST);
         }
     }
@@ -20,12 +20,19 @@
 #ifndef __TrenchBroom__HandleManager__
 #define __TrenchBroom__HandleManager__
 
+#include "Controller/HandleGrid.h"
 #include "Model/Brush.h"
 #include "Model/BrushGeometryTypes.h"
 #include "Model/Picker.h"
+#include "Renderer/PointHandleRenderer.h"
 #include "Utility/Preferences.h"
 #include "Utility/VecMath.h"
 
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <vector>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
@@ -53,43 +60,76 @@ namespace TrenchBroom {
 
     namespace Renderer {
         class LinesRenderer;
-        class PointHandleRenderer;
         class RenderContext;
         class Vbo;
     }
     
     namespace Controller {
-        class VertexHandleManager {
+        /**
+         * The handles of one kind and selection state, indexed by position. Each position is kept in a grid for
+         * picking and, if set, in a renderer. While the set is being updated, positions whose last element was
+         * removed are kept until the update ends, so that handles which do not move are not touched at all.
+         */
+        template <typename Element>
+        class VertexHandleSet {
+        public:
+            typedef std::vector<Element*> List;
+            typedef std::map<Vec3f, List, Vec3f::LexicographicOrder> Map;
         private:
-            Model::VertexToBrushesMap m_unselectedVertexHandles;
-            Model::VertexToBrushesMap m_selectedVertexHandles;
-            Model::VertexToEdgesMap m_unselectedEdgeHandles;
-            Model::VertexToEdgesMap m_selectedEdgeHandles;
-            Model::VertexToFacesMap m_unselectedFaceHandles;
-            Model::VertexToFacesMap m_selectedFaceHandles;
+            Map m_handles;
+            HandleGrid m_grid;
+            Renderer::PointHandleRenderer* m_renderer;
+            Vec3f::List m_emptiedPositions;
+            bool m_updating;
             
-            size_t m_totalVertexCount;
-            size_t m_selectedVertexCount;
-            size_t m_totalEdgeCount;
-            size_t m_selectedEdgeCount;
-            size_t m_totalFaceCount;
-            size_t m_selectedFaceCount;
+            inline void erase(typename Map::iterator it) {
+                m_grid.remove(it->first);
+                if (m_renderer != NULL)
+                    m_renderer->remove(it->first);
+                m_handles.erase(it);
+            }
+        public:
+            VertexHandleSet() :
+            m_renderer(NULL),
+            m_updating(false) {}
             
-            Renderer::PointHandleRenderer* m_selectedHandleRenderer;
-            Renderer::PointHandleRenderer* m_unselectedVertexHandleRenderer;
-            Renderer::PointHandleRenderer* m_unselectedEdgeHandleRenderer;
-            Renderer::PointHandleRenderer* m_unselectedFaceHandleRenderer;
-            Renderer::LinesRenderer* m_selectedEdgeRenderer;
-            bool m_renderStateValid;
-            bool m_recreateRenderers;
+            inline const Map& handles() const {
+                return m_handles;
+            }
             
-            template <typename Element>
-            inline bool removeHandle(const Vec3f& position, Element& element, std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& map) {
-                typedef std::vector<Element*> List;
-                typedef std::map<Vec3f, List, Vec3f::LexicographicOrder> Map;
-                
-                typename Map::iterator mapIt = map.find(position);
-                if (mapIt == map.end())
+            inline const HandleGrid& grid() const {
+                return m_grid;
+            }
+            
+            inline bool contains(const Vec3f& position) const {
+                typename Map::const_iterator it = m_handles.find(position);
+                return it != m_handles.end() && !it->second.empty();
+            }
+            
+            inline void setRenderer(Renderer::PointHandleRenderer* renderer) {
+                m_renderer = renderer;
+                if (m_renderer != NULL) {
+                    m_renderer->clear();
+                    typename Map::const_iterator it, end;
+                    for (it = m_handles.begin(), end = m_handles.end(); it != end; ++it)
+                        m_renderer->add(it->first);
+                }
+            }
+            
+            inline void add(const Vec3f& position, Element& element) {
+                typename Map::iterator it = m_handles.lower_bound(position);
+                if (it == m_handles.end() || m_handles.key_comp()(position, it->first)) {
+                    it = m_handles.insert(it, typename Map::value_type(position, List()));
+                    m_grid.add(position);
+                    if (m_renderer != NULL)
+                        m_renderer->add(position);
+                }
+                it->second.push_back(&element);
+            }
+            
+            inline bool remove(const Vec3f& position, Element& element) {
+                typename Map::iterator mapIt = m_handles.find(position);
+                if (mapIt == m_handles.end())
                     return false;
                 
                 List& elements = mapIt->second;
@@ -98,29 +138,100 @@ namespace TrenchBroom {
                     return false;
                 
                 elements.erase(listIt);
-                if (elements.empty())
-                    map.erase(mapIt);
+                if (elements.empty()) {
+                    if (m_updating)
+                        m_emptiedPositions.push_back(position);
+                    else
+                        erase(mapIt);
+                }
                 return true;
             }
             
-            template <typename Element>
-            inline size_t moveHandle(const Vec3f& position, std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& from, std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& to) {
-                typedef std::vector<Element*> List;
-                typedef std::map<Vec3f, List, Vec3f::LexicographicOrder> Map;
-                
-                typename Map::iterator mapIt = from.find(position);
-                if (mapIt == from.end())
+            /**
+             * Moves all elements at the given position to the given set and returns their number.
+             */
+            inline size_t moveTo(const Vec3f& position, VertexHandleSet& other) {
+                typename Map::iterator mapIt = m_handles.find(position);
+                if (mapIt == m_handles.end())
                     return 0;
                 
-                List& fromElements = mapIt->second;
-                List& toElements = to[position];
-                size_t elementCount = fromElements.size();
-                toElements.insert(toElements.end(), fromElements.begin(), fromElements.end());
+                const List& elements = mapIt->second;
+                const size_t elementCount = elements.size();
+                typename List::const_iterator it, end;
+                for (it = elements.begin(), end = elements.end(); it != end; ++it)
+                    other.add(position, **it);
                 
-                from.erase(mapIt);
+                erase(mapIt);
                 return elementCount;
             }
             
+            inline void moveAllTo(VertexHandleSet& other) {
+                typename Map::const_iterator mapIt, mapEnd;
+                for (mapIt = m_handles.begin(), mapEnd = m_handles.end(); mapIt != mapEnd; ++mapIt) {
+                    const Vec3f& position = mapIt->first;
+                    const List& elements = mapIt->second;
+                    typename List::const_iterator it, end;
+                    for (it = elements.begin(), end = elements.end(); it != end; ++it)
+                        other.add(position, **it);
+                }
+                clear();
+            }
+            
+            inline void clear() {
+                m_handles.clear();
+                m_grid.clear();
+                m_emptiedPositions.clear();
+                if (m_renderer != NULL)
+                    m_renderer->clear();
+            }
+            
+            inline void beginUpdate() {
+                assert(!m_updating);
+                m_updating = true;
+            }
+            
+            /**
+             * Removes the positions which were emptied during the update and were not filled again.
+             */
+            inline void endUpdate() {
+                assert(m_updating);
+                Vec3f::List::const_iterator it, end;
+                for (it = m_emptiedPositions.begin(), end = m_emptiedPositions.end(); it != end; ++it) {
+                    typename Map::iterator mapIt = m_handles.find(*it);
+                    if (mapIt != m_handles.end() && mapIt->second.empty())
+                        erase(mapIt);
+                }
+                m_emptiedPositions.clear();
+                m_updating = false;
+            }
+        };
+        
+        class VertexHandleManager {
+        private:
+            VertexHandleSet<Model::Brush> m_unselectedVertexHandles;
+            VertexHandleSet<Model::Brush> m_selectedVertexHandles;
+            VertexHandleSet<Model::Edge> m_unselectedEdgeHandles;
+            VertexHandleSet<Model::Edge> m_selectedEdgeHandles;
+            VertexHandleSet<Model::Face> m_unselectedFaceHandles;
+            VertexHandleSet<Model::Face> m_selectedFaceHandles;
+            
+            size_t m_totalVertexCount;
+            size_t m_selectedVertexCount;
+            size_t m_totalEdgeCount;
+            size_t m_selectedEdgeCount;
+            size_t m_totalFaceCount;
+            size_t m_selectedFaceCount;
+            
+            Renderer::PointHandleRenderer* m_unselectedVertexHandleRenderer;
+            Renderer::PointHandleRenderer* m_selectedVertexHandleRenderer;
+            Renderer::PointHandleRenderer* m_unselectedEdgeHandleRenderer;
+            Renderer::PointHandleRenderer* m_selectedEdgeHandleRenderer;
+            Renderer::PointHandleRenderer* m_unselectedFaceHandleRenderer;
+            Renderer::PointHandleRenderer* m_selectedFaceHandleRenderer;
+            Renderer::LinesRenderer* m_selectedEdgeRenderer;
+            bool m_renderStateValid;
+            bool m_recreateRenderers;
+            
             inline Model::VertexHandleHit* pickHandle(const Rayf& ray, const Vec3f& position, Model::HitType::Type type) const {
                 Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
                 float handleRadius = prefs.getFloat(Preferences::HandleRadius);
@@ -136,45 +247,49 @@ namespace TrenchBroom {
                 return NULL;
             }
             
+            void pickHandles(const Rayf& ray, const HandleGrid& grid, Model::HitType::Type type, Model::PickResult& pickResult) const;
+            void removeHandles(Model::Brush& brush);
+            void addHandles(Model::Brush& brush);
+            
             void createRenderers();
             void destroyRenderers();
         public:
             VertexHandleManager();
             
             inline const Model::VertexToBrushesMap& unselectedVertexHandles() const {
-                return m_unselectedVertexHandles;
+                return m_unselectedVertexHandles.handles();
             }
             
             inline const Model::VertexToBrushesMap& selectedVertexHandles() const {
-                return m_selectedVertexHandles;
+                return m_selectedVertexHandles.handles();
             }
             
             inline const Model::VertexToEdgesMap& unselectedEdgeHandles() const {
-                return m_unselectedEdgeHandles;
+                return m_unselectedEdgeHandles.handles();
             }
             
             inline const Model::VertexToEdgesMap& selectedEdgeHandles() const {
-                return m_selectedEdgeHandles;
+                return m_selectedEdgeHandles.handles();
             }
             
             inline const Model::VertexToFacesMap& unselectedFaceHandles() const {
-                return m_unselectedFaceHandles;
+                return m_unselectedFaceHandles.handles();
             }
             
             inline const Model::VertexToFacesMap& selectedFaceHandles() const {
-                return m_selectedFaceHandles;
+                return m_selectedFaceHandles.handles();
             }
             
             inline bool vertexHandleSelected(const Vec3f& position) {
-                return m_selectedVertexHandles.find(position) != m_selectedVertexHandles.end();
+                return m_selectedVertexHandles.contains(position);
             }
             
             inline bool edgeHandleSelected(const Vec3f& position) {
-                return m_selectedEdgeHandles.find(position) != m_selectedEdgeHandles.end();
+                return m_selectedEdgeHandles.contains(position);
             }
 
             inline bool faceHandleSelected(const Vec3f& position) {
-                return m_selectedFaceHandles.find(position) != m_selectedFaceHandles.end();
+                return m_selectedFaceHandles.contains(position);
             }
             
             inline size_t selectedVertexCount() const {
@@ -210,6 +325,13 @@ namespace TrenchBroom {
             void remove(Model::Brush& brush);
             void remove(const Model::BrushList& brushes);
             void clear();
+            
+            /**
+             * Must be called before and after the given brushes are changed. Only the handles whose positions were
+             * changed are then updated in the spatial index and in the renderers.
+             */
+            void brushesWillChange(const Model::BrushList& brushes);
+            void brushesDidChange(const Model::BrushList& brushes);
 
             void selectVertexHandle(const Vec3f& position);
             void deselectVertexHandle(const Vec3f& position);
@@ -233,6 +355,7 @@ namespace TrenchBroom {
             
             inline void freeRenderResources() {
                 destroyRenderers();
+                m_recreateRenderers = true;
             }
             
             inline void invalidateRenderState() {
@@ -77,6 +77,10 @@ namespace TrenchBroom {
             return wxRenameFile(sourcePath, destPath, overwrite);
         }
         
+        time_t AbstractFileManager::modificationTime(const String& path) {
+            return wxFileModificationTime(path);
+        }
+        
         char AbstractFileManager::pathSeparator() {
             static const char c = wxFileName::GetPathSeparator();
             return c;
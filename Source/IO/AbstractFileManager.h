@@ -25,6 +25,7 @@
 #include "Utility/String.h"
 
 #include <cassert>
+#include <ctime>
 
 namespace TrenchBroom {
     namespace IO {
@@ -56,7 +57,43 @@ namespace TrenchBroom {
                 return m_end;
             }
         };
-        
+
+        /**
+         * A non-owning view of a range of bytes within a mapped file. The owner of the mapping must
+         * outlive the view.
+         */
+        class FileView {
+        private:
+            char* m_begin;
+            char* m_end;
+        public:
+            FileView() :
+            m_begin(NULL),
+            m_end(NULL) {}
+
+            FileView(char* begin, char* end) :
+            m_begin(begin),
+            m_end(end) {
+                assert(m_end >= m_begin);
+            }
+
+            inline bool valid() const {
+                return m_begin != NULL;
+            }
+
+            inline size_t size() const {
+                return static_cast<size_t>(m_end - m_begin);
+            }
+
+            inline char* begin() const {
+                return m_begin;
+            }
+
+            inline char* end() const {
+                return m_end;
+            }
+        };
+
 #ifndef _WIN32
         class PosixMappedFile : public MappedFile {
         private:
@@ -77,6 +114,7 @@ namespace TrenchBroom {
             bool makeDirectory(const String& path);
             bool deleteFile(const String& path);
             bool moveFile(const String& sourcePath, const String& destPath, bool overwrite);
+            time_t modificationTime(const String& path);
             char pathSeparator();
             StringList directoryContents(const String& path, String extension = "", bool directories = true, bool files = true);
             bool resolveRelativePath(const String& relativePath, const StringList& rootPaths, String& absolutePath);
@@ -98,6 +136,7 @@ namespace TrenchBroom {
             
             virtual String logDirectory() = 0;
             virtual String resourceDirectory() = 0;
+            virtual String cacheDirectory() = 0;
             virtual String resolveFontPath(const String& fontName) = 0;
             
 #if defined _WIN32
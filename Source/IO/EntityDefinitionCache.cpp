@@ -0,0 +1,452 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntityDefinitionCache.h"
+
+#include "IO/IOException.h"
+#include "IO/IOUtils.h"
+#include "Model/EntityDefinition.h"
+#include "Utility/List.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace TrenchBroom {
+    namespace IO {
+        static bool makeDirectories(FileManager& fileManager, const String& path) {
+            if (fileManager.exists(path))
+                return fileManager.isDirectory(path);
+            
+            const String parentPath = fileManager.deleteLastPathComponent(path);
+            if (!parentPath.empty() && parentPath != path && !makeDirectories(fileManager, parentPath))
+                return false;
+            return fileManager.makeDirectory(path);
+        }
+        
+        EntityDefinitionCache::Reader::Reader(char* begin, char* end) :
+        m_cursor(begin),
+        m_end(end) {
+            assert(m_end >= m_cursor);
+        }
+        
+        void EntityDefinitionCache::Reader::check(size_t size) {
+            if (static_cast<size_t>(m_end - m_cursor) < size)
+                throw IOException::unexpectedEof();
+        }
+        
+        uint8_t EntityDefinitionCache::Reader::readUInt8() {
+            check(sizeof(uint8_t));
+            return IO::read<uint8_t>(m_cursor);
+        }
+        
+        uint32_t EntityDefinitionCache::Reader::readUInt32() {
+            check(sizeof(uint32_t));
+            return IO::read<uint32_t>(m_cursor);
+        }
+        
+        int32_t EntityDefinitionCache::Reader::readInt32() {
+            check(sizeof(int32_t));
+            return IO::read<int32_t>(m_cursor);
+        }
+        
+        int64_t EntityDefinitionCache::Reader::readInt64() {
+            check(sizeof(int64_t));
+            return IO::read<int64_t>(m_cursor);
+        }
+        
+        float EntityDefinitionCache::Reader::readFloat() {
+            check(sizeof(float));
+            return IO::read<float>(m_cursor);
+        }
+        
+        String EntityDefinitionCache::Reader::readString() {
+            const size_t length = static_cast<size_t>(readUInt32());
+            check(length);
+            String result(m_cursor, length);
+            m_cursor += length;
+            return result;
+        }
+        
+        size_t EntityDefinitionCache::Reader::readCount(size_t minimumElementSize) {
+            const size_t count = static_cast<size_t>(readUInt32());
+            if (count > static_cast<size_t>(m_end - m_cursor) / minimumElementSize)
+                throw IOException("Invalid element count %u in entity definition cache", static_cast<unsigned int>(count));
+            return count;
+        }
+
+        Model::PropertyDefinition::Ptr EntityDefinitionCache::readPropertyDefinition(Reader& reader) {
+            const uint8_t tag = reader.readUInt8();
+            const String name = reader.readString();
+            const String description = reader.readString();
+            
+            switch (tag) {
+                case PlainPropertyTag: {
+                    const uint8_t type = reader.readUInt8();
+                    if (type != Model::PropertyDefinition::TargetSourceProperty &&
+                        type != Model::PropertyDefinition::TargetDestinationProperty)
+                        throw IOException("Invalid property type %i in entity definition cache", type);
+                    return Model::PropertyDefinition::Ptr(new Model::PropertyDefinition(name, static_cast<Model::PropertyDefinition::Type>(type), description));
+                }
+                case StringPropertyTag: {
+                    const String defaultValue = reader.readString();
+                    return Model::PropertyDefinition::Ptr(new Model::StringPropertyDefinition(name, description, defaultValue));
+                }
+                case IntegerPropertyTag: {
+                    const int defaultValue = static_cast<int>(reader.readInt32());
+                    return Model::PropertyDefinition::Ptr(new Model::IntegerPropertyDefinition(name, description, defaultValue));
+                }
+                case FloatPropertyTag: {
+                    const float defaultValue = reader.readFloat();
+                    return Model::PropertyDefinition::Ptr(new Model::FloatPropertyDefinition(name, description, defaultValue));
+                }
+                case ChoicePropertyTag: {
+                    const int defaultValue = static_cast<int>(reader.readInt32());
+                    Model::ChoicePropertyDefinition* definition = new Model::ChoicePropertyDefinition(name, description, defaultValue);
+                    Model::PropertyDefinition::Ptr result(definition);
+                    
+                    const size_t optionCount = reader.readCount(2 * sizeof(uint32_t));
+                    for (size_t i = 0; i < optionCount; i++) {
+                        const String value = reader.readString();
+                        const String optionDescription = reader.readString();
+                        definition->addOption(value, optionDescription);
+                    }
+                    return result;
+                }
+                case FlagsPropertyTag: {
+                    Model::FlagsPropertyDefinition* definition = new Model::FlagsPropertyDefinition(name, description);
+                    Model::PropertyDefinition::Ptr result(definition);
+                    
+                    const size_t optionCount = reader.readCount(2 * sizeof(uint32_t) + sizeof(uint8_t));
+                    for (size_t i = 0; i < optionCount; i++) {
+                        const int value = static_cast<int>(reader.readInt32());
+                        const String optionDescription = reader.readString();
+                        const bool isDefault = reader.readUInt8() != 0;
+                        definition->addOption(value, optionDescription, isDefault);
+                    }
+                    return result;
+                }
+                default:
+                    throw IOException("Invalid property definition tag %i in entity definition cache", tag);
+            }
+        }
+        
+        Model::ModelDefinition* EntityDefinitionCache::readModelDefinition(Reader& reader) {
+            const String name = reader.readString();
+            const unsigned int skinIndex = static_cast<unsigned int>(reader.readUInt32());
+            const unsigned int frameIndex = static_cast<unsigned int>(reader.readUInt32());
+            
+            const uint8_t tag = reader.readUInt8();
+            switch (tag) {
+                case NoConditionTag:
+                    return new Model::ModelDefinition(name, skinIndex, frameIndex);
+                case PropertyConditionTag: {
+                    const String propertyKey = reader.readString();
+                    const String propertyValue = reader.readString();
+                    return new Model::ModelDefinition(name, skinIndex, frameIndex, propertyKey, propertyValue);
+                }
+                case FlagConditionTag: {
+                    const String propertyKey = reader.readString();
+                    const int flagValue = static_cast<int>(reader.readInt32());
+                    return new Model::ModelDefinition(name, skinIndex, frameIndex, propertyKey, flagValue);
+                }
+                default:
+                    throw IOException("Invalid model condition tag %i in entity definition cache", tag);
+            }
+        }
+
+        Model::EntityDefinition* EntityDefinitionCache::readDefinition(Reader& reader) {
+            const uint8_t type = reader.readUInt8();
+            const String name = reader.readString();
+            const String description = reader.readString();
+            
+            Color color;
+            for (size_t i = 0; i < 4; i++)
+                color[i] = reader.readFloat();
+            
+            BBoxf bounds;
+            Model::ModelDefinition::List modelDefinitions;
+            if (type == Model::EntityDefinition::PointEntity) {
+                for (size_t i = 0; i < 3; i++)
+                    bounds.min[i] = reader.readFloat();
+                for (size_t i = 0; i < 3; i++)
+                    bounds.max[i] = reader.readFloat();
+                
+                const size_t modelCount = reader.readCount(3 * sizeof(uint32_t) + sizeof(uint8_t));
+                modelDefinitions.reserve(modelCount);
+                for (size_t i = 0; i < modelCount; i++)
+                    modelDefinitions.push_back(Model::ModelDefinition::Ptr(readModelDefinition(reader)));
+            } else if (type != Model::EntityDefinition::BrushEntity) {
+                throw IOException("Invalid entity definition type %i in entity definition cache", type);
+            }
+            
+            const size_t propertyCount = reader.readCount(sizeof(uint8_t) + 2 * sizeof(uint32_t));
+            Model::PropertyDefinition::List propertyDefinitions;
+            propertyDefinitions.reserve(propertyCount);
+            for (size_t i = 0; i < propertyCount; i++)
+                propertyDefinitions.push_back(readPropertyDefinition(reader));
+            
+            if (type == Model::EntityDefinition::PointEntity)
+                return new Model::PointEntityDefinition(name, color, bounds, description, propertyDefinitions, modelDefinitions);
+            return new Model::BrushEntityDefinition(name, color, description, propertyDefinitions);
+        }
+
+        void EntityDefinitionCache::writeUInt8(std::ostream& stream, uint8_t value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(uint8_t));
+        }
+        
+        void EntityDefinitionCache::writeUInt32(std::ostream& stream, uint32_t value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(uint32_t));
+        }
+        
+        void EntityDefinitionCache::writeInt32(std::ostream& stream, int32_t value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(int32_t));
+        }
+        
+        void EntityDefinitionCache::writeInt64(std::ostream& stream, int64_t value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(int64_t));
+        }
+        
+        void EntityDefinitionCache::writeFloat(std::ostream& stream, float value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(float));
+        }
+        
+        void EntityDefinitionCache::writeString(std::ostream& stream, const String& str) {
+            writeUInt32(stream, static_cast<uint32_t>(str.size()));
+            stream.write(str.data(), static_cast<std::streamsize>(str.size()));
+        }
+        
+        void EntityDefinitionCache::writePropertyDefinition(std::ostream& stream, const Model::PropertyDefinition& definition) {
+            // FloatPropertyDefinition reports itself as an integer property, so the concrete class must be checked
+            const Model::StringPropertyDefinition* stringDefinition = dynamic_cast<const Model::StringPropertyDefinition*>(&definition);
+            const Model::IntegerPropertyDefinition* integerDefinition = dynamic_cast<const Model::IntegerPropertyDefinition*>(&definition);
+            const Model::FloatPropertyDefinition* floatDefinition = dynamic_cast<const Model::FloatPropertyDefinition*>(&definition);
+            const Model::ChoicePropertyDefinition* choiceDefinition = dynamic_cast<const Model::ChoicePropertyDefinition*>(&definition);
+            const Model::FlagsPropertyDefinition* flagsDefinition = dynamic_cast<const Model::FlagsPropertyDefinition*>(&definition);
+            
+            if (stringDefinition != NULL) {
+                writeUInt8(stream, StringPropertyTag);
+            } else if (integerDefinition != NULL) {
+                writeUInt8(stream, IntegerPropertyTag);
+            } else if (floatDefinition != NULL) {
+                writeUInt8(stream, FloatPropertyTag);
+            } else if (choiceDefinition != NULL) {
+                writeUInt8(stream, ChoicePropertyTag);
+            } else if (flagsDefinition != NULL) {
+                writeUInt8(stream, FlagsPropertyTag);
+            } else {
+                writeUInt8(stream, PlainPropertyTag);
+            }
+            
+            writeString(stream, definition.name());
+            writeString(stream, definition.description());
+            
+            if (stringDefinition != NULL) {
+                writeString(stream, stringDefinition->defaultPropertyValue());
+            } else if (integerDefinition != NULL) {
+                writeInt32(stream, static_cast<int32_t>(integerDefinition->defaultValue()));
+            } else if (floatDefinition != NULL) {
+                writeFloat(stream, floatDefinition->defaultValue());
+            } else if (choiceDefinition != NULL) {
+                writeInt32(stream, static_cast<int32_t>(choiceDefinition->defaultValue()));
+                
+                const Model::ChoicePropertyOption::List& options = choiceDefinition->options();
+                writeUInt32(stream, static_cast<uint32_t>(options.size()));
+                Model::ChoicePropertyOption::List::const_iterator it, end;
+                for (it = options.begin(), end = options.end(); it != end; ++it) {
+                    writeString(stream, it->value());
+                    writeString(stream, it->description());
+                }
+            } else if (flagsDefinition != NULL) {
+                const Model::FlagsPropertyOption::List& options = flagsDefinition->options();
+                writeUInt32(stream, static_cast<uint32_t>(options.size()));
+                Model::FlagsPropertyOption::List::const_iterator it, end;
+                for (it = options.begin(), end = options.end(); it != end; ++it) {
+                    writeInt32(stream, static_cast<int32_t>(it->value()));
+                    writeString(stream, it->description());
+                    writeUInt8(stream, it->isDefault() ? 1 : 0);
+                }
+            } else {
+                writeUInt8(stream, static_cast<uint8_t>(definition.type()));
+            }
+        }
+        
+        void EntityDefinitionCache::writeModelDefinition(std::ostream& stream, const Model::ModelDefinition& definition) {
+            writeString(stream, definition.name());
+            writeUInt32(stream, static_cast<uint32_t>(definition.skinIndex()));
+            writeUInt32(stream, static_cast<uint32_t>(definition.frameIndex()));
+            
+            const Model::ModelDefinitionEvaluator* evaluator = definition.evaluator();
+            const Model::ModelDefinitionPropertyEvaluator* propertyEvaluator = dynamic_cast<const Model::ModelDefinitionPropertyEvaluator*>(evaluator);
+            const Model::ModelDefinitionFlagEvaluator* flagEvaluator = dynamic_cast<const Model::ModelDefinitionFlagEvaluator*>(evaluator);
+            
+            if (propertyEvaluator != NULL) {
+                writeUInt8(stream, PropertyConditionTag);
+                writeString(stream, propertyEvaluator->propertyKey());
+                writeString(stream, propertyEvaluator->propertyValue());
+            } else if (flagEvaluator != NULL) {
+                writeUInt8(stream, FlagConditionTag);
+                writeString(stream, flagEvaluator->propertyKey());
+                writeInt32(stream, static_cast<int32_t>(flagEvaluator->flagValue()));
+            } else {
+                writeUInt8(stream, NoConditionTag);
+            }
+        }
+
+        void EntityDefinitionCache::writeDefinition(std::ostream& stream, const Model::EntityDefinition& definition) {
+            writeUInt8(stream, static_cast<uint8_t>(definition.type()));
+            writeString(stream, definition.name());
+            writeString(stream, definition.description());
+            
+            const Color& color = definition.color();
+            for (size_t i = 0; i < 4; i++)
+                writeFloat(stream, color[i]);
+            
+            if (definition.type() == Model::EntityDefinition::PointEntity) {
+                const Model::PointEntityDefinition& pointDefinition = static_cast<const Model::PointEntityDefinition&>(definition);
+                const BBoxf& bounds = pointDefinition.bounds();
+                for (size_t i = 0; i < 3; i++)
+                    writeFloat(stream, bounds.min[i]);
+                for (size_t i = 0; i < 3; i++)
+                    writeFloat(stream, bounds.max[i]);
+                
+                const Model::ModelDefinition::List& modelDefinitions = pointDefinition.modelDefinitions();
+                writeUInt32(stream, static_cast<uint32_t>(modelDefinitions.size()));
+                Model::ModelDefinition::List::const_iterator it, end;
+                for (it = modelDefinitions.begin(), end = modelDefinitions.end(); it != end; ++it)
+                    writeModelDefinition(stream, **it);
+            }
+            
+            const Model::PropertyDefinition::List& propertyDefinitions = definition.propertyDefinitions();
+            writeUInt32(stream, static_cast<uint32_t>(propertyDefinitions.size()));
+            Model::PropertyDefinition::List::const_iterator it, end;
+            for (it = propertyDefinitions.begin(), end = propertyDefinitions.end(); it != end; ++it)
+                writePropertyDefinition(stream, **it);
+        }
+
+        EntityDefinitionCache::EntityDefinitionCache(const String& definitionPath, const MappedFile& definitionFile, const String& cacheDirectory, const Color& defaultColor) :
+        m_definitionPath(definitionPath),
+        m_sourceSize(static_cast<uint32_t>(definitionFile.size())),
+        m_sourceModificationTime(0),
+        m_defaultColor(defaultColor) {
+            FileManager fileManager;
+            m_sourceModificationTime = static_cast<int64_t>(fileManager.modificationTime(m_definitionPath));
+            if (cacheDirectory.empty())
+                return;
+            
+            // definition files with the same name can live in different directories, so the full path is hashed (FNV-1a)
+            uint32_t pathHash = 2166136261u;
+            for (size_t i = 0; i < m_definitionPath.size(); i++) {
+                pathHash ^= static_cast<uint8_t>(m_definitionPath[i]);
+                pathHash *= 16777619u;
+            }
+            
+            const StringList components = fileManager.pathComponents(m_definitionPath);
+            StringStream fileName;
+            if (!components.empty())
+                fileName << components.back() << "-";
+            fileName << std::hex << std::setw(8) << std::setfill('0') << pathHash;
+            
+            const String directory = fileManager.appendPath(cacheDirectory, EntityDefinitionCacheLayout::Directory);
+            m_cachePath = fileManager.appendExtension(fileManager.appendPath(directory, fileName.str()), EntityDefinitionCacheLayout::Extension);
+        }
+        
+        bool EntityDefinitionCache::read(Model::EntityDefinitionList& definitions) {
+            FileManager fileManager;
+            if (m_cachePath.empty() || !fileManager.exists(m_cachePath))
+                return false;
+            
+            MappedFile::Ptr file = fileManager.mapFile(m_cachePath);
+            if (file.get() == NULL)
+                return false;
+            
+            Model::EntityDefinitionList result;
+            try {
+                Reader reader(file->begin(), file->end());
+                
+                char magic[EntityDefinitionCacheLayout::HeaderMagicLength];
+                for (size_t i = 0; i < EntityDefinitionCacheLayout::HeaderMagicLength; i++)
+                    magic[i] = static_cast<char>(reader.readUInt8());
+                if (EntityDefinitionCacheLayout::HeaderMagic.compare(0, EntityDefinitionCacheLayout::HeaderMagicLength, magic, EntityDefinitionCacheLayout::HeaderMagicLength) != 0)
+                    return false;
+                if (reader.readUInt32() != EntityDefinitionCacheLayout::Version)
+                    return false;
+                if (reader.readString() != m_definitionPath)
+                    return false;
+                if (reader.readUInt32() != m_sourceSize || reader.readInt64() != m_sourceModificationTime)
+                    return false;
+                for (size_t i = 0; i < 4; i++)
+                    if (reader.readFloat() != m_defaultColor[i])
+                        return false;
+                
+                // the counts are checked against the remaining data so that a damaged cache cannot request huge lists
+                const size_t definitionCount = reader.readCount(sizeof(uint8_t) + 2 * sizeof(uint32_t) + 4 * sizeof(float) + sizeof(uint32_t));
+                result.reserve(definitionCount);
+                for (size_t i = 0; i < definitionCount; i++)
+                    result.push_back(readDefinition(reader));
+                
+                if (!reader.atEnd())
+                    throw IOException("Unexpected trailing data in entity definition cache");
+            } catch (IOException&) {
+                Utility::deleteAll(result);
+                return false;
+            }
+            
+            definitions.insert(definitions.end(), result.begin(), result.end());
+            return true;
+        }
+        
+        bool EntityDefinitionCache::write(const Model::EntityDefinitionList& definitions) {
+            FileManager fileManager;
+            if (m_cachePath.empty() || !makeDirectories(fileManager, fileManager.deleteLastPathComponent(m_cachePath)))
+                return false;
+            
+            // write to a temporary file first so that an interrupted write never leaves a damaged cache behind
+            const String tempPath = fileManager.appendExtension(m_cachePath, "tmp");
+            
+            std::fstream stream(tempPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream.is_open())
+                return false;
+            
+            stream.write(EntityDefinitionCacheLayout::HeaderMagic.data(), EntityDefinitionCacheLayout::HeaderMagicLength);
+            writeUInt32(stream, EntityDefinitionCacheLayout::Version);
+            writeString(stream, m_definitionPath);
+            writeUInt32(stream, m_sourceSize);
+            writeInt64(stream, m_sourceModificationTime);
+            for (size_t i = 0; i < 4; i++)
+                writeFloat(stream, m_defaultColor[i]);
+            
+            writeUInt32(stream, static_cast<uint32_t>(definitions.size()));
+            Model::EntityDefinitionList::const_iterator it, end;
+            for (it = definitions.begin(), end = definitions.end(); it != end; ++it)
+                writeDefinition(stream, **it);
+            
+            const bool success = stream.good();
+            stream.close();
+            
+            if (!success || !fileManager.moveFile(tempPath, m_cachePath, true)) {
+                fileManager.deleteFile(tempPath);
+                return false;
+            }
+            return true;
+        }
+    }
+}
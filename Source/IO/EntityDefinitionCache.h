@@ -0,0 +1,142 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__EntityDefinitionCache__
+#define __TrenchBroom__EntityDefinitionCache__
+
+#include "IO/FileManager.h"
+#include "Model/EntityDefinitionTypes.h"
+#include "Model/PropertyDefinition.h"
+#include "Utility/Color.h"
+#include "Utility/String.h"
+
+#include <iostream>
+
+#ifdef _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+namespace TrenchBroom {
+    namespace Model {
+        class ModelDefinition;
+    }
+    
+    namespace IO {
+        namespace EntityDefinitionCacheLayout {
+            static const String Directory               = "EntityDefinitions";
+            static const String Extension               = "tbcache";
+            static const String HeaderMagic             = "TBDC";
+            static const unsigned int HeaderMagicLength = 0x4;
+            static const uint32_t Version               = 2;
+        }
+        
+        /**
+         * Reads and writes a compiled binary form of the definitions parsed from a DEF or FGD file. The cache is
+         * stored in the given cache directory and is only used if the definition file still has the same path, size
+         * and modification time, and if it was compiled with the same default entity color. Values are stored in
+         * native byte order because a cache is only ever read on the machine that wrote it.
+         */
+        class EntityDefinitionCache {
+        private:
+            typedef enum {
+                PlainPropertyTag,
+                StringPropertyTag,
+                IntegerPropertyTag,
+                FloatPropertyTag,
+                ChoicePropertyTag,
+                FlagsPropertyTag
+            } PropertyTag;
+            
+            typedef enum {
+                NoConditionTag,
+                PropertyConditionTag,
+                FlagConditionTag
+            } ConditionTag;
+            
+            class Reader {
+            private:
+                char* m_cursor;
+                char* m_end;
+                
+                void check(size_t size);
+            public:
+                Reader(char* begin, char* end);
+                
+                uint8_t readUInt8();
+                uint32_t readUInt32();
+                int32_t readInt32();
+                int64_t readInt64();
+                float readFloat();
+                String readString();
+                
+                /**
+                 * Reads the number of elements of a list whose elements take at least the given number of bytes each.
+                 * Throws an IOException if the remaining data cannot hold that many elements.
+                 */
+                size_t readCount(size_t minimumElementSize);
+                
+                inline bool atEnd() const {
+                    return m_cursor == m_end;
+                }
+            };
+            
+            String m_definitionPath;
+            String m_cachePath;
+            uint32_t m_sourceSize;
+            int64_t m_sourceModificationTime;
+            Color m_defaultColor;
+            
+            Model::PropertyDefinition::Ptr readPropertyDefinition(Reader& reader);
+            Model::ModelDefinition* readModelDefinition(Reader& reader);
+            Model::EntityDefinition* readDefinition(Reader& reader);
+            
+            void writeUInt8(std::ostream& stream, uint8_t value);
+            void writeUInt32(std::ostream& stream, uint32_t value);
+            void writeInt32(std::ostream& stream, int32_t value);
+            void writeInt64(std::ostream& stream, int64_t value);
+            void writeFloat(std::ostream& stream, float value);
+            void writeString(std::ostream& stream, const String& str);
+            void writePropertyDefinition(std::ostream& stream, const Model::PropertyDefinition& definition);
+            void writeModelDefinition(std::ostream& stream, const Model::ModelDefinition& definition);
+            void writeDefinition(std::ostream& stream, const Model::EntityDefinition& definition);
+        public:
+            EntityDefinitionCache(const String& definitionPath, const MappedFile& definitionFile, const String& cacheDirectory, const Color& defaultColor);
+            
+            inline const String& cachePath() const {
+                return m_cachePath;
+            }
+            
+            /**
+             * Loads the cached definitions and appends them to the given list. Returns false if there is no cache or
+             * if it is stale or damaged, in which case the given list remains unchanged.
+             */
+            bool read(Model::EntityDefinitionList& definitions);
+            
+            /**
+             * Writes the given definitions to the cache file. Returns false if the cache could not be written, e.g.
+             * because there is no cache directory or it cannot be created.
+             */
+            bool write(const Model::EntityDefinitionList& definitions);
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__EntityDefinitionCache__) */
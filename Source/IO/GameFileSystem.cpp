@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "GameFileSystem.h"
+
+#include "IO/Pak.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace IO {
+        GameFileSystem* GameFileSystem::sharedFileSystem = NULL;
+
+        void GameFileSystem::addPakEntries(Directory& directory, const String& searchPath) {
+            const PakManager::PakList& paks = PakManager::sharedManager->paks(searchPath);
+            PakManager::PakList::const_iterator pakIt, pakEnd;
+            for (pakIt = paks.begin(), pakEnd = paks.end(); pakIt != pakEnd; ++pakIt) {
+                const PakEntry::List& entries = pakIt->entries();
+                PakEntry::List::const_iterator entryIt, entryEnd;
+                for (entryIt = entries.begin(), entryEnd = entries.end(); entryIt != entryEnd; ++entryIt) {
+                    const FileView data = entryIt->data();
+                    directory[normalizePath(entryIt->name())] = Entry(data.begin(), data.end());
+                }
+            }
+        }
+
+        void GameFileSystem::addLooseFiles(Directory& directory, const String& directoryPath, const String& prefix) {
+            FileManager fileManager;
+            const StringList names = fileManager.directoryContents(directoryPath);
+            StringList::const_iterator it, end;
+            for (it = names.begin(), end = names.end(); it != end; ++it) {
+                const String& name = *it;
+                const String path = fileManager.appendPath(directoryPath, name);
+                const String relativePath = prefix.empty() ? name : prefix + "/" + name;
+                if (fileManager.isDirectory(path))
+                    addLooseFiles(directory, path, relativePath);
+                else
+                    directory[normalizePath(relativePath)] = Entry(path);
+            }
+        }
+
+        GameFileSystem::SearchPath& GameFileSystem::searchPath(const String& path) {
+            SearchPathMap::iterator it = m_searchPaths.find(path);
+            if (it != m_searchPaths.end())
+                return it->second;
+
+            SearchPath& searchPath = m_searchPaths[path];
+            addPakEntries(searchPath.directory, path);
+            addLooseFiles(searchPath.directory, path, "");
+            return searchPath;
+        }
+
+        String GameFileSystem::normalizePath(const String& path) {
+            String result = Utility::toLower(path);
+            std::replace(result.begin(), result.end(), '\\', '/');
+
+            size_t first = result.find_first_not_of('/');
+            if (first == String::npos)
+                return "";
+            if (first > 0)
+                result.erase(0, first);
+            return result;
+        }
+
+        GameFileSystem::GameFileSystem() {}
+
+        FileView GameFileSystem::findFile(const String& path, const StringList& searchPaths) {
+            const String normalizedPath = normalizePath(path);
+
+            StringList::const_reverse_iterator it, end;
+            for (it = searchPaths.rbegin(), end = searchPaths.rend(); it != end; ++it) {
+                SearchPath& searchPath = this->searchPath(*it);
+                Directory::iterator entryIt = searchPath.directory.find(normalizedPath);
+                if (entryIt == searchPath.directory.end())
+                    continue;
+
+                Entry& entry = entryIt->second;
+                if (entry.begin == NULL && !entry.looseFilePath.empty()) {
+                    FileManager fileManager;
+                    MappedFile::Ptr file = fileManager.mapFile(entry.looseFilePath);
+                    if (file.get() == NULL)
+                        return FileView();
+
+                    searchPath.looseFiles.push_back(file);
+                    entry.begin = file->begin();
+                    entry.end = file->end();
+                    entry.looseFilePath.clear();
+                }
+
+                return FileView(entry.begin, entry.end);
+            }
+
+            return FileView();
+        }
+
+        void GameFileSystem::invalidate() {
+            m_searchPaths.clear();
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__GameFileSystem__
+#define __TrenchBroom__GameFileSystem__
+
+#include "IO/FileManager.h"
+#include "Utility/String.h"
+#include "Utility/UnorderedMap.h"
+
+#include <map>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        /**
+         * Finds game files in the pak files and loose files of a list of search paths. The file
+         * found in the last search path wins the lookup.
+         *
+         * Every search path has its own directory which maps each normalized file path to the file
+         * that wins within that search path, where loose files take precedence over pak entries
+         * and later pak files take precedence over earlier ones. The directories are built lazily
+         * on the first lookup in a search path and kept until the file system is invalidated, so
+         * switching between lists of search paths which share some paths does not rebuild them.
+         */
+        class GameFileSystem {
+        private:
+            class Entry {
+            public:
+                char* begin;
+                char* end;
+                String looseFilePath;
+
+                Entry() :
+                begin(NULL),
+                end(NULL) {}
+
+                Entry(char* i_begin, char* i_end) :
+                begin(i_begin),
+                end(i_end) {}
+
+                Entry(const String& i_looseFilePath) :
+                begin(NULL),
+                end(NULL),
+                looseFilePath(i_looseFilePath) {}
+            };
+
+            typedef std::tr1::unordered_map<String, Entry> Directory;
+            typedef std::vector<MappedFile::Ptr> MappedFileList;
+
+            class SearchPath {
+            public:
+                Directory directory;
+                MappedFileList looseFiles;
+            };
+
+            typedef std::map<String, SearchPath> SearchPathMap;
+
+            SearchPathMap m_searchPaths;
+
+            static void addPakEntries(Directory& directory, const String& searchPath);
+            static void addLooseFiles(Directory& directory, const String& directoryPath, const String& prefix);
+            SearchPath& searchPath(const String& path);
+        public:
+            static GameFileSystem* sharedFileSystem;
+
+            static String normalizePath(const String& path);
+
+            GameFileSystem();
+
+            /**
+             * Returns a view of the contents of the file with the given path relative to the given
+             * search paths, or an invalid view if no such file exists. The returned view remains
+             * valid until this file system is invalidated.
+             */
+            FileView findFile(const String& path, const StringList& searchPaths);
+            void invalidate();
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__GameFileSystem__) */
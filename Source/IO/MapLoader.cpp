@@ -0,0 +1,121 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapLoader.h"
+
+#include "IO/MapParser.h"
+#include "Model/Brush.h"
+#include "Model/Entity.h"
+#include "Utility/Atomic.h"
+#include "Utility/Console.h"
+
+namespace TrenchBroom {
+    namespace IO {
+        wxThread::ExitCode MapLoader::Entry() {
+            Progress progress(m_percent);
+            MapParser parser(m_file->begin(), m_file->end(), m_console);
+            parser.parseMap(m_worldBounds, *this, &progress);
+            Utility::atomicIncrement(m_finished);
+            return (wxThread::ExitCode)0;
+        }
+        
+        void MapLoader::entityBegun(Model::Entity* entity) {
+            Item* item = new Item(Item::EntityBegun);
+            item->entity = entity;
+            m_queue.push(item);
+        }
+        
+        void MapLoader::propertyParsed(const String& key, const String& value) {
+            Item* item = new Item(Item::PropertyParsed);
+            item->key = key;
+            item->value = value;
+            m_queue.push(item);
+        }
+        
+        void MapLoader::brushParsed(Model::Brush* brush) {
+            Item* item = new Item(Item::BrushParsed);
+            item->brush = brush;
+            m_queue.push(item);
+        }
+        
+        void MapLoader::entityEnded(size_t firstLine, size_t lineCount) {
+            Item* item = new Item(Item::EntityEnded);
+            item->firstLine = firstLine;
+            item->lineCount = lineCount;
+            m_queue.push(item);
+        }
+        
+        bool MapLoader::cancelled() {
+            return TestDestroy();
+        }
+        
+        MapLoader::MapLoader(MappedFile::Ptr file, const BBoxf& worldBounds, Utility::Console& console) :
+        wxThread(wxTHREAD_JOINABLE),
+        m_file(file),
+        m_worldBounds(worldBounds),
+        m_console(console),
+        m_percent(0),
+        m_finished(0) {
+            Create();
+            Run();
+        }
+        
+        MapLoader::~MapLoader() {
+            Item* item = m_queue.popAll();
+            while (item != NULL) {
+                delete item->entity;
+                delete item->brush;
+                Item* next = item->next;
+                delete item;
+                item = next;
+            }
+        }
+        
+        void MapLoader::deliver(MapParserListener& listener) {
+            Item* item = m_queue.popAll();
+            while (item != NULL) {
+                switch (item->type) {
+                    case Item::EntityBegun:
+                        listener.entityBegun(item->entity);
+                        break;
+                    case Item::PropertyParsed:
+                        listener.propertyParsed(item->key, item->value);
+                        break;
+                    case Item::BrushParsed:
+                        listener.brushParsed(item->brush);
+                        break;
+                    case Item::EntityEnded:
+                        listener.entityEnded(item->firstLine, item->lineCount);
+                        break;
+                }
+                Item* next = item->next;
+                delete item;
+                item = next;
+            }
+        }
+        
+        void MapLoader::finish() {
+            Wait();
+        }
+        
+        void MapLoader::cancel() {
+            Delete();
+        }
+    }
+}
@@ -0,0 +1,152 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__MapLoader__
+#define __TrenchBroom__MapLoader__
+
+#include "IO/AbstractFileManager.h"
+#include "IO/MapParserListener.h"
+#include "Utility/AtomicQueue.h"
+#include "Utility/ProgressIndicator.h"
+#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+#include <wx/thread.h>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class Brush;
+        class Entity;
+    }
+    
+    namespace Utility {
+        class Console;
+    }
+    
+    namespace IO {
+        /**
+         * Parses a map file and builds the brush geometry on a background thread. The parsed objects are queued and
+         * handed to a listener on the main thread whenever deliver is called, so that the document can show the map
+         * while it is still being loaded.
+         */
+        class MapLoader : public wxThread, public MapParserListener {
+        private:
+            class Item {
+            public:
+                typedef enum {
+                    EntityBegun,
+                    PropertyParsed,
+                    BrushParsed,
+                    EntityEnded
+                } Type;
+                
+                Item* next;
+                Type type;
+                Model::Entity* entity;
+                Model::Brush* brush;
+                String key;
+                String value;
+                size_t firstLine;
+                size_t lineCount;
+                
+                Item(Type i_type) :
+                next(NULL),
+                type(i_type),
+                entity(NULL),
+                brush(NULL),
+                firstLine(0),
+                lineCount(0) {}
+            };
+            
+            class Progress : public Utility::ProgressIndicator {
+            private:
+                volatile long& m_percent;
+            protected:
+                void doReset() {
+                    m_percent = 0;
+                }
+                
+                void doUpdate() {
+                    m_percent = static_cast<long>(percent());
+                }
+            public:
+                Progress(volatile long& percent) :
+                m_percent(percent) {}
+                
+                void setText(const String& text) {}
+            };
+            
+            MappedFile::Ptr m_file;
+            const BBoxf& m_worldBounds;
+            Utility::Console& m_console;
+            Utility::AtomicQueue<Item> m_queue;
+            volatile long m_percent;
+            volatile long m_finished;
+            
+            ExitCode Entry();
+            
+            void entityBegun(Model::Entity* entity);
+            void propertyParsed(const String& key, const String& value);
+            void brushParsed(Model::Brush* brush);
+            void entityEnded(size_t firstLine, size_t lineCount);
+            bool cancelled();
+        public:
+            /**
+             * The loaded entities and brushes keep a reference to the given world bounds, so they must outlive both
+             * the loader and the loaded objects.
+             */
+            MapLoader(MappedFile::Ptr file, const BBoxf& worldBounds, Utility::Console& console);
+            
+            /**
+             * Deletes all objects which have not been delivered. The loader must have been finished or cancelled.
+             */
+            ~MapLoader();
+            
+            inline int percent() const {
+                return static_cast<int>(m_percent);
+            }
+            
+            /**
+             * Returns true once the entire file has been parsed. Objects may still be waiting to be delivered.
+             */
+            inline bool finished() const {
+                return m_finished != 0;
+            }
+            
+            /**
+             * Passes all objects parsed so far to the given listener on the calling thread.
+             */
+            void deliver(MapParserListener& listener);
+            
+            /**
+             * Waits until the entire file has been parsed.
+             */
+            void finish();
+            
+            /**
+             * Stops parsing as soon as the current brush is done and waits for the thread to exit.
+             */
+            void cancel();
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__MapLoader__) */
@@ -27,6 +27,7 @@
 #include "Utility/Console.h"
 #include "Utility/List.h"
 #include "Utility/ProgressIndicator.h"
+#include "Utility/Profiler.h"
 
 namespace TrenchBroom {
     namespace IO {
@@ -126,15 +127,16 @@ namespace TrenchBroom {
             return vec;
         }
 
-        Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator) {
+        bool MapParser::parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, MapParserListener& listener, Utility::ProgressIndicator* indicator) {
             Token token = m_tokenizer.nextToken();
             if (token.type() == TokenType::Eof)
-                return NULL;
+                return false;
             
             expect(TokenType::OBrace | TokenType::CBrace, token);
             if (token.type() == TokenType::CBrace)
-                return NULL;
+                return false;
             
+            // owned by this method until it has been passed to the listener
             Model::Entity* entity = new Model::Entity(worldBounds);
             size_t firstLine = token.line();
             
@@ -144,7 +146,10 @@ namespace TrenchBroom {
                         String key = token.data();
                         expect(TokenType::String, token = m_tokenizer.nextToken());
                         String value = token.data();
-                        entity->setProperty(key, value);
+                        if (entity != NULL)
+                            entity->setProperty(key, value);
+                        else
+                            listener.propertyParsed(key, value);
                         if (facePointFormat == Unknown && key == Model::Entity::FacePointFormatKey) {
                             if (value == "1") {
                                 facePointFormat = Integer;
@@ -159,12 +164,18 @@ namespace TrenchBroom {
                             m_console.info("Assuming floating point plane coordinates");
                             facePointFormat = Float;
                         }
+                        if (entity != NULL) {
+                            listener.entityBegun(entity);
+                            entity = NULL;
+                        }
                         m_tokenizer.pushToken(token);
                         bool moreBrushes = true;
                         while (moreBrushes) {
+                            if (listener.cancelled())
+                                return false;
                             Model::Brush* brush = parseBrush(worldBounds, facePointFormat == Integer, indicator);
                             if (brush != NULL)
-                                entity->addBrush(*brush);
+                                listener.brushParsed(brush);
                             expect(TokenType::OBrace | TokenType::CBrace, token = m_tokenizer.nextToken());
                             moreBrushes = (token.type() == TokenType::OBrace);
                             m_tokenizer.pushToken(token);
@@ -178,8 +189,10 @@ namespace TrenchBroom {
                         }
                         if (indicator != NULL)
                             indicator->update(static_cast<int>(token.position()));
-                        entity->setFilePosition(firstLine, token.line() - firstLine);
-                        return entity;
+                        if (entity != NULL)
+                            listener.entityBegun(entity);
+                        listener.entityEnded(firstLine, token.line() - firstLine);
+                        return true;
                     }
                     default:
                         delete entity;
@@ -187,7 +200,55 @@ namespace TrenchBroom {
                 }
             }
             
-            return entity;
+            if (entity != NULL)
+                listener.entityBegun(entity);
+            return true;
+        }
+        
+        /**
+         * Collects a single entity with its brushes. The entity is deleted unless it has been released, e.g. when
+         * the parser throws an exception.
+         */
+        class EntityCollector : public MapParserListener {
+        private:
+            Model::Entity* m_entity;
+        public:
+            EntityCollector() :
+            m_entity(NULL) {}
+            
+            ~EntityCollector() {
+                delete m_entity;
+            }
+            
+            inline Model::Entity* release() {
+                Model::Entity* entity = m_entity;
+                m_entity = NULL;
+                return entity;
+            }
+            
+            void entityBegun(Model::Entity* entity) {
+                assert(m_entity == NULL);
+                m_entity = entity;
+            }
+            
+            void propertyParsed(const String& key, const String& value) {
+                m_entity->setProperty(key, value);
+            }
+            
+            void brushParsed(Model::Brush* brush) {
+                m_entity->addBrush(*brush);
+            }
+            
+            void entityEnded(size_t firstLine, size_t lineCount) {
+                m_entity->setFilePosition(firstLine, lineCount);
+            }
+        };
+        
+        Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator) {
+            EntityCollector collector;
+            if (!parseEntity(worldBounds, facePointFormat, collector, indicator))
+                return NULL;
+            return collector.release();
         }
 
         MapParser::MapParser(const char* begin, const char* end, Utility::Console& console) :
@@ -205,6 +266,7 @@ namespace TrenchBroom {
         m_size(str.size()) {}
 
         void MapParser::parseMap(Model::Map& map, Utility::ProgressIndicator* indicator) {
+            Utility::ScopedTimer timer("MapParser::parseMap");
             Model::Entity* entity = NULL;
             
             if (indicator != NULL) indicator->reset(static_cast<int>(m_size));
@@ -220,6 +282,21 @@ namespace TrenchBroom {
                 indicator->update(static_cast<int>(m_size));
         }
         
+        void MapParser::parseMap(const BBoxf& worldBounds, MapParserListener& listener, Utility::ProgressIndicator* indicator) {
+            Utility::ScopedTimer timer("MapParser::parseMap");
+            
+            if (indicator != NULL) indicator->reset(static_cast<int>(m_size));
+            try {
+                FacePointFormat facePointFormat = Unknown;
+                while (!listener.cancelled() && parseEntity(worldBounds, facePointFormat, listener, indicator));
+            } catch (MapParserException& e) {
+                m_console.error(e.what());
+            }
+            
+            if (indicator != NULL)
+                indicator->update(static_cast<int>(m_size));
+        }
+        
         Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
             FacePointFormat format = forceIntegerFacePoints ? Integer : Float;
             return parseEntity(worldBounds, format, indicator);
@@ -351,7 +428,7 @@ namespace TrenchBroom {
             size_t oldSize = entities.size();
             try {
                 Model::Entity* entity = NULL;
-                while ((entity = parseEntity(worldBounds, forceIntegerFacePoints ? Integer : Float, NULL)) != NULL)
+                while ((entity = parseEntity(worldBounds, forceIntegerFacePoints, NULL)) != NULL)
                     entities.push_back(entity);
                 return !entities.empty();
             } catch (MapParserException&) {
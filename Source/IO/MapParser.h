@@ -21,6 +21,7 @@
 #define __TrenchBroom__MapParser__
 
 #include "IO/ByteBuffer.h"
+#include "IO/MapParserListener.h"
 #include "IO/StreamTokenizer.h"
 #include "Model/BrushTypes.h"
 #include "Model/EntityTypes.h"
@@ -152,12 +153,19 @@ namespace TrenchBroom {
             
             Vec3f parseVector();
 
+            bool parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, MapParserListener& listener, Utility::ProgressIndicator* indicator);
             Model::Entity* parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator);
         public:
             MapParser(const char* begin, const char* end, Utility::Console& console);
             MapParser(const String& str, Utility::Console& console);
             
             void parseMap(Model::Map& map, Utility::ProgressIndicator* indicator);
+            
+            /**
+             * Parses the entire map and passes each entity, property and brush to the given listener as soon as it
+             * has been parsed. Stops early if the listener is cancelled.
+             */
+            void parseMap(const BBoxf& worldBounds, MapParserListener& listener, Utility::ProgressIndicator* indicator);
             Model::Entity* parseEntity(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator);
             Model::Brush* parseBrush(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator);
             Model::Face* parseFace(const BBoxf& worldBounds, bool forceIntegerFacePoints);
@@ -0,0 +1,70 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_MapParserListener_h
+#define TrenchBroom_MapParserListener_h
+
+#include "Utility/String.h"
+
+#include <cstddef>
+
+namespace TrenchBroom {
+    namespace Model {
+        class Brush;
+        class Entity;
+    }
+    
+    namespace IO {
+        /**
+         * Receives the objects of a map file one at a time while it is being parsed. An entity is passed before its
+         * first brush together with all properties that precede that brush, so that large entities such as worldspawn
+         * can be processed brush by brush.
+         */
+        class MapParserListener {
+        public:
+            virtual ~MapParserListener() {}
+            
+            /**
+             * Called when an entity has been parsed up to its first brush or its closing brace. The listener takes
+             * ownership of the entity.
+             */
+            virtual void entityBegun(Model::Entity* entity) = 0;
+            
+            /**
+             * Called for properties of the current entity which follow one of its brushes.
+             */
+            virtual void propertyParsed(const String& key, const String& value) = 0;
+            
+            /**
+             * Called for each brush of the current entity. The listener takes ownership of the brush.
+             */
+            virtual void brushParsed(Model::Brush* brush) = 0;
+            virtual void entityEnded(size_t firstLine, size_t lineCount) = 0;
+            
+            /**
+             * Polled by the parser between brushes. Parsing stops once this returns true.
+             */
+            virtual bool cancelled() {
+                return false;
+            }
+        };
+    }
+}
+
+#endif
@@ -45,30 +45,34 @@ namespace TrenchBroom {
 
         class PakEntry {
             String m_name;
-            MappedFile::Ptr m_view;
+            char* m_begin;
+            char* m_end;
         public:
-            PakEntry() {}
+            typedef std::vector<PakEntry> List;
+
+            PakEntry() :
+            m_begin(NULL),
+            m_end(NULL) {}
 
             PakEntry(const String& name, char* begin, char* end) :
             m_name(name),
-            m_view(MappedFile::Ptr(new MappedFile(begin, end))) {}
+            m_begin(begin),
+            m_end(end) {}
 
             inline const String& name() const {
                 return m_name;
             }
 
-            inline MappedFile::Ptr data() const {
-                return m_view;
+            inline FileView data() const {
+                return FileView(m_begin, m_end);
             }
         };
 
         class Pak {
         private:
-            typedef std::map<String, PakEntry> PakDirectory;
-
             String m_path;
             MappedFile::Ptr m_file;
-            PakDirectory m_directory;
+            PakEntry::List m_entries;
         public:
             Pak(const String& path, MappedFile::Ptr file);
 
@@ -76,7 +80,9 @@ namespace TrenchBroom {
                 return m_path;
             }
 
-            MappedFile::Ptr entry(const String& name);
+            inline const PakEntry::List& entries() const {
+                return m_entries;
+            }
         };
 
         class ComparePaksByPath {
@@ -87,16 +93,20 @@ namespace TrenchBroom {
         };
 
         class PakManager {
-        private:
+        public:
             typedef std::vector<Pak> PakList;
+        private:
             typedef std::map<String, PakList> PakMap;
 
             PakMap m_paks;
-            bool findPaks(const String& path, PakList& result);
         public:
             static PakManager* sharedManager;
 
-            MappedFile::Ptr entry(const String& name, const String& searchPath);
+            /**
+             * Returns the pak files in the given directory, sorted by path. The directories of the
+             * pak files are read once and cached for the lifetime of this manager.
+             */
+            const PakList& paks(const String& path);
         };
     }
 }
@@ -252,9 +252,9 @@ namespace TrenchBroom {
 
             console.info("Loading '%s' (searching %s)", name.c_str(), pathList.c_str());
 
-            IO::MappedFile::Ptr file = IO::findGameFile(name, paths);
-            if (file.get() != NULL) {
-                Alias* alias = new Alias(name, file->begin(), file->end());
+            IO::FileView file = IO::findGameFile(name, paths);
+            if (file.valid()) {
+                Alias* alias = new Alias(name, file.begin(), file.end());
                 m_aliases[key] = alias;
                 return alias;
             }
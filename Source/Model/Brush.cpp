@@ -36,6 +36,43 @@ namespace TrenchBroom {
             m_selectedFaceCount = 0;
         }
 
+        void Brush::beginEdit(BrushEdit& edit) {
+            assert(!edit.prepared());
+
+            // the operation updates the points of the faces, which are shared with the copy of the geometry
+            edit.m_planes.resize(m_faces.size());
+            for (size_t i = 0; i < m_faces.size(); i++) {
+                BrushEdit::FacePlane& plane = edit.m_planes[i];
+                plane.face = m_faces[i];
+                plane.face->getPoints(plane.points[0], plane.points[1], plane.points[2]);
+                plane.boundary = plane.face->boundary();
+            }
+
+            edit.m_geometry = new BrushGeometry(*m_geometry);
+            edit.m_geometry->restoreFaceSides();
+        }
+
+        bool Brush::endEdit(BrushEdit& edit, bool success) {
+            // swap the changed face planes with the recorded ones, so that the brush looks unchanged until the edit
+            // is committed
+            BrushEdit::FacePlaneList::iterator planeIt, planeEnd;
+            for (planeIt = edit.m_planes.begin(), planeEnd = edit.m_planes.end(); planeIt != planeEnd; ++planeIt) {
+                BrushEdit::FacePlane& plane = *planeIt;
+                FacePoints points;
+                plane.face->getPoints(points[0], points[1], points[2]);
+                const Planef boundary = plane.face->boundary();
+                plane.face->restorePlane(plane.points, plane.boundary);
+                for (size_t i = 0; i < 3; i++)
+                    plane.points[i] = points[i];
+                plane.boundary = boundary;
+            }
+            m_geometry->restoreFaceSides();
+
+            if (!success)
+                discardEdit(edit);
+            return success;
+        }
+
         Brush::Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces) :
         MapObject(),
         m_geometry(NULL),
@@ -209,6 +246,13 @@ namespace TrenchBroom {
             return previous;
         }
 
+        bool Brush::canTransformGeometry(const Mat4f& pointTransform) const {
+            // integer face points are recomputed from the transformed planes, which moves the planes
+            if (m_forceIntegerFacePoints)
+                return false;
+            return axisPermutationMatrix(pointTransform);
+        }
+
         void Brush::setForceIntegerFacePoints(bool forceIntegerFacePoints) {
             FaceList::const_iterator faceIt, faceEnd;
             for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
@@ -220,7 +264,46 @@ namespace TrenchBroom {
             rebuildGeometry();
         }
 
-        void Brush::rebuildGeometry() {
+        bool Brush::convertFacePoints(bool forceIntegerFacePoints, Utility::PlanePointCache& cache, FacePointBackup& backup) {
+            backup.m_forceIntegerFacePoints = m_forceIntegerFacePoints;
+            backup.m_planes.resize(m_faces.size());
+            for (size_t i = 0; i < m_faces.size(); i++) {
+                FacePointBackup::FacePlane& plane = backup.m_planes[i];
+                plane.face = m_faces[i];
+                plane.face->getPoints(plane.points[0], plane.points[1], plane.points[2]);
+                plane.boundary = plane.face->boundary();
+            }
+
+            try {
+                FaceList::const_iterator faceIt, faceEnd;
+                for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
+                    Face& face = **faceIt;
+                    face.setForceIntegerFacePoints(forceIntegerFacePoints, &cache);
+                }
+            } catch (GeometryException&) {
+                revertFacePoints(backup);
+                backup.m_planes.clear();
+                return false;
+            }
+
+            m_forceIntegerFacePoints = forceIntegerFacePoints;
+            return true;
+        }
+
+        void Brush::revertFacePoints(const FacePointBackup& backup) {
+            FacePointBackup::FacePlaneList::const_iterator planeIt, planeEnd;
+            for (planeIt = backup.m_planes.begin(), planeEnd = backup.m_planes.end(); planeIt != planeEnd; ++planeIt) {
+                const FacePointBackup::FacePlane& plane = *planeIt;
+                plane.face->restorePlane(plane.points, plane.boundary, backup.m_forceIntegerFacePoints);
+            }
+            m_forceIntegerFacePoints = backup.m_forceIntegerFacePoints;
+        }
+
+        void Brush::commitFacePoints() {
+            buildGeometry();
+        }
+
+        void Brush::buildGeometry() {
             delete m_geometry;
             m_geometry = new BrushGeometry(m_worldBounds);
 
@@ -243,9 +326,11 @@ namespace TrenchBroom {
             for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
                 Face* face = *it;
                 face->invalidateTexAxes();
-                face->invalidateVertexCache();
             }
+        }
 
+        void Brush::rebuildGeometry() {
+            buildGeometry();
             if (m_entity != NULL)
                 m_entity->invalidateGeometry();
         }
@@ -257,7 +342,20 @@ namespace TrenchBroom {
                 face.transform(pointTransform, vectorTransform, lockTextures, invertOrientation);
             }
 
-            rebuildGeometry();
+            if (!canTransformGeometry(pointTransform)) {
+                rebuildGeometry();
+                return;
+            }
+
+            m_geometry->transform(pointTransform, matrixDeterminant(pointTransform) < 0.0f);
+            if (!m_worldBounds.contains(m_geometry->bounds)) {
+                // let the world bounds clip the brush
+                rebuildGeometry();
+                return;
+            }
+
+            if (m_entity != NULL)
+                m_entity->invalidateGeometry();
         }
 
         bool Brush::clip(Face& face) {
@@ -347,113 +445,66 @@ namespace TrenchBroom {
             rebuildGeometry();
         }
 
-        bool Brush::canMoveVertices(const Vec3f::List& vertexPositions, const Vec3f& delta) const {
-            return m_geometry->canMoveVertices(m_worldBounds, vertexPositions, delta);
-        }
-
-        Vec3f::List Brush::moveVertices(const Vec3f::List& vertexPositions, const Vec3f& delta) {
-            FaceSet newFaces;
-            FaceSet droppedFaces;
-
-            const Vec3f::List newVertexPositions = m_geometry->moveVertices(m_worldBounds, vertexPositions, delta, newFaces, droppedFaces);
-
-            for (FaceSet::iterator it = droppedFaces.begin(); it != droppedFaces.end(); ++it) {
-                Face* face = *it;
-                face->setBrush(NULL);
-                m_faces.erase(std::remove(m_faces.begin(), m_faces.end(), face), m_faces.end());
-                delete face;
-            }
-
-            for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
-                Face* face = *it;
-                face->invalidateTexAxes();
-                face->invalidateVertexCache();
-            }
-
-            for (FaceSet::iterator it = newFaces.begin(); it != newFaces.end(); ++it) {
-                Face* face = *it;
-                face->setBrush(this);
-                m_faces.push_back(face);
+        bool Brush::prepareMoveVertices(const Vec3f::List& vertexPositions, const Vec3f& delta, BrushEdit& edit) {
+            beginEdit(edit);
+            try {
+                return endEdit(edit, edit.m_geometry->moveVertices(m_worldBounds, vertexPositions, delta, edit.vertices, edit.m_newFaces, edit.m_droppedFaces));
+            } catch (GeometryException&) {
+                return endEdit(edit, false);
             }
-
-            return newVertexPositions;
-        }
-
-        bool Brush::canMoveEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta) const {
-            return m_geometry->canMoveEdges(m_worldBounds, edgeInfos, delta);
         }
 
-        EdgeInfoList Brush::moveEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta) {
-            FaceSet newFaces;
-            FaceSet droppedFaces;
-
-            const EdgeInfoList newEdgeInfos = m_geometry->moveEdges(m_worldBounds, edgeInfos, delta, newFaces, droppedFaces);
-
-            for (FaceSet::iterator it = droppedFaces.begin(); it != droppedFaces.end(); ++it) {
-                Face* face = *it;
-                face->setBrush(NULL);
-                m_faces.erase(std::remove(m_faces.begin(), m_faces.end(), face), m_faces.end());
-                delete face;
-            }
-
-            for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
-                Face* face = *it;
-                face->invalidateTexAxes();
-                face->invalidateVertexCache();
-            }
-
-            for (FaceSet::iterator it = newFaces.begin(); it != newFaces.end(); ++it) {
-                Face* face = *it;
-                face->setBrush(this);
-                m_faces.push_back(face);
+        bool Brush::prepareMoveEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta, BrushEdit& edit) {
+            beginEdit(edit);
+            try {
+                return endEdit(edit, edit.m_geometry->moveEdges(m_worldBounds, edgeInfos, delta, edit.edges, edit.m_newFaces, edit.m_droppedFaces));
+            } catch (GeometryException&) {
+                return endEdit(edit, false);
             }
-
-            return newEdgeInfos;
-        }
-
-        bool Brush::canMoveFaces(const FaceInfoList& faceInfos, const Vec3f& delta) const {
-            return m_geometry->canMoveFaces(m_worldBounds, faceInfos, delta);
         }
 
-        FaceInfoList Brush::moveFaces(const FaceInfoList& faceInfos, const Vec3f& delta) {
-            FaceSet newFaces;
-            FaceSet droppedFaces;
-
-            const FaceInfoList newFaceInfos = m_geometry->moveFaces(m_worldBounds, faceInfos, delta, newFaces, droppedFaces);
-
-            for (FaceSet::iterator it = droppedFaces.begin(); it != droppedFaces.end(); ++it) {
-                Face* face = *it;
-                face->setBrush(NULL);
-                m_faces.erase(std::remove(m_faces.begin(), m_faces.end(), face), m_faces.end());
-                delete face;
+        bool Brush::prepareMoveFaces(const FaceInfoList& faceInfos, const Vec3f& delta, BrushEdit& edit) {
+            beginEdit(edit);
+            try {
+                return endEdit(edit, edit.m_geometry->moveFaces(m_worldBounds, faceInfos, delta, edit.faces, edit.m_newFaces, edit.m_droppedFaces));
+            } catch (GeometryException&) {
+                return endEdit(edit, false);
             }
+        }
 
-            for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
-                Face* face = *it;
-                face->invalidateTexAxes();
-                face->invalidateVertexCache();
+        bool Brush::prepareSplitEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta, BrushEdit& edit) {
+            beginEdit(edit);
+            try {
+                return endEdit(edit, edit.m_geometry->splitEdges(m_worldBounds, edgeInfos, delta, edit.vertices, edit.m_newFaces, edit.m_droppedFaces));
+            } catch (GeometryException&) {
+                return endEdit(edit, false);
             }
+        }
 
-            for (FaceSet::iterator it = newFaces.begin(); it != newFaces.end(); ++it) {
-                Face* face = *it;
-                face->setBrush(this);
-                m_faces.push_back(face);
+        bool Brush::prepareSplitFaces(const FaceInfoList& faceInfos, const Vec3f& delta, BrushEdit& edit) {
+            beginEdit(edit);
+            try {
+                return endEdit(edit, edit.m_geometry->splitFaces(m_worldBounds, faceInfos, delta, edit.vertices, edit.m_newFaces, edit.m_droppedFaces));
+            } catch (GeometryException&) {
+                return endEdit(edit, false);
             }
-
-            return newFaceInfos;
         }
 
-        bool Brush::canSplitEdge(const EdgeInfo& edge, const Vec3f& delta) const {
-            return m_geometry->canSplitEdge(m_worldBounds, edge, delta);
-        }
+        void Brush::commitEdit(BrushEdit& edit) {
+            assert(edit.prepared());
 
-        Vec3f Brush::splitEdge(const EdgeInfo& edge, const Vec3f& delta) {
-            FaceSet newFaces;
-            FaceSet droppedFaces;
+            delete m_geometry;
+            m_geometry = edit.m_geometry;
+            edit.m_geometry = NULL;
+            m_geometry->restoreFaceSides();
 
-            Vec3f newVertexPosition = m_geometry->splitEdge(m_worldBounds, edge, delta, newFaces, droppedFaces);
+            BrushEdit::FacePlaneList::const_iterator planeIt, planeEnd;
+            for (planeIt = edit.m_planes.begin(), planeEnd = edit.m_planes.end(); planeIt != planeEnd; ++planeIt) {
+                const BrushEdit::FacePlane& plane = *planeIt;
+                plane.face->restorePlane(plane.points, plane.boundary);
+            }
 
-            for (FaceSet::iterator it = droppedFaces.begin(); it != droppedFaces.end(); ++it) {
+            for (FaceSet::iterator it = edit.m_droppedFaces.begin(); it != edit.m_droppedFaces.end(); ++it) {
                 Face* face = *it;
                 face->setBrush(NULL);
                 m_faces.erase(std::remove(m_faces.begin(), m_faces.end(), face), m_faces.end());
@@ -463,48 +514,33 @@ namespace TrenchBroom {
             for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
                 Face* face = *it;
                 face->invalidateTexAxes();
-                face->invalidateVertexCache();
             }
 
-            for (FaceSet::iterator it = newFaces.begin(); it != newFaces.end(); ++it) {
+            for (FaceSet::iterator it = edit.m_newFaces.begin(); it != edit.m_newFaces.end(); ++it) {
                 Face* face = *it;
                 face->setBrush(this);
                 m_faces.push_back(face);
             }
 
-            return newVertexPosition;
+            edit.m_newFaces.clear();
+            edit.m_droppedFaces.clear();
+            edit.m_planes.clear();
         }
 
-        bool Brush::canSplitFace(const FaceInfo& faceInfo, const Vec3f& delta) const {
-            return m_geometry->canSplitFace(m_worldBounds, faceInfo, delta);
-        }
+        void Brush::discardEdit(BrushEdit& edit) {
+            assert(edit.prepared());
 
-        Vec3f Brush::splitFace(const FaceInfo& faceInfo, const Vec3f& delta) {
-            FaceSet newFaces;
-            FaceSet droppedFaces;
-
-            Vec3f newVertexPosition = m_geometry->splitFace(m_worldBounds, faceInfo, delta, newFaces, droppedFaces);
-
-            for (FaceSet::iterator it = droppedFaces.begin(); it != droppedFaces.end(); ++it) {
-                Face* dropFace = *it;
-                dropFace->setBrush(NULL);
-                m_faces.erase(std::remove(m_faces.begin(), m_faces.end(), dropFace), m_faces.end());
-                delete dropFace;
-            }
-
-            for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
-                Face* face = *it;
-                face->invalidateTexAxes();
-                face->invalidateVertexCache();
-            }
-
-            for (FaceSet::iterator it = newFaces.begin(); it != newFaces.end(); ++it) {
-                Face* newFace = *it;
-                newFace->setBrush(this);
-                m_faces.push_back(newFace);
-            }
+            for (FaceSet::iterator it = edit.m_newFaces.begin(); it != edit.m_newFaces.end(); ++it)
+                delete *it;
 
-            return newVertexPosition;
+            delete edit.m_geometry;
+            edit.m_geometry = NULL;
+            edit.m_newFaces.clear();
+            edit.m_droppedFaces.clear();
+            edit.m_planes.clear();
+            edit.vertices.clear();
+            edit.edges.clear();
+            edit.faces.clear();
         }
 
         void Brush::pick(const Rayf& ray, PickResult& pickResults) {
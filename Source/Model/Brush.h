@@ -26,9 +26,11 @@
 #include "Model/FaceTypes.h"
 #include "Model/MapObject.h"
 #include "Utility/Allocator.h"
+#include "Utility/PlanePointCache.h"
 #include "Utility/VecMath.h"
 
 #include <algorithm>
+#include <cassert>
 #include <iterator>
 #include <vector>
 
@@ -40,6 +42,79 @@ namespace TrenchBroom {
         class Face;
         class Texture;
 
+        /**
+         * A vertex operation which was performed on a copy of the geometry of a brush, see Brush::prepareMoveVertices
+         * and friends. Preparing an edit only touches the brush and its faces, so the edits of different brushes can
+         * be prepared concurrently. The brush looks unchanged until a prepared edit is committed, and the edit must be
+         * committed or discarded before the brush is changed in any other way.
+         */
+        class BrushEdit {
+        private:
+            class FacePlane {
+            public:
+                Face* face;
+                FacePoints points;
+                Planef boundary;
+            };
+
+            typedef std::vector<FacePlane> FacePlaneList;
+
+            BrushGeometry* m_geometry;
+            FaceSet m_newFaces;
+            FaceSet m_droppedFaces;
+            FacePlaneList m_planes;
+
+            friend class Brush;
+        public:
+            typedef std::vector<BrushEdit> List;
+
+            // the results of the operation, depending on its type
+            Vec3f::List vertices;
+            EdgeInfoList edges;
+            FaceInfoList faces;
+
+            BrushEdit() :
+            m_geometry(NULL) {}
+
+            ~BrushEdit() {
+                assert(m_geometry == NULL);
+            }
+
+            inline bool prepared() const {
+                return m_geometry != NULL;
+            }
+        };
+
+        /**
+         * The face points of a brush before they were converted to another face point format, see
+         * Brush::convertFacePoints.
+         */
+        class FacePointBackup {
+        private:
+            class FacePlane {
+            public:
+                Face* face;
+                FacePoints points;
+                Planef boundary;
+            };
+
+            typedef std::vector<FacePlane> FacePlaneList;
+
+            bool m_forceIntegerFacePoints;
+            FacePlaneList m_planes;
+
+            friend class Brush;
+        public:
+            typedef std::vector<FacePointBackup> List;
+
+            FacePointBackup() :
+            m_forceIntegerFacePoints(false) {}
+
+            inline bool converted() const {
+                return !m_planes.empty();
+            }
+        };
+
         class Brush : public MapObject, public Utility::Allocator<Brush> {
         protected:
             class Entity* m_entity;
@@ -52,6 +127,18 @@ namespace TrenchBroom {
             bool m_forceIntegerFacePoints;
 
             void init();
+            void buildGeometry();
+
+            void beginEdit(BrushEdit& edit);
+            bool endEdit(BrushEdit& edit, bool success);
+
+            /**
+             * Returns whether the given transformation can be applied to the geometry of this brush directly instead of
+             * rebuilding it from the transformed faces. This is the case for translations and for rotations by
+             * multiples of 90 degrees and mirrorings about the coordinate axes, unless the brush forces integer face
+             * points.
+             */
+            bool canTransformGeometry(const Mat4f& pointTransform) const;
         public:
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces);
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Brush& brushTemplate);
@@ -98,6 +185,21 @@ namespace TrenchBroom {
             }
             
             void setForceIntegerFacePoints(bool forceIntegerFacePoints);
+
+            /**
+             * Finds new points for the faces of this brush in the given format and records the previous points in
+             * the given backup. The geometry is not rebuilt until the conversion is committed, so the brush and its
+             * faces are the only objects touched, and several brushes can be converted concurrently. Returns false
+             * and leaves the brush unchanged if a face does not get valid points.
+             */
+            bool convertFacePoints(bool forceIntegerFacePoints, Utility::PlanePointCache& cache, FacePointBackup& backup);
+            void revertFacePoints(const FacePointBackup& backup);
+
+            /**
+             * Rebuilds the geometry from the converted face points. Unlike rebuildGeometry, this does not invalidate
+             * the geometry of the entity, so that the brushes of an entity can be committed concurrently.
+             */
+            void commitFacePoints();
             
             inline const Vec3f& center() const {
                 return m_geometry->center;
@@ -145,17 +247,18 @@ namespace TrenchBroom {
             bool canMoveBoundary(const Face& face, const Vec3f& delta) const;
             void moveBoundary(Face& face, const Vec3f& delta, bool lockTexture);
 
-            bool canMoveVertices(const Vec3f::List& vertexPositions, const Vec3f& delta) const;
-            Vec3f::List moveVertices(const Vec3f::List& vertexPositions, const Vec3f& delta);
-            bool canMoveEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta) const;
-            EdgeInfoList moveEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta);
-            bool canMoveFaces(const FaceInfoList& faceInfos, const Vec3f& delta) const;
-            FaceInfoList moveFaces(const FaceInfoList& faceInfos, const Vec3f& delta);
-
-            bool canSplitEdge(const EdgeInfo& edgeInfo, const Vec3f& delta) const;
-            Vec3f splitEdge(const EdgeInfo& edgeInfo, const Vec3f& delta);
-            bool canSplitFace(const FaceInfo& faceInfo, const Vec3f& delta) const;
-            Vec3f splitFace(const FaceInfo& faceInfo, const Vec3f& delta);
+            /*
+             * The following functions perform a vertex operation on a copy of the geometry of this brush. If the
+             * operation succeeds, the edit is prepared and can be committed; otherwise, the edit is discarded and false
+             * is returned. The split operations split the given edges or faces one after another.
+             */
+            bool prepareMoveVertices(const Vec3f::List& vertexPositions, const Vec3f& delta, BrushEdit& edit);
+            bool prepareMoveEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta, BrushEdit& edit);
+            bool prepareMoveFaces(const FaceInfoList& faceInfos, const Vec3f& delta, BrushEdit& edit);
+            bool prepareSplitEdges(const EdgeInfoList& edgeInfos, const Vec3f& delta, BrushEdit& edit);
+            bool prepareSplitFaces(const FaceInfoList& faceInfos, const Vec3f& delta, BrushEdit& edit);
+            void commitEdit(BrushEdit& edit);
+            void discardEdit(BrushEdit& edit);
 
             void pick(const Rayf& ray, PickResult& pickResults);
             bool containsPoint(const Vec3f point) const;
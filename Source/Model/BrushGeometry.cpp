@@ -22,6 +22,7 @@
 #include "Model/Face.h"
 #include "Utility/List.h"
 
+#include <algorithm>
 #include <map>
 #include <cstdio>
 
@@ -1460,6 +1461,34 @@ namespace TrenchBroom {
             return true;
         }
 
+        void BrushGeometry::transform(const Mat4f& pointTransform, bool invertOrientation) {
+            VertexList::iterator vertexIt, vertexEnd;
+            for (vertexIt = vertices.begin(), vertexEnd = vertices.end(); vertexIt != vertexEnd; ++vertexIt) {
+                Vertex& vertex = **vertexIt;
+                vertex.position = pointTransform * vertex.position;
+                vertex.position.correct();
+            }
+
+            if (invertOrientation) {
+                EdgeList::iterator edgeIt, edgeEnd;
+                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
+                    Edge& edge = **edgeIt;
+                    std::swap(edge.left, edge.right);
+                }
+
+                SideList::iterator sideIt, sideEnd;
+                for (sideIt = sides.begin(), sideEnd = sides.end(); sideIt != sideEnd; ++sideIt) {
+                    Side& side = **sideIt;
+                    std::reverse(side.edges.begin(), side.edges.end());
+                    for (size_t i = 0; i < side.edges.size(); i++)
+                        side.vertices[i] = side.edges[i]->startVertex(&side);
+                }
+            }
+
+            bounds = boundsOfVertices(vertices);
+            center = centerOfVertices(vertices);
+        }
+
         void BrushGeometry::updateFacePoints(FaceManager& faceManager) {
             for (size_t i = 0; i < sides.size(); i++) {
                 try {
@@ -1544,39 +1573,7 @@ namespace TrenchBroom {
             return vertex->incidentSides(edges);
         }
 
-        bool BrushGeometry::canMoveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta) {
-            FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
-            Vec3f::List sortedVertexPositions = vertexPositions;
-            std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
-
-            bool canMove = true;
-            Vec3f::List::const_iterator vertexIt, vertexEnd;
-            for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd && canMove; ++vertexIt) {
-                const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(testGeometry.vertices, vertexPosition);
-                assert(vertex != NULL);
-
-                const Vec3f start = vertex->position;
-                const Vec3f end = start + delta;
-
-                MoveVertexResult result = testGeometry.moveVertex(vertex, true, start, end, faceManager);
-                canMove = result.type != MoveVertexResult::VertexUnchanged;
-            }
-
-            canMove &= testGeometry.sides.size() >= 3;
-            canMove &= worldBounds.contains(testGeometry.bounds);
-
-            restoreFaceSides();
-            return canMove;
-        }
-
-        Vec3f::List BrushGeometry::moveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canMoveVertices(worldBounds, vertexPositions, delta));
-
+        bool BrushGeometry::moveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, Vec3f::List& newVertexPositions, FaceSet& newFaces, FaceSet& droppedFaces) {
             FaceManager faceManager;
             VertexList movedVertices;
             Vec3f::List sortedVertexPositions = vertexPositions;
@@ -1586,32 +1583,34 @@ namespace TrenchBroom {
             for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
                 const Vec3f& vertexPosition = *vertexIt;
                 Vertex* vertex = findVertex(vertices, vertexPosition);
-                assert(vertex != NULL);
+                if (vertex == NULL)
+                    return false;
 
                 const Vec3f start = vertex->position;
                 const Vec3f end = start + delta;
 
                 MoveVertexResult result = moveVertex(vertex, true, start, end, faceManager);
+                if (result.type == MoveVertexResult::VertexUnchanged)
+                    return false;
                 if (result.type == MoveVertexResult::VertexMoved)
                     movedVertices.push_back(result.vertex);
                 updateFacePoints(faceManager);
             }
 
-            Vec3f::List newVertexPositions;
+            if (sides.size() < 3 || !worldBounds.contains(bounds))
+                return false;
+
+            newVertexPositions.clear();
             newVertexPositions.reserve(movedVertices.size());
             for (unsigned int i = 0; i < movedVertices.size(); i++)
                 newVertexPositions.push_back(movedVertices[i]->position);
 
             faceManager.getFaces(newFaces, droppedFaces);
-            return newVertexPositions;
+            return true;
         }
 
-        bool BrushGeometry::canMoveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta) {
+        bool BrushGeometry::moveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, EdgeInfoList& newEdgeInfos, FaceSet& newFaces, FaceSet& droppedFaces) {
             FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
             Vec3f::List sortedVertexPositions;
             EdgeInfoList::const_iterator edgeIt, edgeEnd;
             for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd; ++edgeIt) {
@@ -1621,130 +1620,38 @@ namespace TrenchBroom {
             }
             std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
 
-            bool canMove = true;
-            Vec3f::List::const_iterator vertexIt, vertexEnd;
-            for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
-                const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(testGeometry.vertices, vertexPosition);
-                if (vertex == NULL) {
-                    canMove = false;
-                    break;
-                }
-
-                const Vec3f start = vertex->position;
-                const Vec3f end = start + delta;
-
-                MoveVertexResult result = testGeometry.moveVertex(vertex, false, start, end, faceManager);
-                if (result.type != MoveVertexResult::VertexMoved) {
-                    canMove = false;
-                    break;
-                }
-            }
-
-            for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd && canMove; ++edgeIt) {
-                const EdgeInfo& edgeInfo = *edgeIt;
-                canMove = findEdge(testGeometry.edges, edgeInfo.start + delta, edgeInfo.end + delta) != NULL;
-            }
-
-            canMove &= testGeometry.sides.size() >= 3;
-            canMove &= worldBounds.contains(testGeometry.bounds);
-
-            restoreFaceSides();
-            return canMove;
-        }
-
-        EdgeInfoList BrushGeometry::moveEdges(const BBoxf& worldBounds, const EdgeInfoList& i_edges, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canMoveEdges(worldBounds, i_edges, delta));
-
-            FaceManager faceManager;
-            Vec3f::List sortedVertexPositions;
-            EdgeInfoList::const_iterator edgeIt, edgeEnd;
-            for (edgeIt = i_edges.begin(), edgeEnd = i_edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                const EdgeInfo& edgeInfo = *edgeIt;
-                sortedVertexPositions.push_back(edgeInfo.start);
-                sortedVertexPositions.push_back(edgeInfo.end);
-            }
-            std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
-
             Vec3f::List::const_iterator vertexIt, vertexEnd;
             for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
                 const Vec3f& vertexPosition = *vertexIt;
                 Vertex* vertex = findVertex(vertices, vertexPosition);
-                assert(vertex != NULL);
+                if (vertex == NULL)
+                    return false;
 
                 const Vec3f start = vertex->position;
                 const Vec3f end = start + delta;
 
                 MoveVertexResult result = moveVertex(vertex, false, start, end, faceManager);
-                assert(result.type == MoveVertexResult::VertexMoved);
+                if (result.type != MoveVertexResult::VertexMoved)
+                    return false;
                 updateFacePoints(faceManager);
             }
 
-            faceManager.getFaces(newFaces, droppedFaces);
-
-            EdgeInfoList result;
-            EdgeInfoList::const_iterator infoIt, infoEnd;
-            for (infoIt = i_edges.begin(), infoEnd = i_edges.end(); infoIt != infoEnd; ++infoIt) {
-                const EdgeInfo& info = *infoIt;
-                assert(findEdge(edges, info.start + delta, info.end + delta) != NULL);
-                result.push_back(EdgeInfo(info.start + delta, info.end + delta));
-            }
-
-            return result;
-        }
-
-        bool BrushGeometry::canMoveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta) {
-            FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
-            Vec3f::List sortedVertexPositions;
-            FaceInfoList::const_iterator faceIt, faceEnd;
-            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
-                const FaceInfo& faceInfo = *faceIt;
-                Vec3f::List::const_iterator vertexIt, vertexEnd;
-                for (vertexIt = faceInfo.vertices.begin(), vertexEnd = faceInfo.vertices.end(); vertexIt != vertexEnd; ++vertexIt)
-                    sortedVertexPositions.push_back(*vertexIt);
-            }
-            std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
-
-            bool canMove = true;
-            Vec3f::List::const_iterator vertexIt, vertexEnd;
-            for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
-                const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(testGeometry.vertices, vertexPosition);
-                if (vertex == NULL) {
-                    canMove = false;
-                    break;
-                }
-
-                const Vec3f start = vertex->position;
-                const Vec3f end = start + delta;
-
-                MoveVertexResult result = testGeometry.moveVertex(vertex, false, start, end, faceManager);
-                if (result.type != MoveVertexResult::VertexMoved) {
-                    canMove = false;
-                    break;
-                }
-            }
-
-            canMove &= testGeometry.sides.size() >= 3;
-            canMove &= worldBounds.contains(testGeometry.bounds);
+            if (sides.size() < 3 || !worldBounds.contains(bounds))
+                return false;
 
-            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
-                const FaceInfo& faceInfo = *faceIt;
-                const FaceInfo translated = faceInfo.translated(delta);
-                canMove = findSide(testGeometry.sides, translated.vertices) != NULL;
+            newEdgeInfos.clear();
+            for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd; ++edgeIt) {
+                const EdgeInfo& edgeInfo = *edgeIt;
+                if (findEdge(edges, edgeInfo.start + delta, edgeInfo.end + delta) == NULL)
+                    return false;
+                newEdgeInfos.push_back(EdgeInfo(edgeInfo.start + delta, edgeInfo.end + delta));
             }
 
-            restoreFaceSides();
-            return canMove;
+            faceManager.getFaces(newFaces, droppedFaces);
+            return true;
         }
 
-        FaceInfoList BrushGeometry::moveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canMoveFaces(worldBounds, faceInfos, delta));
-
+        bool BrushGeometry::moveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceInfoList& newFaceInfos, FaceSet& newFaces, FaceSet& droppedFaces) {
             FaceManager faceManager;
             Vec3f::List sortedVertexPositions;
             FaceInfoList::const_iterator faceIt, faceEnd;
@@ -1760,132 +1667,107 @@ namespace TrenchBroom {
             for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
                 const Vec3f& vertexPosition = *vertexIt;
                 Vertex* vertex = findVertex(vertices, vertexPosition);
-                assert(vertex != NULL);
+                if (vertex == NULL)
+                    return false;
 
                 const Vec3f start = vertex->position;
                 const Vec3f end = start + delta;
 
                 MoveVertexResult result = moveVertex(vertex, false, start, end, faceManager);
-                assert(result.type == MoveVertexResult::VertexMoved);
+                if (result.type != MoveVertexResult::VertexMoved)
+                    return false;
             }
 
-            updateFacePoints(faceManager);
-            faceManager.getFaces(newFaces, droppedFaces);
+            if (sides.size() < 3 || !worldBounds.contains(bounds))
+                return false;
 
-            FaceInfoList result;
+            newFaceInfos.clear();
             for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
                 const FaceInfo& faceInfo = *faceIt;
                 const FaceInfo translated = faceInfo.translated(delta);
                 Side* side = findSide(sides, translated.vertices);
-                assert(side != NULL);
+                if (side == NULL)
+                    return false;
                 assert(side->face != NULL);
-                result.push_back(translated);
+                newFaceInfos.push_back(translated);
             }
-            return result;
-        }
 
-        bool BrushGeometry::canSplitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta) {
-            // find the edge
-            Edge* edge = findEdge(edges, edgeInfo.start, edgeInfo.end);
-            if (edge == NULL)
-                return false;
-
-            // detect whether the drag would make the incident faces invalid
-            const Vec3f& leftNorm = edge->left->face->boundary().normal;
-            const Vec3f& rightNorm = edge->right->face->boundary().normal;
-
-            // we allow a bit more leeway when testing here, as otherwise edges sometimes cannot be split
-            if (Math<float>::neg(delta.dot(leftNorm), 0.01f) ||
-                Math<float>::neg(delta.dot(rightNorm), 0.01f))
-                return false;
+            updateFacePoints(faceManager);
+            faceManager.getFaces(newFaces, droppedFaces);
+            return true;
+        }
 
+        bool BrushGeometry::splitEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, Vec3f::List& newVertexPositions, FaceSet& newFaces, FaceSet& droppedFaces) {
             FaceManager faceManager;
+            newVertexPositions.clear();
 
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
-            // The given edge is not an edge of testGeometry!
-            Edge* testEdge = findEdge(testGeometry.edges, edgeInfo.start, edgeInfo.end);
-            assert(testEdge != NULL);
-
-            Vertex* newVertex = testGeometry.splitEdge(testEdge);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = testGeometry.moveVertex(newVertex, false, start, end, faceManager);
-            bool canSplit = result.type == MoveVertexResult::VertexMoved;
-            canSplit &= testGeometry.sides.size() >= 3;
-            canSplit &= worldBounds.contains(testGeometry.bounds);
+            EdgeInfoList::const_iterator edgeIt, edgeEnd;
+            for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd; ++edgeIt) {
+                const EdgeInfo& edgeInfo = *edgeIt;
+                Edge* edge = findEdge(edges, edgeInfo.start, edgeInfo.end);
+                if (edge == NULL)
+                    return false;
 
-            restoreFaceSides();
-            return canSplit;
-        }
+                // detect whether the drag would make the incident faces invalid
+                const Vec3f& leftNorm = edge->left->face->boundary().normal;
+                const Vec3f& rightNorm = edge->right->face->boundary().normal;
 
-        Vec3f BrushGeometry::splitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canSplitEdge(worldBounds, edgeInfo, delta));
+                // we allow a bit more leeway when testing here, as otherwise edges sometimes cannot be split
+                if (Math<float>::neg(delta.dot(leftNorm), 0.01f) ||
+                    Math<float>::neg(delta.dot(rightNorm), 0.01f))
+                    return false;
 
-            Edge* edge = findEdge(edges, edgeInfo.start, edgeInfo.end);
+                Vertex* newVertex = splitEdge(edge);
+                const Vec3f start = newVertex->position;
+                const Vec3f end = start + delta;
+                MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
+                if (result.type != MoveVertexResult::VertexMoved)
+                    return false;
+                if (sides.size() < 3 || !worldBounds.contains(bounds))
+                    return false;
 
-            FaceManager faceManager;
-            Vertex* newVertex = splitEdge(edge);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
-            assert(result.type == MoveVertexResult::VertexMoved);
+                updateFacePoints(faceManager);
+                newVertexPositions.push_back(result.vertex->position);
+            }
 
-            updateFacePoints(faceManager);
             faceManager.getFaces(newFaces, droppedFaces);
-            return result.vertex->position;
+            return true;
         }
 
-        bool BrushGeometry::canSplitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta) {
-            Side* side = findSide(sides, faceInfo.vertices);
-            if (side == NULL)
-                return false;
-
-            Face* face = side->face;
-            assert(face != NULL);
-
-            // detect whether the drag would lead to an indented face
-            const Vec3f& norm = face->boundary().normal;
-            if (Math<float>::zero(delta.dot(norm)))
-                return false;
-
+        bool BrushGeometry::splitFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, Vec3f::List& newVertexPositions, FaceSet& newFaces, FaceSet& droppedFaces) {
             FaceManager faceManager;
+            newVertexPositions.clear();
 
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
-            Vertex* newVertex = testGeometry.splitFace(face, faceManager);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = testGeometry.moveVertex(newVertex, false, start, end, faceManager);
-            bool canSplit = result.type == MoveVertexResult::VertexMoved;
-            canSplit &= testGeometry.sides.size() >= 3;
-            canSplit &= worldBounds.contains(testGeometry.bounds);
-
-            restoreFaceSides();
-            return canSplit;
-        }
+            FaceInfoList::const_iterator faceIt, faceEnd;
+            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
+                const FaceInfo& faceInfo = *faceIt;
+                Side* side = findSide(sides, faceInfo.vertices);
+                if (side == NULL)
+                    return false;
 
-        Vec3f BrushGeometry::splitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canSplitFace(worldBounds, faceInfo, delta));
+                Face* face = side->face;
+                assert(face != NULL);
 
-            Side* side = findSide(sides, faceInfo.vertices);
-            assert(side != NULL);
+                // detect whether the drag would lead to an indented face
+                const Vec3f& norm = face->boundary().normal;
+                if (Math<float>::zero(delta.dot(norm)))
+                    return false;
 
-            Face* face = side->face;
-            assert(face != NULL);
+                Vertex* newVertex = splitFace(face, faceManager);
+                const Vec3f start = newVertex->position;
+                const Vec3f end = start + delta;
+                MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
+                if (result.type != MoveVertexResult::VertexMoved)
+                    return false;
+                if (sides.size() < 3 || !worldBounds.contains(bounds))
+                    return false;
 
-            FaceManager faceManager;
-            Vertex* newVertex = splitFace(face, faceManager);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
-            assert(result.type == MoveVertexResult::VertexMoved);
+                updateFacePoints(faceManager);
+                newVertexPositions.push_back(result.vertex->position);
+            }
 
-            updateFacePoints(faceManager);
             faceManager.getFaces(newFaces, droppedFaces);
-            return result.vertex->position;
+            return true;
         }
 
         Vertex* findVertex(const VertexList& vertices, const Vec3f& position, float epsilon) {
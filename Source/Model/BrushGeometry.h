@@ -348,6 +348,13 @@ namespace TrenchBroom {
             CutResult addFace(Face& face, FaceSet& droppedFaces);
             bool addFaces(const FaceList& faces, FaceSet& droppedFaces);
 
+            /**
+             * Transforms the vertices in place without changing the topology. Only valid for transformations which
+             * map the brush onto a congruent brush, see axisPermutationMatrix. If the transformation mirrors the brush,
+             * the orientation of the edges and sides is inverted so that the sides still face outward.
+             */
+            void transform(const Mat4f& pointTransform, bool invertOrientation);
+
             void updateFacePoints(FaceManager& faceManager);
 
             void correct(FaceSet& newFaces, FaceSet& droppedFaces, float epsilon);
@@ -355,17 +362,16 @@ namespace TrenchBroom {
 
             SideList incidentSides(const Vertex* vertex);
 
-            bool canMoveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta);
-            Vec3f::List moveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces);
-            bool canMoveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta);
-            EdgeInfoList moveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces);
-            bool canMoveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta);
-            FaceInfoList moveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces);
-
-            bool canSplitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta);
-            Vec3f splitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces);
-            bool canSplitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta);
-            Vec3f splitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces);
+            /*
+             * The following vertex operations return false if the operation cannot be completed, leaving the geometry
+             * in an unusable state. They must therefore only be performed on a copy of a brush's geometry, see
+             * Brush::prepareMoveVertices and friends.
+             */
+            bool moveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, Vec3f::List& newVertexPositions, FaceSet& newFaces, FaceSet& droppedFaces);
+            bool moveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, EdgeInfoList& newEdgeInfos, FaceSet& newFaces, FaceSet& droppedFaces);
+            bool moveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceInfoList& newFaceInfos, FaceSet& newFaces, FaceSet& droppedFaces);
+            bool splitEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, Vec3f::List& newVertexPositions, FaceSet& newFaces, FaceSet& droppedFaces);
+            bool splitFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, Vec3f::List& newVertexPositions, FaceSet& newFaces, FaceSet& droppedFaces);
         };
 
         template <class T>
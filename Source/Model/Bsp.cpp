@@ -295,9 +295,9 @@ namespace TrenchBroom {
 
             console.info("Loading '%s' (searching %s)", name.c_str(), pathList.c_str());
 
-            IO::MappedFile::Ptr file = IO::findGameFile(name, paths);
-            if (file.get() != NULL) {
-                Bsp* bsp = new Bsp(name, file->begin(), file->end());
+            IO::FileView file = IO::findGameFile(name, paths);
+            if (file.valid()) {
+                Bsp* bsp = new Bsp(name, file.begin(), file.end());
                 m_bsps[key] = bsp;
                 return bsp;
             }
@@ -26,8 +26,37 @@
 
 namespace TrenchBroom {
     namespace Model {
+        template <typename T>
+        inline bool containsIndexed(const std::vector<T*>& list, const T& object) {
+            const size_t index = object.editStateIndex();
+            return index < list.size() && list[index] == &object;
+        }
+        
+        template <typename T>
+        inline void pushIndexed(std::vector<T*>& list, T& object) {
+            object.setEditStateIndex(list.size());
+            list.push_back(&object);
+        }
+        
+        template <typename T>
+        inline void eraseIndexed(std::vector<T*>& list, T& object) {
+            assert(containsIndexed(list, object));
+            const size_t index = object.editStateIndex();
+            T* last = list.back();
+            list[index] = last;
+            last->setEditStateIndex(index);
+            list.pop_back();
+        }
+        
+        template <typename T>
+        inline void reindex(std::vector<T*>& list) {
+            for (size_t i = 0; i < list.size(); i++)
+                list[i]->setEditStateIndex(i);
+        }
+        
         bool EditStateManager::doSetEditState(const EntityList& entities, EditState::Type newState, EditStateChangeSet& changeSet) {
             bool changed = false;
+            changeSet.reserveEntities(newState, entities.size());
             
             for (unsigned int i = 0; i < entities.size(); i++) {
                 Entity& entity = *entities[i];
@@ -35,19 +64,13 @@ namespace TrenchBroom {
                     EditState::Type previousState = entity.setEditState(newState);
                     changeSet.addEntity(previousState, entity);
                     
-                    if (previousState == EditState::Selected)
-                        Utility::erase(current().selectedEntities, &entity);
-                    else if (previousState == EditState::Hidden)
-                        Utility::erase(current().hiddenEntities, &entity);
-                    else if (previousState == EditState::Locked)
-                        Utility::erase(current().lockedEntities, &entity);
-                    
-                    if (newState == EditState::Selected)
-                        current().selectedEntities.push_back(&entity);
-                    else if (newState == EditState::Hidden)
-                        current().hiddenEntities.push_back(&entity);
-                    else if (newState == EditState::Locked)
-                        current().lockedEntities.push_back(&entity);
+                    // a previously locked object may end up locked instead of in the requested state
+                    EntityList* previousList = current().entities(previousState);
+                    if (previousList != NULL)
+                        eraseIndexed(*previousList, entity);
+                    EntityList* newList = current().entities(entity.editState());
+                    if (newList != NULL)
+                        pushIndexed(*newList, entity);
                     changed = true;
                 }
             }
@@ -57,6 +80,7 @@ namespace TrenchBroom {
 
         bool EditStateManager::doSetEditState(const BrushList& brushes, EditState::Type newState, EditStateChangeSet& changeSet) {
             bool changed = false;
+            changeSet.reserveBrushes(newState, brushes.size());
             
             for (unsigned int i = 0; i < brushes.size(); i++) {
                 Brush& brush = *brushes[i];
@@ -64,19 +88,12 @@ namespace TrenchBroom {
                     EditState::Type previousState = brush.setEditState(newState);
                     changeSet.addBrush(previousState, brush);
                     
-                    if (previousState == EditState::Selected)
-                        Utility::erase(current().selectedBrushes, &brush);
-                    else if (previousState == EditState::Hidden)
-                        Utility::erase(current().hiddenBrushes, &brush);
-                    else if (previousState == EditState::Locked)
-                        Utility::erase(current().lockedBrushes, &brush);
-                    
-                    if (newState == EditState::Selected)
-                        current().selectedBrushes.push_back(&brush);
-                    else if (newState == EditState::Hidden)
-                        current().hiddenBrushes.push_back(&brush);
-                    else if (newState == EditState::Locked)
-                        current().lockedBrushes.push_back(&brush);
+                    BrushList* previousList = current().brushes(previousState);
+                    if (previousList != NULL)
+                        eraseIndexed(*previousList, brush);
+                    BrushList* newList = current().brushes(brush.editState());
+                    if (newList != NULL)
+                        pushIndexed(*newList, brush);
                     changed = true;
                 }
             }
@@ -86,13 +103,15 @@ namespace TrenchBroom {
         
         bool EditStateManager::doSetSelected(const FaceList& faces, bool newState, EditStateChangeSet& changeSet) {
             bool changed = false;
+            changeSet.reserveFaces(!newState, faces.size());
+            
             for (unsigned int i = 0; i < faces.size(); i++) {
                 Face& face = *faces[i];
                 if (face.selected() != newState) {
                     if (newState)
-                        current().selectedFaces.push_back(&face);
-                    else
-                        Utility::erase(current().selectedFaces, &face);
+                        pushIndexed(current().selectedFaces, face);
+                    else if (containsIndexed(current().selectedFaces, face))
+                        eraseIndexed(current().selectedFaces, face);
                     face.setSelected(newState);
                     changeSet.addFace(!newState, face);
                     changed = true;
@@ -101,56 +120,76 @@ namespace TrenchBroom {
             return changed;
         }
 
+        void EditStateManager::setDefault(Entity& entity, EditStateChangeSet& changeSet) {
+            EditState::Type previousState = entity.setEditState(EditState::Default);
+            changeSet.addEntity(previousState, entity);
+            
+            EntityList* newList = current().entities(entity.editState());
+            if (newList != NULL)
+                pushIndexed(*newList, entity);
+        }
+        
+        void EditStateManager::setDefault(Brush& brush, EditStateChangeSet& changeSet) {
+            EditState::Type previousState = brush.setEditState(EditState::Default);
+            changeSet.addBrush(previousState, brush);
+            
+            BrushList* newList = current().brushes(brush.editState());
+            if (newList != NULL)
+                pushIndexed(*newList, brush);
+        }
+        
         void EditStateManager::setDefaultAndClear(EntityList& entities, EditStateChangeSet& changeSet, const EntityList& except) {
-            if (except.empty()) {
-                EntityList::iterator it, end;
-                for (it = entities.begin(), end = entities.end(); it != end; ++it) {
+            EntityList kept;
+            if (!except.empty()) {
+                kept.reserve(except.size());
+                EntityList::const_iterator it, end;
+                for (it = except.begin(), end = except.end(); it != end; ++it) {
                     Entity& entity = **it;
-                    EditState::Type previousState = entity.setEditState(EditState::Default);
-                    changeSet.addEntity(previousState, entity);
-                }
-                entities.clear();
-            } else {
-                EntityList::iterator it = entities.begin();
-                while (it != entities.end()) {
-                    Entity& entity = **it;
-                    if (std::find(except.begin(), except.end(), &entity) == except.end()) {
-                        EditState::Type previousState = entity.setEditState(EditState::Default);
-                        changeSet.addEntity(previousState, entity);
-                        it = entities.erase(it);
-                    } else {
-                        ++it;
+                    if (containsIndexed(entities, entity)) {
+                        eraseIndexed(entities, entity);
+                        kept.push_back(&entity);
                     }
                 }
             }
+            
+            if (!entities.empty())
+                changeSet.reserveEntities(entities.front()->editState(), EditState::Default, entities.size());
+            
+            EntityList::iterator it, end;
+            for (it = entities.begin(), end = entities.end(); it != end; ++it)
+                setDefault(**it, changeSet);
+            
+            entities.swap(kept);
+            reindex(entities);
         }
         
         void EditStateManager::setDefaultAndClear(BrushList& brushes, EditStateChangeSet& changeSet, const BrushList& except) {
-            if (except.empty()) {
-                BrushList::iterator it, end;
-                for (it = brushes.begin(), end = brushes.end(); it != end; ++it) {
+            BrushList kept;
+            if (!except.empty()) {
+                kept.reserve(except.size());
+                BrushList::const_iterator it, end;
+                for (it = except.begin(), end = except.end(); it != end; ++it) {
                     Brush& brush = **it;
-                    EditState::Type previousState = brush.setEditState(EditState::Default);
-                    changeSet.addBrush(previousState, brush);
-                }
-                brushes.clear();
-            } else {
-                BrushList::iterator it = brushes.begin();
-                while (it != brushes.end()) {
-                    Brush& brush = **it;
-                    if (std::find(except.begin(), except.end(), &brush) == except.end()) {
-                        EditState::Type previousState = brush.setEditState(EditState::Default);
-                        changeSet.addBrush(previousState, brush);
-                        it = brushes.erase(it);
-                    } else {
-                        ++it;
+                    if (containsIndexed(brushes, brush)) {
+                        eraseIndexed(brushes, brush);
+                        kept.push_back(&brush);
                     }
                 }
             }
             
+            if (!brushes.empty())
+                changeSet.reserveBrushes(brushes.front()->editState(), EditState::Default, brushes.size());
+            
+            BrushList::iterator it, end;
+            for (it = brushes.begin(), end = brushes.end(); it != end; ++it)
+                setDefault(**it, changeSet);
+            
+            brushes.swap(kept);
+            reindex(brushes);
         }
         
         void EditStateManager::deselectAndClear(FaceList& faces, EditStateChangeSet& changeSet) {
+            changeSet.reserveFaces(true, faces.size());
             for (unsigned int i = 0; i < faces.size(); i++) {
                 Face& face = *faces[i];
                 face.setSelected(false);
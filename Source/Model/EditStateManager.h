@@ -28,7 +28,6 @@
 #include "Model/TextureTypes.h"
 
 #include <cassert>
-#include <map>
 #include <vector>
 
 namespace TrenchBroom {
@@ -45,6 +44,11 @@ namespace TrenchBroom {
                 SMFaces
             } SelectionMode;
 
+            /**
+             * Every selected, hidden or locked object is stored in the list of its edit state at the position given
+             * by its edit state index, so that it can be removed in constant time by swapping it with the last
+             * element. The order of the lists is therefore not the order in which the objects were added.
+             */
             class State {
             public:
                 EntityList selectedEntities;
@@ -73,6 +77,26 @@ namespace TrenchBroom {
                     return SMNone;
                 }
                 
+                inline EntityList* entities(EditState::Type state) {
+                    if (state == EditState::Selected)
+                        return &selectedEntities;
+                    if (state == EditState::Hidden)
+                        return &hiddenEntities;
+                    if (state == EditState::Locked)
+                        return &lockedEntities;
+                    return NULL;
+                }
+                
+                inline BrushList* brushes(EditState::Type state) {
+                    if (state == EditState::Selected)
+                        return &selectedBrushes;
+                    if (state == EditState::Hidden)
+                        return &hiddenBrushes;
+                    if (state == EditState::Locked)
+                        return &lockedBrushes;
+                    return NULL;
+                }
+                
                 inline void clear() {
                     selectedEntities.clear();
                     hiddenEntities.clear();
@@ -98,6 +122,8 @@ namespace TrenchBroom {
             bool doSetEditState(const EntityList& entities, EditState::Type newState, EditStateChangeSet& changeSet);
             bool doSetEditState(const BrushList& brushes, EditState::Type newState, EditStateChangeSet& changeSet);
             bool doSetSelected(const FaceList& faces, bool newState, EditStateChangeSet& changeSet);
+            void setDefault(Entity& entity, EditStateChangeSet& changeSet);
+            void setDefault(Brush& brush, EditStateChangeSet& changeSet);
             void setDefaultAndClear(EntityList& entities, EditStateChangeSet& changeSet, const EntityList& except = EmptyEntityList);
             void setDefaultAndClear(BrushList& brushes, EditStateChangeSet& changeSet, const BrushList& except = EmptyBrushList);
             void deselectAndClear(FaceList& faces, EditStateChangeSet& changeSet);
@@ -201,14 +227,11 @@ namespace TrenchBroom {
         };
         
         class EditStateChangeSet {
-        public:
-            typedef std::map<EditState::Type, EntityList> EntityStateChange;
-            typedef std::map<EditState::Type, BrushList> BrushStateChange;
         private:
-            mutable EntityStateChange m_entityStateChangesFrom;
-            mutable EntityStateChange m_entityStateChangesTo;
-            mutable BrushStateChange m_brushStateChangesFrom;
-            mutable BrushStateChange m_brushStateChangesTo;
+            EntityList m_entityStateChangesFrom[EditState::Count];
+            EntityList m_entityStateChangesTo[EditState::Count];
+            BrushList m_brushStateChangesFrom[EditState::Count];
+            BrushList m_brushStateChangesTo[EditState::Count];
             FaceList m_selectedFaces;
             FaceList m_deselectedFaces;
             bool m_empty;
@@ -218,6 +241,33 @@ namespace TrenchBroom {
             bool m_faceSelectionChanged;
             
             friend class EditStateManager;
+            template <typename T>
+            inline static void reserve(std::vector<T*>& list, size_t count) {
+                list.reserve(list.size() + count);
+            }
+            
+            inline void reserveEntities(EditState::Type previousState, EditState::Type newState, size_t count) {
+                reserve(m_entityStateChangesFrom[previousState], count);
+                reserve(m_entityStateChangesTo[newState], count);
+            }
+            
+            inline void reserveEntities(EditState::Type newState, size_t count) {
+                reserve(m_entityStateChangesTo[newState], count);
+            }
+            
+            inline void reserveBrushes(EditState::Type previousState, EditState::Type newState, size_t count) {
+                reserve(m_brushStateChangesFrom[previousState], count);
+                reserve(m_brushStateChangesTo[newState], count);
+            }
+            
+            inline void reserveBrushes(EditState::Type newState, size_t count) {
+                reserve(m_brushStateChangesTo[newState], count);
+            }
+            
+            inline void reserveFaces(bool previouslySelected, size_t count) {
+                reserve(previouslySelected ? m_deselectedFaces : m_selectedFaces, count);
+            }
+            
             inline void addEntity(EditState::Type previousState, Entity& entity) {
                 m_entityStateChangesFrom[previousState].push_back(&entity);
                 m_entityStateChangesTo[entity.editState()].push_back(&entity);
@@ -683,6 +683,40 @@ namespace TrenchBroom {
             invalidateGeometry();
         }
 
+        bool Entity::definitionChangesBounds(const EntityDefinition* definition) const {
+            const bool oldPointEntity = m_definition != NULL && m_definition->type() == EntityDefinition::PointEntity;
+            const bool newPointEntity = definition != NULL && definition->type() == EntityDefinition::PointEntity;
+            if (oldPointEntity != newPointEntity)
+                return true;
+            if (!oldPointEntity)
+                return false;
+            
+            const PointEntityDefinition* oldPointDefinition = static_cast<const PointEntityDefinition*>(m_definition);
+            const PointEntityDefinition* newPointDefinition = static_cast<const PointEntityDefinition*>(definition);
+            return !(oldPointDefinition->bounds() == newPointDefinition->bounds());
+        }
+
+        bool Entity::definitionChangesAppearance(const EntityDefinition* definition) const {
+            if (definitionChangesBounds(definition))
+                return true;
+            if ((m_definition == NULL) != (definition == NULL))
+                return true;
+            if (m_definition == NULL)
+                return false;
+            if (!(m_definition->color() == definition->color()))
+                return true;
+            if (m_definition->type() != EntityDefinition::PointEntity)
+                return false;
+            
+            const ModelDefinition* oldModel = static_cast<const PointEntityDefinition*>(m_definition)->model(properties());
+            const ModelDefinition* newModel = static_cast<const PointEntityDefinition*>(definition)->model(properties());
+            if (oldModel == NULL || newModel == NULL)
+                return oldModel != newModel;
+            return (oldModel->name() != newModel->name() ||
+                    oldModel->skinIndex() != newModel->skinIndex() ||
+                    oldModel->frameIndex() != newModel->frameIndex());
+        }
+
         bool Entity::selectable() const {
             return m_brushes.empty();
         }
@@ -246,6 +246,17 @@ namespace TrenchBroom {
             }
 
             void setDefinition(EntityDefinition* definition);
+            
+            /**
+             * Returns whether replacing this entity's definition with the given definition may change its bounds.
+             */
+            bool definitionChangesBounds(const EntityDefinition* definition) const;
+            
+            /**
+             * Returns whether replacing this entity's definition with the given definition may change the way it is
+             * rendered, i.e., its bounds, its color, or its model.
+             */
+            bool definitionChangesAppearance(const EntityDefinition* definition) const;
 
             bool selectable() const;
 
@@ -53,6 +53,14 @@ namespace TrenchBroom {
         public:
             ModelDefinitionPropertyEvaluator(const PropertyKey& propertyKey, const PropertyValue& propertyValue);
             
+            inline const PropertyKey& propertyKey() const {
+                return m_propertyKey;
+            }
+            
+            inline const PropertyValue& propertyValue() const {
+                return m_propertyValue;
+            }
+            
             bool evaluate(const PropertyList& properties) const;
         };
         
@@ -63,6 +71,14 @@ namespace TrenchBroom {
         public:
             ModelDefinitionFlagEvaluator(const PropertyKey& propertyKey, int flagValue);
             
+            inline const PropertyKey& propertyKey() const {
+                return m_propertyKey;
+            }
+            
+            inline int flagValue() const {
+                return m_flagValue;
+            }
+            
             bool evaluate(const PropertyList& properties) const;
         };
         
@@ -104,6 +120,10 @@ namespace TrenchBroom {
                 return m_frameIndex;
             }
             
+            inline const ModelDefinitionEvaluator* evaluator() const {
+                return m_evaluator.get();
+            }
+            
             inline bool matches(const PropertyList& properties) const {
                 if (m_evaluator == NULL)
                     return true;
@@ -151,6 +171,14 @@ namespace TrenchBroom {
                 return m_color;
             }
             
+            inline const String& description() const {
+                return m_description;
+            }
+            
+            inline const PropertyDefinition::List& propertyDefinitions() const {
+                return m_propertyDefinitions;
+            }
+            
             const FlagsPropertyDefinition* spawnflags() const {
                 PropertyDefinition::List::const_iterator it, end;
                 for (it = m_propertyDefinitions.begin(), end = m_propertyDefinitions.end(); it != end; ++it) {
@@ -200,6 +228,10 @@ namespace TrenchBroom {
                 return m_bounds;
             }
 
+            inline const ModelDefinition::List& modelDefinitions() const {
+                return m_modelDefinitions;
+            }
+
             const ModelDefinition* model(const PropertyList& properties = EmptyPropertyList) const;
         };
         
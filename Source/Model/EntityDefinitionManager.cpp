@@ -21,6 +21,7 @@
 
 #include "IO/FileManager.h"
 #include "IO/DefParser.h"
+#include "IO/EntityDefinitionCache.h"
 #include "IO/FgdParser.h"
 #include "Utility/Color.h"
 #include "Utility/Console.h"
@@ -32,6 +33,13 @@
 
 namespace TrenchBroom {
     namespace Model {
+        void EntityDefinitionManager::reindex() {
+            m_index.clear();
+            EntityDefinitionMap::const_iterator it, end;
+            for (it = m_entityDefinitions.begin(), end = m_entityDefinitions.end(); it != end; ++it)
+                m_index.add(it->second->name(), it->second);
+        }
+        
         EntityDefinitionManager::EntityDefinitionManager(Utility::Console& console) :
         m_console(console) {}
         
@@ -56,7 +64,7 @@ namespace TrenchBroom {
             return result;
         }
 
-        void EntityDefinitionManager::load(const String& path) {
+        bool EntityDefinitionManager::load(const String& path, EntityDefinitionList& replacedDefinitions) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             const Color& defaultColor = prefs.getColor(Preferences::EntityBoundsColor);
             EntityDefinitionMap newDefinitions;
@@ -65,24 +73,44 @@ namespace TrenchBroom {
             IO::MappedFile::Ptr file = fileManager.mapFile(path);
             if (file.get() != NULL) {
                 try {
-                    const String extension = fileManager.pathExtension(path);
-                    if (Utility::equalsString(extension, "def", false)) {
-                        IO::DefParser parser(file->begin(), file->end(), defaultColor);
+                    IO::EntityDefinitionCache cache(path, *file, fileManager.cacheDirectory(), defaultColor);
+                    EntityDefinitionList cachedDefinitions;
+                    if (cache.read(cachedDefinitions)) {
+                        EntityDefinitionList::const_iterator it, end;
+                        for (it = cachedDefinitions.begin(), end = cachedDefinitions.end(); it != end; ++it)
+                            Utility::insertOrReplace(newDefinitions, (*it)->name(), *it);
+                    } else {
+                        const String extension = fileManager.pathExtension(path);
+                        if (Utility::equalsString(extension, "def", false)) {
+                            IO::DefParser parser(file->begin(), file->end(), defaultColor);
+                            
+                            EntityDefinition* definition = NULL;
+                            while ((definition = parser.nextDefinition()) != NULL)
+                                Utility::insertOrReplace(newDefinitions, definition->name(), definition);
+                        } else if (Utility::equalsString(extension, "fgd", false)) {
+                            IO::FgdParser parser(file->begin(), file->end(), defaultColor);
+                            
+                            EntityDefinition* definition = NULL;
+                            while ((definition = parser.nextDefinition()) != NULL)
+                                Utility::insertOrReplace(newDefinitions, definition->name(), definition);
+                        }
                         
-                        EntityDefinition* definition = NULL;
-                        while ((definition = parser.nextDefinition()) != NULL)
-                            Utility::insertOrReplace(newDefinitions, definition->name(), definition);
-                    } else if (Utility::equalsString(extension, "fgd", false)) {
-                        IO::FgdParser parser(file->begin(), file->end(), defaultColor);
-                        
-                        EntityDefinition* definition = NULL;
-                        while ((definition = parser.nextDefinition()) != NULL)
-                            Utility::insertOrReplace(newDefinitions, definition->name(), definition);
+                        EntityDefinitionList parsedDefinitions;
+                        EntityDefinitionMap::const_iterator it, end;
+                        for (it = newDefinitions.begin(), end = newDefinitions.end(); it != end; ++it)
+                            parsedDefinitions.push_back(it->second);
+                        if (!cache.write(parsedDefinitions))
+                            m_console.debug("Unable to write entity definition cache %s", cache.cachePath().c_str());
                     }
                     
-                    clear();
-                    m_entityDefinitions = newDefinitions;
+                    EntityDefinitionMap::const_iterator it, end;
+                    for (it = m_entityDefinitions.begin(), end = m_entityDefinitions.end(); it != end; ++it)
+                        replacedDefinitions.push_back(it->second);
+                    
+                    m_entityDefinitions.swap(newDefinitions);
                     m_path = path;
+                    reindex();
+                    return true;
                 } catch (IO::ParserException& e) {
                     Utility::deleteAll(newDefinitions);
                     m_console.error(e.what());
@@ -90,10 +118,12 @@ namespace TrenchBroom {
             } else {
                 m_console.error("Unable to open entity definition file %s", path.c_str());
             }
+            return false;
         }
         
         void EntityDefinitionManager::clear() {
             Utility::deleteAll(m_entityDefinitions);
+            m_index.clear();
         }
 
         EntityDefinition* EntityDefinitionManager::definition(const String& name) {
@@ -22,6 +22,7 @@
 #include "Model/EntityDefinitionTypes.h"
 #include "Model/EntityDefinition.h"
 #include "Utility/String.h"
+#include "Utility/StringIndex.h"
 
 #include <map>
 
@@ -33,6 +34,8 @@ namespace TrenchBroom {
     namespace Model {
         class EntityDefinition;
         
+        typedef Utility::StringIndex<EntityDefinition*> EntityDefinitionIndex;
+
         class EntityDefinitionManager {
         public:
             enum SortOrder {
@@ -70,15 +73,32 @@ namespace TrenchBroom {
             Utility::Console& m_console;
             String m_path;
             EntityDefinitionMap m_entityDefinitions;
+            EntityDefinitionIndex m_index;
+            
+            void reindex();
         public:
             EntityDefinitionManager(Utility::Console& console);
             ~EntityDefinitionManager();
             
             static StringList builtinDefinitionFiles();
             
-            void load(const String& path);
+            /**
+             * Loads the definitions in the given file and replaces the current definitions with them. The replaced
+             * definitions are not deleted, but appended to the given list so that the caller can move entities over
+             * to the new definitions before deleting the old ones. Returns false if the file could not be loaded, in
+             * which case the current definitions remain in place. A compiled cache of the file is used if it is up to
+             * date, otherwise the file is parsed and the cache is rewritten.
+             */
+            bool load(const String& path, EntityDefinitionList& replacedDefinitions);
             void clear();
             
+            /**
+             * Returns the name index of the current definitions.
+             */
+            inline const EntityDefinitionIndex& index() const {
+                return m_index;
+            }
+            
             EntityDefinition* definition(const String& name);
             EntityDefinitionList definitions(EntityDefinition::Type type, SortOrder order = Name);
             EntityDefinitionGroups groups(EntityDefinition::Type type, SortOrder order = Name);
@@ -22,12 +22,13 @@
 #include "Model/Brush.h"
 #include "Model/BrushGeometry.h"
 #include "Model/Texture.h"
+#include "Utility/Atomic.h"
 
 namespace TrenchBroom {
     namespace Model {
-        inline void FindFacePoints::operator()(const Face& face, FacePoints& points) const {
+        inline void FindFacePoints::operator()(const Face& face, FacePoints& points, Utility::PlanePointCache* cache) const {
             size_t numPoints = selectInitialPoints(face, points);
-            findPoints(face.boundary(), points, numPoints);
+            findPoints(face.boundary(), points, numPoints, cache);
         }
 
         const FindFacePoints& FindFacePoints::instance(bool forceIntegerCoordinates) {
@@ -71,8 +72,13 @@ namespace TrenchBroom {
              */
         }
         
-        inline void FindIntegerFacePoints::findPoints(const Planef& plane, FacePoints& points, size_t numPoints) const {
-            m_findPoints(plane, points, numPoints);
+        inline void FindIntegerFacePoints::findPoints(const Planef& plane, FacePoints& points, size_t numPoints, Utility::PlanePointCache* cache) const {
+            if (cache == NULL || numPoints > 0) {
+                m_findPoints(plane, points, numPoints);
+            } else if (!cache->find(plane, points)) {
+                m_findPoints(plane, points, numPoints);
+                cache->insert(plane, points);
+            }
         }
 
         const FindIntegerFacePoints FindIntegerFacePoints::Instance = FindIntegerFacePoints();
@@ -82,7 +88,7 @@ namespace TrenchBroom {
             return 3;
         }
         
-        inline void FindFloatFacePoints::findPoints(const Planef& plane, FacePoints& points, size_t numPoints) const {
+        inline void FindFloatFacePoints::findPoints(const Planef& plane, FacePoints& points, size_t numPoints, Utility::PlanePointCache* cache) const {
             m_findPoints(plane, points, numPoints);
         }
         
@@ -98,8 +104,8 @@ namespace TrenchBroom {
         };
         
         void Face::init() {
-            static unsigned int currentId = 1;
-            m_faceId = currentId++;
+            static volatile long currentId = 0;
+            m_faceId = static_cast<unsigned int>(Utility::atomicIncrement(currentId));
             for (size_t i = 0; i < 3; i++)
                 m_points[i] = Vec3f::Null;
             m_xOffset = 0.0f;
@@ -111,8 +117,8 @@ namespace TrenchBroom {
             m_texture = NULL;
             m_filePosition = 0;
             m_selected = false;
+            m_editStateIndex = 0;
             m_texAxesValid = false;
-            m_vertexCacheValid = false;
             m_contentType = CTDefault;
         }
         
@@ -159,39 +165,16 @@ namespace TrenchBroom {
             }
         }
 
-        void Face::validateVertexCache() const {
-            assert(m_side != NULL);
-            
+        void Face::textureProjection(Vec3f& xAxis, Vec3f& yAxis, Vec2f& offset) const {
             if (!m_texAxesValid)
                 validateTexAxes(m_boundary.normal);
             
-            unsigned int width = m_texture != NULL ? m_texture->width() : 1;
-            unsigned int height = m_texture != NULL ? m_texture->height() : 1;
-            
-            size_t vertexCount = m_side->vertices.size();
-            m_vertexCache.resize(3 * (vertexCount - 2));
-            
-            Vec2f texCoords;
-            size_t j = 0;
-            for (size_t i = 1; i < vertexCount - 1; i++) {
-                m_vertexCache[j++] = Renderer::FaceVertex(m_side->vertices[0]->position,
-                                                          m_boundary.normal,
-                                                          Vec2f((m_side->vertices[0]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
-                                                                (m_side->vertices[0]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
-                                                          );
-                m_vertexCache[j++] = Renderer::FaceVertex(m_side->vertices[i]->position,
-                                                          m_boundary.normal,
-                                                          Vec2f((m_side->vertices[i]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
-                                                                (m_side->vertices[i]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
-                                                          );
-                m_vertexCache[j++] = Renderer::FaceVertex(m_side->vertices[i+1]->position,
-                                                          m_boundary.normal,
-                                                          Vec2f((m_side->vertices[i+1]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
-                                                                (m_side->vertices[i+1]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
-                                                          );
-            }
+            const float width = m_texture != NULL ? static_cast<float>(m_texture->width()) : 1.0f;
+            const float height = m_texture != NULL ? static_cast<float>(m_texture->height()) : 1.0f;
             
-            m_vertexCacheValid = true;
+            xAxis = m_scaledTexAxisX / width;
+            yAxis = m_scaledTexAxisY / height;
+            offset = Vec2f(m_xOffset / width, m_yOffset / height);
         }
         
         void Face::compensateTransformation(const Mat4f& transformation) {
@@ -383,14 +366,24 @@ namespace TrenchBroom {
         m_xScale(face.xScale()),
         m_yScale(face.yScale()),
         m_texAxesValid(false),
-        m_vertexCacheValid(false),
         m_filePosition(face.filePosition()),
         m_selected(false),
+        m_editStateIndex(0),
         m_contentType(face.contentType()) {
             face.getPoints(m_points[0], m_points[1], m_points[2]);
             updatePointsFromBoundary();
         }
         
+        Face::Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, unsigned int faceId, const FacePoints& points, const Planef& boundary) : m_worldBounds(worldBounds) {
+            init();
+            m_faceId = faceId;
+            m_forceIntegerFacePoints = forceIntegerFacePoints;
+            for (size_t i = 0; i < 3; i++)
+                m_points[i] = points[i];
+            m_boundary = boundary;
+            updatePointsFromBoundary();
+        }
+        
 		Face::~Face() {
 			m_texPlanefNormIndex = 0;
 			m_texFaceNormIndex = 0;
@@ -416,7 +409,6 @@ namespace TrenchBroom {
 			m_side = NULL;
 			m_filePosition = 0;
 			m_selected = false;
-			m_vertexCacheValid = false;
 			m_texAxesValid = false;
 		}
         
@@ -430,7 +422,6 @@ namespace TrenchBroom {
             m_yScale = faceTemplate.yScale();
             setTexture(faceTemplate.texture());
             m_texAxesValid = false;
-            m_vertexCacheValid = false;
 			m_selected = faceTemplate.selected();
             m_contentType = faceTemplate.contentType();
         }
@@ -484,9 +475,9 @@ namespace TrenchBroom {
             }
         }
         
-        void Face::updatePointsFromBoundary() {
+        void Face::updatePointsFromBoundary(Utility::PlanePointCache* cache) {
             const FindFacePoints& findPoints = FindFacePoints::instance(m_forceIntegerFacePoints);
-            findPoints(*this, m_points);
+            findPoints(*this, m_points, cache);
             correctFacePoints();
             
             if (!m_boundary.setPoints(m_points[0], m_points[1], m_points[2])) {
@@ -500,14 +491,26 @@ namespace TrenchBroom {
             }
         }
 
+        void Face::restorePlane(const FacePoints& points, const Planef& boundary) {
+            for (size_t i = 0; i < 3; i++)
+                m_points[i] = points[i];
+            m_boundary = boundary;
+            m_texAxesValid = false;
+        }
+
+        void Face::restorePlane(const FacePoints& points, const Planef& boundary, bool forceIntegerFacePoints) {
+            restorePlane(points, boundary);
+            m_forceIntegerFacePoints = forceIntegerFacePoints;
+        }
+        
         void Face::correctFacePoints() {
             for (size_t i = 0; i < 3; i++)
                 m_points[i].correct();
         }
         
-        void Face::setForceIntegerFacePoints(bool forceIntegerFacePoints) {
+        void Face::setForceIntegerFacePoints(bool forceIntegerFacePoints, Utility::PlanePointCache* cache) {
             m_forceIntegerFacePoints = forceIntegerFacePoints;
-            updatePointsFromBoundary();
+            updatePointsFromBoundary(cache);
         }
 
         void Face::setTexture(Texture* texture) {
@@ -523,7 +526,6 @@ namespace TrenchBroom {
             
             if (m_texture != NULL)
                 m_texture->incUsageCount();
-            m_vertexCacheValid = false;
             updateContentType();
         }
         
@@ -622,10 +624,8 @@ namespace TrenchBroom {
                     break;
                     
                 default:
-                    return;
+                    break;
             }
-            
-            m_vertexCacheValid = false;
         }
         
         void Face::rotateTexture(float angle) {
@@ -637,7 +637,6 @@ namespace TrenchBroom {
             else
                 m_rotation -= angle;
             m_texAxesValid = false;
-            m_vertexCacheValid = false;
         }
         
         void Face::setSelected(bool selected) {
@@ -668,7 +667,6 @@ namespace TrenchBroom {
                 correctFacePoints();
 
             m_texAxesValid = false;
-            m_vertexCacheValid = false;
         }
     }
 }
@@ -22,9 +22,9 @@
 
 #include "Model/BrushGeometry.h"
 #include "Model/FaceTypes.h"
-#include "Renderer/FaceVertex.h"
 #include "Utility/Allocator.h"
 #include "Utility/FindPlanePoints.h"
+#include "Utility/PlanePointCache.h"
 #include "Utility/String.h"
 #include "Utility/VecMath.h"
 
@@ -39,12 +39,12 @@ namespace TrenchBroom {
         class FindFacePoints {
         protected:
             virtual size_t selectInitialPoints(const Face& face, FacePoints& points) const = 0;
-            virtual void findPoints(const Planef& plane, FacePoints& points, size_t numPoints) const = 0;
+            virtual void findPoints(const Planef& plane, FacePoints& points, size_t numPoints, Utility::PlanePointCache* cache) const = 0;
         public:
             virtual ~FindFacePoints() {}
 
             static const FindFacePoints& instance(bool forceIntegerCoordinates);
-            inline void operator()(const Face& face, FacePoints& points) const;
+            inline void operator()(const Face& face, FacePoints& points, Utility::PlanePointCache* cache = NULL) const;
         };
 
         class FindIntegerFacePoints : public FindFacePoints {
@@ -52,7 +52,7 @@ namespace TrenchBroom {
             FindIntegerPlanePoints m_findPoints;
         protected:
             inline size_t selectInitialPoints(const Face& face, FacePoints& points) const;
-            inline void findPoints(const Planef& plane, FacePoints& points, size_t numPoints) const;
+            inline void findPoints(const Planef& plane, FacePoints& points, size_t numPoints, Utility::PlanePointCache* cache) const;
         public:
             static const FindIntegerFacePoints Instance;
         };
@@ -62,7 +62,7 @@ namespace TrenchBroom {
             FindFloatPlanePoints m_findPoints;
         protected:
             inline size_t selectInitialPoints(const Face& face, FacePoints& points) const;
-            inline void findPoints(const Planef& plane, FacePoints& points, size_t numPoints) const;
+            inline void findPoints(const Planef& plane, FacePoints& points, size_t numPoints, Utility::PlanePointCache* cache) const;
         public:
             static const FindFloatFacePoints Instance;
         };
@@ -131,11 +131,9 @@ namespace TrenchBroom {
             mutable Vec3f m_scaledTexAxisX;
             mutable Vec3f m_scaledTexAxisY;
 
-            mutable bool m_vertexCacheValid;
-            mutable Renderer::FaceVertex::List m_vertexCache;
-
             size_t m_filePosition;
             bool m_selected;
+            size_t m_editStateIndex;
             
             ContentType m_contentType;
 
@@ -149,7 +147,6 @@ namespace TrenchBroom {
             void init();
             void texAxesAndIndices(const Vec3f& faceNormal, Vec3f& xAxis, Vec3f& yAxis, unsigned int& planeNormIndex, unsigned int& faceNormIndex) const;
             void validateTexAxes(const Vec3f& faceNormal) const;
-            void validateVertexCache() const;
 
             void projectOntoTexturePlane(Vec3f& xAxis, Vec3f& yAxis);
             void compensateTransformation(const Mat4f& transformation);
@@ -158,6 +155,10 @@ namespace TrenchBroom {
             Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Vec3f& point1, const Vec3f& point2, const Vec3f& point3, const String& textureName);
             Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Face& faceTemplate);
             Face(const Face& face);
+            /**
+             * Creates a face with the given ID and plane, e.g. to restore a face from an undo snapshot.
+             */
+            Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, unsigned int faceId, const FacePoints& points, const Planef& boundary);
 			~Face();
 
             void restore(const Face& faceTemplate);
@@ -186,7 +187,14 @@ namespace TrenchBroom {
             }
 
             void updatePointsFromVertices();
-            void updatePointsFromBoundary();
+            void updatePointsFromBoundary(Utility::PlanePointCache* cache = NULL);
+            
+            /**
+             * Resets the points and the boundary of this face, e.g. to roll back a vertex operation which was
+             * prepared on a copy of the brush geometry.
+             */
+            void restorePlane(const FacePoints& points, const Planef& boundary);
+            void restorePlane(const FacePoints& points, const Planef& boundary, bool forceIntegerFacePoints);
 
             inline void getPoints(Vec3f& point1, Vec3f& point2, Vec3f& point3) const {
                 point1 = m_points[0];
@@ -213,7 +221,7 @@ namespace TrenchBroom {
                 return m_forceIntegerFacePoints;
             }
 
-            void setForceIntegerFacePoints(bool forceIntegerFacePoints);
+            void setForceIntegerFacePoints(bool forceIntegerFacePoints, Utility::PlanePointCache* cache = NULL);
             
             inline const VertexList& vertices() const {
                 return m_side->vertices;
@@ -251,10 +259,7 @@ namespace TrenchBroom {
             }
 
             inline void setXOffset(float xOffset) {
-                if (xOffset == m_xOffset)
-                    return;
                 m_xOffset = xOffset;
-                m_vertexCacheValid = false;
             }
 
             inline float yOffset() const {
@@ -262,10 +267,7 @@ namespace TrenchBroom {
             }
 
             inline void setYOffset(float yOffset) {
-                if (yOffset == m_yOffset)
-                    return;
                 m_yOffset = yOffset;
-                m_vertexCacheValid = false;
             }
 
             inline float rotation() const {
@@ -277,7 +279,6 @@ namespace TrenchBroom {
                     return;
                 m_rotation = rotation;
                 m_texAxesValid = false;
-                m_vertexCacheValid = false;
             }
 
             inline float xScale() const {
@@ -289,7 +290,6 @@ namespace TrenchBroom {
                     return;
                 m_xScale = xScale;
                 m_texAxesValid = false;
-                m_vertexCacheValid = false;
             }
 
             inline float yScale() const {
@@ -301,7 +301,6 @@ namespace TrenchBroom {
                     return;
                 m_yScale = yScale;
                 m_texAxesValid = false;
-                m_vertexCacheValid = false;
             }
 
             inline void setAttributes(const Face& face) {
@@ -321,15 +320,12 @@ namespace TrenchBroom {
             void moveTexture(const Vec3f& up, const Vec3f& right, Direction direction, float distance);
             void rotateTexture(float angle);
 
-            inline void invalidateVertexCache() {
-                m_vertexCacheValid = false;
-            }
-
-            inline const Renderer::FaceVertex::List& cachedVertices() const {
-                if (!m_vertexCacheValid)
-                    validateVertexCache();
-                return m_vertexCache;
-            }
+            /**
+             * Returns the projection of positions to texture coordinates, which are computed as
+             * (position.dot(xAxis) + offset.x(), position.dot(yAxis) + offset.y()). The texture size is included, so
+             * the coordinates can be written to the vertex buffer directly.
+             */
+            void textureProjection(Vec3f& xAxis, Vec3f& yAxis, Vec2f& offset) const;
 
             inline bool selected() const {
                 return m_selected;
@@ -337,6 +333,18 @@ namespace TrenchBroom {
 
             void setSelected(bool selected);
 
+            /**
+             * The position of this face in the edit state manager's list of selected faces. Only valid while the
+             * face is selected.
+             */
+            inline size_t editStateIndex() const {
+                return m_editStateIndex;
+            }
+
+            inline void setEditStateIndex(size_t index) {
+                m_editStateIndex = index;
+            }
+
             inline size_t filePosition() const {
                 return m_filePosition;
             }
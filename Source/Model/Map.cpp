@@ -22,9 +22,89 @@
 #include "Model/Brush.h"
 #include "Model/Entity.h"
 #include "Utility/List.h"
+#include "Utility/PlanePointCache.h"
+#include "Utility/ProgressIndicator.h"
+#include "Utility/WorkerPool.h"
+
+#include <algorithm>
 
 namespace TrenchBroom {
     namespace Model {
+        /**
+         * Converts the face points of a list of brushes in two passes. The first pass finds the new face points and
+         * can be run in several steps and reverted. The second pass rebuilds the geometry of the converted brushes.
+         * Both passes run on the shared worker pool. The plane points are cached for the whole conversion, since the
+         * same planes occur on many brushes.
+         */
+        class FacePointConversion : public Utility::ParallelTask {
+        private:
+            const BrushList& m_brushes;
+            bool m_forceIntegerFacePoints;
+            Utility::PlanePointCache m_cache;
+            FacePointBackup::List m_backups;
+            size_t m_first;
+            bool m_committing;
+        public:
+            FacePointConversion(const BrushList& brushes, bool forceIntegerFacePoints) :
+            m_brushes(brushes),
+            m_forceIntegerFacePoints(forceIntegerFacePoints),
+            m_backups(brushes.size()),
+            m_first(0),
+            m_committing(false) {}
+
+            void run(size_t index) {
+                Brush& brush = *m_brushes[m_first + index];
+                FacePointBackup& backup = m_backups[m_first + index];
+                if (!m_committing)
+                    brush.convertFacePoints(m_forceIntegerFacePoints, m_cache, backup);
+                else if (backup.converted())
+                    brush.commitFacePoints();
+            }
+
+            inline bool finished() const {
+                return m_first == m_brushes.size();
+            }
+
+            inline size_t convertedCount() const {
+                return m_first;
+            }
+
+            /**
+             * Converts the face points of the given number of brushes following the brushes converted so far.
+             */
+            void convert(size_t count) {
+                assert(!m_committing);
+                count = std::min(count, m_brushes.size() - m_first);
+                Utility::WorkerPool::execute(*this, count);
+                m_first += count;
+            }
+
+            void revert() {
+                for (size_t i = 0; i < m_first; i++)
+                    if (m_backups[i].converted())
+                        m_brushes[i]->revertFacePoints(m_backups[i]);
+                m_first = 0;
+            }
+
+            /**
+             * Rebuilds the geometry of all brushes which were converted and returns the number of brushes which
+             * could not be converted.
+             */
+            size_t commit() {
+                assert(finished());
+                m_committing = true;
+                m_first = 0;
+                Utility::WorkerPool::execute(*this, m_brushes.size());
+                m_first = m_brushes.size();
+
+                size_t failedCount = 0;
+                for (size_t i = 0; i < m_brushes.size(); i++)
+                    if (!m_backups[i].converted())
+                        failedCount++;
+                return failedCount;
+            }
+        };
+
         void Map::addEntityTargetname(Entity& entity, const String* targetname) {
             if (targetname != NULL && !targetname->empty())
                 m_entitiesWithTargetname[*targetname].insert(&entity);
@@ -113,19 +193,42 @@ namespace TrenchBroom {
             clear();
         }
 
-        void Map::setForceIntegerFacePoints(bool forceIntegerFacePoints) {
+        bool Map::setForceIntegerFacePoints(bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator, size_t& failedCount) {
+            failedCount = 0;
+
+            BrushList brushes;
             EntityList::const_iterator entityIt, entityEnd;
             for (entityIt = m_entities.begin(), entityEnd = m_entities.end(); entityIt != entityEnd; ++entityIt) {
-                Model::Entity& entity = **entityIt;
-                const Model::BrushList& brushes = entity.brushes();
-                BrushList::const_iterator brushIt, brushEnd;
-                for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                    Model::Brush& brush = **brushIt;
-                    brush.setForceIntegerFacePoints(forceIntegerFacePoints);
+                const Model::Entity& entity = **entityIt;
+                const Model::BrushList& entityBrushes = entity.brushes();
+                brushes.insert(brushes.end(), entityBrushes.begin(), entityBrushes.end());
+            }
+
+            FacePointConversion conversion(brushes, forceIntegerFacePoints);
+            const size_t stepSize = std::max(brushes.size() / 100, static_cast<size_t>(256));
+            if (indicator != NULL && !brushes.empty())
+                indicator->reset(static_cast<int>(brushes.size()));
+
+            while (!conversion.finished()) {
+                conversion.convert(stepSize);
+                if (indicator != NULL) {
+                    indicator->update(static_cast<int>(conversion.convertedCount()));
+                    if (indicator->cancelled()) {
+                        conversion.revert();
+                        return false;
+                    }
                 }
             }
-            
+
+            failedCount = conversion.commit();
+            for (entityIt = m_entities.begin(), entityEnd = m_entities.end(); entityIt != entityEnd; ++entityIt) {
+                Model::Entity& entity = **entityIt;
+                if (!entity.brushes().empty())
+                    entity.invalidateGeometry();
+            }
+
             m_forceIntegerFacePoints = forceIntegerFacePoints;
+            return true;
         }
 
         void Map::addEntity(Entity& entity) {
@@ -28,6 +28,10 @@
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
+    namespace Utility {
+        class ProgressIndicator;
+    }
+
     namespace Model {
         class Entity;
         
@@ -67,7 +71,13 @@ namespace TrenchBroom {
                 return m_forceIntegerFacePoints;
             }
             
-            void setForceIntegerFacePoints(bool forceIntegerFacePoints);
+            /**
+             * Converts the face points of all brushes to the given format on the shared worker pool. The brushes are
+             * converted in steps, and the given indicator, if any, is updated after each step. If the indicator is
+             * cancelled, all brushes are reverted and false is returned. Brushes whose faces do not get valid points
+             * are left unchanged and counted in failedCount.
+             */
+            bool setForceIntegerFacePoints(bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator, size_t& failedCount);
             
             void addEntity(Entity& entity);
             void removeEntity(Entity& entity);
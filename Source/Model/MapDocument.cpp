@@ -21,9 +21,12 @@
 
 #include "Controller/Autosaver.h"
 #include "Controller/Command.h"
+#include "Controller/EntityDefinitionChangeEvent.h"
+#include "Controller/LoadMapBatchEvent.h"
 #include "IO/FileManager.h"
+#include "IO/GameFileSystem.h"
 #include "IO/IOException.h"
-#include "IO/MapParser.h"
+#include "IO/MapLoader.h"
 #include "IO/MapWriter.h"
 #include "IO/Wad.h"
 #include "Model/Brush.h"
@@ -53,14 +56,20 @@
 
 #include <wx/msgdlg.h>
 #include <wx/stdpaths.h>
-#include <wx/stopwatch.h>
 
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Model {
+        namespace MapDocumentTimers {
+            static const int Autosave               = 1;
+            static const int Load                   = 2;
+            static const int LoadInterval           = 50;
+        }
+        
         BEGIN_EVENT_TABLE(MapDocument, wxDocument)
-        EVT_TIMER(wxID_ANY, MapDocument::OnAutosaveTimer)
+        EVT_TIMER(MapDocumentTimers::Autosave, MapDocument::OnAutosaveTimer)
+        EVT_TIMER(MapDocumentTimers::Load, MapDocument::OnLoadTimer)
         END_EVENT_TABLE()
 
         IMPLEMENT_DYNAMIC_CLASS(MapDocument, wxDocument)
@@ -75,10 +84,12 @@ namespace TrenchBroom {
                 
                 console().info("Loading file %s", file.mbc_str().data());
                 
-                View::ProgressIndicatorDialog progressIndicator;
-                loadMap(mappedFile->begin(), mappedFile->end(), progressIndicator);
-                loadTextures();
-                loadEntityDefinitionFile();
+                // the map is parsed in the background and added to the document by OnLoadTimer
+                m_loadProgress = new View::ProgressIndicatorDialog(true, false);
+                m_loadProgress->setText("Loading map file...");
+                m_loadWatch.Start();
+                m_mapLoader = new IO::MapLoader(mappedFile, m_map->worldBounds(), console());
+                m_loadTimer->Start(MapDocumentTimers::LoadInterval);
 
                 String title = fileManager.pathComponents(path).back();
                 SetTitle(title);
@@ -95,6 +106,9 @@ namespace TrenchBroom {
         }
 
         bool MapDocument::DoSaveDocument(const wxString& file) {
+            if (m_mapLoader != NULL)
+                endLoading(false);
+            
             try {
                 wxStopWatch watch;
                 IO::MapWriter mapWriter;
@@ -108,6 +122,11 @@ namespace TrenchBroom {
         }
 
         void MapDocument::clear() {
+            abortLoading();
+            m_loadedObjectCount = 0;
+            m_announcedObjectCount = 0;
+            m_loadedResources = false;
+            m_announcedMap = false;
             m_sharedResources->textureRendererManager().invalidate();
             m_editStateManager->clear();
             m_map->clear();
@@ -128,16 +147,127 @@ namespace TrenchBroom {
             m_sharedResources->loadPalette(palettePath);
         }
 
-        void MapDocument::loadMap(char* begin, char* end, Utility::ProgressIndicator& progressIndicator) {
-            progressIndicator.setText("Loading map file...");
+        void MapDocument::entityBegun(Entity* entity) {
+            assert(m_loadingEntity == NULL);
+            m_loadingEntity = entity;
             
-            wxStopWatch watch;
-            IO::MapParser parser(begin, end, console());
-            parser.parseMap(*m_map, &progressIndicator);
+            // worldspawn is added right away so that its brushes can be shown while they are loaded, all other
+            // entities are added once they are complete
+            if (entity->worldspawn()) {
+                addEntity(*entity);
+                if (!m_loadedResources)
+                    loadResources();
+            }
+        }
+        
+        void MapDocument::propertyParsed(const String& key, const String& value) {
+            if (m_loadingEntity->worldspawn()) {
+                entityWillChange(*m_loadingEntity);
+                m_loadingEntity->setProperty(key, value);
+                entityDidChange(*m_loadingEntity);
+            } else {
+                m_loadingEntity->setProperty(key, value);
+            }
+        }
+        
+        void MapDocument::brushParsed(Brush* brush) {
+            if (m_loadingEntity->worldspawn())
+                addBrush(*m_loadingEntity, *brush);
+            else
+                m_loadingEntity->addBrush(*brush);
+            m_loadedObjectCount++;
+        }
+        
+        void MapDocument::entityEnded(size_t firstLine, size_t lineCount) {
+            m_loadingEntity->setFilePosition(firstLine, lineCount);
+            if (!m_loadingEntity->worldspawn()) {
+                addEntity(*m_loadingEntity);
+                m_loadedEntities.push_back(m_loadingEntity);
+            }
+            m_loadingEntity = NULL;
+            m_loadedObjectCount++;
+        }
+        
+        void MapDocument::loadResources() {
+            m_loadedResources = true;
+            loadTextures();
+            loadEntityDefinitionFile();
+        }
+        
+        void MapDocument::updateLoadingViews(bool force) {
+            // the views are only notified once the textures are loaded, and the intervals grow with the map so that
+            // the brush renderers are not rebuilt for every batch
+            if (!m_loadedResources)
+                return;
             
-            console().info("Loaded map file in %f seconds", watch.Time() / 1000.0f);
+            if (!m_announcedMap) {
+                m_announcedMap = true;
+                m_announcedObjectCount = m_loadedObjectCount;
+                m_loadedEntities.clear();
+                
+                Controller::Command loadCommand(Controller::Command::LoadMap);
+                UpdateAllViews(NULL, &loadCommand);
+            } else if (force || m_loadedObjectCount > m_announcedObjectCount + m_announcedObjectCount / 2) {
+                m_announcedObjectCount = m_loadedObjectCount;
+                
+                Controller::LoadMapBatchEvent batchEvent(m_loadedEntities);
+                m_loadedEntities.clear();
+                UpdateAllViews(NULL, &batchEvent);
+            }
         }
-
+        
+        void MapDocument::discardLoadingEntity() {
+            // an entity which was cut short by a parse error or by cancelling is dropped unless it is worldspawn
+            if (m_loadingEntity != NULL && !m_loadingEntity->worldspawn())
+                delete m_loadingEntity;
+            m_loadingEntity = NULL;
+        }
+        
+        void MapDocument::endLoading(bool cancel) {
+            assert(m_mapLoader != NULL);
+            
+            m_loadTimer->Stop();
+            if (cancel)
+                m_mapLoader->cancel();
+            else
+                m_mapLoader->finish();
+            m_mapLoader->deliver(*this);
+            delete m_mapLoader;
+            m_mapLoader = NULL;
+            discardLoadingEntity();
+            delete m_loadProgress;
+            m_loadProgress = NULL;
+            
+            if (!m_loadedResources)
+                loadResources();
+            updateLoadingViews(true);
+            
+            if (cancel) {
+                console().warn("Cancelled loading map file after %f seconds, the map is incomplete", m_loadWatch.Time() / 1000.0f);
+                
+                // make sure that the incomplete map cannot be saved over the original file
+                SetTitle(GetTitle() + " (incomplete)");
+                SetFilename(wxEmptyString, true);
+                SetDocumentSaved(false);
+            } else {
+                console().info("Loaded map file in %f seconds", m_loadWatch.Time() / 1000.0f);
+            }
+        }
+        
+        void MapDocument::abortLoading() {
+            if (m_mapLoader == NULL)
+                return;
+            
+            m_loadTimer->Stop();
+            m_mapLoader->cancel();
+            delete m_mapLoader;
+            m_mapLoader = NULL;
+            discardLoadingEntity();
+            delete m_loadProgress;
+            m_loadProgress = NULL;
+            m_loadedEntities.clear();
+        }
+        
         void MapDocument::setAllTexturesToNull() {
             const Model::EntityList& entities = m_map->entities();
             for (size_t i = 0; i < entities.size(); i++) {
@@ -206,6 +336,14 @@ namespace TrenchBroom {
         MapDocument::MapDocument() :
         m_autosaver(NULL),
         m_autosaveTimer(NULL),
+        m_mapLoader(NULL),
+        m_loadTimer(NULL),
+        m_loadProgress(NULL),
+        m_loadingEntity(NULL),
+        m_loadedObjectCount(0),
+        m_announcedObjectCount(0),
+        m_loadedResources(false),
+        m_announcedMap(false),
         m_console(NULL),
         m_sharedResources(NULL),
         m_map(NULL),
@@ -223,6 +361,9 @@ namespace TrenchBroom {
         m_pointFile(NULL) {}
 
         MapDocument::~MapDocument() {
+            abortLoading();
+            delete m_loadTimer;
+            m_loadTimer = NULL;
             delete m_autosaveTimer;
             m_autosaveTimer = NULL;
             delete m_autosaver;
@@ -269,6 +410,7 @@ namespace TrenchBroom {
                 EntityDefinition* definition = m_definitionManager->definition(Entity::WorldspawnClassname);
                 worldspawn->setDefinition(definition);
                 m_map->addEntity(*worldspawn);
+                m_octree->addObject(*worldspawn);
             }
 
             return *worldspawn;
@@ -427,20 +569,36 @@ namespace TrenchBroom {
             m_octree->addObjects(Utility::makeList(objects));
         }
 
-        void MapDocument::setForceIntegerCoordinates(bool forceIntegerCoordinates) {
+        bool MapDocument::setForceIntegerCoordinates(bool forceIntegerCoordinates) {
             if (forceIntegerCoordinates)
                 console().info("Converting face plane points to integer coordinates...");
             else
                 console().info("Converting face plane points to floating point coordinates...");
             
+            size_t failedCount = 0;
+            bool converted = false;
+            {
+                View::ProgressIndicatorDialog progress(true);
+                progress.setText("Converting face plane points...");
+                converted = m_map->setForceIntegerFacePoints(forceIntegerCoordinates, &progress, failedCount);
+            }
+
+            if (!converted) {
+                console().info("Conversion cancelled, the map was not changed");
+                return false;
+            }
+
+            if (failedCount > 0)
+                console().warn("%u brushes could not be converted and were left unchanged", static_cast<unsigned int>(failedCount));
+
             GetCommandProcessor()->ClearCommands();
             
-            m_map->setForceIntegerFacePoints(forceIntegerCoordinates);
             worldspawn().setProperty(Entity::FacePointFormatKey, forceIntegerCoordinates);
             incModificationCount();
 
             Controller::Command loadCommand(Controller::Command::LoadMap);
             UpdateAllViews(NULL, &loadCommand);
+            return true;
         }
 
         Utility::Console& MapDocument::console() const {
@@ -500,6 +658,7 @@ namespace TrenchBroom {
         
         void MapDocument::invalidateSearchPaths() {
             m_searchPathsValid = false;
+            IO::GameFileSystem::sharedFileSystem->invalidate();
         }
 
         bool MapDocument::pointFileExists() {
@@ -571,27 +730,36 @@ namespace TrenchBroom {
                 return;
             }
 
-            const EntityList& entities = m_map->entities();
-            for (unsigned int i = 0; i < entities.size(); i++) {
-                Entity& entity = *entities[i];
-                entity.setDefinition(NULL);
-            }
-
-            m_octree->clear();
-            
-            m_definitionManager->clear();
-            m_definitionManager->load(definitionPath);
+            EntityDefinitionList replacedDefinitions;
+            if (!m_definitionManager->load(definitionPath, replacedDefinitions))
+                return;
 
+            // the replaced definitions stay alive until every entity has been moved over to its new definition
+            EntityList changedEntities;
+            const EntityList& entities = m_map->entities();
             for (unsigned int i = 0; i < entities.size(); i++) {
                 Entity& entity = *entities[i];
+                EntityDefinition* definition = NULL;
                 const PropertyValue* classname = entity.classname();
-                if (classname != NULL) {
-                    EntityDefinition* definition = m_definitionManager->definition(*classname);
+                if (classname != NULL)
+                    definition = m_definitionManager->definition(*classname);
+                
+                if (entity.definitionChangesAppearance(definition))
+                    changedEntities.push_back(&entity);
+                
+                if (entity.definitionChangesBounds(definition)) {
+                    m_octree->removeObject(entity);
+                    entity.setDefinition(definition);
+                    m_octree->addObject(entity);
+                } else {
                     entity.setDefinition(definition);
                 }
             }
             
-            m_octree->loadMap();
+            Utility::deleteAll(replacedDefinitions);
+            
+            Controller::EntityDefinitionChangeEvent changeEvent(changedEntities);
+            UpdateAllViews(NULL, &changeEvent);
         }
 
         void MapDocument::loadTextures() {
@@ -634,8 +802,9 @@ namespace TrenchBroom {
             m_definitionManager = new EntityDefinitionManager(*m_console);
             m_modificationCount = 0;
             m_autosaver = new Controller::Autosaver(*this);
-            m_autosaveTimer = new wxTimer(this);
+            m_autosaveTimer = new wxTimer(this, MapDocumentTimers::Autosave);
             m_autosaveTimer->Start(1000);
+            m_loadTimer = new wxTimer(this, MapDocumentTimers::Load);
 
             loadPalette();
 
@@ -666,8 +835,7 @@ namespace TrenchBroom {
 
         bool MapDocument::OnOpenDocument(const wxString& path) {
             if (wxDocument::OnOpenDocument(path)) {
-                Controller::Command loadCommand(Controller::Command::LoadMap);
-                UpdateAllViews(NULL, &loadCommand);
+                // the views are notified by OnLoadTimer as the map is loaded
                 m_modificationCount = 0;
                 m_autosaver->clearDirtyFlag();
 				return true;
@@ -677,7 +845,23 @@ namespace TrenchBroom {
         }
 
         void MapDocument::OnAutosaveTimer(wxTimerEvent& event) {
-            m_autosaver->triggerAutosave();
+            if (m_mapLoader == NULL)
+                m_autosaver->triggerAutosave();
+        }
+
+        void MapDocument::OnLoadTimer(wxTimerEvent& event) {
+            if (m_mapLoader == NULL)
+                return;
+            
+            if (m_loadProgress->cancelled()) {
+                endLoading(true);
+            } else if (m_mapLoader->finished()) {
+                endLoading(false);
+            } else {
+                m_mapLoader->deliver(*this);
+                updateLoadingViews(false);
+                m_loadProgress->update(m_mapLoader->percent());
+            }
         }
 	}
 }
@@ -20,11 +20,13 @@
 #ifndef __TrenchBroom__MapDocument__
 #define __TrenchBroom__MapDocument__
 
+#include "IO/MapParserListener.h"
 #include "Model/BrushTypes.h"
 #include "Model/EntityTypes.h"
 #include "Utility/String.h"
 
 #include <wx/docview.h>
+#include <wx/stopwatch.h>
 #include <wx/timer.h>
 
 namespace TrenchBroom {
@@ -32,6 +34,10 @@ namespace TrenchBroom {
         class Autosaver;
     }
     
+    namespace IO {
+        class MapLoader;
+    }
+    
     namespace Renderer {
         class SharedResources;
     }
@@ -42,6 +48,10 @@ namespace TrenchBroom {
         class ProgressIndicator;
     }
     
+    namespace View {
+        class ProgressIndicatorDialog;
+    }
+    
     namespace Model {
         class Brush;
         class EditStateManager;
@@ -56,11 +66,23 @@ namespace TrenchBroom {
         class Texture;
         class TextureManager;
         
-        class MapDocument : public wxDocument {
+        class MapDocument : public wxDocument, public IO::MapParserListener {
             DECLARE_DYNAMIC_CLASS(MapDocument)
         protected:
             Controller::Autosaver* m_autosaver;
             wxTimer* m_autosaveTimer;
+            
+            IO::MapLoader* m_mapLoader;
+            wxTimer* m_loadTimer;
+            wxStopWatch m_loadWatch;
+            View::ProgressIndicatorDialog* m_loadProgress;
+            Entity* m_loadingEntity;
+            EntityList m_loadedEntities;
+            size_t m_loadedObjectCount;
+            size_t m_announcedObjectCount;
+            bool m_loadedResources;
+            bool m_announcedMap;
+
             Utility::Console* m_console;
             Renderer::SharedResources* m_sharedResources;
             Map* m_map;
@@ -86,7 +108,17 @@ namespace TrenchBroom {
             void clear();
 
             void loadPalette();
-            void loadMap(char* begin, char* end, Utility::ProgressIndicator& progressIndicator);
+            
+            void entityBegun(Entity* entity);
+            void propertyParsed(const String& key, const String& value);
+            void brushParsed(Brush* brush);
+            void entityEnded(size_t firstLine, size_t lineCount);
+            
+            void loadResources();
+            void updateLoadingViews(bool force);
+            void discardLoadingEntity();
+            void endLoading(bool cancel);
+            void abortLoading();
 
             void setAllTexturesToNull();
             void refreshAllTextures();
@@ -113,7 +145,11 @@ namespace TrenchBroom {
             void brushDidChange(Brush& brush);
             void brushesWillChange(const BrushList& brushes);
             void brushesDidChange(const BrushList& brushes);
-            void setForceIntegerCoordinates(bool forceIntegerCoordinates);
+            /**
+             * Converts the face points of all brushes and clears the command history. Returns false if the user
+             * cancelled the conversion, in which case the map is unchanged.
+             */
+            bool setForceIntegerCoordinates(bool forceIntegerCoordinates);
             
             Utility::Console& console() const;
             Renderer::SharedResources& sharedResources() const;
@@ -149,6 +185,7 @@ namespace TrenchBroom {
 			bool OnNewDocument();
             bool OnOpenDocument(const wxString& path);
             void OnAutosaveTimer(wxTimerEvent& event);
+            void OnLoadTimer(wxTimerEvent& event);
 
             DECLARE_EVENT_TABLE();
         };
@@ -22,6 +22,7 @@
 
 #include "Model/EditState.h"
 #include "Model/MapObjectTypes.h"
+#include "Utility/Atomic.h"
 #include "Utility/VecMath.h"
 
 #include <vector>
@@ -37,6 +38,7 @@ namespace TrenchBroom {
         private:
             unsigned int m_uniqueId;
             EditState::Type m_editState;
+            size_t m_editStateIndex;
             bool m_previouslyLocked;
             
             size_t m_fileFirstLine;
@@ -49,11 +51,13 @@ namespace TrenchBroom {
 
             MapObject() :
             m_editState(EditState::Default),
+            m_editStateIndex(0),
             m_previouslyLocked(false),
             m_fileFirstLine(0),
             m_fileLineCount(0) {
-                static unsigned int currentId = 1;
-                m_uniqueId = currentId++;
+                // map objects may be created by the map loader thread
+                static volatile long currentId = 0;
+                m_uniqueId = static_cast<unsigned int>(Utility::atomicIncrement(currentId));
             }
             
             virtual ~MapObject() {
@@ -112,6 +116,18 @@ namespace TrenchBroom {
                 return previous;
             }
             
+            /**
+             * The position of this object in the edit state manager's list of objects in its edit state. Only valid
+             * while the object is selected, hidden or locked.
+             */
+            inline size_t editStateIndex() const {
+                return m_editStateIndex;
+            }
+            
+            inline void setEditStateIndex(size_t index) {
+                m_editStateIndex = index;
+            }
+            
             inline bool selected() const {
                 return m_editState == EditState::Selected;
             }
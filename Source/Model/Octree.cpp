@@ -23,6 +23,7 @@
 #include "Model/Entity.h"
 #include "Model/Map.h"
 #include "Model/MapObject.h"
+#include "Utility/Profiler.h"
 
 #include <algorithm>
 #include <cmath>
@@ -182,6 +183,8 @@ namespace TrenchBroom {
         }
         
         void Octree::loadMap() {
+            Utility::ScopedTimer timer("Octree::loadMap");
+            
             const EntityList& entities = m_map.entities();
             for (unsigned int i = 0; i < entities.size(); i++) {
                 Entity* entity = entities[i];
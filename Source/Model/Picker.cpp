@@ -21,6 +21,7 @@
 #include "Model/Face.h"
 #include "Model/MapObject.h"
 #include "Model/Octree.h"
+#include "Utility/Profiler.h"
 
 #include <algorithm>
 
@@ -68,6 +69,17 @@ namespace TrenchBroom {
             m_hits.push_back(hit);
         }
 
+        void PickResult::addTranslated(PickResult& other, const Vec3f& delta) {
+            HitList::const_iterator it, end;
+            for (it = other.m_hits.begin(), end = other.m_hits.end(); it != end; ++it) {
+                Hit* hit = *it;
+                hit->translate(delta);
+                m_hits.push_back(hit);
+            }
+            other.m_hits.clear();
+            m_sorted = false;
+        }
+
         Hit* PickResult::first(HitType::Type typeMask, bool ignoreOccluders, Filter& filter) {
             if (!m_hits.empty()) {
                 if (!m_sorted)
@@ -114,14 +126,38 @@ namespace TrenchBroom {
         Picker::Picker(Octree& octree) : m_octree(octree) {}
 
         PickResult* Picker::pick(const Rayf& ray) {
+            Utility::ScopedTimer timer("Picker::pick");
             PickResult* pickResults = new PickResult();
 
             MapObjectList objects = m_octree.intersect(ray);
+            Utility::Profiler::count("Picker::candidates", static_cast<int64_t>(objects.size()));
             for (unsigned int i = 0; i < objects.size(); i++)
-                objects[i]->pick(ray, *pickResults);
+                if (m_translatedObjects.empty() || m_translatedObjects.count(objects[i]) == 0)
+                    objects[i]->pick(ray, *pickResults);
+
+            if (!m_translatedObjects.empty()) {
+                // the octree still contains the translated objects at their original positions
+                const Rayf translatedRay(ray.origin - m_translation, ray.direction);
+                PickResult translatedResults;
+                MapObjectSet::const_iterator it, end;
+                for (it = m_translatedObjects.begin(), end = m_translatedObjects.end(); it != end; ++it)
+                    (*it)->pick(translatedRay, translatedResults);
+                pickResults->addTranslated(translatedResults, m_translation);
+            }
 
             return pickResults;
         }
 
+        void Picker::setTranslatedObjects(const MapObjectList& objects, const Vec3f& translation) {
+            m_translatedObjects.clear();
+            m_translatedObjects.insert(objects.begin(), objects.end());
+            m_translation = translation;
+        }
+
+        void Picker::clearTranslatedObjects() {
+            m_translatedObjects.clear();
+            m_translation = Vec3f::Null;
+        }
+
     }
 }
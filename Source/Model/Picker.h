@@ -21,6 +21,7 @@
 #define TrenchBroom_Picker_h
 
 #include "Model/Filter.h"
+#include "Model/MapObjectTypes.h"
 #include "Utility/VecMath.h"
 
 using namespace TrenchBroom::VecMath;
@@ -68,6 +69,10 @@ namespace TrenchBroom {
                 return m_distance;
             }
             
+            inline void translate(const Vec3f& delta) {
+                m_hitPoint += delta;
+            }
+            
             virtual bool pickable(Filter& filter) const = 0;
         };
         
@@ -128,6 +133,11 @@ namespace TrenchBroom {
             ~PickResult();
             
             void add(Hit* hit);
+            
+            /**
+             * Moves all hits of the given result into this result, translating their hit points by the given delta.
+             */
+            void addTranslated(PickResult& other, const Vec3f& delta);
             Hit* first(HitType::Type typeMask, bool ignoreOccluders, Filter& filter);
             HitList hits(HitType::Type typeMask, Filter& filter);
             HitList hits(Filter& filter);
@@ -136,9 +146,18 @@ namespace TrenchBroom {
         class Picker {
         private:
             Octree& m_octree;
+            MapObjectSet m_translatedObjects;
+            Vec3f m_translation;
         public:
             Picker(Octree& octree);
             PickResult* pick(const Rayf& ray);
+            
+            /**
+             * Picks the given objects as if they were translated by the given delta without changing them or the
+             * octree. Used while the objects are being dragged and only previewed at their new position.
+             */
+            void setTranslatedObjects(const MapObjectList& objects, const Vec3f& translation);
+            void clearTranslatedObjects();
         };
     }
 }
@@ -129,6 +129,10 @@ namespace TrenchBroom {
             std::advance(insertPos, index);
             m_collections.insert(insertPos, collection);
 
+            const TextureList& textures = collection->textures();
+            for (size_t i = 0; i < textures.size(); i++)
+                m_index.add(textures[i]->name(), textures[i]);
+            
             reloadTextures();
         }
 
@@ -140,6 +144,10 @@ namespace TrenchBroom {
             std::advance(removePos, index);
             m_collections.erase(removePos);
 
+            const TextureList& textures = collection->textures();
+            for (size_t i = 0; i < textures.size(); i++)
+                m_index.remove(textures[i]);
+            
             reloadTextures();
             return collection;
         }
@@ -162,6 +170,7 @@ namespace TrenchBroom {
             m_texturesByName.clear();
             m_texturesByUsage.clear();
             m_collectionMap.clear();
+            m_index.clear();
             Utility::deleteAll(m_collections);
         }
     }
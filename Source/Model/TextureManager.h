@@ -25,6 +25,7 @@
 #include "Model/TextureTypes.h"
 #include "Utility/Color.h"
 #include "Utility/String.h"
+#include "Utility/StringIndex.h"
 
 #include <algorithm>
 #include <map>
@@ -107,6 +108,8 @@ namespace TrenchBroom {
             LoaderPtr loader() const;
         };
 
+        typedef Utility::StringIndex<Texture*> TextureIndex;
+
         class TextureManager {
         private:
             typedef std::map<Texture*, TextureCollection*> TextureCollectionMap;
@@ -117,6 +120,7 @@ namespace TrenchBroom {
             TextureMap m_texturesCaseInsensitive;
             TextureList m_texturesByName;
             mutable TextureList m_texturesByUsage;
+            TextureIndex m_index;
             void reloadTextures();
         public:
             ~TextureManager();
@@ -137,6 +141,14 @@ namespace TrenchBroom {
                 return m_texturesByUsage;
             }
             
+            /**
+             * Returns the name index of the textures of all collections, including overridden textures. The index
+             * is updated whenever a collection is added or removed.
+             */
+            inline const TextureIndex& index() const {
+                return m_index;
+            }
+            
             inline Texture* texture(const std::string& name) {
                 TextureMap::iterator it = m_texturesCaseSensitive.find(name);
                 if (it == m_texturesCaseSensitive.end()) {
@@ -21,7 +21,6 @@
 #define __TrenchBroom__AttributeArray__
 
 #include <GL/glew.h>
-#include "Renderer/FaceVertex.h"
 #include "Renderer/Vbo.h"
 #include "Renderer/Shader/ShaderProgram.h"
 #include "Utility/String.h"
@@ -340,6 +339,10 @@ namespace TrenchBroom {
             inline size_t vertexCount() const {
                 return m_vertexCount;
             }
+
+            inline size_t vertexCapacity() const {
+                return m_vertexCapacity;
+            }
             
             inline void addAttribute(float value) {
                 assert(m_vertexCount < m_vertexCapacity);
@@ -460,23 +463,6 @@ namespace TrenchBroom {
                 attributesAdded();
             }
             
-            inline void addAttributes(const FaceVertex::List& cachedVertices) {
-                assert(m_attributes[0].attributeType() == Attribute::Position);
-                assert(m_attributes[0].valueType() == GL_FLOAT);
-                assert(m_attributes[0].size() == 3);
-                assert(m_attributes[1].attributeType() == Attribute::Normal);
-                assert(m_attributes[1].valueType() == GL_FLOAT);
-                assert(m_attributes[1].size() == 3);
-                assert(m_attributes[2].attributeType() == Attribute::TexCoord0);
-                assert(m_attributes[2].valueType() == GL_FLOAT);
-                assert(m_attributes[2].size() == 2);
-                assert(m_padBy == 0);
-                assert(m_vertexCount + cachedVertices.size() <= m_vertexCapacity);
-                
-                m_writeOffset = m_block->writeBuffer(reinterpret_cast<const unsigned char*>(&cachedVertices.front()), m_writeOffset, static_cast<size_t>(cachedVertices.size() * sizeof(FaceVertex)));
-                attributesAdded(static_cast<size_t>(cachedVertices.size()));
-            }
-            
             inline void bindAttributes(const ShaderProgram& program) {
                 for (size_t i = 0; i < m_attributes.size(); i++) {
                     Attribute& attribute = m_attributes[i];
@@ -493,6 +479,7 @@ namespace TrenchBroom {
             inline void setup() {
                 assert(m_specIndex == 0);
                 
+                m_block->activate();
                 size_t offset = m_block->address();
                 for (size_t i = 0; i < m_attributes.size(); i++) {
                     Attribute& attribute = m_attributes[i];
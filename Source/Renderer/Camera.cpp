@@ -23,6 +23,23 @@
 
 namespace TrenchBroom {
     namespace Renderer {
+        void Camera::validateFrustumPlanes() const {
+            // the planes of the clip space cube in world coordinates, see Gribb & Hartmann, "Fast Extraction of
+            // Viewing Frustum Planes from the World-View-Projection Matrix"
+            for (size_t i = 0; i < 6; i++) {
+                const size_t row = i / 2;
+                const float sign = i % 2 == 0 ? 1.0f : -1.0f;
+                
+                Vec3f normal;
+                for (size_t j = 0; j < 3; j++)
+                    normal[j] = m_matrix[j][3] + sign * m_matrix[j][row];
+                const float distance = -(m_matrix[3][3] + sign * m_matrix[3][row]);
+                
+                const float length = normal.length();
+                m_frustumPlanes[i] = Planef(normal / length, distance / length);
+            }
+        }
+        
         void Camera::validate() const {
             if (m_ortho)
                 m_projectionMatrix = orthoMatrix(m_nearPlane, m_farPlane,
@@ -39,6 +56,8 @@ namespace TrenchBroom {
             bool invertible;
             m_invertedMatrix = invertedMatrix(m_matrix, invertible);
             assert(invertible);
+            
+            validateFrustumPlanes();
         }
         
         Camera::Camera(float fieldOfVision, float nearPlane, float farPlane, const Vec3f& position, const Vec3f& direction) :
@@ -175,6 +194,20 @@ namespace TrenchBroom {
             left = Planef(crossed(m_up, d), m_position);
         }
 
+        bool Camera::intersectsFrustum(const BBoxf& bounds) const {
+            // the bounds are outside if the corner which lies furthest in the direction of a plane's normal is
+            // below that plane
+            for (size_t i = 0; i < 6; i++) {
+                const Planef& plane = m_frustumPlanes[i];
+                const Vec3f corner(plane.normal.x() >= 0.0f ? bounds.max.x() : bounds.min.x(),
+                                   plane.normal.y() >= 0.0f ? bounds.max.y() : bounds.min.y(),
+                                   plane.normal.z() >= 0.0f ? bounds.max.z() : bounds.min.z());
+                if (plane.pointDistance(corner) < 0.0f)
+                    return false;
+            }
+            return true;
+        }
+
         Vec3f Camera::vectorTo(const Vec3f& point) const {
             return (point - m_position).normalized();
         }
@@ -53,8 +53,10 @@ namespace TrenchBroom {
             mutable Mat4f m_viewMatrix;
             mutable Mat4f m_matrix;
             mutable Mat4f m_invertedMatrix;
+            mutable Planef m_frustumPlanes[6];
             mutable bool m_valid;
             
+            void validateFrustumPlanes() const;
             void validate() const;
         public:
             Camera(float fieldOfVision, float nearPlane, float farPlane, const Vec3f& position, const Vec3f& direction);
@@ -156,6 +158,13 @@ namespace TrenchBroom {
             
             const Mat4f billboardMatrix(bool fixUp = false) const;
             void frustumPlanes(Planef& top, Planef& right, Planef& bottom, Planef& left) const;
+            
+            /**
+             * Returns whether the given bounds intersect the view frustum including the near and far planes, as it was
+             * when the camera was last updated. The test is conservative, i.e. some bounds near the edges of the
+             * frustum are reported as intersecting although they are not.
+             */
+            bool intersectsFrustum(const BBoxf& bounds) const;
 
             Vec3f vectorTo(const Vec3f& point) const;
             float distanceTo(const Vec3f& point) const;
@@ -19,143 +19,323 @@
 
 #include "EdgeRenderer.h"
 
-#include "GL/glew.h"
 #include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
 #include "Model/Entity.h"
 #include "Model/EntityDefinition.h"
 #include "Model/Face.h"
+#include "Renderer/AttributeArray.h"
 #include "Renderer/RenderContext.h"
-#include "Renderer/VertexArray.h"
+#include "Renderer/Vbo.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
+#include "Utility/UnorderedMap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 
 namespace TrenchBroom {
     namespace Renderer {
-        unsigned int EdgeRenderer::vertexCount(const Model::BrushList& brushes, const Model::FaceList& faces) {
-            Model::BrushList::const_iterator brushIt, brushEnd;
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            unsigned int vertexCount = 0;
+        /**
+         * Collects the vertex positions and the line indices of edges. Vertices are shared by all edges added since
+         * the last call to beginScope, so a scope should cover a brush unless the edges are welded. Edges which were
+         * already added since the last call to beginScope are skipped if welding is enabled.
+         */
+        class EdgeWriter {
+        private:
+            class PositionKey {
+            private:
+                float m_values[3];
+            public:
+                PositionKey(const Vec3f& position) {
+                    m_values[0] = position.x();
+                    m_values[1] = position.y();
+                    m_values[2] = position.z();
+                    
+                    // 0 and -0 are the same coordinate, but have different bits
+                    for (size_t i = 0; i < 3; i++)
+                        if (m_values[i] == 0.0f)
+                            m_values[i] = 0.0f;
+                }
+                
+                inline size_t hash() const {
+                    size_t result = 0;
+                    for (size_t i = 0; i < 3; i++) {
+                        unsigned int bits;
+                        std::memcpy(&bits, &m_values[i], sizeof(bits));
+                        result = result * 31u + bits;
+                    }
+                    return result;
+                }
+                
+                inline bool operator== (const PositionKey& other) const {
+                    return m_values[0] == other.m_values[0] && m_values[1] == other.m_values[1] && m_values[2] == other.m_values[2];
+                }
+            };
             
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                vertexCount += brush.edges().size();
+            class PositionKeyHash {
+            public:
+                inline size_t operator() (const PositionKey& key) const {
+                    return key.hash();
+                }
+            };
+            
+            class EdgeKey {
+            private:
+                GLuint m_first;
+                GLuint m_second;
+            public:
+                EdgeKey(GLuint index1, GLuint index2) :
+                m_first(std::min(index1, index2)),
+                m_second(std::max(index1, index2)) {}
+                
+                inline size_t hash() const {
+                    return static_cast<size_t>(m_first) * 2654435761u + m_second;
+                }
+                
+                inline bool operator== (const EdgeKey& other) const {
+                    return m_first == other.m_first && m_second == other.m_second;
+                }
+            };
+            
+            class EdgeKeyHash {
+            public:
+                inline size_t operator() (const EdgeKey& key) const {
+                    return key.hash();
+                }
+            };
+            
+            typedef std::tr1::unordered_map<PositionKey, GLuint, PositionKeyHash> VertexIndexMap;
+            typedef std::tr1::unordered_set<EdgeKey, EdgeKeyHash> EdgeSet;
+            
+            bool m_weld;
+            VertexIndexMap m_vertexIndices;
+            EdgeSet m_edges;
+            Vec3f::List m_positions;
+            std::vector<GLuint> m_indices;
+            
+            inline GLuint vertexIndex(const Vec3f& position) {
+                std::pair<VertexIndexMap::iterator, bool> result = m_vertexIndices.insert(VertexIndexMap::value_type(PositionKey(position), static_cast<GLuint>(m_positions.size())));
+                if (result.second)
+                    m_positions.push_back(position);
+                return result.first->second;
             }
+        public:
+            EdgeWriter(bool weld) :
+            m_weld(weld) {}
             
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                vertexCount += face.edges().size();
+            inline bool weld() const {
+                return m_weld;
             }
             
-            return 2 * vertexCount;
-        }
-        
-        void EdgeRenderer::writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces) {
-            m_vertexArray = new VertexArray(vbo, GL_LINES, vertexCount(brushes, faces),
-                                            Attribute::position3f());
-
-            Model::BrushList::const_iterator brushIt, brushEnd;
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                const Model::EdgeList& edges = brush.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(edge.end->position);
-                }
+            inline void beginScope() {
+                m_vertexIndices.clear();
+                m_edges.clear();
             }
             
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                const Model::EdgeList& edges = face.edges();
+            inline void addEdges(const Model::EdgeList& edges) {
                 Model::EdgeList::const_iterator edgeIt, edgeEnd;
                 for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
                     const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(edge.end->position);
+                    const GLuint start = vertexIndex(edge.start->position);
+                    const GLuint end = vertexIndex(edge.end->position);
+                    if (!m_weld || m_edges.insert(EdgeKey(start, end)).second) {
+                        m_indices.push_back(start);
+                        m_indices.push_back(end);
+                    }
                 }
             }
+            
+            inline const Vec3f::List& positions() const {
+                return m_positions;
+            }
+            
+            inline const std::vector<GLuint>& indices() const {
+                return m_indices;
+            }
+        };
+        
+        static const Color& edgeColor(const Model::Brush& brush, const Color& defaultColor) {
+            const Model::Entity* entity = brush.entity();
+            const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
+            return (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
         }
         
-        void EdgeRenderer::writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor) {
-            m_vertexArray = new VertexArray(vbo, GL_LINES, vertexCount(brushes, faces),
-                                            Attribute::position3f(),
-                                            Attribute::color4f());
-
+        static void addEdges(EdgeWriter& writer, const Model::BrushList& brushes, const Model::FaceList& faces) {
             Model::BrushList::const_iterator brushIt, brushEnd;
             for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
                 const Model::Brush& brush = **brushIt;
-                const Model::Entity* entity = brush.entity();
-                const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
-                const Color& color = (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
-                
-                const Model::EdgeList& edges = brush.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(color);
-                    m_vertexArray->addAttribute(edge.end->position);
-                    m_vertexArray->addAttribute(color);
-                }
+                if (!writer.weld())
+                    writer.beginScope();
+                writer.addEdges(brush.edges());
             }
-
+            
             Model::FaceList::const_iterator faceIt, faceEnd;
             for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
                 const Model::Face& face = **faceIt;
-                const Model::Brush* brush = face.brush();
-                const Model::Entity* entity = brush->entity();
-                const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
-                const Color& color = (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
+                if (!writer.weld())
+                    writer.beginScope();
+                writer.addEdges(face.edges());
+            }
+        }
+        
+        void EdgeRenderer::writeEdgeData(const Model::BrushList& brushes, const Model::FaceList& faces, const Color* defaultColor, bool weld) {
+            EdgeWriter writer(weld);
+            
+            if (defaultColor == NULL) {
+                addEdges(writer, brushes, faces);
+                m_groups.push_back(EdgeGroup(Color(), 0, writer.indices().size()));
+            } else {
+                // there are only a few distinct colors, so they are searched linearly
+                std::vector<Color> colors;
+                std::vector<Model::BrushList> colorBrushes;
+                std::vector<Model::FaceList> colorFaces;
                 
-                const Model::EdgeList& edges = face.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(color);
-                    m_vertexArray->addAttribute(edge.end->position);
-                    m_vertexArray->addAttribute(color);
+                Model::BrushList::const_iterator brushIt, brushEnd;
+                for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
+                    Model::Brush* brush = *brushIt;
+                    const Color& color = edgeColor(*brush, *defaultColor);
+                    size_t index = 0;
+                    while (index < colors.size() && colors[index] != color)
+                        index++;
+                    if (index == colors.size()) {
+                        colors.push_back(color);
+                        colorBrushes.push_back(Model::BrushList());
+                        colorFaces.push_back(Model::FaceList());
+                    }
+                    colorBrushes[index].push_back(brush);
+                }
+                
+                Model::FaceList::const_iterator faceIt, faceEnd;
+                for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
+                    Model::Face* face = *faceIt;
+                    const Color& color = edgeColor(*face->brush(), *defaultColor);
+                    size_t index = 0;
+                    while (index < colors.size() && colors[index] != color)
+                        index++;
+                    if (index == colors.size()) {
+                        colors.push_back(color);
+                        colorBrushes.push_back(Model::BrushList());
+                        colorFaces.push_back(Model::FaceList());
+                    }
+                    colorFaces[index].push_back(face);
+                }
+                
+                for (size_t i = 0; i < colors.size(); i++) {
+                    // edges of different colors must not be welded
+                    writer.beginScope();
+                    const size_t firstIndex = writer.indices().size();
+                    addEdges(writer, colorBrushes[i], colorFaces[i]);
+                    m_groups.push_back(EdgeGroup(colors[i], firstIndex, writer.indices().size() - firstIndex));
                 }
             }
+            
+            writeBuffers(writer);
+        }
+        
+        void EdgeRenderer::writeBuffers(const EdgeWriter& writer) {
+            const Vec3f::List& positions = writer.positions();
+            const std::vector<GLuint>& indices = writer.indices();
+            m_indexCount = indices.size();
+            if (m_indexCount == 0)
+                return;
+            
+            m_vertexBlock = m_vbo.allocBlock(positions.size() * 3 * sizeof(GLfloat));
+            m_vertexBlock->writeBuffer(reinterpret_cast<const unsigned char*>(&positions.front()), 0, positions.size() * 3 * sizeof(GLfloat));
+            
+            if (positions.size() <= 0xFFFF) {
+                m_indexType = GL_UNSIGNED_SHORT;
+                std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+                m_indexBlock = m_vbo.allocBlock(shortIndices.size() * sizeof(GLushort));
+                m_indexBlock->writeBuffer(reinterpret_cast<const unsigned char*>(&shortIndices.front()), 0, shortIndices.size() * sizeof(GLushort));
+            } else {
+                m_indexType = GL_UNSIGNED_INT;
+                m_indexBlock = m_vbo.allocBlock(indices.size() * sizeof(GLuint));
+                m_indexBlock->writeBuffer(reinterpret_cast<const unsigned char*>(&indices.front()), 0, indices.size() * sizeof(GLuint));
+            }
+        }
+        
+        void EdgeRenderer::renderGroup(size_t firstIndex, size_t indexCount) {
+            if (indexCount == 0)
+                return;
+            
+            const size_t indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+            glDrawElements(GL_LINES, static_cast<GLsizei>(indexCount), m_indexType, reinterpret_cast<GLvoid*>(m_indexBlock->address() + firstIndex * indexSize));
         }
 
-        EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces) :
-        m_vertexArray(NULL) {
-            writeEdgeData(vbo, brushes, faces);
+        EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, bool weld) :
+        m_vbo(vbo),
+        m_vertexBlock(NULL),
+        m_indexBlock(NULL),
+        m_indexType(GL_UNSIGNED_SHORT),
+        m_indexCount(0) {
+            writeEdgeData(brushes, faces, NULL, weld);
         }
         
-        EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor) :
-        m_vertexArray(NULL) {
-            writeEdgeData(vbo, brushes, faces, defaultColor);
+        EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor, bool weld) :
+        m_vbo(vbo),
+        m_vertexBlock(NULL),
+        m_indexBlock(NULL),
+        m_indexType(GL_UNSIGNED_SHORT),
+        m_indexCount(0) {
+            writeEdgeData(brushes, faces, &defaultColor, weld);
         }
 
         EdgeRenderer::~EdgeRenderer() {
-            delete m_vertexArray;
-            m_vertexArray = NULL;
+            if (m_vertexBlock != NULL) {
+                m_vertexBlock->freeBlock();
+                m_vertexBlock = NULL;
+            }
+            if (m_indexBlock != NULL) {
+                m_indexBlock->freeBlock();
+                m_indexBlock = NULL;
+            }
         }
 
-
         void EdgeRenderer::render(RenderContext& context) {
-            assert(m_vertexArray != NULL);
+            if (m_indexCount == 0)
+                return;
             
             ShaderManager& shaderManager = context.shaderManager();
-            ShaderProgram& coloredEdgeProgram = shaderManager.shaderProgram(Shaders::ColoredEdgeShader);
-            if (coloredEdgeProgram.activate()) {
-                m_vertexArray->render();
-                coloredEdgeProgram.deactivate();
+            ShaderProgram& edgeProgram = shaderManager.shaderProgram(Shaders::EdgeShader);
+            if (edgeProgram.activate()) {
+                Attribute position = Attribute::position3f();
+                m_vertexBlock->activate();
+                position.setGLState(0, 3 * sizeof(GLfloat), m_vertexBlock->address());
+                m_indexBlock->activateElements();
+                
+                EdgeGroup::List::const_iterator groupIt, groupEnd;
+                for (groupIt = m_groups.begin(), groupEnd = m_groups.end(); groupIt != groupEnd; ++groupIt) {
+                    const EdgeGroup& group = *groupIt;
+                    edgeProgram.setUniformVariable("Color", group.color);
+                    renderGroup(group.firstIndex, group.indexCount);
+                }
+                
+                m_vbo.deactivateElements();
+                position.clearGLState(0);
+                edgeProgram.deactivate();
             }
         }
         
         void EdgeRenderer::render(RenderContext& context, const Color& color) {
-            assert(m_vertexArray != NULL);
+            if (m_indexCount == 0)
+                return;
 
             ShaderManager& shaderManager = context.shaderManager();
             ShaderProgram& edgeProgram = shaderManager.shaderProgram(Shaders::EdgeShader);
             if (edgeProgram.activate()) {
+                Attribute position = Attribute::position3f();
+                m_vertexBlock->activate();
+                position.setGLState(0, 3 * sizeof(GLfloat), m_vertexBlock->address());
+                m_indexBlock->activateElements();
+                
+                // the groups are stored one after another, so all edges can be drawn at once
                 edgeProgram.setUniformVariable("Color", color);
-                m_vertexArray->render();
+                renderGroup(0, m_indexCount);
+                
+                m_vbo.deactivateElements();
+                position.clearGLState(0);
                 edgeProgram.deactivate();
             }
         }
@@ -20,26 +20,63 @@
 #ifndef __TrenchBroom__EdgeRenderer__
 #define __TrenchBroom__EdgeRenderer__
 
+#include <GL/glew.h>
 #include "Model/BrushTypes.h"
 #include "Model/FaceTypes.h"
 #include "Utility/Color.h"
 
+#include <vector>
+
 namespace TrenchBroom {
     namespace Renderer {
         class RenderContext;
         class Vbo;
-        class VertexArray;
+        class VboBlock;
+        class EdgeWriter;
         
+        /**
+         * Renders the edges of brushes and faces as indexed lines. The positions of the vertices of each brush are
+         * stored once, and every edge is stored as a pair of 16 or 32 bit indices in the same VBO. The edges are
+         * grouped by their color, and each group is drawn with the color as a uniform. If welding is enabled, the
+         * vertices and edges of a group which coincide with those of another brush are only stored once.
+         */
         class EdgeRenderer {
         protected:
-            VertexArray* m_vertexArray;
+            class EdgeGroup {
+            public:
+                typedef std::vector<EdgeGroup> List;
+                
+                Color color;
+                size_t firstIndex;
+                size_t indexCount;
+                
+                EdgeGroup(const Color& i_color, size_t i_firstIndex, size_t i_indexCount) :
+                color(i_color),
+                firstIndex(i_firstIndex),
+                indexCount(i_indexCount) {}
+            };
+            
+            Vbo& m_vbo;
+            VboBlock* m_vertexBlock;
+            VboBlock* m_indexBlock;
+            GLenum m_indexType;
+            size_t m_indexCount;
+            EdgeGroup::List m_groups;
             
-            unsigned int vertexCount(const Model::BrushList& brushes, const Model::FaceList& faces);
-            void writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces);
-            void writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor);
+            void writeEdgeData(const Model::BrushList& brushes, const Model::FaceList& faces, const Color* defaultColor, bool weld);
+            void writeBuffers(const EdgeWriter& writer);
+            void renderGroup(size_t firstIndex, size_t indexCount);
         public:
-            EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces);
-            EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor);
+            /**
+             * Creates a renderer for edges which are all drawn in the color passed to render.
+             */
+            EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, bool weld = false);
+            
+            /**
+             * Creates a renderer for edges which are drawn in the color of their brush entity, or in the given default
+             * color if they don't belong to a brush entity.
+             */
+            EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor, bool weld = false);
             ~EdgeRenderer();
 
             void render(RenderContext& context);
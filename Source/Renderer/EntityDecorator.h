@@ -20,8 +20,12 @@
 #ifndef TrenchBroom_EntityDecorator_h
 #define TrenchBroom_EntityDecorator_h
 
+#include "Utility/VecMath.h"
+
 #include <vector>
 
+using namespace TrenchBroom::VecMath;
+
 namespace TrenchBroom {
     namespace Model {
         class MapDocument;
@@ -34,16 +38,31 @@ namespace TrenchBroom {
         class EntityDecorator {
         private:
             const Model::MapDocument& m_document;
+            Mat4f m_selectionTransformation;
         protected:
             inline const Model::MapDocument& document() const {
                 return m_document;
             }
+            
+            inline const Mat4f& selectionTransformation() const {
+                return m_selectionTransformation;
+            }
         public:
             typedef std::vector<EntityDecorator*> List;
             
-            EntityDecorator(const Model::MapDocument& document) : m_document(document) {}
+            EntityDecorator(const Model::MapDocument& document) :
+            m_document(document),
+            m_selectionTransformation(Mat4f::Identity) {}
             virtual ~EntityDecorator() {}
 
+            /**
+             * Decorations of selected entities are placed as if the selection was transformed by the given matrix.
+             */
+            inline void setSelectionTransformation(const Mat4f& transformation) {
+                m_selectionTransformation = transformation;
+                invalidate();
+            }
+            
             virtual void invalidate() = 0;
             virtual void render(Vbo& vbo, RenderContext& context) = 0;
         };
@@ -50,8 +50,8 @@ namespace TrenchBroom {
         }
         
         void EntityLinkDecorator::makeLink(Model::Entity& source, Model::Entity& target, Vec3f::List& vertices) const {
-            vertices.push_back(source.center());
-            vertices.push_back(target.center());
+            vertices.push_back(source.selected() ? selectionTransformation() * source.center() : source.center());
+            vertices.push_back(target.selected() ? selectionTransformation() * target.center() : target.center());
         }
 
         void EntityLinkDecorator::buildLinks(RenderContext& context, Model::Entity& entity, size_t depth, Model::EntitySet& visitedEntities, Vec3f::List& selectedLinks, Vec3f::List& unselectedLinks, Vec3f::List& selectedKillLinks, Vec3f::List& unselectedKillLinks) const {
@@ -20,15 +20,20 @@
 #include "EntityRenderer.h"
 
 #include "Model/MapDocument.h"
+#include "Renderer/Camera.h"
 #include "Renderer/EntityModelRenderer.h"
 #include "Renderer/EntityModelRendererManager.h"
+#include "Renderer/OcclusionBuffer.h"
 #include "Renderer/SharedResources.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
 #include "Renderer/Text/FontManager.h"
+#include "Renderer/VertexArray.h"
 #include "Utility/Preferences.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 namespace TrenchBroom {
     namespace Renderer {
@@ -49,10 +54,88 @@ namespace TrenchBroom {
             return Text::Alignment::Bottom;
         }
 
+        // the distance by which an entity's bounds are expanded when its classname is culled, since it is drawn above them
+        static const float ClassnameFrustumMargin = 64.0f;
+        
+        /**
+         * Adds the faces of the given box as quads, darkening each face depending on its direction so that the box
+         * still reads as a solid without lighting.
+         */
+        static void writeImpostor(VertexArray& vertexArray, const BBoxf& bounds, const Color& color) {
+            static const float Shades[6] = { 0.7f, 0.7f, 0.85f, 0.85f, 0.55f, 1.0f }; // -X, +X, -Y, +Y, -Z, +Z
+            
+            const Vec3f& min = bounds.min;
+            const Vec3f& max = bounds.max;
+            const Vec3f corners[8] = {
+                Vec3f(min.x(), min.y(), min.z()), Vec3f(max.x(), min.y(), min.z()),
+                Vec3f(max.x(), max.y(), min.z()), Vec3f(min.x(), max.y(), min.z()),
+                Vec3f(min.x(), min.y(), max.z()), Vec3f(max.x(), min.y(), max.z()),
+                Vec3f(max.x(), max.y(), max.z()), Vec3f(min.x(), max.y(), max.z())
+            };
+            static const size_t Faces[6][4] = {
+                { 0, 4, 7, 3 }, { 1, 2, 6, 5 },
+                { 0, 1, 5, 4 }, { 3, 7, 6, 2 },
+                { 0, 3, 2, 1 }, { 4, 5, 6, 7 }
+            };
+            
+            for (size_t i = 0; i < 6; i++) {
+                const Color faceColor(Shades[i] * color.x(), Shades[i] * color.y(), Shades[i] * color.z(), color.w());
+                for (size_t j = 0; j < 4; j++) {
+                    vertexArray.addAttribute(corners[Faces[i][j]]);
+                    vertexArray.addAttribute(faceColor);
+                }
+            }
+        }
+        
+        /**
+         * Returns bounds which contain the model of the given entity regardless of the entity's rotation.
+         */
+        static BBoxf modelBounds(const Model::Entity& entity, const EntityModelRenderer& renderer) {
+            const BBoxf& bounds = renderer.bounds();
+            Vec3f extent;
+            for (size_t i = 0; i < 3; i++)
+                extent[i] = std::max(std::abs(bounds.min[i]), std::abs(bounds.max[i]));
+            
+            BBoxf result(entity.origin(), extent.length());
+            return result.mergeWith(entity.bounds());
+        }
+        
+        EntityRenderer::EntityClassnameFilter::EntityClassnameFilter(const EntityRenderer& entityRenderer) :
+        m_entityRenderer(entityRenderer) {}
+        
         bool EntityRenderer::EntityClassnameFilter::stringVisible(RenderContext& context, const EntityKey& entity) const {
-            return context.filter().entityVisible(*entity);
+            if (!context.filter().entityVisible(*entity))
+                return false;
+            return m_entityRenderer.boundsVisible(context, entity->bounds().expanded(ClassnameFrustumMargin));
+        }
+        
+        bool EntityRenderer::boundsVisible(RenderContext& context, const BBoxf& bounds) const {
+            if (!m_frustumCulling)
+                return true;
+            if (!context.camera().intersectsFrustum(bounds))
+                return false;
+            return m_occlusionBuffer == NULL || m_occlusionBuffer->visible(bounds);
         }
 
+        const Color EntityRenderer::impostorColor(const Model::Entity& entity) const {
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            
+            const Model::EntityDefinition* definition = entity.definition();
+            Color color = definition != NULL ? definition->color() : prefs.getColor(Preferences::EntityBoundsColor);
+            color[3] = 1.0f;
+            
+            // mimic the entity model shader
+            if (m_grayscale) {
+                const float gray = 0.299f * color.x() + 0.587f * color.y() + 0.114f * color.z();
+                color = Color(gray, gray, gray, color.w());
+            }
+            if (m_applyTinting) {
+                for (size_t i = 0; i < 3; i++)
+                    color[i] = std::min(2.0f * color[i] * m_tintColor[i] * m_tintColor.w(), 1.0f);
+            }
+            return color;
+        }
+        
         void EntityRenderer::writeColoredBounds(RenderContext& context, const Model::EntityList& entities) {
             if (entities.empty())
                 return;
@@ -184,7 +267,7 @@ namespace TrenchBroom {
             ShaderProgram& textProgram = shaderManager.shaderProgram(Shaders::TextShader);
             ShaderProgram& textBackgroundProgram = shaderManager.shaderProgram(Shaders::TextBackgroundShader);
 
-            EntityClassnameFilter classnameFilter;
+            EntityClassnameFilter classnameFilter(*this);
             if (m_renderOccludedClassnames) {
                 glDisable(GL_DEPTH_TEST);
                 m_classnameRenderer->render(context, classnameFilter, textProgram,
@@ -209,6 +292,8 @@ namespace TrenchBroom {
             ShaderManager& shaderManager = m_document.sharedResources().shaderManager();
             ShaderProgram& entityModelProgram = shaderManager.shaderProgram(Shaders::EntityModelShader);
 
+            // distant models are collected and rendered as boxes afterwards
+            Model::EntityList impostors;
             if (entityModelProgram.activate()) {
                 modelRendererManager.activate();
                 entityModelProgram.setUniformVariable("Brightness", prefs.getFloat(Preferences::RendererBrightness));
@@ -216,11 +301,18 @@ namespace TrenchBroom {
                 entityModelProgram.setUniformVariable("TintColor", m_tintColor);
                 entityModelProgram.setUniformVariable("GrayScale", m_grayscale);
 
+                const float lodDistance2 = m_modelLodDistance * m_modelLodDistance;
                 EntityModelRenderers::iterator it, end;
                 for (it = m_modelRenderers.begin(), end = m_modelRenderers.end(); it != end; ++it) {
                     Model::Entity* entity = it->first;
-                    if (context.filter().entityVisible(*entity)) {
-                        EntityModelRenderer* renderer = it->second.renderer;
+                    EntityModelRenderer* renderer = it->second.renderer;
+                    if (!context.filter().entityVisible(*entity))
+                        continue;
+                    
+                    if (lodDistance2 > 0.0f && context.camera().squaredDistanceTo(entity->center()) > lodDistance2) {
+                        if (boundsVisible(context, entity->bounds()))
+                            impostors.push_back(entity);
+                    } else if (boundsVisible(context, modelBounds(*entity, *renderer))) {
                         renderer->render(entityModelProgram, context.transformation(), *entity);
                     }
                 }
@@ -228,6 +320,28 @@ namespace TrenchBroom {
                 modelRendererManager.deactivate();
                 entityModelProgram.deactivate();
             }
+            
+            renderImpostors(context, impostors);
+        }
+        
+        void EntityRenderer::renderImpostors(RenderContext& context, const Model::EntityList& entities) {
+            if (entities.empty())
+                return;
+            
+            Vbo& streamVbo = context.streamVbo();
+            VertexArray impostorArray(streamVbo, GL_QUADS, static_cast<unsigned int>(24 * entities.size()),
+                                      Attribute::position3f(),
+                                      Attribute::color4f());
+            
+            SetVboState mapVbo(streamVbo, Vbo::VboMapped);
+            for (size_t i = 0; i < entities.size(); i++) {
+                const Model::Entity& entity = *entities[i];
+                writeImpostor(impostorArray, entity.bounds(), impostorColor(entity));
+            }
+            
+            SetVboState activateVbo(streamVbo, Vbo::VboActive);
+            ActivateShader shader(context.shaderManager(), Shaders::ColoredEdgeShader);
+            impostorArray.render();
         }
 
         EntityRenderer::EntityRenderer(Vbo& boundsVbo, Model::MapDocument& document) :
@@ -243,7 +357,11 @@ namespace TrenchBroom {
         m_overrideBoundsColor(false),
         m_renderOccludedBounds(false),
         m_applyTinting(false),
-        m_grayscale(false) {
+        m_grayscale(false),
+        m_renderClassnames(true),
+        m_frustumCulling(true),
+        m_occlusionBuffer(NULL),
+        m_modelLodDistance(0.0f) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             
             const String& fontName = prefs.getString(Preferences::RendererFontName);
@@ -350,6 +468,18 @@ namespace TrenchBroom {
             m_boundsValid = false;
         }
 
+        void EntityRenderer::updateEntities(const Model::EntityList& entities) {
+            Model::EntityList containedEntities;
+            for (unsigned int i = 0; i < entities.size(); i++) {
+                Model::Entity* entity = entities[i];
+                if (m_entities.count(entity) > 0)
+                    containedEntities.push_back(entity);
+            }
+            
+            removeEntities(containedEntities);
+            addEntities(containedEntities);
+        }
+
         void EntityRenderer::render(RenderContext& context) {
             if (!m_boundsValid)
                 validateBounds(context);
@@ -360,7 +490,7 @@ namespace TrenchBroom {
                 renderModels(context);
             if (context.viewOptions().showEntityBounds())
                 renderBounds(context);
-            if (context.viewOptions().showEntityClassnames())
+            if (m_renderClassnames && context.viewOptions().showEntityClassnames())
                 renderClassnames(context);
         }
     }
@@ -39,6 +39,7 @@ namespace TrenchBroom {
     
     namespace Renderer {
         class EntityModelRenderer;
+        class OcclusionBuffer;
         class Vbo;
         class VertexArray;
         
@@ -72,7 +73,11 @@ namespace TrenchBroom {
             typedef Text::TextRenderer<EntityKey> EntityClassnameRenderer;
             
             class EntityClassnameFilter : public EntityClassnameRenderer::TextRendererFilter {
+            private:
+                const EntityRenderer& m_entityRenderer;
             public:
+                EntityClassnameFilter(const EntityRenderer& entityRenderer);
+                
                 inline bool stringVisible(RenderContext& context, const EntityKey& entity) const;
             };
             
@@ -98,7 +103,13 @@ namespace TrenchBroom {
             bool m_applyTinting;
             Color m_tintColor;
             bool m_grayscale;
+            bool m_renderClassnames;
+            bool m_frustumCulling;
+            const OcclusionBuffer* m_occlusionBuffer;
+            float m_modelLodDistance;
             
+            bool boundsVisible(RenderContext& context, const BBoxf& bounds) const;
+            const Color impostorColor(const Model::Entity& entity) const;
             void writeColoredBounds(RenderContext& context, const Model::EntityList& entities);
             void writeBounds(RenderContext& context, const Model::EntityList& entities);
             void validateBounds(RenderContext& context);
@@ -107,6 +118,7 @@ namespace TrenchBroom {
             void renderBounds(RenderContext& context);
             void renderClassnames(RenderContext& context);
             void renderModels(RenderContext& context);
+            void renderImpostors(RenderContext& context, const Model::EntityList& entities);
             void renderFigures(RenderContext& context);
 
             // prevent copying
@@ -118,6 +130,14 @@ namespace TrenchBroom {
             
             void setClassnameFadeDistance(float classnameFadeDistance);
             
+            /**
+             * Sets the distance beyond which entity models are replaced by flat shaded boxes, or 0 to always render
+             * the models.
+             */
+            inline void setModelLodDistance(float modelLodDistance) {
+                m_modelLodDistance = modelLodDistance;
+            }
+            
             inline void setClassnameColor(const Color& classnameColor, const Color& classnameBackgroundColor) {
                 m_classnameColor = classnameColor;
                 m_classnameBackgroundColor = classnameBackgroundColor;
@@ -163,11 +183,32 @@ namespace TrenchBroom {
             inline void setGrayscale(bool grayscale) {
                 m_grayscale = grayscale;
             }
+            
+            inline void setRenderClassnames(bool renderClassnames) {
+                m_renderClassnames = renderClassnames;
+            }
+            
+            /**
+             * Sets whether models and classnames outside of the view frustum are skipped. This must be disabled while
+             * the entities are rendered with a model transformation, because the entity bounds are not transformed.
+             */
+            inline void setFrustumCulling(bool frustumCulling) {
+                m_frustumCulling = frustumCulling;
+            }
+            
+            /**
+             * Sets the occlusion buffer against which models and classnames are tested if frustum culling is
+             * enabled, or NULL to disable occlusion culling. Must not be set if occluded classnames are rendered.
+             */
+            inline void setOcclusionBuffer(const OcclusionBuffer* occlusionBuffer) {
+                m_occlusionBuffer = occlusionBuffer;
+            }
 
             void addEntity(Model::Entity& entity);
             void addEntities(const Model::EntityList& entities);
             void removeEntity(Model::Entity& entity);
             void removeEntities(const Model::EntityList& entities);
+            void updateEntities(const Model::EntityList& entities);
             void invalidateBounds();
             void invalidateModels();
             void clear();
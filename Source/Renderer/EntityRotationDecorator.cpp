@@ -35,6 +35,8 @@
 #include "Utility/VecMath.h"
 #include "View/ViewOptions.h"
 
+#include <cassert>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
@@ -63,6 +65,15 @@ namespace TrenchBroom {
             triangle[1] = Vec3f(t2, 0.0f);
             triangle[2] = Vec3f(t3, 0.0f);
             
+            // the arrows are built in untransformed space, so the camera is moved there instead
+            Vec3f cameraPosition = context.camera().position();
+            if (!(selectionTransformation() == Mat4f::Identity)) {
+                bool invertible;
+                const Mat4f inverse = invertedMatrix(selectionTransformation(), invertible);
+                assert(invertible);
+                cameraPosition = inverse * cameraPosition;
+            }
+            
             Vec3f::List vertices;
             Model::EntityList::const_iterator it, end;
             for (it = entities.begin(), end = entities.end(); it != end; ++it) {
@@ -71,7 +82,7 @@ namespace TrenchBroom {
                     const Vec3f direction = entity.rotation() * Vec3f::PosX;
                     const Vec3f& center = entity.center();
                     const Planef plane(direction, center);
-                    const Vec3f toCam = center - context.camera().position();
+                    const Vec3f toCam = center - cameraPosition;
                     if (toCam.lengthSquared() > maxDistance2)
                         continue;
                     Vec3f onPlane = plane.project(toCam);
@@ -82,7 +93,7 @@ namespace TrenchBroom {
                     const Vec3f rotZ = entity.rotation() * Vec3f::NegZ;
                     const float angle = angleFrom(rotZ, onPlane, direction);
                     
-                    const Mat4f matrix = translationMatrix(center) * rotationMatrix(angle, -direction) * rotationMatrix(entity.rotation()) * translationMatrix(16.0f * Vec3f::PosX);
+                    const Mat4f matrix = selectionTransformation() * translationMatrix(center) * rotationMatrix(angle, -direction) * rotationMatrix(entity.rotation()) * translationMatrix(16.0f * Vec3f::PosX);
                     for (size_t i = 0; i < 3; i++)
                         vertices.push_back(matrix * triangle[i]);
                 }
@@ -92,11 +103,12 @@ namespace TrenchBroom {
             if (vertexCount == 0)
                 return;
             
-            VertexArray vertexArray(vbo, GL_TRIANGLES, vertexCount, Attribute::position3f(), 0);
-            SetVboState mapVbo(vbo, Vbo::VboMapped);
+            Vbo& streamVbo = context.streamVbo();
+            VertexArray vertexArray(streamVbo, GL_TRIANGLES, vertexCount, Attribute::position3f(), 0);
+            SetVboState mapVbo(streamVbo, Vbo::VboMapped);
             vertexArray.addAttributes(vertices);
             
-            SetVboState activateVbo(vbo, Vbo::VboActive);
+            SetVboState activateVbo(streamVbo, Vbo::VboActive);
             ActivateShader shader(context.shaderManager(), Shaders::HandleShader);
             
             glDepthMask(GL_FALSE);
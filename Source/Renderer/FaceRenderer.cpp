@@ -20,80 +20,221 @@
 #include "FaceRenderer.h"
 
 #include "Model/Face.h"
+#include "Model/Texture.h"
+#include "Renderer/FaceVertexArray.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
+#include "Renderer/TextureArray.h"
 #include "Renderer/TextureRenderer.h"
 #include "Renderer/TextureRendererManager.h"
-#include "Renderer/VertexArray.h"
 #include "Utility/Grid.h"
 #include "Utility/Preferences.h"
 #include "Utility/VecMath.h"
 
+#include <cassert>
+#include <map>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Renderer {
         String FaceRenderer::AlphaBlendedTextures[] = {"clip", "hint", /*"skip",*/ "hintskip", "trigger"};
 
+        /**
+         * Marks the faces whose texture coordinates can be stored as half floats and counts their corners and
+         * triangles.
+         */
+        static void findCompactFaces(const Model::FaceList& faces, std::vector<bool>& compactFaces, size_t& compactVertexCount, size_t& compactTriangleCount) {
+            compactFaces.assign(faces.size(), false);
+            if (!FaceVertexArray::halfTexCoordsSupported())
+                return;
+            
+            for (size_t i = 0; i < faces.size(); i++) {
+                const Model::Face& face = *faces[i];
+                if (FaceVertexArray::halfTexCoordsPrecise(face)) {
+                    compactFaces[i] = true;
+                    compactVertexCount += face.vertices().size();
+                    compactTriangleCount += face.vertices().size() - 2;
+                }
+            }
+        }
+        
+        static void countFaces(const Model::FaceList& faces, size_t& vertexCount, size_t& triangleCount) {
+            for (size_t i = 0; i < faces.size(); i++) {
+                const size_t faceVertexCount = faces[i]->vertices().size();
+                vertexCount += faceVertexCount;
+                triangleCount += faceVertexCount - 2;
+            }
+        }
+        
+        void FaceRenderer::writeTextureFaces(Vbo& vbo, TextureRenderer* texture, const Model::FaceList& faces, TextureFaceArrayList& faceArrays) {
+            // split the faces into those with half float texture coordinates and the rest
+            std::vector<bool> compactFaces;
+            size_t compactVertexCount = 0;
+            size_t compactTriangleCount = 0;
+            findCompactFaces(faces, compactFaces, compactVertexCount, compactTriangleCount);
+            
+            size_t vertexCount = 0;
+            size_t triangleCount = 0;
+            countFaces(faces, vertexCount, triangleCount);
+            vertexCount -= compactVertexCount;
+            triangleCount -= compactTriangleCount;
+            
+            FaceVertexArray* compactArray = compactVertexCount > 0 ? new FaceVertexArray(vbo, compactVertexCount, compactTriangleCount, true) : NULL;
+            FaceVertexArray* faceArray = vertexCount > 0 ? new FaceVertexArray(vbo, vertexCount, triangleCount, false) : NULL;
+            
+            for (size_t i = 0; i < faces.size(); i++) {
+                const Model::Face& face = *faces[i];
+                if (compactFaces[i])
+                    compactArray->addFace(face);
+                else
+                    faceArray->addFace(face);
+            }
+            
+            if (compactArray != NULL)
+                faceArrays.push_back(TextureFaceArray(texture, compactArray));
+            if (faceArray != NULL)
+                faceArrays.push_back(TextureFaceArray(texture, faceArray));
+        }
+        
+        void FaceRenderer::writeFaceBatches(Vbo& vbo, TextureArray& textureArray, const TextureLayerFacesList& layerFaces) {
+            std::vector<std::vector<bool> > compactFaces(layerFaces.size());
+            size_t compactVertexCount = 0;
+            size_t compactTriangleCount = 0;
+            size_t vertexCount = 0;
+            size_t triangleCount = 0;
+            for (size_t i = 0; i < layerFaces.size(); i++) {
+                const Model::FaceList& faces = *layerFaces[i].faces;
+                findCompactFaces(faces, compactFaces[i], compactVertexCount, compactTriangleCount);
+                countFaces(faces, vertexCount, triangleCount);
+            }
+            vertexCount -= compactVertexCount;
+            triangleCount -= compactTriangleCount;
+            
+            FaceBatch compactBatch(&textureArray, compactVertexCount > 0 ? new FaceVertexArray(vbo, compactVertexCount, compactTriangleCount, true, true) : NULL);
+            FaceBatch faceBatch(&textureArray, vertexCount > 0 ? new FaceVertexArray(vbo, vertexCount, triangleCount, false, true) : NULL);
+            
+            for (size_t i = 0; i < layerFaces.size(); i++) {
+                const TextureLayerFaces& textureLayerFaces = layerFaces[i];
+                const Model::FaceList& faces = *textureLayerFaces.faces;
+                const size_t compactFirstIndex = compactBatch.faceArray != NULL ? compactBatch.faceArray->indexCount() : 0;
+                const size_t firstIndex = faceBatch.faceArray != NULL ? faceBatch.faceArray->indexCount() : 0;
+                
+                for (size_t j = 0; j < faces.size(); j++) {
+                    const Model::Face& face = *faces[j];
+                    if (compactFaces[i][j])
+                        compactBatch.faceArray->addFace(face, textureLayerFaces.layer);
+                    else
+                        faceBatch.faceArray->addFace(face, textureLayerFaces.layer);
+                }
+                
+                if (compactBatch.faceArray != NULL && compactBatch.faceArray->indexCount() > compactFirstIndex)
+                    compactBatch.textureRanges.push_back(TextureRange(textureLayerFaces.texture, compactFirstIndex, compactBatch.faceArray->indexCount() - compactFirstIndex));
+                if (faceBatch.faceArray != NULL && faceBatch.faceArray->indexCount() > firstIndex)
+                    faceBatch.textureRanges.push_back(TextureRange(textureLayerFaces.texture, firstIndex, faceBatch.faceArray->indexCount() - firstIndex));
+            }
+            
+            if (compactBatch.faceArray != NULL)
+                m_faceBatches.push_back(compactBatch);
+            if (faceBatch.faceArray != NULL)
+                m_faceBatches.push_back(faceBatch);
+        }
+        
         void FaceRenderer::writeFaceData(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter) {
             const FaceCollectionMap& faceCollectionMap = faceSorter.collections();
             if (faceCollectionMap.empty())
                 return;
             
+            // the opaque textured faces are batched by the texture arrays which hold their textures
+            typedef std::map<TextureArray*, TextureLayerFacesList> TextureArrayFacesMap;
+            const bool useTextureArrays = TextureArray::supported();
+            TextureArrayFacesMap textureArrayFaces;
+            
             FaceCollectionMap::const_iterator it, end;
             for (it = faceCollectionMap.begin(), end = faceCollectionMap.end(); it != end; ++it) {
                 Model::Texture* texture = it->first;
-                TextureRenderer* textureRenderer = texture != NULL ? &textureRendererManager.renderer(texture) : NULL;
                 const FaceCollection& faceCollection = it->second;
                 const Model::FaceList& faces = faceCollection.polygons();
-                const size_t vertexCount = 3 * faceCollection.vertexCount() - 6 * faces.size();
-                VertexArray* vertexArray = new VertexArray(vbo, GL_TRIANGLES, vertexCount,
-                                                           Attribute::position3f(),
-                                                           Attribute::normal3f(),
-                                                           Attribute::texCoord02f(),
-                                                           0);
                 
-                for (size_t i = 0; i < faces.size(); i++) {
-                    Model::Face* face = faces[i];
-                    vertexArray->addAttributes(face->cachedVertices());
+                if (texture == NULL) {
+                    writeTextureFaces(vbo, NULL, faces, m_faceArrays);
+                } else {
+                    TextureRenderer& textureRenderer = textureRendererManager.renderer(texture);
+                    if (alphaBlend(texture->name())) {
+                        writeTextureFaces(vbo, &textureRenderer, faces, m_transparentFaceArrays);
+                    } else if (useTextureArrays) {
+                        unsigned int layer;
+                        TextureArray& textureArray = textureRendererManager.textureArray(textureRenderer, layer);
+                        textureArrayFaces[&textureArray].push_back(TextureLayerFaces(&textureRenderer, layer, &faces));
+                    } else {
+                        writeTextureFaces(vbo, &textureRenderer, faces, m_faceArrays);
+                    }
                 }
-                
-                if (texture != NULL && alphaBlend(texture->name()))
-                    m_transparentVertexArrays.push_back(TextureVertexArray(textureRenderer, vertexArray));
-                else
-                    m_vertexArrays.push_back(TextureVertexArray(textureRenderer, vertexArray));
             }
+            
+            TextureArrayFacesMap::const_iterator arrayIt, arrayEnd;
+            for (arrayIt = textureArrayFaces.begin(), arrayEnd = textureArrayFaces.end(); arrayIt != arrayEnd; ++arrayIt)
+                writeFaceBatches(vbo, *arrayIt->first, arrayIt->second);
         }
 
-        void FaceRenderer::render(RenderContext& context, bool grayScale, const Color* tintColor) {
-            if (m_vertexArrays.empty() && m_transparentVertexArrays.empty())
-                return;
+        Vec3f FaceRenderer::cameraPosition(RenderContext& context) const {
+            // the shader computes the view vector from untransformed vertices
+            const Mat4f& modelMatrix = context.transformation().modelMatrix();
+            if (modelMatrix == Mat4f::Identity)
+                return context.camera().position();
             
+            bool invertible;
+            const Mat4f inverse = invertedMatrix(modelMatrix, invertible);
+            assert(invertible);
+            return inverse * context.camera().position();
+        }
+
+        void FaceRenderer::setUniforms(ShaderProgram& shader, RenderContext& context, bool grayScale, const Color* tintColor, const bool applyTexture) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             Utility::Grid& grid = context.grid();
             
+            shader.setUniformVariable("Brightness", prefs.getFloat(Preferences::RendererBrightness));
+            shader.setUniformVariable("Alpha", 1.0f);
+            shader.setUniformVariable("RenderGrid", grid.visible());
+            shader.setUniformVariable("GridSize", static_cast<float>(grid.actualSize()));
+            shader.setUniformVariable("GridAlpha", prefs.getFloat(Preferences::GridAlpha));
+            shader.setUniformVariable("GridCheckerboard", prefs.getBool(Preferences::GridCheckerboard));
+            shader.setUniformVariable("ApplyTexture", applyTexture);
+            shader.setUniformVariable("ApplyTinting", tintColor != NULL);
+            if (tintColor != NULL)
+                shader.setUniformVariable("TintColor", *tintColor);
+            shader.setUniformVariable("GrayScale", grayScale);
+            shader.setUniformVariable("CameraPosition", cameraPosition(context));
+            shader.setUniformVariable("ShadeFaces", context.viewOptions().shadeFaces() );
+            shader.setUniformVariable("UseFog", context.viewOptions().useFog() );
+        }
+        
+        void FaceRenderer::render(RenderContext& context, bool grayScale, const Color* tintColor) {
+            if (m_faceBatches.empty() && m_faceArrays.empty() && m_transparentFaceArrays.empty())
+                return;
+            
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             ShaderManager& shaderManager = context.shaderManager();
-            ShaderProgram& faceProgram = shaderManager.shaderProgram(Shaders::FaceShader);
+            const bool applyTexture = context.viewOptions().faceRenderMode() == View::ViewOptions::Textured;
+            
+            if (!m_faceBatches.empty()) {
+                ShaderProgram& faceArrayProgram = shaderManager.shaderProgram(Shaders::FaceArrayShader);
+                if (faceArrayProgram.activate()) {
+                    glActiveTexture(GL_TEXTURE0);
+                    setUniforms(faceArrayProgram, context, grayScale, tintColor, applyTexture);
+                    renderFaceBatches(faceArrayProgram, applyTexture);
+                    faceArrayProgram.deactivate();
+                }
+            }
+            
+            if (m_faceArrays.empty() && m_transparentFaceArrays.empty())
+                return;
             
+            ShaderProgram& faceProgram = shaderManager.shaderProgram(Shaders::FaceShader);
             if (faceProgram.activate()) {
                 glActiveTexture(GL_TEXTURE0);
-                
-                const bool applyTexture = context.viewOptions().faceRenderMode() == View::ViewOptions::Textured;
-                faceProgram.setUniformVariable("Brightness", prefs.getFloat(Preferences::RendererBrightness));
-                faceProgram.setUniformVariable("Alpha", 1.0f);
-                faceProgram.setUniformVariable("RenderGrid", grid.visible());
-                faceProgram.setUniformVariable("GridSize", static_cast<float>(grid.actualSize()));
-                faceProgram.setUniformVariable("GridAlpha", prefs.getFloat(Preferences::GridAlpha));
-                faceProgram.setUniformVariable("GridCheckerboard", prefs.getBool(Preferences::GridCheckerboard));
-                faceProgram.setUniformVariable("ApplyTexture", applyTexture);
-                faceProgram.setUniformVariable("ApplyTinting", tintColor != NULL);
-                if (tintColor != NULL)
-                    faceProgram.setUniformVariable("TintColor", *tintColor);
-                faceProgram.setUniformVariable("GrayScale", grayScale);
-                faceProgram.setUniformVariable("CameraPosition", context.camera().position());
-                faceProgram.setUniformVariable("ShadeFaces", context.viewOptions().shadeFaces() );
-                faceProgram.setUniformVariable("UseFog", context.viewOptions().useFog() );
+                setUniforms(faceProgram, context, grayScale, tintColor, applyTexture);
                 
                 renderOpaqueFaces(faceProgram, applyTexture);
                 glDepthMask(GL_FALSE);
@@ -105,31 +246,51 @@ namespace TrenchBroom {
             }
         }
 
+        void FaceRenderer::renderFaceBatches(ShaderProgram& shader, const bool applyTexture) {
+            for (size_t i = 0; i < m_faceBatches.size(); i++) {
+                const FaceBatch& faceBatch = m_faceBatches[i];
+                if (applyTexture) {
+                    faceBatch.textureArray->activate();
+                    shader.setUniformVariable("FaceTextureArray", 0);
+                    faceBatch.faceArray->render();
+                    faceBatch.textureArray->deactivate();
+                } else {
+                    // without textures, the faces are colored by the average colors of their textures
+                    const TextureRangeList& textureRanges = faceBatch.textureRanges;
+                    for (size_t j = 0; j < textureRanges.size(); j++) {
+                        const TextureRange& textureRange = textureRanges[j];
+                        shader.setUniformVariable("Color", textureRange.texture->averageColor());
+                        faceBatch.faceArray->render(textureRange.firstIndex, textureRange.indexCount);
+                    }
+                }
+            }
+        }
+
         void FaceRenderer::renderOpaqueFaces(ShaderProgram& shader, const bool applyTexture) {
-            renderFaces(m_vertexArrays, shader, applyTexture);
+            renderFaces(m_faceArrays, shader, applyTexture);
         }
         
         void FaceRenderer::renderTransparentFaces(ShaderProgram& shader, const bool applyTexture) {
-            renderFaces(m_transparentVertexArrays, shader, applyTexture);
+            renderFaces(m_transparentFaceArrays, shader, applyTexture);
         }
 
-        void FaceRenderer::renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const bool applyTexture) {
-            for (size_t i = 0; i < vertexArrays.size(); i++) {
-                const TextureVertexArray& textureVertexArray = vertexArrays[i];
-                if (textureVertexArray.texture != NULL) {
-                    textureVertexArray.texture->activate();
+        void FaceRenderer::renderFaces(const TextureFaceArrayList& faceArrays, ShaderProgram& shader, const bool applyTexture) {
+            for (size_t i = 0; i < faceArrays.size(); i++) {
+                const TextureFaceArray& textureFaceArray = faceArrays[i];
+                if (textureFaceArray.texture != NULL) {
+                    textureFaceArray.texture->activate();
                     shader.setUniformVariable("ApplyTexture", applyTexture);
                     shader.setUniformVariable("FaceTexture", 0);
-                    shader.setUniformVariable("Color", textureVertexArray.texture->averageColor());
+                    shader.setUniformVariable("Color", textureFaceArray.texture->averageColor());
                 } else {
                     shader.setUniformVariable("ApplyTexture", false);
                     shader.setUniformVariable("Color", m_faceColor);
                 }
                 
-                textureVertexArray.vertexArray->render();
+                textureFaceArray.faceArray->render();
                 
-                if (textureVertexArray.texture != NULL)
-                    textureVertexArray.texture->deactivate();
+                if (textureFaceArray.texture != NULL)
+                    textureFaceArray.texture->deactivate();
             }
         }
 
@@ -138,6 +299,30 @@ namespace TrenchBroom {
             writeFaceData(vbo, textureRendererManager, faceSorter);
         }
         
+        FaceRenderer::~FaceRenderer() {
+            for (size_t i = 0; i < m_faceBatches.size(); i++)
+                delete m_faceBatches[i].faceArray;
+            for (size_t i = 0; i < m_faceArrays.size(); i++)
+                delete m_faceArrays[i].faceArray;
+            for (size_t i = 0; i < m_transparentFaceArrays.size(); i++)
+                delete m_transparentFaceArrays[i].faceArray;
+        }
+        
+        size_t FaceRenderer::vboCapacity(const Sorter& faceSorter) {
+            size_t capacity = 0;
+            const FaceCollectionMap& faceCollectionMap = faceSorter.collections();
+            FaceCollectionMap::const_iterator it, end;
+            for (it = faceCollectionMap.begin(), end = faceCollectionMap.end(); it != end; ++it) {
+                const FaceCollection& faceCollection = it->second;
+                const size_t vertexCount = faceCollection.vertexCount();
+                const size_t triangleCount = vertexCount - 2 * faceCollection.polygons().size();
+                
+                // a collection may be split into two arrays, and each block may be padded by up to three bytes
+                capacity += FaceVertexArray::requiredCapacity(vertexCount, triangleCount) + 6;
+            }
+            return capacity;
+        }
+        
         void FaceRenderer::render(RenderContext& context, bool grayScale) {
             render(context, grayScale, NULL);
         }
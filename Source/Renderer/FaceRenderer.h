@@ -20,9 +20,15 @@
 #ifndef __TrenchBroom__FaceRenderer__
 #define __TrenchBroom__FaceRenderer__
 
+#include "Model/FaceTypes.h"
 #include "Renderer/TexturedPolygonSorter.h"
-#include "Renderer/TextureVertexArray.h"
 #include "Utility/Color.h"
+#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Model {
@@ -31,7 +37,11 @@ namespace TrenchBroom {
     }
     
     namespace Renderer {
+        class FaceVertexArray;
         class RenderContext;
+        class ShaderProgram;
+        class TextureArray;
+        class TextureRenderer;
         class TextureRendererManager;
         class Vbo;
         
@@ -42,9 +52,72 @@ namespace TrenchBroom {
             typedef Sorter::PolygonCollection FaceCollection;
             typedef Sorter::PolygonCollectionMap FaceCollectionMap;
 
+            class TextureFaceArray {
+            public:
+                TextureRenderer* texture;
+                FaceVertexArray* faceArray;
+                
+                TextureFaceArray(TextureRenderer* i_texture, FaceVertexArray* i_faceArray) :
+                texture(i_texture),
+                faceArray(i_faceArray) {}
+            };
+            
+            typedef std::vector<TextureFaceArray> TextureFaceArrayList;
+            
+            /**
+             * The faces of one texture, which is the given layer of a texture array.
+             */
+            class TextureLayerFaces {
+            public:
+                TextureRenderer* texture;
+                unsigned int layer;
+                const Model::FaceList* faces;
+                
+                TextureLayerFaces(TextureRenderer* i_texture, unsigned int i_layer, const Model::FaceList* i_faces) :
+                texture(i_texture),
+                layer(i_layer),
+                faces(i_faces) {}
+            };
+            
+            typedef std::vector<TextureLayerFaces> TextureLayerFacesList;
+            
+            /**
+             * The range of indices in a face batch which belongs to one texture.
+             */
+            class TextureRange {
+            public:
+                TextureRenderer* texture;
+                size_t firstIndex;
+                size_t indexCount;
+                
+                TextureRange(TextureRenderer* i_texture, size_t i_firstIndex, size_t i_indexCount) :
+                texture(i_texture),
+                firstIndex(i_firstIndex),
+                indexCount(i_indexCount) {}
+            };
+            
+            typedef std::vector<TextureRange> TextureRangeList;
+            
+            /**
+             * The faces of all textures in one texture array, which are drawn with a single call.
+             */
+            class FaceBatch {
+            public:
+                TextureArray* textureArray;
+                FaceVertexArray* faceArray;
+                TextureRangeList textureRanges;
+                
+                FaceBatch(TextureArray* i_textureArray, FaceVertexArray* i_faceArray) :
+                textureArray(i_textureArray),
+                faceArray(i_faceArray) {}
+            };
+            
+            typedef std::vector<FaceBatch> FaceBatchList;
+            
             Color m_faceColor;
-            TextureVertexArrayList m_vertexArrays;
-            TextureVertexArrayList m_transparentVertexArrays;
+            FaceBatchList m_faceBatches;
+            TextureFaceArrayList m_faceArrays;
+            TextureFaceArrayList m_transparentFaceArrays;
             
             static String AlphaBlendedTextures[];
             
@@ -59,13 +132,29 @@ namespace TrenchBroom {
                 return false;
             }
             
+            void writeTextureFaces(Vbo& vbo, TextureRenderer* texture, const Model::FaceList& faces, TextureFaceArrayList& faceArrays);
+            void writeFaceBatches(Vbo& vbo, TextureArray& textureArray, const TextureLayerFacesList& layerFaces);
             void writeFaceData(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter);
+            Vec3f cameraPosition(RenderContext& context) const;
+            void setUniforms(ShaderProgram& shader, RenderContext& context, bool grayScale, const Color* tintColor, const bool applyTexture);
             void render(RenderContext& context, bool grayScale, const Color* tintColor);
+            void renderFaceBatches(ShaderProgram& shader, const bool applyTexture);
             void renderOpaqueFaces(ShaderProgram& shader, const bool applyTexture);
             void renderTransparentFaces(ShaderProgram& shader, const bool applyTexture);
-            void renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const bool applyTexture);
+            void renderFaces(const TextureFaceArrayList& faceArrays, ShaderProgram& shader, const bool applyTexture);
         public:
+            /**
+             * Writes the faces sorted by the given sorter to the given VBO, which must be mapped. Faces whose
+             * texture coordinates are precise enough as half floats are kept in separate, smaller arrays. If texture
+             * arrays are supported, the opaque textured faces are batched by the texture array of their texture.
+             */
             FaceRenderer(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter, const Color& faceColor);
+            ~FaceRenderer();
+            
+            /**
+             * Returns the number of bytes which a face renderer for the given sorter needs at most in its VBO.
+             */
+            static size_t vboCapacity(const Sorter& faceSorter);
             
             void render(RenderContext& context, bool grayScale);
             void render(RenderContext& context, bool grayScale, const Color& tintColor);
@@ -20,42 +20,69 @@
 #ifndef __TrenchBroom__FaceVertex__
 #define __TrenchBroom__FaceVertex__
 
+#include <GL/glew.h>
 #include "Utility/VecMath.h"
 
-#include <vector>
+#include <algorithm>
+#include <cstring>
 
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Renderer {
-#if defined _WIN32
-#pragma pack(push,1)
-#endif
-        struct FaceVertex {
-            typedef std::vector<FaceVertex> List;
-            
-            float px, py, pz;
-            float nx, ny, nz;
-            float ts, tt;
-            
-            FaceVertex(const Vec3f& position, const Vec3f& normal, const Vec2f& texCoord) :
-            px(position.x()),
-            py(position.y()),
-            pz(position.z()),
-            nx(normal.x()),
-            ny(normal.y()),
-            nz(normal.z()),
-            ts(texCoord.x()),
-            tt(texCoord.y()) {}
-            
-            FaceVertex() {}
-            
-#if defined _WIN32
-        };
-#pragma pack(pop)
-#else
-        } __attribute__((packed));
-#endif
+        namespace FaceVertex {
+            /**
+             * Converts the given value to a 16 bit float, rounding to the nearest representable value. Values which
+             * are too large for a half float become infinite.
+             */
+            inline GLushort halfFloat(float value) {
+                GLuint bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+
+                const GLuint sign = (bits >> 16) & 0x8000;
+                const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+                GLuint mantissa = bits & 0x7FFFFF;
+
+                if (exponent <= 0) {
+                    // subnormal half float or zero
+                    if (exponent < -10)
+                        return static_cast<GLushort>(sign);
+                    mantissa |= 0x800000;
+                    const GLuint shift = static_cast<GLuint>(14 - exponent);
+                    GLuint half = mantissa >> shift;
+                    if ((mantissa >> (shift - 1)) & 1)
+                        half++;
+                    return static_cast<GLushort>(sign | half);
+                }
+
+                if (exponent >= 31)
+                    return static_cast<GLushort>(sign | 0x7C00);
+
+                // a carry from rounding correctly moves into the exponent
+                GLuint half = sign | (static_cast<GLuint>(exponent) << 10) | (mantissa >> 13);
+                if (mantissa & 0x1000)
+                    half++;
+                return static_cast<GLushort>(half);
+            }
+
+            inline GLuint packedComponent(float value, GLuint shift) {
+                const float clamped = std::max(-1.0f, std::min(1.0f, value));
+                const int packed = static_cast<int>(Math<float>::round(clamped * 511.0f));
+                return (static_cast<GLuint>(packed) & 0x3FF) << shift;
+            }
+
+            /**
+             * Packs the given unit vector into the signed 10-10-10-2 format, leaving the w component 0.
+             */
+            inline GLuint packedNormal(const Vec3f& normal) {
+                return packedComponent(normal.x(), 0) | packedComponent(normal.y(), 10) | packedComponent(normal.z(), 20);
+            }
+
+            inline GLbyte byteComponent(float value) {
+                const float clamped = std::max(-1.0f, std::min(1.0f, value));
+                return static_cast<GLbyte>(Math<float>::round(clamped * 127.0f));
+            }
+        }
     }
 }
 
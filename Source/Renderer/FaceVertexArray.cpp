@@ -0,0 +1,203 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FaceVertexArray.h"
+
+#include "Model/Face.h"
+#include "Model/Texture.h"
+#include "Renderer/FaceVertex.h"
+#include "Renderer/Vbo.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        void FaceVertexArray::writeVertex(size_t index, const Vec3f& position, const unsigned char* normal, const Vec2f& texCoords, unsigned int layer) {
+            unsigned char buffer[MaxVertexSize];
+            std::memcpy(buffer, &position, 3 * sizeof(GLfloat));
+            std::memcpy(buffer + 12, normal, 4);
+            if (m_halfTexCoords) {
+                // half floats represent layer indices up to 2048 exactly
+                const GLushort halfTexCoords[4] = { FaceVertex::halfFloat(texCoords.x()), FaceVertex::halfFloat(texCoords.y()), FaceVertex::halfFloat(static_cast<float>(layer)), 0 };
+                std::memcpy(buffer + 16, halfTexCoords, m_textureLayers ? sizeof(halfTexCoords) : 2 * sizeof(GLushort));
+            } else {
+                const GLfloat floatTexCoords[3] = { texCoords.x(), texCoords.y(), static_cast<float>(layer) };
+                std::memcpy(buffer + 16, floatTexCoords, m_textureLayers ? sizeof(floatTexCoords) : 2 * sizeof(GLfloat));
+            }
+            m_vertexBlock->writeBuffer(buffer, index * m_vertexSize, m_vertexSize);
+        }
+        
+        void FaceVertexArray::writeIndex(size_t index, size_t vertex) {
+            if (m_indexType == GL_UNSIGNED_SHORT) {
+                const GLushort value = static_cast<GLushort>(vertex);
+                m_indexBlock->writeBuffer(reinterpret_cast<const unsigned char*>(&value), index * sizeof(GLushort), sizeof(GLushort));
+            } else {
+                const GLuint value = static_cast<GLuint>(vertex);
+                m_indexBlock->writeBuffer(reinterpret_cast<const unsigned char*>(&value), index * sizeof(GLuint), sizeof(GLuint));
+            }
+        }
+        
+        FaceVertexArray::FaceVertexArray(Vbo& vbo, size_t vertexCapacity, size_t triangleCapacity, bool halfTexCoords, bool textureLayers) :
+        m_vbo(vbo),
+        m_vertexBlock(NULL),
+        m_indexBlock(NULL),
+        m_packedNormals(packedNormalsSupported()),
+        m_halfTexCoords(halfTexCoords),
+        m_textureLayers(textureLayers),
+        m_vertexSize(textureLayers ? (halfTexCoords ? 24 : 28) : (halfTexCoords ? 20 : 24)),
+        m_vertexCapacity(vertexCapacity),
+        m_indexCapacity(3 * triangleCapacity),
+        m_vertexCount(0),
+        m_indexCount(0),
+        m_indexType(vertexCapacity <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT) {
+            assert(vertexCapacity > 0 && triangleCapacity > 0);
+            assert(!halfTexCoords || halfTexCoordsSupported());
+            
+            m_vertexBlock = m_vbo.allocBlock(m_vertexCapacity * m_vertexSize);
+            m_indexBlock = m_vbo.allocBlock(m_indexCapacity * (m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint)));
+            
+            m_attributes.push_back(Attribute::position3f());
+            if (m_packedNormals)
+                m_attributes.push_back(Attribute(4, GL_INT_2_10_10_10_REV, Attribute::Normal));
+            else
+                m_attributes.push_back(Attribute(3, GL_BYTE, Attribute::Normal));
+            m_attributes.push_back(Attribute(m_textureLayers ? 3 : 2, m_halfTexCoords ? GL_HALF_FLOAT : GL_FLOAT, Attribute::TexCoord0));
+        }
+        
+        FaceVertexArray::~FaceVertexArray() {
+            if (m_vertexBlock != NULL) {
+                m_vertexBlock->freeBlock();
+                m_vertexBlock = NULL;
+            }
+            if (m_indexBlock != NULL) {
+                m_indexBlock->freeBlock();
+                m_indexBlock = NULL;
+            }
+        }
+        
+        bool FaceVertexArray::packedNormalsSupported() {
+            return GLEW_VERSION_3_3 || GLEW_ARB_vertex_type_2_10_10_10_rev;
+        }
+        
+        bool FaceVertexArray::halfTexCoordsSupported() {
+            return GLEW_VERSION_3_0 || GLEW_ARB_half_float_vertex;
+        }
+        
+        bool FaceVertexArray::halfTexCoordsPrecise(const Model::Face& face) {
+            Vec3f xAxis, yAxis;
+            Vec2f offset;
+            face.textureProjection(xAxis, yAxis, offset);
+            
+            const Model::VertexList& vertices = face.vertices();
+            assert(vertices.size() >= 3);
+            
+            const Vec3f& origin = vertices.front()->position;
+            const float originS = origin.dot(xAxis) + offset.x();
+            const float originT = origin.dot(yAxis) + offset.y();
+            const float shiftS = std::floor(originS);
+            const float shiftT = std::floor(originT);
+            
+            float maximum = 0.0f;
+            for (size_t i = 0; i < vertices.size(); i++) {
+                const Vec3f& position = vertices[i]->position;
+                maximum = std::max(maximum, std::abs(position.dot(xAxis) + offset.x() - shiftS));
+                maximum = std::max(maximum, std::abs(position.dot(yAxis) + offset.y() - shiftT));
+            }
+            
+            // a half float has 11 significant bits, so the rounding error is at most maximum / 2048 texture
+            // repetitions; keep it below an eighth of a texel
+            const Model::Texture* texture = face.texture();
+            const float textureSize = texture != NULL ? static_cast<float>(std::max(texture->width(), texture->height())) : 1.0f;
+            return maximum * textureSize <= 256.0f;
+        }
+        
+        size_t FaceVertexArray::requiredCapacity(size_t vertexCount, size_t triangleCount) {
+            const size_t vertexCapacity = vertexCount * MaxVertexSize + 3;
+            const size_t indexCapacity = 3 * triangleCount * sizeof(GLuint) + 3;
+            return vertexCapacity + indexCapacity;
+        }
+        
+        void FaceVertexArray::addFace(const Model::Face& face, unsigned int layer) {
+            const Model::VertexList& vertices = face.vertices();
+            const size_t vertexCount = vertices.size();
+            assert(vertexCount >= 3);
+            assert(m_vertexCount + vertexCount <= m_vertexCapacity);
+            assert(m_indexCount + 3 * (vertexCount - 2) <= m_indexCapacity);
+            
+            unsigned char normal[4] = { 0, 0, 0, 0 };
+            const Vec3f& faceNormal = face.boundary().normal;
+            if (m_packedNormals) {
+                const GLuint packedNormal = FaceVertex::packedNormal(faceNormal);
+                std::memcpy(normal, &packedNormal, sizeof(packedNormal));
+            } else {
+                normal[0] = static_cast<unsigned char>(FaceVertex::byteComponent(faceNormal.x()));
+                normal[1] = static_cast<unsigned char>(FaceVertex::byteComponent(faceNormal.y()));
+                normal[2] = static_cast<unsigned char>(FaceVertex::byteComponent(faceNormal.z()));
+            }
+            
+            Vec3f xAxis, yAxis;
+            Vec2f offset;
+            face.textureProjection(xAxis, yAxis, offset);
+            
+            // textures repeat, so shifting the coordinates of the face by whole repetitions keeps them small
+            const Vec3f& origin = vertices.front()->position;
+            offset[0] -= std::floor(origin.dot(xAxis) + offset.x());
+            offset[1] -= std::floor(origin.dot(yAxis) + offset.y());
+            
+            const size_t firstVertex = m_vertexCount;
+            for (size_t i = 0; i < vertexCount; i++) {
+                const Vec3f& position = vertices[i]->position;
+                writeVertex(m_vertexCount++, position, normal, Vec2f(position.dot(xAxis) + offset.x(), position.dot(yAxis) + offset.y()), layer);
+            }
+            
+            for (size_t i = 1; i < vertexCount - 1; i++) {
+                writeIndex(m_indexCount++, firstVertex);
+                writeIndex(m_indexCount++, firstVertex + i);
+                writeIndex(m_indexCount++, firstVertex + i + 1);
+            }
+        }
+        
+        void FaceVertexArray::render() {
+            render(0, m_indexCount);
+        }
+        
+        void FaceVertexArray::render(size_t firstIndex, size_t indexCount) {
+            assert(firstIndex + indexCount <= m_indexCount);
+            if (indexCount == 0)
+                return;
+            
+            m_vertexBlock->activate();
+            size_t offset = m_vertexBlock->address();
+            const size_t attributeOffsets[3] = { 0, 12, 16 };
+            for (size_t i = 0; i < m_attributes.size(); i++)
+                m_attributes[i].setGLState(i, m_vertexSize, offset + attributeOffsets[i]);
+            
+            m_indexBlock->activateElements();
+            const size_t indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), m_indexType, reinterpret_cast<GLvoid*>(m_indexBlock->address() + firstIndex * indexSize));
+            m_vbo.deactivateElements();
+            
+            for (size_t i = 0; i < m_attributes.size(); i++)
+                m_attributes[i].clearGLState(i);
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__FaceVertexArray__
+#define __TrenchBroom__FaceVertexArray__
+
+#include <GL/glew.h>
+#include "Renderer/AttributeArray.h"
+#include "Utility/VecMath.h"
+
+#include <cstddef>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class Face;
+    }
+    
+    namespace Renderer {
+        class Vbo;
+        class VboBlock;
+        
+        /**
+         * Renders brush faces as indexed triangles. Every polygon corner is stored once with its position, its normal
+         * and its texture coordinates, and the fan triangulation of the polygon is stored as 16 or 32 bit indices in
+         * the same VBO. Normals are packed into 10-10-10-2 integers if supported and into signed bytes otherwise.
+         * Texture coordinates are stored as half floats if requested, which is only precise enough for faces which
+         * pass halfTexCoordsPrecise. If texture layers are requested, the texture coordinates get a third component
+         * which selects the layer of a texture array, so that faces with different textures can share an array.
+         */
+        class FaceVertexArray {
+        private:
+            Vbo& m_vbo;
+            VboBlock* m_vertexBlock;
+            VboBlock* m_indexBlock;
+            Attribute::List m_attributes;
+            bool m_packedNormals;
+            bool m_halfTexCoords;
+            bool m_textureLayers;
+            size_t m_vertexSize;
+            size_t m_vertexCapacity;
+            size_t m_indexCapacity;
+            size_t m_vertexCount;
+            size_t m_indexCount;
+            GLenum m_indexType;
+            
+            void writeVertex(size_t index, const Vec3f& position, const unsigned char* normal, const Vec2f& texCoords, unsigned int layer);
+            void writeIndex(size_t index, size_t vertex);
+        public:
+            /**
+             * The number of bytes of the largest vertex.
+             */
+            static const size_t MaxVertexSize = 28;
+            
+            /**
+             * Allocates room for the given number of polygon corners and triangles from the given VBO, which must be
+             * mapped.
+             */
+            FaceVertexArray(Vbo& vbo, size_t vertexCapacity, size_t triangleCapacity, bool halfTexCoords, bool textureLayers = false);
+            ~FaceVertexArray();
+            
+            static bool packedNormalsSupported();
+            static bool halfTexCoordsSupported();
+            
+            /**
+             * Returns whether the texture coordinates of the given face are precise to a fraction of a texel when
+             * they are stored as half floats. The coordinates are shifted by whole texture repetitions so that they
+             * start near the origin, so this depends on the size of the face relative to its texture.
+             */
+            static bool halfTexCoordsPrecise(const Model::Face& face);
+            
+            /**
+             * Returns the number of bytes needed in a VBO to store the given number of polygon corners and triangles,
+             * including the padding which aligns the indices.
+             */
+            static size_t requiredCapacity(size_t vertexCount, size_t triangleCount);
+            
+            inline size_t indexCount() const {
+                return m_indexCount;
+            }
+            
+            /**
+             * Adds the given face. The layer is only stored if this array has texture layers.
+             */
+            void addFace(const Model::Face& face, unsigned int layer = 0);
+            void render();
+            
+            /**
+             * Renders the triangles of the given range of indices.
+             */
+            void render(size_t firstIndex, size_t indexCount);
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__FaceVertexArray__) */
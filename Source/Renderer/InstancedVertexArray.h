@@ -25,6 +25,7 @@
 #include "Utility/String.h"
 
 #include <cassert>
+#include <set>
 #include <vector>
 
 namespace TrenchBroom {
@@ -41,7 +42,13 @@ namespace TrenchBroom {
             GLint m_textureSize;
         protected:
             virtual GLint createTexture(GLuint textureId) = 0;
+            
+            inline GLuint textureId() const {
+                return m_textureId;
+            }
         public:
+            typedef std::set<size_t> IndexSet;
+            
             InstanceAttributes(const String& name) :
             m_name(name),
             m_textureId(0) {
@@ -83,6 +90,14 @@ namespace TrenchBroom {
             inline void cleanup() {
                 glBindTexture(GL_TEXTURE_2D, 0);
             }
+            
+            /**
+             * Replaces the attributes of the given instances with the corresponding values. Returns false if the
+             * values cannot be updated in place, e.g. because they no longer fit into the texture.
+             */
+            virtual bool update(const Vec4f::List& values, const IndexSet& indices) {
+                return false;
+            }
         };
         
         class InstanceAttributesVec4f : public InstanceAttributes {
@@ -114,6 +129,37 @@ namespace TrenchBroom {
             InstanceAttributesVec4f(const String& name, const Vec4f::List& vertices) :
             InstanceAttributes(name),
             m_vertices(vertices) {}
+            
+            bool update(const Vec4f::List& values, const IndexSet& indices) {
+                if (textureId() == 0) {
+                    m_vertices = values;
+                    return true;
+                }
+                
+                const size_t size = static_cast<size_t>(textureSize());
+                if (values.size() > size * size)
+                    return false;
+                
+                // upload every row of the texture which contains a changed instance
+                glBindTexture(GL_TEXTURE_2D, textureId());
+                Vec4f::List row(size);
+                size_t previousRow = size;
+                IndexSet::const_iterator it, end;
+                for (it = indices.begin(), end = indices.end(); it != end && *it < values.size(); ++it) {
+                    const size_t rowIndex = *it / size;
+                    if (rowIndex == previousRow)
+                        continue;
+                    
+                    for (size_t i = 0; i < size; i++) {
+                        const size_t index = rowIndex * size + i;
+                        row[i] = index < values.size() ? values[index] : Vec4f::Null;
+                    }
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(rowIndex), static_cast<GLsizei>(size), 1, GL_RGBA, GL_FLOAT, reinterpret_cast<const GLvoid*>(&row.front()));
+                    previousRow = rowIndex;
+                }
+                glBindTexture(GL_TEXTURE_2D, 0);
+                return true;
+            }
         };
         
         // requires ARB_draw_instanced and ARB_texture_float
@@ -156,6 +202,24 @@ namespace TrenchBroom {
                 m_instanceAttributes.push_back(new InstanceAttributesVec4f(name, values));
             }
             
+            /**
+             * Patches the given instances of the attribute array with the given name and sets the number of instances
+             * to the number of values. Returns false if the array must be recreated instead.
+             */
+            inline bool updateAttributeArray(const String& name, const Vec4f::List& values, const InstanceAttributes::IndexSet& indices) {
+                InstanceAttributesList::iterator it, end;
+                for (it = m_instanceAttributes.begin(), end = m_instanceAttributes.end(); it != end; ++it) {
+                    InstanceAttributes& attributes = **it;
+                    if (attributes.name() == name) {
+                        if (!attributes.update(values, indices))
+                            return false;
+                        m_instanceCount = static_cast<unsigned int>(values.size());
+                        return true;
+                    }
+                }
+                return false;
+            }
+            
             inline void render(ShaderProgram& program) {
                 bindAttributes(program);
                 setup();
@@ -22,7 +22,9 @@
 #include "Controller/AddObjectsCommand.h"
 #include "Controller/Command.h"
 #include "Controller/ChangeEditStateCommand.h"
+#include "Controller/EntityDefinitionChangeEvent.h"
 #include "Controller/EntityPropertyCommand.h"
+#include "Controller/LoadMapBatchEvent.h"
 #include "Controller/PreferenceChangeEvent.h"
 #include "Controller/RemoveObjectsCommand.h"
 #include "IO/FileManager.h"
@@ -34,11 +36,14 @@
 #include "Model/Filter.h"
 #include "Model/Map.h"
 #include "Model/MapDocument.h"
+#include "Renderer/ApplyMatrix.h"
+#include "Renderer/Camera.h"
 #include "Renderer/EdgeRenderer.h"
 #include "Renderer/EntityRenderer.h"
 #include "Renderer/EntityRotationDecorator.h"
 #include "Renderer/EntityLinkDecorator.h"
 #include "Renderer/FaceRenderer.h"
+#include "Renderer/OcclusionBuffer.h"
 #include "Renderer/PointHandleRenderer.h"
 #include "Renderer/PointTraceRenderer.h"
 #include "Renderer/RenderContext.h"
@@ -49,30 +54,150 @@
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
 #include "Renderer/Vbo.h"
+#include "Renderer/VertexArray.h"
 #include "Renderer/Text/FontDescriptor.h"
 #include "Utility/Console.h"
 #include "Utility/Grid.h"
 #include "Utility/List.h"
 #include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
+#include "Utility/WorkerPool.h"
+
+#include <wx/stopwatch.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace TrenchBroom {
     namespace Renderer {
         static const int IndexSize = sizeof(GLuint);
         static const int VertexSize = 3 * sizeof(GLfloat);
-        static const int NormalSize = 3 * sizeof(GLfloat);
         static const int ColorSize = 4;
-        static const int TexCoordSize = 2 * sizeof(GLfloat);
-        static const int FaceVertexSize = VertexSize + NormalSize + TexCoordSize;
         static const int EdgeVertexSize = VertexSize;
         static const int EntityBoundsVertexSize = ColorSize + VertexSize;
+        
+        // the time in microseconds which each frame may spend on compacting the VBOs
+        static const long VboCompactionBudget = 1000;
+        
+        // the edge length of the grid cells into which the unselected brushes are divided for culling
+        static const float GeometryCellSize = 1024.0f;
+        
+        // faces whose area is smaller than this are not used as occluders
+        static const float OccluderMinArea = 128.0f * 128.0f;
+        
+        // the maximum number of occluders which are rasterized per frame
+        static const size_t MaxOccluderCount = 256;
+        
+        static const Color OccludedCellColor(1.0f, 0.0f, 0.0f, 1.0f);
+        
+        class GeometryCellKey {
+        private:
+            int m_x;
+            int m_y;
+            int m_z;
+        public:
+            GeometryCellKey(const Vec3f& point) :
+            m_x(static_cast<int>(std::floor(point.x() / GeometryCellSize))),
+            m_y(static_cast<int>(std::floor(point.y() / GeometryCellSize))),
+            m_z(static_cast<int>(std::floor(point.z() / GeometryCellSize))) {}
+            
+            inline bool operator< (const GeometryCellKey& other) const {
+                if (m_x != other.m_x)
+                    return m_x < other.m_x;
+                if (m_y != other.m_y)
+                    return m_y < other.m_y;
+                return m_z < other.m_z;
+            }
+        };
+        
+        /**
+         * Collects the unselected brushes and faces of one grid cell while the geometry data is rebuilt.
+         */
+        class GeometryCellContents {
+        public:
+            BBoxf bounds;
+            Model::BrushList worldBrushes;
+            Model::BrushList entityBrushes;
+            FaceRenderer::Sorter faceSorter;
+            Model::FaceList occluders;
+            
+            GeometryCellContents(const BBoxf& i_bounds) :
+            bounds(i_bounds) {}
+        };
+        
+        typedef std::map<GeometryCellKey, GeometryCellContents*> GeometryCellContentsMap;
+        
+        static GeometryCellContents& geometryCellContents(GeometryCellContentsMap& cellContents, const Model::Brush& brush) {
+            const BBoxf& bounds = brush.bounds();
+            const GeometryCellKey key(bounds.center());
+            GeometryCellContentsMap::iterator it = cellContents.lower_bound(key);
+            if (it == cellContents.end() || key < it->first)
+                it = cellContents.insert(it, GeometryCellContentsMap::value_type(key, new GeometryCellContents(bounds)));
+            else
+                it->second->bounds.mergeWith(bounds);
+            return *it->second;
+        }
+        
+        static float faceArea(const Model::Face& face) {
+            const Model::VertexList& vertices = face.vertices();
+            Vec3f sum;
+            for (size_t i = 1; i < vertices.size() - 1; i++)
+                sum += crossed(vertices[i]->position - vertices[0]->position, vertices[i + 1]->position - vertices[0]->position);
+            return 0.5f * sum.length();
+        }
+        
+        class OccluderCandidate {
+        public:
+            float weight;
+            Model::Face* face;
+            
+            OccluderCandidate(float i_weight, Model::Face* i_face) :
+            weight(i_weight),
+            face(i_face) {}
+            
+            // orders the candidates with the largest weight first
+            inline bool operator< (const OccluderCandidate& other) const {
+                return weight > other.weight;
+            }
+        };
+        
+        class OcclusionBandRasterization : public Utility::ParallelTask {
+        private:
+            OcclusionBuffer& m_occlusionBuffer;
+        public:
+            OcclusionBandRasterization(OcclusionBuffer& occlusionBuffer) :
+            m_occlusionBuffer(occlusionBuffer) {}
+            
+            void run(size_t index) {
+                m_occlusionBuffer.rasterizeBand(index);
+            }
+        };
+        
+        static void countVboStatistics(const Vbo& vbo, const char* occupancyName, const char* fragmentationName, const char* pageCountName) {
+            const Vbo::Statistics statistics = vbo.statistics();
+            Utility::Profiler::count(occupancyName, static_cast<int64_t>(100.0f * statistics.occupancy()));
+            Utility::Profiler::count(fragmentationName, static_cast<int64_t>(100.0f * statistics.fragmentation()));
+            Utility::Profiler::count(pageCountName, static_cast<int64_t>(statistics.pageCount));
+        }
 
-        void MapRenderer::rebuildGeometryData(RenderContext& context) {
-            if (!m_geometryDataValid) {
-                delete m_faceRenderer;
-                m_faceRenderer = NULL;
-                delete m_edgeRenderer;
-                m_edgeRenderer = NULL;
+        void MapRenderer::clearGeometryCells() {
+            GeometryCell::List::const_iterator cellIt, cellEnd;
+            for (cellIt = m_geometryCells.begin(), cellEnd = m_geometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                GeometryCell* cell = *cellIt;
+                delete cell->faceRenderer;
+                delete cell->edgeRenderer;
+                delete cell;
             }
+            m_geometryCells.clear();
+            m_visibleGeometryCells.clear();
+            m_occludedGeometryCells.clear();
+        }
+        
+        void MapRenderer::rebuildGeometryData(RenderContext& context) {
+            Utility::ScopedTimer timer("MapRenderer::rebuildGeometryData");
+            
+            if (!m_geometryDataValid)
+                clearGeometryCells();
             if (!m_selectedGeometryDataValid) {
                 delete m_selectedFaceRenderer;
                 m_selectedFaceRenderer = NULL;
@@ -86,12 +211,10 @@ namespace TrenchBroom {
                 m_lockedEdgeRenderer = NULL;
             }
             
-            FaceSorter unselectedFaceSorter;
+            GeometryCellContentsMap cellContents;
             FaceSorter selectedFaceSorter;
             FaceSorter lockedFaceSorter;
             
-            Model::BrushList unselectedWorldBrushes;
-            Model::BrushList unselectedEntityBrushes;
             Model::BrushList selectedBrushes;
             Model::BrushList lockedBrushes;
             Model::FaceList partiallySelectedBrushFaces;
@@ -104,15 +227,19 @@ namespace TrenchBroom {
                 for (size_t j = 0; j < brushes.size(); j++) {
                     Model::Brush* brush = brushes[j];
                     if (context.filter().brushVisible(*brush)) {
+                        GeometryCellContents* cell = NULL;
                         if (entity->selected() || brush->selected()) {
                             selectedBrushes.push_back(brush);
                         } else if (entity->locked() || brush->locked()) {
                             lockedBrushes.push_back(brush);
                         } else {
-                            if (entity->worldspawn())
-                                unselectedWorldBrushes.push_back(brush);
-                            else
-                                unselectedEntityBrushes.push_back(brush);
+                            if (!m_geometryDataValid) {
+                                cell = &geometryCellContents(cellContents, *brush);
+                                if (entity->worldspawn())
+                                    cell->worldBrushes.push_back(brush);
+                                else
+                                    cell->entityBrushes.push_back(brush);
+                            }
                             if (brush->partiallySelected()) {
                                 const Model::FaceList& faces = brush->faces();
                                 for (size_t k = 0; k < faces.size(); k++) {
@@ -132,34 +259,42 @@ namespace TrenchBroom {
                                 selectedFaceSorter.addPolygon(texture, face, face->vertices().size());
                             else if (entity->locked() || brush->locked())
                                 lockedFaceSorter.addPolygon(texture, face, face->vertices().size());
-                            else
-                                unselectedFaceSorter.addPolygon(texture, face, face->vertices().size());
+                            else if (cell != NULL) {
+                                cell->faceSorter.addPolygon(texture, face, face->vertices().size());
+                                if (face->contentType() == Model::Face::CTDefault && faceArea(*face) >= OccluderMinArea)
+                                    cell->occluders.push_back(face);
+                            }
                         }
                     }
                 }
             }
             
-            // merge the collected brushes
-            Model::BrushList unselectedBrushes(unselectedWorldBrushes);
-            unselectedBrushes.insert(unselectedBrushes.end(), unselectedEntityBrushes.begin(), unselectedEntityBrushes.end());
-
             // write face triangles
             m_faceVbo->activate();
             m_faceVbo->map();
             
             // make sure that the VBO is sufficiently large
-            size_t totalFaceVertexCount = unselectedFaceSorter.vertexCount() + selectedFaceSorter.vertexCount() + lockedFaceSorter.vertexCount();
-            size_t totalPolygonCount = unselectedFaceSorter.polygonCount() + selectedFaceSorter.polygonCount() + lockedFaceSorter.polygonCount();
-            size_t totalTriangleVertexCount = 3 * totalFaceVertexCount - 6 * totalPolygonCount;
-            m_faceVbo->ensureFreeCapacity(static_cast<unsigned int>(totalTriangleVertexCount) * FaceVertexSize);
+            size_t faceCapacity = 0;
+            GeometryCellContentsMap::const_iterator cellIt, cellEnd;
+            for (cellIt = cellContents.begin(), cellEnd = cellContents.end(); cellIt != cellEnd; ++cellIt)
+                faceCapacity += FaceRenderer::vboCapacity(cellIt->second->faceSorter);
+            if (!m_selectedGeometryDataValid)
+                faceCapacity += FaceRenderer::vboCapacity(selectedFaceSorter);
+            if (!m_lockedGeometryDataValid)
+                faceCapacity += FaceRenderer::vboCapacity(lockedFaceSorter);
+            m_faceVbo->ensureFreeCapacity(faceCapacity);
             
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             TextureRendererManager& textureRendererManager = m_document.sharedResources().textureRendererManager();
             const Color& faceColor = prefs.getColor(Preferences::FaceColor);
 
-            if (!m_geometryDataValid && !unselectedFaceSorter.empty()) {
-                assert(m_faceRenderer == NULL);
-                m_faceRenderer = new FaceRenderer(*m_faceVbo, textureRendererManager, unselectedFaceSorter, faceColor);
+            // each cell's faces and edges are written in one go so that they are contiguous in the VBOs
+            for (cellIt = cellContents.begin(), cellEnd = cellContents.end(); cellIt != cellEnd; ++cellIt) {
+                const GeometryCellContents& contents = *cellIt->second;
+                FaceRenderer* faceRenderer = NULL;
+                if (!contents.faceSorter.empty())
+                    faceRenderer = new FaceRenderer(*m_faceVbo, textureRendererManager, contents.faceSorter, faceColor);
+                m_geometryCells.push_back(new GeometryCell(contents.bounds, faceRenderer, NULL, contents.occluders));
             }
             
             if (!m_selectedGeometryDataValid && !selectedFaceSorter.empty()) {
@@ -181,9 +316,14 @@ namespace TrenchBroom {
             
             const Color& edgeColor = prefs.getColor(Preferences::EdgeColor);
 
-            if (!m_geometryDataValid && !unselectedBrushes.empty()) {
-                assert(m_edgeRenderer == NULL);
-                m_edgeRenderer = new EdgeRenderer(*m_edgeVbo, unselectedBrushes, Model::EmptyFaceList, edgeColor);
+            if (!m_geometryDataValid) {
+                size_t cellIndex = 0;
+                for (cellIt = cellContents.begin(), cellEnd = cellContents.end(); cellIt != cellEnd; ++cellIt) {
+                    const GeometryCellContents& contents = *cellIt->second;
+                    Model::BrushList brushes(contents.worldBrushes);
+                    brushes.insert(brushes.end(), contents.entityBrushes.begin(), contents.entityBrushes.end());
+                    m_geometryCells[cellIndex++]->edgeRenderer = new EdgeRenderer(*m_edgeVbo, brushes, Model::EmptyFaceList, edgeColor, true);
+                }
             }
             
             if (!m_selectedGeometryDataValid && (!selectedBrushes.empty() || !partiallySelectedBrushFaces.empty())) {
@@ -193,12 +333,15 @@ namespace TrenchBroom {
             
             if (!m_lockedGeometryDataValid && !lockedBrushes.empty()) {
                 assert(m_lockedEdgeRenderer == NULL);
-                m_lockedEdgeRenderer = new EdgeRenderer(*m_edgeVbo, lockedBrushes, Model::EmptyFaceList);
+                m_lockedEdgeRenderer = new EdgeRenderer(*m_edgeVbo, lockedBrushes, Model::EmptyFaceList, true);
             }
             
             m_edgeVbo->unmap();
             m_edgeVbo->deactivate();
             
+            for (cellIt = cellContents.begin(), cellEnd = cellContents.end(); cellIt != cellEnd; ++cellIt)
+                delete cellIt->second;
+            
             m_geometryDataValid = true;
             m_selectedGeometryDataValid = true;
             m_lockedGeometryDataValid = true;
@@ -217,14 +360,99 @@ namespace TrenchBroom {
             }
         }
 
+        bool MapRenderer::rasterizeOccluders(RenderContext& context) {
+            const Camera& camera = context.camera();
+            const Vec3f& cameraPosition = camera.position();
+            
+            // prefer the front facing occluders which cover the largest part of the screen
+            std::vector<OccluderCandidate> candidates;
+            GeometryCell::List::const_iterator cellIt, cellEnd;
+            for (cellIt = m_visibleGeometryCells.begin(), cellEnd = m_visibleGeometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                const Model::FaceList& occluders = (*cellIt)->occluders;
+                for (size_t i = 0; i < occluders.size(); i++) {
+                    Model::Face* face = occluders[i];
+                    if (face->boundary().pointDistance(cameraPosition) > 0.0f) {
+                        const float distance2 = std::max(camera.squaredDistanceTo(face->center()), 1.0f);
+                        candidates.push_back(OccluderCandidate(faceArea(*face) / distance2, face));
+                    }
+                }
+            }
+            
+            if (candidates.empty())
+                return false;
+            if (candidates.size() > MaxOccluderCount) {
+                std::partial_sort(candidates.begin(), candidates.begin() + MaxOccluderCount, candidates.end());
+                candidates.erase(candidates.begin() + MaxOccluderCount, candidates.end());
+            }
+            
+            m_occlusionBuffer->reset(camera.projectionMatrix() * camera.viewMatrix());
+            Vec3f::List vertices;
+            for (size_t i = 0; i < candidates.size(); i++) {
+                const Model::VertexList& faceVertices = candidates[i].face->vertices();
+                vertices.clear();
+                for (size_t j = 0; j < faceVertices.size(); j++)
+                    vertices.push_back(faceVertices[j]->position);
+                m_occlusionBuffer->addOccluder(vertices);
+            }
+            
+            OcclusionBandRasterization rasterization(*m_occlusionBuffer);
+            Utility::WorkerPool::execute(rasterization, OcclusionBuffer::BandCount);
+            return true;
+        }
+        
+        void MapRenderer::cullGeometryCells(RenderContext& context) {
+            Utility::ScopedTimer timer("MapRenderer::cullGeometryCells");
+            
+            m_visibleGeometryCells.clear();
+            m_occludedGeometryCells.clear();
+            
+            const Camera& camera = context.camera();
+            GeometryCell::List::const_iterator cellIt, cellEnd;
+            for (cellIt = m_geometryCells.begin(), cellEnd = m_geometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                GeometryCell* cell = *cellIt;
+                if (camera.intersectsFrustum(cell->bounds))
+                    m_visibleGeometryCells.push_back(cell);
+            }
+            
+            // occluders only hide anything if the faces are rendered
+            const View::ViewOptions& viewOptions = context.viewOptions();
+            const bool occlusionCulling = (viewOptions.showBrushes() &&
+                                           viewOptions.faceRenderMode() != View::ViewOptions::Discard &&
+                                           rasterizeOccluders(context));
+            if (occlusionCulling) {
+                GeometryCell::List visibleCells;
+                for (cellIt = m_visibleGeometryCells.begin(), cellEnd = m_visibleGeometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                    GeometryCell* cell = *cellIt;
+                    if (m_occlusionBuffer->visible(cell->bounds))
+                        visibleCells.push_back(cell);
+                    else
+                        m_occludedGeometryCells.push_back(cell);
+                }
+                m_visibleGeometryCells.swap(visibleCells);
+            }
+            
+            // the selected entities are not culled since their classnames are also rendered when they are occluded
+            const OcclusionBuffer* occlusionBuffer = occlusionCulling ? m_occlusionBuffer : NULL;
+            m_entityRenderer->setOcclusionBuffer(occlusionBuffer);
+            m_lockedEntityRenderer->setOcclusionBuffer(occlusionBuffer);
+            
+            Utility::Profiler::count("MapRenderer::visibleGeometryCells", static_cast<int64_t>(m_visibleGeometryCells.size()));
+            Utility::Profiler::count("MapRenderer::occludedGeometryCells", static_cast<int64_t>(m_occludedGeometryCells.size()));
+        }
+
         void MapRenderer::renderFaces(RenderContext& context) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             
             m_faceVbo->activate();
-            if (m_faceRenderer != NULL)
-                m_faceRenderer->render(context, false);
+            GeometryCell::List::const_iterator cellIt, cellEnd;
+            for (cellIt = m_visibleGeometryCells.begin(), cellEnd = m_visibleGeometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                const GeometryCell& cell = **cellIt;
+                if (cell.faceRenderer != NULL)
+                    cell.faceRenderer->render(context, false);
+            }
             if (context.viewOptions().renderSelection() && m_selectedFaceRenderer != NULL) {
                 const Color& color = m_overrideSelectionColors ? m_selectedFaceColor : prefs.getColor(Preferences::SelectedFaceColor);
+                ApplyModelMatrix applyTransformation(context.transformation(), m_selectionTransformation);
                 m_selectedFaceRenderer->render(context, false, color);
             }
             if (m_lockedFaceRenderer != NULL)
@@ -237,9 +465,11 @@ namespace TrenchBroom {
             
             m_edgeVbo->activate();
             if (context.viewOptions().renderEdges()) {
-                if (m_edgeRenderer != NULL) {
-                    glSetEdgeOffset(0.02f);
-                    m_edgeRenderer->render(context);
+                glSetEdgeOffset(0.02f);
+                GeometryCell::List::const_iterator cellIt, cellEnd;
+                for (cellIt = m_visibleGeometryCells.begin(), cellEnd = m_visibleGeometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                    const GeometryCell& cell = **cellIt;
+                    cell.edgeRenderer->render(context);
                 }
                 if (m_lockedEdgeRenderer != NULL) {
                     glSetEdgeOffset(0.02f);
@@ -249,7 +479,7 @@ namespace TrenchBroom {
             if (context.viewOptions().renderSelection() && m_selectedEdgeRenderer != NULL) {
                 const Color& edgeColor = m_overrideSelectionColors ? m_selectedEdgeColor : prefs.getColor(Preferences::SelectedEdgeColor);
                 const Color& occludedEdgeColor = m_overrideSelectionColors ? m_occludedSelectedEdgeColor : prefs.getColor(Preferences::OccludedSelectedEdgeColor);
-                
+                ApplyModelMatrix applyTransformation(context.transformation(), m_selectionTransformation);
                 
                 glDisable(GL_DEPTH_TEST);
                 glSetEdgeOffset(0.02f);
@@ -270,6 +500,51 @@ namespace TrenchBroom {
             }
         }
 
+        void MapRenderer::renderOccludedGeometryCells(RenderContext& context) {
+            if (m_occludedGeometryCells.empty())
+                return;
+            
+            Vbo& streamVbo = context.streamVbo();
+            VertexArray boundsArray(streamVbo, GL_LINES, static_cast<unsigned int>(24 * m_occludedGeometryCells.size()), Attribute::position3f());
+            SetVboState mapVbo(streamVbo, Vbo::VboMapped);
+            
+            Vec3f::List vertices(24);
+            GeometryCell::List::const_iterator cellIt, cellEnd;
+            for (cellIt = m_occludedGeometryCells.begin(), cellEnd = m_occludedGeometryCells.end(); cellIt != cellEnd; ++cellIt) {
+                const GeometryCell& cell = **cellIt;
+                cell.bounds.vertices(vertices);
+                for (size_t i = 0; i < vertices.size(); i++)
+                    boundsArray.addAttribute(vertices[i]);
+            }
+            
+            SetVboState activateVbo(streamVbo, Vbo::VboActive);
+            ActivateShader shader(context.shaderManager(), Shaders::EdgeShader);
+            
+            glDisable(GL_DEPTH_TEST);
+            shader.setUniformVariable("Color", OccludedCellColor);
+            boundsArray.render();
+            glEnable(GL_DEPTH_TEST);
+        }
+
+        void MapRenderer::compactVbos() {
+            Utility::ScopedTimer timer("MapRenderer::compactVbos");
+            
+            Vbo* vbos[] = { m_faceVbo, m_edgeVbo, m_entityVbo, m_utilityVbo };
+            wxStopWatch watch;
+            for (size_t i = 0; i < 4; i++) {
+                const long remainingBudget = VboCompactionBudget - static_cast<long>(watch.TimeInMicro().GetValue());
+                if (remainingBudget <= 0)
+                    break;
+                vbos[i]->compact(remainingBudget);
+            }
+            
+            if (Utility::Profiler::enabled()) {
+                countVboStatistics(*m_faceVbo, "FaceVbo::occupancy %", "FaceVbo::fragmentation %", "FaceVbo::pages");
+                countVboStatistics(*m_edgeVbo, "EdgeVbo::occupancy %", "EdgeVbo::fragmentation %", "EdgeVbo::pages");
+                countVboStatistics(*m_entityVbo, "EntityVbo::occupancy %", "EntityVbo::fragmentation %", "EntityVbo::pages");
+            }
+        }
+
         void MapRenderer::changeEditState(const Model::EditStateChangeSet& changeSet) {
             m_entityRenderer->addEntities(changeSet.entitiesTo(Model::EditState::Default));
             m_entityRenderer->removeEntities(changeSet.entitiesFrom(Model::EditState::Default));
@@ -382,15 +657,12 @@ namespace TrenchBroom {
         }
         
         void MapRenderer::clear() {
-            delete m_faceRenderer;
-            m_faceRenderer = NULL;
+            clearGeometryCells();
             delete m_selectedFaceRenderer;
             m_selectedFaceRenderer = NULL;
             delete m_lockedFaceRenderer;
             m_lockedFaceRenderer = NULL;
             
-            delete m_edgeRenderer;
-            m_edgeRenderer = NULL;
             delete m_selectedEdgeRenderer;
             m_selectedEdgeRenderer = NULL;
             delete m_lockedEdgeRenderer;
@@ -406,12 +678,11 @@ namespace TrenchBroom {
         
         MapRenderer::MapRenderer(Model::MapDocument& document) :
         m_document(document),
+        m_occlusionBuffer(new OcclusionBuffer()),
         m_faceVbo(NULL),
-        m_faceRenderer(NULL),
         m_selectedFaceRenderer(NULL),
         m_lockedFaceRenderer(NULL),
         m_edgeVbo(NULL),
-        m_edgeRenderer(NULL),
         m_selectedEdgeRenderer(NULL),
         m_lockedEdgeRenderer(NULL),
         m_entityVbo(NULL),
@@ -421,6 +692,7 @@ namespace TrenchBroom {
         m_utilityVbo(NULL),
         m_pointTraceRenderer(NULL),
         m_overrideSelectionColors(false),
+        m_transformSelection(false),
         m_rendering(false),
         m_geometryDataValid(false),
         m_selectedGeometryDataValid(false),
@@ -434,6 +706,7 @@ namespace TrenchBroom {
             
             m_entityRenderer = new EntityRenderer(*m_entityVbo, m_document);
             m_entityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
+            m_entityRenderer->setModelLodDistance(prefs.getFloat(Preferences::EntityModelLodDistance));
             m_entityRenderer->setClassnameColor(prefs.getColor(Preferences::InfoOverlayTextColor), prefs.getColor(Preferences::InfoOverlayBackgroundColor));
             
             m_selectedEntityRenderer = new EntityRenderer(*m_entityVbo, m_document);
@@ -446,6 +719,7 @@ namespace TrenchBroom {
             
             m_lockedEntityRenderer = new EntityRenderer(*m_entityVbo, m_document);
             m_lockedEntityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
+            m_lockedEntityRenderer->setModelLodDistance(prefs.getFloat(Preferences::EntityModelLodDistance));
             m_lockedEntityRenderer->setClassnameColor(prefs.getColor(Preferences::LockedInfoOverlayTextColor), prefs.getColor(Preferences::LockedInfoOverlayBackgroundColor));
             m_lockedEntityRenderer->setBoundsColor(prefs.getColor(Preferences::LockedEntityBoundsColor));
             m_lockedEntityRenderer->setTintColor(prefs.getColor(Preferences::LockedEntityColor));
@@ -472,22 +746,37 @@ namespace TrenchBroom {
             m_lockedEdgeRenderer = NULL;
             delete m_selectedEdgeRenderer;
             m_selectedEdgeRenderer = NULL;
-            delete m_edgeRenderer;
-            m_edgeRenderer = NULL;
             delete m_edgeVbo;
             m_edgeVbo = NULL;
             delete m_lockedFaceRenderer;
             m_lockedFaceRenderer = NULL;
             delete m_selectedFaceRenderer;
             m_selectedFaceRenderer = NULL;
-            delete m_faceRenderer;
-            m_faceRenderer = NULL;
+            clearGeometryCells();
             delete m_faceVbo;
             m_faceVbo = NULL;
             delete m_utilityVbo;
             m_utilityVbo = NULL;
+            delete m_occlusionBuffer;
+            m_occlusionBuffer = NULL;
         }
 
+        void MapRenderer::setSelectionTransformation(const Mat4f& transformation) {
+            m_transformSelection = true;
+            m_selectionTransformation = transformation;
+            
+            EntityDecorator::List::const_iterator decoratorIt, decoratorEnd;
+            for (decoratorIt = m_entityDecorators.begin(), decoratorEnd = m_entityDecorators.end(); decoratorIt != decoratorEnd; ++decoratorIt) {
+                EntityDecorator& decorator = **decoratorIt;
+                decorator.setSelectionTransformation(transformation);
+            }
+        }
+        
+        void MapRenderer::clearSelectionTransformation() {
+            setSelectionTransformation(Mat4f::Identity);
+            m_transformSelection = false;
+        }
+        
         void MapRenderer::update(const Controller::Command& command) {
             switch (command.type()) {
                 case Controller::Command::LoadMap: {
@@ -495,6 +784,12 @@ namespace TrenchBroom {
                     m_entityRenderer->addEntities(m_document.map().entities());
                     break;
                 }
+                case Controller::Command::LoadMapBatch: {
+                    const Controller::LoadMapBatchEvent& batchEvent = static_cast<const Controller::LoadMapBatchEvent&>(command);
+                    m_entityRenderer->addEntities(batchEvent.addedEntities());
+                    invalidateBrushes();
+                    break;
+                }
                 case Controller::Command::ClearMap: {
                     clear();
                     break;
@@ -514,6 +809,27 @@ namespace TrenchBroom {
                     const Controller::PreferenceChangeEvent& preferenceChangeEvent = static_cast<const Controller::PreferenceChangeEvent&>(command);
                     if (preferenceChangeEvent.isPreferenceChanged(Preferences::QuakePath))
                         invalidateEntityModelRendererCache();
+                    if (preferenceChangeEvent.isPreferenceChanged(Preferences::InfoOverlayFadeDistance)) {
+                        Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+                        m_entityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
+                        m_lockedEntityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
+                    }
+                    if (preferenceChangeEvent.isPreferenceChanged(Preferences::EntityModelLodDistance)) {
+                        Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+                        m_entityRenderer->setModelLodDistance(prefs.getFloat(Preferences::EntityModelLodDistance));
+                        m_lockedEntityRenderer->setModelLodDistance(prefs.getFloat(Preferences::EntityModelLodDistance));
+                    }
+                    break;
+                }
+                case Controller::Command::SetEntityDefinitionFile: {
+                    const Controller::EntityDefinitionChangeEvent& changeEvent = static_cast<const Controller::EntityDefinitionChangeEvent&>(command);
+                    const Model::EntityList& changedEntities = changeEvent.changedEntities();
+                    if (!changedEntities.empty()) {
+                        m_entityRenderer->updateEntities(changedEntities);
+                        m_selectedEntityRenderer->updateEntities(changedEntities);
+                        m_lockedEntityRenderer->updateEntities(changedEntities);
+                        invalidateDecorators();
+                    }
                     break;
                 }
                 case Controller::Command::SetFaceAttributes:
@@ -589,6 +905,8 @@ namespace TrenchBroom {
                 return;
             m_rendering = true;
             
+            Utility::ScopedTimer timer("MapRenderer::render");
+            
             validate(context);
             
             glEnable(GL_BLEND);
@@ -600,6 +918,8 @@ namespace TrenchBroom {
             glShadeModel(GL_SMOOTH);
             glResetEdgeOffset();
             
+            cullGeometryCells(context);
+            
             if (context.viewOptions().showBrushes() && context.viewOptions().faceRenderMode() != View::ViewOptions::Discard)
                 renderFaces(context);
             
@@ -608,8 +928,13 @@ namespace TrenchBroom {
             
             if (context.viewOptions().showEntities()) {
                 m_entityRenderer->render(context);
-                if (context.viewOptions().renderSelection())
+                if (context.viewOptions().renderSelection()) {
+                    // the classnames are placed in screen space and would not follow the transformation
+                    ApplyModelMatrix applyTransformation(context.transformation(), m_selectionTransformation);
+                    m_selectedEntityRenderer->setRenderClassnames(!m_transformSelection);
+                    m_selectedEntityRenderer->setFrustumCulling(!m_transformSelection);
                     m_selectedEntityRenderer->render(context);
+                }
                 m_lockedEntityRenderer->render(context);
                 renderDecorators(context);
             }
@@ -617,6 +942,11 @@ namespace TrenchBroom {
             if (m_pointTraceRenderer != NULL)
                 m_pointTraceRenderer->render(*m_utilityVbo, context);
             
+            if (context.viewOptions().showOccludedCells())
+                renderOccludedGeometryCells(context);
+            
+            compactVbos();
+            
             m_rendering = false;
         }
     }
@@ -52,6 +52,7 @@ namespace TrenchBroom {
         class EntityRenderer;
         class FaceRenderer;
         class Figure;
+        class OcclusionBuffer;
         class PointTraceRenderer;
         class RenderContext;
         class Shader;
@@ -68,17 +69,41 @@ namespace TrenchBroom {
             typedef TexturedPolygonSorter<Model::Texture, Model::Face*> FaceSorter;
             typedef FaceSorter::PolygonCollection FaceCollection;
             typedef FaceSorter::PolygonCollectionMap FaceCollectionMap;
+            
+            /**
+             * The faces and edges of the unselected brushes whose centers lie in one cell of a regular grid. The
+             * cell is skipped if its bounds, which enclose all of its brushes, are outside of the view frustum or
+             * hidden behind occluders. The large opaque faces of the cell's brushes are its occluder candidates.
+             */
+            class GeometryCell {
+            public:
+                typedef std::vector<GeometryCell*> List;
+                
+                BBoxf bounds;
+                FaceRenderer* faceRenderer;
+                EdgeRenderer* edgeRenderer;
+                Model::FaceList occluders;
+                
+                GeometryCell(const BBoxf& i_bounds, FaceRenderer* i_faceRenderer, EdgeRenderer* i_edgeRenderer, const Model::FaceList& i_occluders) :
+                bounds(i_bounds),
+                faceRenderer(i_faceRenderer),
+                edgeRenderer(i_edgeRenderer),
+                occluders(i_occluders) {}
+            };
         private:
             Model::MapDocument& m_document;
             
             // level geometry rendering
+            GeometryCell::List m_geometryCells;
+            GeometryCell::List m_visibleGeometryCells;
+            GeometryCell::List m_occludedGeometryCells;
+            OcclusionBuffer* m_occlusionBuffer;
+            
             Vbo* m_faceVbo;
-            FaceRenderer* m_faceRenderer;
             FaceRenderer* m_selectedFaceRenderer;
             FaceRenderer* m_lockedFaceRenderer;
             
             Vbo* m_edgeVbo;
-            EdgeRenderer* m_edgeRenderer;
             EdgeRenderer* m_selectedEdgeRenderer;
             EdgeRenderer* m_lockedEdgeRenderer;
             
@@ -96,19 +121,27 @@ namespace TrenchBroom {
             Color m_selectedEdgeColor;
             Color m_occludedSelectedEdgeColor;
             
+            bool m_transformSelection;
+            Mat4f m_selectionTransformation;
+            
             // state
             bool m_rendering;
             bool m_geometryDataValid;
             bool m_selectedGeometryDataValid;
             bool m_lockedGeometryDataValid;
             
+            void clearGeometryCells();
             void rebuildGeometryData(RenderContext& context);
             
             void validate(RenderContext& context);
             
+            bool rasterizeOccluders(RenderContext& context);
+            void cullGeometryCells(RenderContext& context);
             void renderFaces(RenderContext& context);
             void renderEdges(RenderContext& context);
             void renderDecorators(RenderContext& context);
+            void renderOccludedGeometryCells(RenderContext& context);
+            void compactVbos();
 
             void changeEditState(const Model::EditStateChangeSet& changeSet);
             void invalidateEntities();
@@ -135,6 +168,17 @@ namespace TrenchBroom {
                 m_occludedSelectedEdgeColor = occludedEdgeColor;
             }
             
+            /**
+             * Renders the selected objects transformed by the given matrix without changing their geometry data.
+             * Used to preview a transformation while the user drags the selection.
+             */
+            void setSelectionTransformation(const Mat4f& transformation);
+            void clearSelectionTransformation();
+            
+            inline const Mat4f& selectionTransformation() const {
+                return m_selectionTransformation;
+            }
+            
             void update(const Controller::Command& command);
 
             void setPointTrace(const Vec3f::List& points);
@@ -0,0 +1,281 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        static inline int clampPixel(int value, int max) {
+            return std::max(0, std::min(value, max));
+        }
+        
+        void OcclusionBuffer::addPolygon(const Vec3f::List& vertices) {
+            const size_t count = vertices.size();
+            
+            // the depth plane is computed from the largest triangle of a fan
+            float area2 = 0.0f;
+            float triangleArea2 = 0.0f;
+            size_t triangle = 0;
+            for (size_t i = 1; i < count - 1; i++) {
+                const Vec3f& v0 = vertices[0];
+                const Vec3f& v1 = vertices[i];
+                const Vec3f& v2 = vertices[i + 1];
+                const float currentArea2 = (v1.x() - v0.x()) * (v2.y() - v0.y()) - (v1.y() - v0.y()) * (v2.x() - v0.x());
+                area2 += currentArea2;
+                if (std::abs(currentArea2) > std::abs(triangleArea2)) {
+                    triangleArea2 = currentArea2;
+                    triangle = i;
+                }
+            }
+            
+            if (Math<float>::zero(area2) || Math<float>::zero(triangleArea2))
+                return;
+            
+            Occluder occluder;
+            const Vec3f& v0 = vertices[0];
+            const Vec3f& v1 = vertices[triangle];
+            const Vec3f& v2 = vertices[triangle + 1];
+            
+            // the depth plane, moved back to the farthest depth within each pixel
+            occluder.depthX = ((v1.z() - v0.z()) * (v2.y() - v0.y()) - (v2.z() - v0.z()) * (v1.y() - v0.y())) / triangleArea2;
+            occluder.depthY = ((v2.z() - v0.z()) * (v1.x() - v0.x()) - (v1.z() - v0.z()) * (v2.x() - v0.x())) / triangleArea2;
+            occluder.depthC = v0.z() - occluder.depthX * v0.x() - occluder.depthY * v0.y();
+            occluder.depthC += 0.5f * (std::abs(occluder.depthX) + std::abs(occluder.depthY));
+            
+            // the edge functions, moved inwards so that they are negative at the center of every pixel which an edge
+            // passes through
+            const float sign = area2 > 0.0f ? 1.0f : -1.0f;
+            occluder.firstEdge = m_edges.size();
+            for (size_t i = 0; i < count; i++) {
+                Edge edge(vertices[i], vertices[(i + 1) % count], sign);
+                if (edge.a == 0.0f && edge.b == 0.0f)
+                    continue;
+                edge.c -= 0.5f * (std::abs(edge.a) + std::abs(edge.b));
+                m_edges.push_back(edge);
+            }
+            occluder.edgeCount = m_edges.size() - occluder.firstEdge;
+            
+            float minX = vertices[0].x();
+            float minY = vertices[0].y();
+            float maxX = vertices[0].x();
+            float maxY = vertices[0].y();
+            for (size_t i = 1; i < count; i++) {
+                minX = std::min(minX, vertices[i].x());
+                minY = std::min(minY, vertices[i].y());
+                maxX = std::max(maxX, vertices[i].x());
+                maxY = std::max(maxY, vertices[i].y());
+            }
+            
+            const int pixelMaxX = static_cast<int>(Width) - 1;
+            const int pixelMaxY = static_cast<int>(Height) - 1;
+            occluder.minX = clampPixel(static_cast<int>(std::floor(minX)), pixelMaxX);
+            occluder.minY = clampPixel(static_cast<int>(std::floor(minY)), pixelMaxY);
+            occluder.maxX = clampPixel(static_cast<int>(std::ceil(maxX)), pixelMaxX);
+            occluder.maxY = clampPixel(static_cast<int>(std::ceil(maxY)), pixelMaxY);
+            
+            const size_t index = m_occluders.size();
+            m_occluders.push_back(occluder);
+            
+            const size_t firstBand = static_cast<size_t>(occluder.minY) / TileSize;
+            const size_t lastBand = static_cast<size_t>(occluder.maxY) / TileSize;
+            for (size_t band = firstBand; band <= lastBand; band++)
+                m_bandOccluders[band].push_back(index);
+        }
+        
+        bool OcclusionBuffer::visible(int minX, int minY, int maxX, int maxY, float depth) const {
+            const int firstTileX = minX / static_cast<int>(TileSize);
+            const int firstTileY = minY / static_cast<int>(TileSize);
+            const int lastTileX = maxX / static_cast<int>(TileSize);
+            const int lastTileY = maxY / static_cast<int>(TileSize);
+            
+            for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+                for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+                    if (m_tileDepth[static_cast<size_t>(tileY) * TilesPerRow + static_cast<size_t>(tileX)] < depth)
+                        continue;
+                    
+                    // the tile is not completely hidden, so look at its pixels within the given bounds
+                    const int startX = std::max(minX, tileX * static_cast<int>(TileSize));
+                    const int startY = std::max(minY, tileY * static_cast<int>(TileSize));
+                    const int endX = std::min(maxX, (tileX + 1) * static_cast<int>(TileSize) - 1);
+                    const int endY = std::min(maxY, (tileY + 1) * static_cast<int>(TileSize) - 1);
+                    for (int y = startY; y <= endY; y++) {
+                        const float* row = &m_depth[static_cast<size_t>(y) * Width];
+                        for (int x = startX; x <= endX; x++)
+                            if (row[x] >= depth)
+                                return true;
+                    }
+                }
+            }
+            return false;
+        }
+        
+        OcclusionBuffer::OcclusionBuffer() :
+        m_depth(Width * Height, 1.0f),
+        m_tileDepth(TilesPerRow * BandCount, 1.0f) {}
+        
+        void OcclusionBuffer::reset(const Mat4f& matrix) {
+            m_matrix = matrix;
+            m_edges.clear();
+            m_occluders.clear();
+            for (size_t i = 0; i < BandCount; i++)
+                m_bandOccluders[i].clear();
+        }
+        
+        void OcclusionBuffer::addOccluder(const Vec3f::List& vertices) {
+            if (vertices.size() < 3)
+                return;
+            
+            // clip the polygon in clip coordinates against the near plane, where z + w = 0
+            Vec4f::List clipVertices;
+            clipVertices.reserve(vertices.size() + 1);
+            
+            Vec4f previous = m_matrix * Vec4f(vertices.back(), 1.0f);
+            for (size_t i = 0; i < vertices.size(); i++) {
+                const Vec4f current = m_matrix * Vec4f(vertices[i], 1.0f);
+                const float previousDistance = previous.z() + previous.w();
+                const float currentDistance = current.z() + current.w();
+                if ((previousDistance >= 0.0f) != (currentDistance >= 0.0f)) {
+                    const float t = previousDistance / (previousDistance - currentDistance);
+                    clipVertices.push_back(previous + (current - previous) * t);
+                }
+                if (currentDistance >= 0.0f)
+                    clipVertices.push_back(current);
+                previous = current;
+            }
+            
+            if (clipVertices.size() < 3)
+                return;
+            
+            Vec3f::List screenVertices;
+            screenVertices.reserve(clipVertices.size());
+            for (size_t i = 0; i < clipVertices.size(); i++) {
+                const Vec4f& clipVertex = clipVertices[i];
+                if (clipVertex.w() <= 0.0f)
+                    return;
+                const Vec3f ndc = clipVertex.overLast();
+                screenVertices.push_back(Vec3f((ndc.x() + 1.0f) * 0.5f * static_cast<float>(Width),
+                                               (ndc.y() + 1.0f) * 0.5f * static_cast<float>(Height),
+                                               (ndc.z() + 1.0f) * 0.5f));
+            }
+            
+            addPolygon(screenVertices);
+        }
+        
+        void OcclusionBuffer::rasterizeBand(const size_t band) {
+            assert(band < BandCount);
+            
+            const int bandMinY = static_cast<int>(band * TileSize);
+            const int bandMaxY = bandMinY + static_cast<int>(TileSize) - 1;
+            float* bandDepth = &m_depth[band * TileSize * Width];
+            std::fill(bandDepth, bandDepth + TileSize * Width, 1.0f);
+            
+            const IndexList& occluderIndices = m_bandOccluders[band];
+            for (size_t i = 0; i < occluderIndices.size(); i++) {
+                const Occluder& occluder = m_occluders[occluderIndices[i]];
+                const int minY = std::max(occluder.minY, bandMinY);
+                const int maxY = std::min(occluder.maxY, bandMaxY);
+                for (int y = minY; y <= maxY; y++) {
+                    const float centerY = static_cast<float>(y) + 0.5f;
+                    
+                    // find the span of pixels whose centers lie on the inner side of all edges
+                    float firstX = static_cast<float>(occluder.minX);
+                    float lastX = static_cast<float>(occluder.maxX);
+                    for (size_t j = 0; j < occluder.edgeCount && firstX <= lastX; j++) {
+                        const Edge& edge = m_edges[occluder.firstEdge + j];
+                        const float value = edge.b * centerY + edge.c;
+                        if (edge.a > 0.0f)
+                            firstX = std::max(firstX, std::ceil(-value / edge.a - 0.5f));
+                        else if (edge.a < 0.0f)
+                            lastX = std::min(lastX, std::floor(-value / edge.a - 0.5f));
+                        else if (value < 0.0f)
+                            lastX = firstX - 1.0f;
+                    }
+                    
+                    if (firstX > lastX)
+                        continue;
+                    
+                    const int startX = static_cast<int>(firstX);
+                    const int endX = static_cast<int>(lastX);
+                    float depth = occluder.depthX * (static_cast<float>(startX) + 0.5f) + occluder.depthY * centerY + occluder.depthC;
+                    
+                    float* row = &m_depth[static_cast<size_t>(y) * Width];
+                    for (int x = startX; x <= endX; x++) {
+                        row[x] = std::min(row[x], depth);
+                        depth += occluder.depthX;
+                    }
+                }
+            }
+            
+            // record the farthest depth of every tile in this band
+            float* tileDepth = &m_tileDepth[band * TilesPerRow];
+            for (size_t tileX = 0; tileX < TilesPerRow; tileX++) {
+                float maxDepth = 0.0f;
+                for (size_t y = 0; y < TileSize; y++) {
+                    const float* row = bandDepth + y * Width + tileX * TileSize;
+                    for (size_t x = 0; x < TileSize; x++)
+                        maxDepth = std::max(maxDepth, row[x]);
+                }
+                tileDepth[tileX] = maxDepth;
+            }
+        }
+        
+        void OcclusionBuffer::rasterize() {
+            for (size_t band = 0; band < BandCount; band++)
+                rasterizeBand(band);
+        }
+        
+        bool OcclusionBuffer::visible(const BBoxf& bounds) const {
+            float minX = std::numeric_limits<float>::max();
+            float minY = std::numeric_limits<float>::max();
+            float maxX = -std::numeric_limits<float>::max();
+            float maxY = -std::numeric_limits<float>::max();
+            float minDepth = std::numeric_limits<float>::max();
+            
+            for (size_t i = 0; i < 8; i++) {
+                const Vec4f clipVertex = m_matrix * Vec4f(bounds.vertex(i), 1.0f);
+                if (clipVertex.z() + clipVertex.w() <= 0.0f || clipVertex.w() <= 0.0f)
+                    return true;
+                
+                const Vec3f ndc = clipVertex.overLast();
+                const float x = (ndc.x() + 1.0f) * 0.5f * static_cast<float>(Width);
+                const float y = (ndc.y() + 1.0f) * 0.5f * static_cast<float>(Height);
+                minX = std::min(minX, x);
+                minY = std::min(minY, y);
+                maxX = std::max(maxX, x);
+                maxY = std::max(maxY, y);
+                minDepth = std::min(minDepth, (ndc.z() + 1.0f) * 0.5f);
+            }
+            
+            if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(Width) || minY >= static_cast<float>(Height))
+                return false;
+            
+            const int pixelMaxX = static_cast<int>(Width) - 1;
+            const int pixelMaxY = static_cast<int>(Height) - 1;
+            return visible(clampPixel(static_cast<int>(std::floor(minX)), pixelMaxX),
+                           clampPixel(static_cast<int>(std::floor(minY)), pixelMaxY),
+                           clampPixel(static_cast<int>(std::floor(maxX)), pixelMaxX),
+                           clampPixel(static_cast<int>(std::floor(maxY)), pixelMaxY),
+                           minDepth);
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__OcclusionBuffer__
+#define __TrenchBroom__OcclusionBuffer__
+
+#include "Utility/VecMath.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Renderer {
+        /**
+         * A small depth buffer which is rendered on the CPU for occlusion culling. Large occluder polygons are
+         * rasterized into it, and the screen space bounds of other objects are then tested against it before they
+         * are drawn. Occluders are rasterized conservatively: they only write the pixels which they cover completely,
+         * and they write the farthest depth within each pixel. Pixels at the silhouettes of the occluders, including
+         * gaps between adjacent occluders which are narrower than a pixel, are therefore never hidden.
+         *
+         * The rows of the buffer are divided into bands, which can be rasterized concurrently. Every band also
+         * records the farthest depth of each of its tiles, which is tested first.
+         */
+        class OcclusionBuffer {
+        public:
+            static const size_t Width = 256;
+            static const size_t Height = 128;
+            static const size_t TileSize = 8;
+            static const size_t TilesPerRow = Width / TileSize;
+            static const size_t BandCount = Height / TileSize;
+        private:
+            /**
+             * An edge function which is non-negative on the inner side of the edge.
+             */
+            class Edge {
+            public:
+                float a;
+                float b;
+                float c;
+                
+                Edge() : a(0.0f), b(0.0f), c(0.0f) {}
+                
+                Edge(const Vec3f& start, const Vec3f& end, float sign) :
+                a(sign * (start.y() - end.y())),
+                b(sign * (end.x() - start.x())),
+                c(sign * (start.x() * end.y() - start.y() * end.x())) {}
+                
+                inline float value(float x, float y) const {
+                    return a * x + b * y + c;
+                }
+            };
+            
+            typedef std::vector<Edge> EdgeList;
+            
+            /**
+             * A projected convex occluder polygon with the range of its edge functions, its depth plane and its pixel
+             * bounds. The edge functions are moved inwards by half a pixel, so that they are non-negative at the
+             * centers of the pixels which the polygon covers completely.
+             */
+            class Occluder {
+            public:
+                typedef std::vector<Occluder> List;
+                
+                size_t firstEdge;
+                size_t edgeCount;
+                float depthX;
+                float depthY;
+                float depthC;
+                int minX;
+                int minY;
+                int maxX;
+                int maxY;
+            };
+            
+            typedef std::vector<size_t> IndexList;
+            
+            Mat4f m_matrix;
+            EdgeList m_edges;
+            Occluder::List m_occluders;
+            IndexList m_bandOccluders[BandCount];
+            std::vector<float> m_depth;
+            std::vector<float> m_tileDepth;
+            
+            void addPolygon(const Vec3f::List& vertices);
+            bool visible(int minX, int minY, int maxX, int maxY, float depth) const;
+        public:
+            OcclusionBuffer();
+            
+            /**
+             * Removes all occluders and sets the matrix which transforms world coordinates to clip coordinates.
+             */
+            void reset(const Mat4f& matrix);
+            
+            /**
+             * Adds the given convex polygon, which is clipped against the near plane.
+             */
+            void addOccluder(const Vec3f::List& vertices);
+            
+            /**
+             * Rasterizes the occluders which overlap the given band. Different bands may be rasterized concurrently.
+             */
+            void rasterizeBand(size_t band);
+            
+            /**
+             * Rasterizes all bands on the calling thread.
+             */
+            void rasterize();
+            
+            /**
+             * Returns false if the given bounds are completely hidden by the rasterized occluders or lie outside of
+             * the screen. Bounds which reach behind the near plane are always visible.
+             */
+            bool visible(const BBoxf& bounds) const;
+            
+            inline size_t occluderCount() const {
+                return m_occluders.size();
+            }
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__OcclusionBuffer__) */
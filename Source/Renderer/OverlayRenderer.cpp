@@ -20,20 +20,144 @@
 #include "OverlayRenderer.h"
 
 #include "Renderer/ApplyMatrix.h"
+#include "Renderer/Camera.h"
 #include "Renderer/CompassRenderer.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/Vbo.h"
+#include "Renderer/Shader/Shader.h"
+#include "Renderer/Shader/ShaderManager.h"
+#include "Renderer/Text/FontManager.h"
+#include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
+#include "Utility/String.h"
 #include "Utility/VecMath.h"
 
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Renderer {
-        OverlayRenderer::OverlayRenderer() :
+        const Vec3f OverlayTextAnchor::basePosition() const {
+            return m_camera.unproject(m_x, m_y, 0.1f);
+        }
+        
+        const Text::Alignment::Type OverlayTextAnchor::alignment() const {
+            return Text::Alignment::Top | Text::Alignment::Left;
+        }
+        
+        OverlayTextAnchor::OverlayTextAnchor(const Camera& camera, float x, float y) :
+        m_camera(camera),
+        m_x(x),
+        m_y(y) {}
+        
+        class CompareStatisticsByTotal {
+        public:
+            inline bool operator() (const Utility::Profiler::StatisticMap::value_type* left, const Utility::Profiler::StatisticMap::value_type* right) const {
+                if (left->second.type != right->second.type)
+                    return left->second.type == Utility::Profiler::TimerEvent;
+                return left->second.total > right->second.total;
+            }
+        };
+        
+        void OverlayRenderer::renderCompass(RenderContext& context, const float viewWidth, const float viewHeight) {
+            if (m_compass == NULL)
+                m_compass = new CompassRenderer();
+            
+            const Mat4f projection = orthoMatrix(0.0f, 1000.0f, -viewWidth / 2.0f, viewHeight / 2.0f, viewWidth / 2.0f, -viewHeight / 2.0f);
+            const Mat4f view = viewMatrix(Vec3f::PosY, Vec3f::PosZ) * translationMatrix(500.0f * Vec3f::PosY);
+            Renderer::ApplyTransformation ortho(context.transformation(), projection, view);
+            
+            const Mat4f compassTransformation = translationMatrix(Vec3f(-viewWidth / 2.0f + 50.0f, 0.0f, -viewHeight / 2.0f + 50.0f)) * scalingMatrix(2.0f);
+            Renderer::ApplyModelMatrix applyCompassTranslate(context.transformation(), compassTransformation);
+            
+            m_compass->render(*m_vbo, context);
+        }
+        
+        void OverlayRenderer::updateProfiler(RenderContext& context) {
+            static const size_t MaxLines = 32;
+            
+            Utility::Profiler& profiler = *Utility::Profiler::sharedProfiler;
+            profiler.collect();
+            
+            if (m_profilerRenderer == NULL) {
+                Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+                const String& fontName = prefs.getString(Preferences::RendererFontName);
+                const int fontSize = prefs.getInt(Preferences::RendererFontSize);
+                
+                Text::TexturedFont* font = m_fontManager.font(Text::FontDescriptor(fontName, static_cast<unsigned int>(fontSize)));
+                assert(font != NULL);
+                
+                m_profilerRenderer = new Text::TextRenderer<size_t>(*font);
+                m_profilerRenderer->setFadeDistance(1000.0f);
+                m_profilerWindow = profiler.windowCount() + 1;
+            }
+            
+            if (m_profilerWindow == profiler.windowCount())
+                return;
+            m_profilerWindow = profiler.windowCount();
+            
+            typedef std::vector<const Utility::Profiler::StatisticMap::value_type*> StatisticList;
+            const Utility::Profiler::StatisticMap& statistics = profiler.statistics();
+            StatisticList sorted;
+            
+            Utility::Profiler::StatisticMap::const_iterator it, end;
+            for (it = statistics.begin(), end = statistics.end(); it != end; ++it)
+                sorted.push_back(&*it);
+            std::sort(sorted.begin(), sorted.end(), CompareStatisticsByTotal());
+            
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            const float lineHeight = static_cast<float>(prefs.getInt(Preferences::RendererFontSize)) + 12.0f;
+            
+            m_profilerRenderer->clear();
+            m_profilerRenderer->addString(0, "Profiler (last second)", Text::TextAnchor::Ptr(new OverlayTextAnchor(context.camera(), 10.0f, 10.0f)));
+            
+            for (size_t i = 0; i < sorted.size() && i < MaxLines; i++) {
+                const String& name = sorted[i]->first;
+                const Utility::Profiler::Statistic& statistic = sorted[i]->second;
+                
+                StringStream buffer;
+                buffer.setf(std::ios::fixed);
+                buffer << std::setprecision(2) << name << ": ";
+                if (statistic.type == Utility::Profiler::TimerEvent) {
+                    const double average = static_cast<double>(statistic.total) / static_cast<double>(statistic.count) / 1000.0;
+                    const double max = static_cast<double>(statistic.max) / 1000.0;
+                    buffer << statistic.count << "x, avg " << average << "ms, max " << max << "ms";
+                } else {
+                    buffer << statistic.last << " (max " << statistic.max << ")";
+                }
+                
+                const float y = 10.0f + static_cast<float>(i + 1) * lineHeight;
+                m_profilerRenderer->addString(i + 1, buffer.str(), Text::TextAnchor::Ptr(new OverlayTextAnchor(context.camera(), 10.0f, y)));
+            }
+        }
+        
+        void OverlayRenderer::renderProfiler(RenderContext& context) {
+            updateProfiler(context);
+            
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            const Color& textColor = prefs.getColor(Preferences::InfoOverlayTextColor);
+            const Color& backgroundColor = prefs.getColor(Preferences::InfoOverlayBackgroundColor);
+            ShaderProgram& textShader = context.shaderManager().shaderProgram(Shaders::TextShader);
+            ShaderProgram& backgroundShader = context.shaderManager().shaderProgram(Shaders::TextBackgroundShader);
+            
+            glDisable(GL_DEPTH_TEST);
+            m_profilerRenderer->render(context, m_profilerFilter, textShader, textColor, backgroundShader, backgroundColor);
+            glEnable(GL_DEPTH_TEST);
+        }
+        
+        OverlayRenderer::OverlayRenderer(Text::FontManager& fontManager) :
         m_vbo(NULL),
-        m_compass(NULL) {}
+        m_compass(NULL),
+        m_fontManager(fontManager),
+        m_profilerRenderer(NULL),
+        m_profilerWindow(0) {}
 
         OverlayRenderer::~OverlayRenderer() {
+            delete m_profilerRenderer;
+            m_profilerRenderer = NULL;
             delete m_compass;
             m_compass = NULL;
             delete m_vbo;
@@ -43,19 +167,12 @@ namespace TrenchBroom {
         void OverlayRenderer::render(RenderContext& context, const float viewWidth, const float viewHeight) {
             if (m_vbo == NULL)
                 m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
-            if (m_compass == NULL)
-                m_compass = new CompassRenderer();
 
             glClear(GL_DEPTH_BUFFER_BIT);
-
-            const Mat4f projection = orthoMatrix(0.0f, 1000.0f, -viewWidth / 2.0f, viewHeight / 2.0f, viewWidth / 2.0f, -viewHeight / 2.0f);
-            const Mat4f view = viewMatrix(Vec3f::PosY, Vec3f::PosZ) * translationMatrix(500.0f * Vec3f::PosY);
-            Renderer::ApplyTransformation ortho(context.transformation(), projection, view);
-
-            const Mat4f compassTransformation = translationMatrix(Vec3f(-viewWidth / 2.0f + 50.0f, 0.0f, -viewHeight / 2.0f + 50.0f)) * scalingMatrix(2.0f);
-            Renderer::ApplyModelMatrix applyCompassTranslate(context.transformation(), compassTransformation);
-
-            m_compass->render(*m_vbo, context);
+            renderCompass(context, viewWidth, viewHeight);
+            
+            if (Utility::Profiler::enabled())
+                renderProfiler(context);
         }
     }
 }
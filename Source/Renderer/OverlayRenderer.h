@@ -20,20 +20,54 @@
 #ifndef __TrenchBroom__OverlayRenderer__
 #define __TrenchBroom__OverlayRenderer__
 
+#include "Renderer/Text/TextRenderer.h"
+
 #include <iostream>
 
 namespace TrenchBroom {
     namespace Renderer {
+        namespace Text {
+            class FontManager;
+        }
+        
+        class Camera;
         class CompassRenderer;
         class RenderContext;
         class Vbo;
         
+        /**
+         * Anchors a text to a fixed position in window coordinates, measured from the top left corner of the view.
+         */
+        class OverlayTextAnchor : public Text::TextAnchor {
+        private:
+            const Camera& m_camera;
+            float m_x;
+            float m_y;
+        protected:
+            const Vec3f basePosition() const;
+            const Text::Alignment::Type alignment() const;
+        public:
+            OverlayTextAnchor(const Camera& camera, float x, float y);
+        };
+        
         class OverlayRenderer {
         private:
             Vbo* m_vbo;
             CompassRenderer* m_compass;
+            Text::FontManager& m_fontManager;
+            Text::TextRenderer<size_t>* m_profilerRenderer;
+            Text::TextRenderer<size_t>::SimpleTextRendererFilter m_profilerFilter;
+            size_t m_profilerWindow;
+            
+            void renderCompass(RenderContext& context, const float viewWidth, const float viewHeight);
+            void updateProfiler(RenderContext& context);
+            void renderProfiler(RenderContext& context);
+            
+            // prevent copying
+            OverlayRenderer(const OverlayRenderer& other);
+            void operator= (const OverlayRenderer& other);
         public:
-            OverlayRenderer();
+            OverlayRenderer(Text::FontManager& fontManager);
             ~OverlayRenderer();
             
             void render(RenderContext& context, const float viewWidth, const float viewHeight);
@@ -111,6 +111,15 @@ namespace TrenchBroom {
         void InstancedPointHandleRenderer::render(Vbo& vbo, RenderContext& context) {
             SetVboState activateVbo(vbo, Vbo::VboActive);
             
+            if (valid() && !changedSlots().empty()) {
+                const Vec4f::List& positionList = positions();
+                if (m_vertexArray != NULL && !positionList.empty() &&
+                    m_vertexArray->updateAttributeArray("position", positionList, changedSlots()))
+                    validate();
+                else
+                    invalidate();
+            }
+            
             if (!valid()) {
                 delete m_vertexArray;
                 m_vertexArray = NULL;
@@ -23,6 +23,10 @@
 #include "Utility/Color.h"
 #include "Utility/VecMath.h"
 
+#include <cassert>
+#include <map>
+#include <set>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
@@ -32,8 +36,16 @@ namespace TrenchBroom {
         class Vbo;
         class VertexArray;
         
+        /**
+         * Renders a set of handles at distinct positions. Each handle occupies a slot in the instance data, and adding
+         * or removing a handle only changes the slots involved, so that the instance data can be patched in place.
+         */
         class PointHandleRenderer {
+        public:
+            typedef std::set<size_t> SlotSet;
         private:
+            typedef std::map<Vec3f, size_t, Vec3f::LexicographicOrder> SlotMap;
+            
             float m_radius;
             unsigned int m_iterations;
             float m_scalingFactor;
@@ -41,7 +53,14 @@ namespace TrenchBroom {
 
             Color m_color;
             Vec4f::List m_positions;
+            SlotMap m_slots;
+            SlotSet m_changedSlots;
             bool m_valid;
+            
+            inline void slotChanged(size_t slot) {
+                if (m_valid)
+                    m_changedSlots.insert(slot);
+            }
         protected:
             Vec3f::List sphere() const;
             
@@ -63,6 +82,19 @@ namespace TrenchBroom {
 
             inline void validate() {
                 m_valid = true;
+                m_changedSlots.clear();
+            }
+            
+            inline void invalidate() {
+                m_valid = false;
+                m_changedSlots.clear();
+            }
+            
+            /**
+             * The slots which were changed since the renderer was last validated.
+             */
+            inline const SlotSet& changedSlots() const {
+                return m_changedSlots;
             }
             
             inline const Color& color() const {
@@ -82,13 +114,42 @@ namespace TrenchBroom {
             static PointHandleRenderer* create(float radius, unsigned int iterations, float scalingFactor, float maximumDistance);
             
             inline void add(const Vec3f& position) {
-                m_positions.push_back(Vec4f(position, 0.0f));
-                m_valid = false;
+                const size_t slot = m_positions.size();
+                const bool inserted = m_slots.insert(SlotMap::value_type(position, slot)).second;
+                assert(inserted);
+                if (inserted) {
+                    m_positions.push_back(Vec4f(position, 0.0f));
+                    slotChanged(slot);
+                }
+            }
+            
+            /**
+             * Removes the handle at the given position by moving the handle in the last slot into its slot.
+             */
+            inline void remove(const Vec3f& position) {
+                SlotMap::iterator it = m_slots.find(position);
+                assert(it != m_slots.end());
+                if (it == m_slots.end())
+                    return;
+                
+                const size_t slot = it->second;
+                const size_t last = m_positions.size() - 1;
+                m_slots.erase(it);
+                if (slot != last) {
+                    const Vec4f& moved = m_positions[last];
+                    m_slots[Vec3f(moved.x(), moved.y(), moved.z())] = slot;
+                    m_positions[slot] = moved;
+                    slotChanged(slot);
+                }
+                m_positions.pop_back();
+                slotChanged(last);
             }
             
             inline void clear() {
-                m_valid &= m_positions.empty();
+                if (!m_positions.empty())
+                    invalidate();
                 m_positions.clear();
+                m_slots.clear();
             }
             
             inline void setColor(const Color& color) {
@@ -43,6 +43,7 @@ namespace TrenchBroom {
     namespace Renderer {
         class Camera;
         class ShaderManager;
+        class Vbo;
 
         class RenderContext {
         private:
@@ -50,16 +51,18 @@ namespace TrenchBroom {
             Model::Filter& m_filter;
             Transformation m_transformation;
             ShaderManager& m_shaderManager;
+            Vbo& m_streamVbo;
             Utility::Grid& m_grid;
             View::ViewOptions& m_viewOptions;
             Controller::InputState& m_inputState;
             Utility::Console& m_console;
         public:
-            RenderContext(Camera& camera, Model::Filter& filter, ShaderManager& shaderManager, Utility::Grid& grid, View::ViewOptions& viewOptions, Controller::InputState& inputState, Utility::Console& console) :
+            RenderContext(Camera& camera, Model::Filter& filter, ShaderManager& shaderManager, Vbo& streamVbo, Utility::Grid& grid, View::ViewOptions& viewOptions, Controller::InputState& inputState, Utility::Console& console) :
             m_camera(camera),
             m_filter(filter),
             m_transformation(m_camera.projectionMatrix(), m_camera.viewMatrix()),
             m_shaderManager(shaderManager),
+            m_streamVbo(streamVbo),
             m_grid(grid),
             m_viewOptions(viewOptions),
             m_inputState(inputState),
@@ -77,6 +80,14 @@ namespace TrenchBroom {
                 return m_shaderManager;
             }
 
+            /**
+             * Returns a stream VBO for geometry which is rebuilt in every frame. Its blocks must be freed before the
+             * frame ends.
+             */
+            inline Vbo& streamVbo() const {
+                return m_streamVbo;
+            }
+
             inline Utility::Grid& grid() const {
                 return m_grid;
             }
@@ -29,7 +29,8 @@ namespace TrenchBroom {
             const ShaderConfig ColoredEdgeShader = ShaderConfig("Colored Edge Shader Program", "ColoredEdge.vertsh", "Edge.fragsh");
             const ShaderConfig EdgeShader = ShaderConfig("Edge Shader Program", "Edge.vertsh", "Edge.fragsh");
             const ShaderConfig EntityModelShader = ShaderConfig("Entity Model Shader Program", "EntityModel.vertsh", "EntityModel.fragsh");
-            const ShaderConfig FaceShader = ShaderConfig("Face Shader Program", "Face.vertsh", "Face.fragsh");
+            const ShaderConfig FaceShader = ShaderConfig("Face Shader Program", "Face.vertsh", "Face.fragsh", "FaceTexture.fragsh");
+            const ShaderConfig FaceArrayShader = ShaderConfig("Face Array Shader Program", "Face.vertsh", "Face.fragsh", "FaceTextureArray.fragsh");
             const ShaderConfig TextShader = ShaderConfig("Text Shader Program", "Text.vertsh", "Text.fragsh");
             const ShaderConfig TextBackgroundShader = ShaderConfig("Text Background Shader Program", "TextBackground.vertsh", "TextBackground.fragsh");
             const ShaderConfig TextureBrowserShader = ShaderConfig("Texture Browser Shader Program", "TextureBrowser.vertsh", "TextureBrowser.fragsh");
@@ -44,6 +44,13 @@ namespace TrenchBroom {
                 m_fragmentShaders.push_back(fragmentShader);
             }
             
+            ShaderConfig(const String name, const String& vertexShader, const String& fragmentShader1, const String& fragmentShader2) :
+            m_name(name) {
+                m_vertexShaders.push_back(vertexShader);
+                m_fragmentShaders.push_back(fragmentShader1);
+                m_fragmentShaders.push_back(fragmentShader2);
+            }
+            
             inline const String& name() const {
                 return m_name;
             }
@@ -62,6 +69,7 @@ namespace TrenchBroom {
             extern const ShaderConfig EdgeShader;
             extern const ShaderConfig EntityModelShader;
             extern const ShaderConfig FaceShader;
+            extern const ShaderConfig FaceArrayShader;
             extern const ShaderConfig TextShader;
             extern const ShaderConfig TextBackgroundShader;
             extern const ShaderConfig TextureBrowserShader;
@@ -166,7 +166,7 @@ namespace TrenchBroom {
 
                 typedef std::map<Key, TextEntry, Comparator> TextMap;
                 typedef std::pair<Key, TextEntry> TextMapItem;
-                typedef std::vector<TextEntry> EntryList;
+                typedef std::vector<const TextEntry*> EntryList;
 
                 TexturedFont& m_font;
                 float m_fadeDistance;
@@ -181,22 +181,20 @@ namespace TrenchBroom {
                     m_entries.insert(TextMapItem(key, TextEntry(vertices, size, anchor)));
                 }
 
-                EntryList visibleEntries(RenderContext& context, const TextRendererFilter& filter) {
+                EntryList visibleEntries(RenderContext& context, const TextRendererFilter& filter) const {
                     float cutoff = (m_fadeDistance + 100) * (m_fadeDistance + 100);
                     EntryList result;
 
-                    typename TextMap::iterator it, end;
+                    // the distance check is cheaper than most filters, so distant strings are dropped first
+                    typename TextMap::const_iterator it, end;
                     for (it = m_entries.begin(), end = m_entries.end(); it != end; ++it) {
-                        Key key = it->first;
-                        if (filter.stringVisible(context, key)) {
-                            const TextEntry& entry = it->second;
-                            const TextAnchor& anchor = entry.textAnchor();
-                            const Vec3f position = anchor.position();
-
-                            float dist2 = context.camera().squaredDistanceTo(position);
-                            if (dist2 <= cutoff)
-                                result.push_back(entry);
-                        }
+                        const TextEntry& entry = it->second;
+                        const TextAnchor& anchor = entry.textAnchor();
+                        const Vec3f position = anchor.position();
+
+                        float dist2 = context.camera().squaredDistanceTo(position);
+                        if (dist2 <= cutoff && filter.stringVisible(context, it->first))
+                            result.push_back(&entry);
                     }
 
                     return result;
@@ -266,11 +264,11 @@ namespace TrenchBroom {
                         return;
 
                     if (m_vbo == NULL)
-                        m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
+                        m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF, Vbo::StreamUsage);
 
                     size_t textVertexCount = 0;
                     for (size_t i = 0; i < entries.size(); i++) {
-                        const TextEntry& entry = entries[i];
+                        const TextEntry& entry = *entries[i];
                         textVertexCount += entry.vertices().size() / 2;
                     }
 
@@ -284,7 +282,7 @@ namespace TrenchBroom {
 
                     SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
                     for (size_t i = 0; i < entries.size(); i++) {
-                        const TextEntry& entry = entries[i];
+                        const TextEntry& entry = *entries[i];
                         const Vec2f& size = entry.size().rounded();
                         const TextAnchor& anchor = entry.textAnchor();
                         const Vec3f offset = anchor.offset(context.camera(), size);
@@ -337,6 +335,7 @@ namespace TrenchBroom {
                     }
 
                     glDepthMask(GL_TRUE);
+                    m_vbo->endFrame();
                 }
             };
         }
@@ -0,0 +1,107 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextureArray.h"
+
+#include "Renderer/TextureRenderer.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        void TextureArray::createTexture() {
+            if (m_textureId != 0)
+                glDeleteTextures(1, &m_textureId);
+            
+            // leave room for more layers so that loading another texture collection doesn't recreate every array
+            m_capacity = 8;
+            while (m_capacity < m_layers.size())
+                m_capacity *= 2;
+            m_capacity = std::min(m_capacity, static_cast<size_t>(m_maxLayerCount));
+            m_uploadedLayerCount = 0;
+            
+            glGenTextures(1, &m_textureId);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureId);
+            glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height), static_cast<GLsizei>(m_capacity), 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        }
+        
+        void TextureArray::uploadLayers() {
+            std::vector<unsigned char> image(m_width * m_height * 3);
+            for (size_t i = m_uploadedLayerCount; i < m_layers.size(); i++) {
+                m_layers[i]->copyImage(&image[0]);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height), 1, GL_RGB, GL_UNSIGNED_BYTE, &image[0]);
+            }
+            m_uploadedLayerCount = m_layers.size();
+        }
+        
+        TextureArray::TextureArray(unsigned int width, unsigned int height) :
+        m_width(width),
+        m_height(height),
+        m_maxLayerCount(maxLayerCount()),
+        m_textureId(0),
+        m_capacity(0),
+        m_uploadedLayerCount(0) {}
+        
+        TextureArray::~TextureArray() {
+            if (m_textureId != 0) {
+                glDeleteTextures(1, &m_textureId);
+                m_textureId = 0;
+            }
+        }
+        
+        bool TextureArray::supported() {
+            return GLEW_VERSION_3_0 || GLEW_EXT_texture_array;
+        }
+        
+        unsigned int TextureArray::maxLayerCount() {
+            GLint maxLayers = 0;
+            glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+            
+            // faces may store their layer index as a half float, which is exact up to 2048
+            return static_cast<unsigned int>(std::max(std::min(maxLayers, 2048), 1));
+        }
+        
+        unsigned int TextureArray::addLayer(TextureRenderer& texture) {
+            assert(!full());
+            assert(texture.width() == m_width && texture.height() == m_height);
+            
+            m_layers.push_back(&texture);
+            return static_cast<unsigned int>(m_layers.size() - 1);
+        }
+        
+        void TextureArray::activate() {
+            if (m_textureId == 0 || m_capacity < m_layers.size())
+                createTexture();
+            else
+                glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureId);
+            
+            if (m_uploadedLayerCount < m_layers.size())
+                uploadLayers();
+        }
+        
+        void TextureArray::deactivate() {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__TextureArray__
+#define __TrenchBroom__TextureArray__
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class TextureRenderer;
+        
+        /**
+         * Holds textures of the same size as the layers of one array texture, so that faces with different textures
+         * can be drawn without switching textures. The layers are uploaded when the array is activated, and the
+         * array texture is recreated with more room when layers were added beyond its capacity.
+         */
+        class TextureArray {
+        public:
+            typedef std::vector<TextureArray*> List;
+        private:
+            typedef std::vector<TextureRenderer*> LayerList;
+            
+            unsigned int m_width;
+            unsigned int m_height;
+            unsigned int m_maxLayerCount;
+            LayerList m_layers;
+            GLuint m_textureId;
+            size_t m_capacity;
+            size_t m_uploadedLayerCount;
+            
+            void createTexture();
+            void uploadLayers();
+            
+            // prevent copying
+            TextureArray(const TextureArray& other);
+            void operator= (const TextureArray& other);
+        public:
+            TextureArray(unsigned int width, unsigned int height);
+            ~TextureArray();
+            
+            static bool supported();
+            
+            /**
+             * Returns the number of layers which an array texture can have at most.
+             */
+            static unsigned int maxLayerCount();
+            
+            inline unsigned int width() const {
+                return m_width;
+            }
+            
+            inline unsigned int height() const {
+                return m_height;
+            }
+            
+            inline bool full() const {
+                return m_layers.size() >= m_maxLayerCount;
+            }
+            
+            /**
+             * Adds the given texture, which must have the size of this array, as a new layer and returns its index.
+             */
+            unsigned int addLayer(TextureRenderer& texture);
+            
+            void activate();
+            void deactivate();
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__TextureArray__) */
@@ -24,6 +24,8 @@
 #include "Model/Alias.h"
 #include "Renderer/Palette.h"
 
+#include <cstring>
+
 namespace TrenchBroom {
     namespace Renderer {
         void TextureRenderer::init(unsigned int width, unsigned int height) {
@@ -90,5 +92,15 @@ namespace TrenchBroom {
         void TextureRenderer::deactivate() {
             glBindTexture(GL_TEXTURE_2D, 0);
         }
+        
+        void TextureRenderer::copyImage(unsigned char* rgbImage) {
+            if (m_textureBuffer != NULL) {
+                std::memcpy(rgbImage, m_textureBuffer, m_width * m_height * 3);
+            } else if (m_textureId != 0) {
+                glBindTexture(GL_TEXTURE_2D, m_textureId);
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, rgbImage);
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+        }
     }
 }
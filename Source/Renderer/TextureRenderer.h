@@ -61,6 +61,20 @@ namespace TrenchBroom {
                 return m_averageColor;
             }
             
+            inline unsigned int width() const {
+                return m_width;
+            }
+            
+            inline unsigned int height() const {
+                return m_height;
+            }
+            
+            /**
+             * Copies the RGB image of this texture into the given buffer, reading it back from the GL if it has
+             * already been uploaded.
+             */
+            void copyImage(unsigned char* rgbImage);
+            
             void activate();
             void deactivate();
         };
@@ -22,6 +22,7 @@
 #include "Model/Texture.h"
 #include "Model/TextureManager.h"
 #include "Renderer/TextureRenderer.h"
+#include "Utility/List.h"
 #include "Utility/Map.h"
 
 #include <cassert>
@@ -62,6 +63,8 @@ namespace TrenchBroom {
         }
 
         void TextureRendererManager::clear() {
+            Utility::deleteAll(m_textureArrays);
+            m_textureArrayLayers.clear();
             Utility::deleteAll(m_textureCollections);
         }
 
@@ -107,5 +110,32 @@ namespace TrenchBroom {
 
             return *textureRenderer;
         }
+        
+        TextureArray& TextureRendererManager::textureArray(TextureRenderer& texture, unsigned int& layer) {
+            assert(TextureArray::supported());
+            
+            TextureArrayLayerMap::const_iterator it = m_textureArrayLayers.find(&texture);
+            if (it != m_textureArrayLayers.end()) {
+                layer = it->second.second;
+                return *it->second.first;
+            }
+            
+            TextureArray* textureArray = NULL;
+            TextureArray::List::const_iterator arrayIt, arrayEnd;
+            for (arrayIt = m_textureArrays.begin(), arrayEnd = m_textureArrays.end(); arrayIt != arrayEnd && textureArray == NULL; ++arrayIt) {
+                TextureArray* candidate = *arrayIt;
+                if (candidate->width() == texture.width() && candidate->height() == texture.height() && !candidate->full())
+                    textureArray = candidate;
+            }
+            
+            if (textureArray == NULL) {
+                textureArray = new TextureArray(texture.width(), texture.height());
+                m_textureArrays.push_back(textureArray);
+            }
+            
+            layer = textureArray->addLayer(texture);
+            m_textureArrayLayers[&texture] = TextureArrayLayer(textureArray, layer);
+            return *textureArray;
+        }
     }
 }
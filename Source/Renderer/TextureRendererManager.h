@@ -21,6 +21,7 @@
 #define __TrenchBroom__TextureRendererManager__
 
 #include "Model/Texture.h"
+#include "Renderer/TextureArray.h"
 
 #include <map>
 
@@ -53,10 +54,15 @@ namespace TrenchBroom {
             typedef std::map<Model::TextureCollection*, TextureRendererCollection*> TextureRendererCollectionMap;
             typedef std::pair<Model::TextureCollection*, TextureRendererCollection*> TextureRendererCollectionEntry;
             
+            typedef std::pair<TextureArray*, unsigned int> TextureArrayLayer;
+            typedef std::map<TextureRenderer*, TextureArrayLayer> TextureArrayLayerMap;
+            
             Model::TextureManager& m_textureManager;
             TextureRenderer* m_dummyTexture;
             Palette* m_palette;
             TextureRendererCollectionMap m_textureCollections;
+            TextureArray::List m_textureArrays;
+            TextureArrayLayerMap m_textureArrayLayers;
             bool m_valid;
 
             void clear();
@@ -73,6 +79,12 @@ namespace TrenchBroom {
             
             TextureRenderer& renderer(Model::Texture* texture);
             
+            /**
+             * Returns the texture array which holds the given texture and the index of its layer. The texture is added
+             * to an array of its size if it isn't in one yet. Texture arrays must be supported.
+             */
+            TextureArray& textureArray(TextureRenderer& texture, unsigned int& layer);
+            
             inline void invalidate() {
                 m_valid = false;
             }
@@ -80,6 +80,10 @@ namespace TrenchBroom {
                 loadModelViewMatrix(m_viewStack.back() * m_modelStack.back());
             }
             
+            inline const Mat4f& modelMatrix() const {
+                return m_modelStack.back();
+            }
+            
             inline void popModelMatrix() {
                 assert(m_modelStack.size() > 1);
                 m_modelStack.pop_back();
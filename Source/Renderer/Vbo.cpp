@@ -18,10 +18,29 @@
  */
 
 #include "Vbo.h"
+
+#include <wx/stopwatch.h>
+
 #include <algorithm>
 
 namespace TrenchBroom {
     namespace Renderer {
+        static inline size_t floorLog2(size_t value) {
+            size_t result = 0;
+            while (value >>= 1)
+                result++;
+            return result;
+        }
+        
+        static inline size_t lowestBit(unsigned int value) {
+            static const size_t DeBruijnPositions[32] = {
+                0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+                31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+            };
+            assert(value != 0);
+            return DeBruijnPositions[((value & (~value + 1)) * 0x077CB531u) >> 27];
+        }
+        
         void VboBlock::insertBetween(VboBlock* previousBlock, VboBlock* nextBlock) {
             if (previousBlock != NULL) previousBlock->m_next = this;
             m_previous = previousBlock;
@@ -29,216 +48,595 @@ namespace TrenchBroom {
             m_next = nextBlock;
         }
         
+        void VboBlock::activateElements() {
+            assert(m_vbo.state() >= Vbo::VboActive);
+            assert(m_page->vboId != 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_page->vboId);
+        }
+        
         void VboBlock::freeBlock() {
             m_vbo.freeBlock(*this);
         }
         
-        size_t Vbo::findFreeBlockInRange(size_t address, size_t capacity, size_t start, size_t length) {
-            assert(length > 0);
-            
-            size_t pivot = start + length / 2;
-            VboBlock* block = m_freeBlocks[pivot];
-
-            int order = block->compare(address, capacity);
-            if (order == 0)
-                return pivot;
-            if (length == 1) {
-                if (order > 0)
-                    return pivot;
-                return pivot + 1;
+        void Vbo::sizeClass(size_t capacity, size_t& firstLevel, size_t& secondLevel) {
+            if (capacity < SmallBlockSize) {
+                firstLevel = 0;
+                secondLevel = capacity / (SmallBlockSize / SecondLevelCount);
+            } else {
+                const size_t log = floorLog2(capacity);
+                assert(log < 32);
+                firstLevel = log - SmallBlockBits + 1;
+                secondLevel = (capacity >> (log - SecondLevelBits)) - SecondLevelCount;
             }
-            
-            if (order > 0)
-                return findFreeBlockInRange(address, capacity, start, length / 2);
-            return findFreeBlockInRange(address, capacity, pivot, (length + 1) / 2);
         }
         
-        size_t Vbo::findFreeBlock(size_t address, size_t capacity) {
-            if (m_freeBlocks.empty()) return 0;
-            size_t index = findFreeBlockInRange(address, capacity, 0, static_cast<size_t>(m_freeBlocks.size()));
-            assert(index == m_freeBlocks.size() ||
-                   capacity < m_freeBlocks[index]->capacity() ||
-                   (capacity == m_freeBlocks[index]->capacity() && address <= m_freeBlocks[index]->address()));
-            return index;
+        bool Vbo::copyBuffersSupported() {
+            return GLEW_VERSION_3_1 || GLEW_ARB_copy_buffer;
         }
-
-        void Vbo::insertFreeBlock(VboBlock& block) {
-            assert(block.free());
-            size_t index = findFreeBlock(block.address(), block.capacity());
-            assert(index <= m_freeBlocks.size());
-            if (index < m_freeBlocks.size()) {
-                std::vector<VboBlock*>::iterator it = m_freeBlocks.begin();
-                std::advance(it, index);
-                m_freeBlocks.insert(it, &block);
-            } else {
-                m_freeBlocks.push_back(&block);
-            }
-#ifdef _DEBUG_VBO
-            checkFreeBlocks();
-#endif
+        
+        bool Vbo::mapRangeSupported() {
+            return GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range;
         }
         
-        void Vbo::removeFreeBlock(VboBlock& block) {
-            assert(block.free());
-            size_t index = findFreeBlock(block.address(), block.capacity());
-            assert(index < m_freeBlocks.size());
-            assert(m_freeBlocks[index] == &block);
-            std::vector<VboBlock*>::iterator it = m_freeBlocks.begin();
-            std::advance(it, index);
-            m_freeBlocks.erase(it);
-#ifdef _DEBUG_VBO
-            checkFreeBlocks();
-#endif
+        bool Vbo::fencesSupported() {
+            return mapRangeSupported() && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
         }
         
-        void Vbo::resizeVbo(size_t newCapacity) {
-            VboState oldState = m_state;
+        VboBlock* Vbo::findFreeBlock(size_t capacity) {
+            // round the capacity up to the next size class, so that every block of the class found is large enough
+            size_t rounded = capacity;
+            if (capacity < SmallBlockSize)
+                rounded += SmallBlockSize / SecondLevelCount - 1;
+            else
+                rounded += (static_cast<size_t>(1) << (floorLog2(capacity) - SecondLevelBits)) - 1;
             
-            unsigned char* temp = NULL;
-            MemBlock::List memBlocks;
-            if (m_vboId != 0 && m_freeCapacity < m_totalCapacity) {
-                VboBlock* currentBlock = m_first;
-                size_t totalLength = 0;
-                
-                while (currentBlock != NULL) {
-                    while (currentBlock != NULL && currentBlock->free())
-                        currentBlock = currentBlock->m_next;
-                    if (currentBlock != NULL) {
-                        size_t start = currentBlock->address();
-                        size_t length = 0;
-                        while (currentBlock != NULL && !currentBlock->free()) {
-                            length += currentBlock->capacity();
-                            currentBlock = currentBlock->m_next;
-                        }
-                        memBlocks.push_back(MemBlock(start, length));
-                        totalLength += length;
+            size_t firstLevel, secondLevel;
+            sizeClass(rounded, firstLevel, secondLevel);
+            if (firstLevel < FirstLevelCount) {
+                unsigned int secondLevelMap = m_secondLevelMaps[firstLevel] & (~0u << secondLevel);
+                if (secondLevelMap == 0) {
+                    const unsigned int firstLevelMap = firstLevel + 1 < FirstLevelCount ? m_firstLevelMap & (~0u << (firstLevel + 1)) : 0;
+                    if (firstLevelMap != 0) {
+                        firstLevel = lowestBit(firstLevelMap);
+                        secondLevelMap = m_secondLevelMaps[firstLevel];
                     }
                 }
-                
-                if (m_state < VboActive)
-                    activate();
-                if (m_state < VboMapped)
-                    map();
+                if (secondLevelMap != 0)
+                    return m_freeLists[firstLevel][lowestBit(secondLevelMap)];
+            }
+            
+            // the rounding skips the blocks of the class of the capacity itself, some of which may be large enough
+            sizeClass(capacity, firstLevel, secondLevel);
+            for (VboBlock* block = m_freeLists[firstLevel][secondLevel]; block != NULL; block = block->m_nextFree)
+                if (block->capacity() >= capacity)
+                    return block;
+            return NULL;
+        }
 
-                temp = new unsigned char[totalLength];
-                size_t offset = 0;
-                MemBlock::List::const_iterator it, end;
-                for (it = memBlocks.begin(), end = memBlocks.end(); it != end; ++it) {
-                    const MemBlock& memBlock = *it;
-                    memcpy(temp + offset, m_buffer + memBlock.start, memBlock.length);
-                    offset += memBlock.length;
-                }
+        void Vbo::insertFreeBlock(VboBlock& block) {
+            assert(block.free());
+            
+            // the free blocks of a page which is being evacuated are not available for allocation
+            if (block.m_page->evacuating)
+                return;
+            
+            size_t firstLevel, secondLevel;
+            sizeClass(block.capacity(), firstLevel, secondLevel);
+            
+            VboBlock* head = m_freeLists[firstLevel][secondLevel];
+            block.m_previousFree = NULL;
+            block.m_nextFree = head;
+            if (head != NULL)
+                head->m_previousFree = &block;
+            m_freeLists[firstLevel][secondLevel] = &block;
+            
+            m_secondLevelMaps[firstLevel] |= 1u << secondLevel;
+            m_firstLevelMap |= 1u << firstLevel;
+        }
+        
+        void Vbo::removeFreeBlock(VboBlock& block) {
+            assert(block.free());
+            if (block.m_page->evacuating)
+                return;
+            
+            size_t firstLevel, secondLevel;
+            sizeClass(block.capacity(), firstLevel, secondLevel);
+            
+            if (block.m_previousFree != NULL)
+                block.m_previousFree->m_nextFree = block.m_nextFree;
+            else
+                m_freeLists[firstLevel][secondLevel] = block.m_nextFree;
+            if (block.m_nextFree != NULL)
+                block.m_nextFree->m_previousFree = block.m_previousFree;
+            block.m_previousFree = block.m_nextFree = NULL;
+            
+            if (m_freeLists[firstLevel][secondLevel] == NULL) {
+                m_secondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+                if (m_secondLevelMaps[firstLevel] == 0)
+                    m_firstLevelMap &= ~(1u << firstLevel);
             }
+        }
+        
+        void Vbo::linkBlock(VboBlock& block, VboBlock* previous, VboBlock* next) {
+            VboPage& page = *block.m_page;
+            block.insertBetween(previous, next);
+            if (previous == NULL)
+                page.first = &block;
+            if (next == NULL)
+                page.last = &block;
+        }
+        
+        void Vbo::unlinkBlock(VboBlock& block) {
+            VboPage& page = *block.m_page;
+            if (block.m_previous != NULL)
+                block.m_previous->m_next = block.m_next;
+            else
+                page.first = block.m_next;
+            if (block.m_next != NULL)
+                block.m_next->m_previous = block.m_previous;
+            else
+                page.last = block.m_previous;
+            block.m_previous = block.m_next = NULL;
+        }
+        
+        void Vbo::createPageBuffer(VboPage& page) {
+            assert(page.vboId == 0);
             
-            size_t addedCapacity = newCapacity - m_totalCapacity;
-            m_freeCapacity = newCapacity - (m_totalCapacity - m_freeCapacity);
-            m_totalCapacity = newCapacity;
+            glGenBuffers(1, &page.vboId);
+            glBindBuffer(m_type, page.vboId);
+            glBufferData(m_type, static_cast<GLsizeiptr>(page.capacity), NULL, m_usage == StreamUsage ? GL_STREAM_DRAW : GL_DYNAMIC_DRAW);
+            m_activePage = &page;
             
-            if (m_last->free()) {
-                resizeBlock(*m_last, m_last->capacity() + addedCapacity);
+            GLenum error = glGetError();
+			if (error != GL_NO_ERROR)
+				throw VboException(*this, "Vbo page could not be created", error);
+        }
+        
+        void Vbo::bindPage(VboPage& page) {
+            assert(m_state >= VboActive);
+            if (m_activePage != &page) {
+                glBindBuffer(m_type, page.vboId);
+                m_activePage = &page;
+            }
+        }
+        
+        void Vbo::mapPage(VboPage& page) {
+            bindPage(page);
+            if (m_usage == StreamUsage && mapRangeSupported()) {
+                // the ring allocation makes sure that the GPU does not read what is written into the mapped page
+                const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+                page.buffer = reinterpret_cast<unsigned char*>(glMapBufferRange(m_type, 0, static_cast<GLsizeiptr>(page.capacity), access));
             } else {
-                VboBlock* block = new VboBlock(*this, m_last->address() + m_last->capacity(), addedCapacity);
-                block->insertBetween(m_last, NULL);
+                page.buffer = reinterpret_cast<unsigned char*>(glMapBuffer(m_type, GL_WRITE_ONLY));
+            }
+            
+            GLenum error = glGetError();
+            if (page.buffer == NULL || error != GL_NO_ERROR)
+                throw VboException(*this, "Vbo page could not be mapped", error);
+        }
+        
+        void Vbo::addPage(size_t capacity) {
+            VboPage* page = new VboPage(capacity);
+            if (m_usage == StaticUsage) {
+                VboBlock* block = new VboBlock(*this, *page, 0, capacity);
+                linkBlock(*block, NULL, NULL);
+                page->freeBlockCount = 1;
                 insertFreeBlock(*block);
             }
             
-            if (m_vboId != 0) {
+            m_pages.push_back(page);
+            m_totalCapacity += capacity;
+            m_freeCapacity += capacity;
+            
+            if (m_state >= VboActive) {
+                VboPage* activePage = m_activePage;
+                createPageBuffer(*page);
                 if (m_state == VboMapped)
-                    unmap();
-                if (m_state == VboActive)
-                    deactivate();
-                glDeleteBuffers(1, &m_vboId);
-                m_vboId = 0;
+                    mapPage(*page);
+                if (activePage != NULL)
+                    bindPage(*activePage);
             }
+        }
+        
+        void Vbo::releasePage(VboPage& page) {
+            assert(page.freeCapacity == page.capacity);
+            assert(m_pages.size() > 1);
             
-            if (temp != NULL) {
-                assert(!memBlocks.empty());
-                
-                if (m_state < VboActive)
-                    activate();
-                if (m_state < VboMapped)
-                    map();
-                
-                size_t offset = 0;
-                MemBlock::List::const_iterator it, end;
-                for (it = memBlocks.begin(), end = memBlocks.end(); it != end; ++it) {
-                    const MemBlock& memBlock = *it;
-                    memcpy(m_buffer + memBlock.start, temp + offset, memBlock.length);
+            if (&page == m_evacuatingPage)
+                m_evacuatingPage = NULL;
+            if (&page == m_compactingPage)
+                m_compactingPage = NULL;
+            m_compactionCursor = NULL;
+            
+            if (m_usage == StaticUsage) {
+                VboBlock* block = page.first;
+                assert(block != NULL && block == page.last);
+                removeFreeBlock(*block);
+                delete block;
+            } else {
+                releaseStreamSegments(page);
+            }
+            
+            if (page.vboId != 0) {
+                if (m_state == VboMapped) {
+                    bindPage(page);
+                    glUnmapBuffer(m_type);
                 }
-                
-                delete [] temp;
-                temp = NULL;
-                memBlocks.clear();
-                
-                if (oldState < VboMapped)
-                    unmap();
-                if (oldState < VboActive)
-                    deactivate();
+                glDeleteBuffers(1, &page.vboId);
+                if (m_activePage == &page) {
+                    m_activePage = NULL;
+                    if (m_state >= VboActive)
+                        glBindBuffer(m_type, 0);
+                }
+            }
+            
+            m_pages.erase(std::find(m_pages.begin(), m_pages.end(), &page));
+            m_totalCapacity -= page.capacity;
+            m_freeCapacity -= page.capacity;
+            delete &page;
+            
+            if (m_state >= VboActive && m_activePage == NULL)
+                bindPage(*m_pages.front());
+        }
+        
+        void Vbo::copyData(VboPage& source, size_t sourceAddress, VboPage& destination, size_t destinationAddress, size_t length) {
+            if (m_state == VboMapped) {
+                memmove(destination.buffer + destinationAddress, source.buffer + sourceAddress, length);
+                return;
+            }
+            
+            glBindBuffer(GL_COPY_READ_BUFFER, source.vboId);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, destination.vboId);
+            if (&source != &destination || sourceAddress + length <= destinationAddress || destinationAddress + length <= sourceAddress) {
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(sourceAddress), static_cast<GLintptr>(destinationAddress), static_cast<GLsizeiptr>(length));
             } else {
-                if (oldState > VboInactive && m_state < VboActive)
-                    activate();
-                if (oldState > VboActive && m_state < VboMapped)
-                    map();
+                // the ranges of a copy within a buffer must not overlap, so the data is copied in pieces which are
+                // no longer than the distance it moves
+                assert(destinationAddress < sourceAddress);
+                const size_t distance = sourceAddress - destinationAddress;
+                for (size_t offset = 0; offset < length; offset += distance) {
+                    const size_t pieceLength = std::min(distance, length - offset);
+                    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(sourceAddress + offset), static_cast<GLintptr>(destinationAddress + offset), static_cast<GLsizeiptr>(pieceLength));
+                }
             }
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        
+        bool Vbo::fragmented(const VboPage& page, bool full) const {
+            if (page.evacuating || page.freeBlockCount == 0)
+                return false;
             
-#ifdef _DEBUG_VBO
-            checkBlockChain();
-            checkFreeBlocks();
-#endif
+            const size_t tailCapacity = page.last->free() ? page.last->capacity() : 0;
+            const size_t enclosedCapacity = page.freeCapacity - tailCapacity;
+            if (full)
+                return enclosedCapacity > 0;
+            
+            // moving blocks costs bandwidth, so a page is only compacted once a quarter of it is lost in holes
+            return enclosedCapacity > page.capacity / 4;
         }
         
-        void Vbo::resizeBlock(VboBlock& block, size_t newCapacity) {
-            if (block.capacity() == newCapacity) return;
-            if (block.free()) {
-                removeFreeBlock(block);
-                block.m_capacity = newCapacity;
-                insertFreeBlock(block);
+        bool Vbo::needsCompaction(bool full) const {
+            if (m_evacuatingPage != NULL || m_compactingPage != NULL)
+                return true;
+            
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                const VboPage& page = **it;
+                if (evacuationCandidate(page, full) || fragmented(page, full))
+                    return true;
             }
+            return false;
         }
         
-        VboBlock* Vbo::packBlock(VboBlock& block) {
-            VboBlock* first = block.m_next;
-            if (first == NULL)
-                return NULL;
+        bool Vbo::evacuationCandidate(const VboPage& page, bool full) const {
+            if (m_pages.size() < 2 || m_evacuationBlocked)
+                return false;
             
-            VboBlock* previous = NULL;
-            VboBlock* last = first;
-            size_t size = 0;
-            size_t address = first->address();
+            // a page is only evacuated if it is mostly empty and fits into the free space of the other pages with
+            // room to spare
+            const size_t usedCapacity = page.capacity - page.freeCapacity;
+            const size_t otherFreeCapacity = m_freeCapacity - page.freeCapacity;
+            return (full || usedCapacity < page.capacity / 4) && 2 * usedCapacity <= otherFreeCapacity;
+        }
+        
+        void Vbo::startEvacuation(bool full) {
+            assert(m_evacuatingPage == NULL);
+            
+            // pick the candidate with the fewest used bytes
+            VboPage* candidate = NULL;
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                VboPage& page = **it;
+                if (evacuationCandidate(page, full) && (candidate == NULL || page.capacity - page.freeCapacity < candidate->capacity - candidate->freeCapacity))
+                    candidate = &page;
+            }
+            
+            if (candidate == NULL)
+                return;
+            
+            for (VboBlock* block = candidate->first; block != NULL; block = block->m_next)
+                if (block->free())
+                    removeFreeBlock(*block);
+            candidate->evacuating = true;
+            m_evacuatingPage = candidate;
+            if (m_compactingPage == candidate) {
+                m_compactingPage = NULL;
+                m_compactionCursor = NULL;
+            }
+        }
+        
+        void Vbo::stopEvacuation() {
+            assert(m_evacuatingPage != NULL);
+            
+            VboPage& page = *m_evacuatingPage;
+            page.evacuating = false;
+            for (VboBlock* block = page.first; block != NULL; block = block->m_next)
+                if (block->free())
+                    insertFreeBlock(*block);
+            m_evacuatingPage = NULL;
+        }
+        
+        bool Vbo::evacuateBlock() {
+            assert(m_evacuatingPage != NULL);
+            
+            VboPage& page = *m_evacuatingPage;
+            if (page.freeCapacity == page.capacity) {
+                releasePage(page);
+                return true;
+            }
+            
+            VboBlock* block = page.first;
+            while (block->free())
+                block = block->m_next;
+            
+            VboBlock* destination = findFreeBlock(block->capacity());
+            if (destination == NULL) {
+                // don't try again until blocks are allocated or freed
+                stopEvacuation();
+                m_evacuationBlocked = true;
+                return false;
+            }
+            
+            // allocate the destination and let the two blocks trade places, so that the owner of the block keeps
+            // its pointer
+            destination = allocBlock(block->capacity());
+            assert(destination->capacity() == block->capacity());
+            copyData(page, block->address(), *destination->m_page, destination->address(), block->capacity());
+            
+            VboBlock* blockPrevious = block->m_previous;
+            VboBlock* blockNext = block->m_next;
+            VboBlock* destinationPrevious = destination->m_previous;
+            VboBlock* destinationNext = destination->m_next;
+            unlinkBlock(*block);
+            unlinkBlock(*destination);
+            
+            std::swap(block->m_page, destination->m_page);
+            std::swap(block->m_address, destination->m_address);
+            linkBlock(*block, destinationPrevious, destinationNext);
+            linkBlock(*destination, blockPrevious, blockNext);
+            
+            freeBlock(*destination);
+            return true;
+        }
+        
+        bool Vbo::slideBlocks(bool full) {
+            if (m_compactingPage == NULL) {
+                VboPage::List::const_iterator it, end;
+                for (it = m_pages.begin(), end = m_pages.end(); it != end && m_compactingPage == NULL; ++it)
+                    if (fragmented(**it, full))
+                        m_compactingPage = *it;
+                if (m_compactingPage == NULL)
+                    return false;
+                m_compactionCursor = NULL;
+            }
+            
+            VboPage& page = *m_compactingPage;
+            VboBlock* hole = m_compactionCursor;
+            if (hole == NULL) {
+                hole = page.first;
+                while (hole != NULL && !hole->free())
+                    hole = hole->m_next;
+            }
+            
+            if (hole == NULL || hole->m_next == NULL) {
+                m_compactingPage = NULL;
+                m_compactionCursor = NULL;
+                return true;
+            }
             
-            do {
-                last->m_address -= block.capacity();
-                size += last->capacity();
-                previous = last;
+            // move the run of used blocks after the hole to its start, the hole then follows the run
+            VboBlock* first = hole->m_next;
+            VboBlock* last = first;
+            size_t length = first->capacity();
+            while (last->m_next != NULL && !last->m_next->free()) {
                 last = last->m_next;
-            } while (last != NULL && !last->free());
+                length += last->capacity();
+            }
             
-            memmove(m_buffer + block.address(), m_buffer + address, size);
+            copyData(page, first->address(), page, hole->address(), length);
+            for (VboBlock* block = first; block != last->m_next; block = block->m_next)
+                block->m_address -= hole->capacity();
             
-            if (last != NULL) {
-                last->m_address -= block.capacity();
-                resizeBlock(*last, last->capacity() + block.capacity());
-            } else {
-                VboBlock* newBlock = new VboBlock(*this, previous->address() + previous->capacity(), block.capacity());
-                insertFreeBlock(*newBlock);
-                newBlock->insertBetween(previous, NULL);
-                m_last = newBlock;
+            VboBlock* next = last->m_next;
+            unlinkBlock(*hole);
+            hole->m_address = last->address() + last->capacity();
+            linkBlock(*hole, last, next);
+            
+            if (next != NULL) {
+                assert(next->free());
+                removeFreeBlock(*hole);
+                removeFreeBlock(*next);
+                hole->m_capacity += next->capacity();
+                unlinkBlock(*next);
+                delete next;
+                page.freeBlockCount--;
+                insertFreeBlock(*hole);
+            }
+            
+            m_compactionCursor = hole;
+            return true;
+        }
+        
+        bool Vbo::compactStep(bool full) {
+            // pages which became empty are released, but one page is always kept
+            if (m_pages.size() > 1) {
+                VboPage::List::const_iterator it, end;
+                for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                    VboPage& page = **it;
+                    if (page.freeCapacity == page.capacity) {
+                        releasePage(page);
+                        return true;
+                    }
+                }
+            }
+            
+            if (m_evacuatingPage == NULL)
+                startEvacuation(full);
+            if (m_evacuatingPage != NULL && evacuateBlock())
+                return true;
+            
+            return slideBlocks(full);
+        }
+        
+        void Vbo::closeStreamSegment() {
+            if (fencesSupported() && m_streamHead > m_streamSegmentStart)
+                m_streamSegments.push_back(StreamSegment(m_pages.back(), m_streamSegmentStart, m_streamHead));
+            m_streamSegmentStart = m_streamHead;
+        }
+        
+        bool Vbo::waitForStreamSegments(const VboPage& page, size_t start, size_t end) {
+            // fences are signaled in the order in which they were inserted, so all segments up to the last one which
+            // was waited for are retired
+            size_t retiredCount = 0;
+            bool available = true;
+            for (size_t i = 0; i < m_streamSegments.size() && available; i++) {
+                const StreamSegment& segment = m_streamSegments[i];
+                if (segment.page == &page && segment.start < end && start < segment.end) {
+                    if (segment.fence == NULL) {
+                        // the segment was written in this frame and may hold blocks which have not been drawn yet
+                        available = false;
+                    } else {
+                        GLenum result;
+                        do {
+                            result = glClientWaitSync(segment.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+                        } while (result == GL_TIMEOUT_EXPIRED);
+                        retiredCount = i + 1;
+                    }
+                }
+            }
+            
+            for (size_t i = 0; i < retiredCount; i++)
+                glDeleteSync(m_streamSegments[i].fence);
+            m_streamSegments.erase(m_streamSegments.begin(), m_streamSegments.begin() + static_cast<long>(retiredCount));
+            return available;
+        }
+        
+        void Vbo::releaseStreamSegments(const VboPage& page) {
+            StreamSegment::List::iterator it = m_streamSegments.begin();
+            while (it != m_streamSegments.end()) {
+                if (it->page == &page) {
+                    if (it->fence != NULL)
+                        glDeleteSync(it->fence);
+                    it = m_streamSegments.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        
+        void Vbo::orphanPage(VboPage& page) {
+            if (page.vboId == 0)
+                return;
+            
+            VboPage* activePage = m_activePage;
+            if (m_state == VboInactive)
+                glBindBuffer(m_type, page.vboId);
+            else
+                bindPage(page);
+            if (m_state == VboMapped)
+                glUnmapBuffer(m_type);
+            
+            // the driver keeps the old storage until the GPU has finished reading it
+            glBufferData(m_type, static_cast<GLsizeiptr>(page.capacity), NULL, GL_STREAM_DRAW);
+            
+            if (m_state == VboMapped)
+                mapPage(page);
+            if (m_state == VboInactive)
+                glBindBuffer(m_type, 0);
+            else if (activePage != NULL)
+                bindPage(*activePage);
+        }
+        
+        VboBlock* Vbo::allocStreamBlock(size_t capacity) {
+            VboPage* page = m_pages.back();
+            size_t address = m_streamHead;
+            
+            if (address + capacity > page->capacity) {
+                // wrap around to the start of the ring
+                closeStreamSegment();
+                address = 0;
+                if (!fencesSupported()) {
+                    // without fences, the storage can only be replaced if none of its blocks are in use
+                    if (page->freeCapacity == page->capacity)
+                        orphanPage(*page);
+                    else
+                        page = NULL;
+                }
             }
             
-            if (m_first == &block) m_first = block.m_next;
+            if (page != NULL && (address + capacity > page->capacity || !waitForStreamSegments(*page, address, address + capacity)))
+                page = NULL;
             
-            removeFreeBlock(block);
-            if (block.m_previous != NULL) block.m_previous->m_next = block.m_next;
-            if (block.m_next != NULL) block.m_next->m_previous = block.m_previous;
+            if (page == NULL) {
+                // continue in a new page and release the current one at the end of the frame; with fences, this means
+                // that the ring cannot hold the geometry of one frame, so the new page is larger
+                closeStreamSegment();
+                const size_t pageCapacity = fencesSupported() ? 2 * m_pages.back()->capacity : m_pages.back()->capacity;
+                addPage(std::max(pageCapacity, capacity));
+                page = m_pages.back();
+                address = 0;
+            }
+            
+            if (address == 0)
+                m_streamSegmentStart = 0;
+            m_streamHead = address + capacity;
+            
+            VboBlock* block = new VboBlock(*this, *page, address, capacity);
+            block->m_free = false;
+            page->freeCapacity -= capacity;
+            m_freeCapacity -= capacity;
+            return block;
+        }
+        
+        void Vbo::freeStreamBlock(VboBlock& block) {
+            VboPage& page = *block.m_page;
+            page.freeCapacity += block.capacity();
+            m_freeCapacity += block.capacity();
             delete &block;
-
-            return last;
         }
         
-        Vbo::Vbo(GLenum type, size_t capacity) : m_type(type), m_totalCapacity(capacity), m_freeCapacity(capacity), m_buffer(NULL), m_vboId(0), m_state(VboInactive) {
-            m_first = new VboBlock(*this, 0, m_totalCapacity);
-            m_last = m_first;
-            m_freeBlocks.push_back(m_first);
+        Vbo::Vbo(GLenum type, size_t capacity, VboUsage usage) :
+        m_type(type),
+        m_usage(usage),
+        m_totalCapacity(0),
+        m_freeCapacity(0),
+        m_activePage(NULL),
+        m_evacuatingPage(NULL),
+        m_compactingPage(NULL),
+        m_compactionCursor(NULL),
+        m_evacuationBlocked(false),
+        m_firstLevelMap(0),
+        m_streamSegmentStart(0),
+        m_streamHead(0),
+        m_state(VboInactive) {
+            for (size_t i = 0; i < FirstLevelCount; i++) {
+                m_secondLevelMaps[i] = 0;
+                for (size_t j = 0; j < SecondLevelCount; j++)
+                    m_freeLists[i][j] = NULL;
+            }
+            
+            addPage((capacity + 3) & ~static_cast<size_t>(3));
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
@@ -254,27 +652,43 @@ namespace TrenchBroom {
                 unmap();
             if (m_state == VboActive)
                 deactivate();
-            if (m_vboId != 0)
-                glDeleteBuffers(1, &m_vboId);
-            m_freeBlocks.clear();
-            VboBlock* block = m_first;
-            while (block != NULL) {
-                VboBlock* next = block->m_next;
-                delete block;
-                block = next;
+            
+            StreamSegment::List::const_iterator segmentIt, segmentEnd;
+            for (segmentIt = m_streamSegments.begin(), segmentEnd = m_streamSegments.end(); segmentIt != segmentEnd; ++segmentIt) {
+                if (segmentIt->fence != NULL)
+                    glDeleteSync(segmentIt->fence);
+            }
+            m_streamSegments.clear();
+            
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                VboPage* page = *it;
+                if (page->vboId != 0)
+                    glDeleteBuffers(1, &page->vboId);
+                VboBlock* block = page->first;
+                while (block != NULL) {
+                    VboBlock* next = block->m_next;
+                    delete block;
+                    block = next;
+                }
+                delete page;
             }
+            m_pages.clear();
         }
         
         void Vbo::activate() {
             assert(m_state != VboActive);
             
-            if (m_vboId == 0) {
-                glGenBuffers(1, &m_vboId);
-                glBindBuffer(m_type, m_vboId);
-                glBufferData(m_type, static_cast<GLsizeiptr>(m_totalCapacity), NULL, GL_DYNAMIC_DRAW);
-            } else {
-                glBindBuffer(m_type, m_vboId);
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                VboPage& page = **it;
+                if (page.vboId == 0)
+                    createPageBuffer(page);
             }
+            
+            VboPage& firstPage = *m_pages.front();
+            glBindBuffer(m_type, firstPage.vboId);
+            m_activePage = &firstPage;
 
             GLenum error = glGetError();
 			if (error != GL_NO_ERROR)
@@ -287,16 +701,19 @@ namespace TrenchBroom {
             assert(m_state == VboActive);
             
             glBindBuffer(m_type, 0);
+            m_activePage = NULL;
             m_state = VboInactive;
         }
         
         void Vbo::map() {
             assert(m_state == VboActive);
             
-            m_buffer = (unsigned char *)glMapBuffer(m_type, GL_WRITE_ONLY);
-            GLenum error = glGetError();
-			if (m_buffer == NULL || error != GL_NO_ERROR)
-				throw VboException(*this, "Vbo could not be mapped", error);
+            VboPage* activePage = m_activePage;
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it)
+                mapPage(**it);
+            if (activePage != NULL)
+                bindPage(*activePage);
 
             m_state = VboMapped;
         }
@@ -304,66 +721,83 @@ namespace TrenchBroom {
         void Vbo::unmap() {
             assert(m_state == VboMapped);
             
-            glUnmapBuffer(m_type);
+            VboPage* activePage = m_activePage;
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                VboPage& page = **it;
+                bindPage(page);
+                glUnmapBuffer(m_type);
+                page.buffer = NULL;
+            }
+            if (activePage != NULL)
+                bindPage(*activePage);
 
             GLenum error = glGetError();
 			if (error != GL_NO_ERROR)
 				throw VboException(*this, "Vbo could not be unmapped", error);
 
-			m_buffer = NULL;
             m_state = VboActive;
         }
         
+        void Vbo::deactivateElements() {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        
         void Vbo::ensureFreeCapacity(size_t capacity) {
-            pack();
-            if (m_freeCapacity < capacity)
-                resizeVbo(m_totalCapacity + (capacity - m_freeCapacity));
+            if (capacity == 0 || m_usage == StreamUsage)
+                return;
+            
+            capacity = (capacity + 3) & ~static_cast<size_t>(3);
+            if (findFreeBlock(capacity) == NULL && m_evacuatingPage != NULL)
+                stopEvacuation();
+            if (findFreeBlock(capacity) == NULL)
+                addPage(std::max(capacity, m_totalCapacity));
         }
 
         VboBlock* Vbo::allocBlock(size_t capacity) {
             assert(capacity > 0);
             
+            // keep every block aligned to four bytes, so that any block can hold element indices
+            capacity = (capacity + 3) & ~static_cast<size_t>(3);
+            if (m_usage == StreamUsage)
+                return allocStreamBlock(capacity);
+            
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
 #endif
 
-            size_t index = findFreeBlock(0, capacity);
-            if (index >= m_freeBlocks.size()) {
-                SetVboState mapVbo(*this, VboMapped);
-                pack();
-
-                if (capacity > m_freeCapacity) {
-                    const size_t usedCapacity = m_totalCapacity - m_freeCapacity;
-                    size_t newCapacity = m_totalCapacity;
-                    size_t newFreeCapacity = m_freeCapacity;
-                    while (capacity > newFreeCapacity) {
-                        newCapacity *= 2;
-                        newFreeCapacity = newCapacity - usedCapacity;
-                    }
-                    resizeVbo(newCapacity);
-                }
-                
-                index = findFreeBlock(0, capacity);
-                assert(index < m_freeBlocks.size());
+            VboBlock* block = findFreeBlock(capacity);
+            if (block == NULL && m_evacuatingPage != NULL) {
+                stopEvacuation();
+                block = findFreeBlock(capacity);
+            }
+            if (block == NULL) {
+                // grow like a single buffer which doubles its size, but keep the existing pages where they are
+                addPage(std::max(capacity, m_totalCapacity));
+                block = findFreeBlock(capacity);
             }
+            assert(block != NULL && block->capacity() >= capacity);
             
-            VboBlock* block = m_freeBlocks[index];
-            std::vector<VboBlock*>::iterator it = m_freeBlocks.begin();
-            std::advance(it, index);
-            m_freeBlocks.erase(it);
+            VboPage& page = *block->m_page;
+            removeFreeBlock(*block);
             
             // split block
             if (capacity < block->capacity()) {
-                VboBlock* remainder = new VboBlock(*this, block->address() + capacity, block->capacity() - capacity);
-                remainder->insertBetween(block, block->m_next);
+                VboBlock* remainder = new VboBlock(*this, page, block->address() + capacity, block->capacity() - capacity);
+                linkBlock(*remainder, block, block->m_next);
                 block->m_capacity = capacity;
                 insertFreeBlock(*remainder);
-                if (m_last == block) m_last = remainder;
+            } else {
+                page.freeBlockCount--;
             }
             
-            m_freeCapacity -= block->capacity();
             block->m_free = false;
+            page.freeCapacity -= capacity;
+            m_freeCapacity -= capacity;
+            m_evacuationBlocked = false;
+            if (&page == m_compactingPage)
+                m_compactionCursor = NULL;
 
 #ifdef _DEBUG_VBO
             checkBlockChain();
@@ -374,86 +808,152 @@ namespace TrenchBroom {
         }
         
         VboBlock* Vbo::freeBlock(VboBlock& block) {
+            assert(!block.free());
+            if (m_usage == StreamUsage) {
+                freeStreamBlock(block);
+                return NULL;
+            }
+            
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
 #endif
 
+            VboPage& page = *block.m_page;
             VboBlock* previous = block.m_previous;
             VboBlock* next = block.m_next;
+            VboBlock* result = &block;
             
+            page.freeCapacity += block.capacity();
+            page.freeBlockCount++;
             m_freeCapacity += block.capacity();
             block.m_free = true;
-            
-            if (previous != NULL && previous->free() && next != NULL && next->free()) {
-                resizeBlock(*previous, previous->capacity() + block.capacity() + next->capacity());
-                if (m_last == next) m_last = previous;
-                removeFreeBlock(*next);
-                previous->insertBetween(previous->m_previous, next->m_next);
-                delete &block;
-                delete next;
-                return previous;
-            }
+            m_evacuationBlocked = false;
+            if (&page == m_compactingPage)
+                m_compactionCursor = NULL;
             
             if (previous != NULL && previous->free()) {
-                resizeBlock(*previous, previous->capacity() + block.capacity());
-                if (m_last == &block) m_last = previous;
-                previous->insertBetween(previous->m_previous, next);
+                removeFreeBlock(*previous);
+                previous->m_capacity += block.capacity();
+                unlinkBlock(block);
                 delete &block;
-                return previous;
+                page.freeBlockCount--;
+                result = previous;
             }
             
             if (next != NULL && next->free()) {
-                if (m_last == next) m_last = &block;
                 removeFreeBlock(*next);
-                block.m_capacity += next->capacity();
-                block.m_free = true;
-                block.insertBetween(previous, next->m_next);
-                insertFreeBlock(block);
+                result->m_capacity += next->capacity();
+                unlinkBlock(*next);
                 delete next;
-                return &block;
+                page.freeBlockCount--;
             }
             
-            insertFreeBlock(block);
+            insertFreeBlock(*result);
 
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
 #endif
 
-            return &block;
+            return result;
         }
 
         void Vbo::freeAllBlocks() {
-            m_freeBlocks.clear();
-            VboBlock* block = m_first;
-            while (block != NULL) {
-                VboBlock* next = block->m_next;
-                delete block;
-                block = next;
+            assert(m_usage == StaticUsage);
+            if (m_evacuatingPage != NULL)
+                stopEvacuation();
+            m_compactingPage = NULL;
+            m_compactionCursor = NULL;
+            
+            m_firstLevelMap = 0;
+            for (size_t i = 0; i < FirstLevelCount; i++) {
+                m_secondLevelMaps[i] = 0;
+                for (size_t j = 0; j < SecondLevelCount; j++)
+                    m_freeLists[i][j] = NULL;
+            }
+            
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                VboPage& page = **it;
+                VboBlock* block = page.first;
+                while (block != NULL) {
+                    VboBlock* next = block->m_next;
+                    delete block;
+                    block = next;
+                }
+                page.first = page.last = NULL;
+                
+                block = new VboBlock(*this, page, 0, page.capacity);
+                linkBlock(*block, NULL, NULL);
+                page.freeCapacity = page.capacity;
+                page.freeBlockCount = 1;
+                insertFreeBlock(*block);
             }
-            m_first = m_last = new VboBlock(*this, 0, m_totalCapacity);
-            m_freeBlocks.push_back(m_first);
             m_freeCapacity = m_totalCapacity;
         }
-
-        void Vbo::pack() {
-            assert(m_state == VboMapped);
+        
+        void Vbo::endFrame() {
+            if (m_usage != StreamUsage)
+                return;
+            
+            // the segments of this frame are fenced only now, after all of their blocks have been drawn
+            closeStreamSegment();
+            StreamSegment::List::iterator it, end;
+            for (it = m_streamSegments.begin(), end = m_streamSegments.end(); it != end; ++it) {
+                if (it->fence == NULL)
+                    it->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            
+            // retire the segments which the GPU has finished reading, but don't wait for the others
+            size_t retiredCount = 0;
+            while (retiredCount < m_streamSegments.size() &&
+                   glClientWaitSync(m_streamSegments[retiredCount].fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+                retiredCount++;
+            for (size_t i = 0; i < retiredCount; i++)
+                glDeleteSync(m_streamSegments[i].fence);
+            m_streamSegments.erase(m_streamSegments.begin(), m_streamSegments.begin() + static_cast<long>(retiredCount));
+            
+            // release the pages which were replaced by a larger one once their blocks are freed
+            size_t i = 0;
+            while (i + 1 < m_pages.size()) {
+                VboPage& page = *m_pages[i];
+                if (page.freeCapacity == page.capacity)
+                    releasePage(page);
+                else
+                    i++;
+            }
+        }
+        
+        bool Vbo::compact(long timeBudget) {
+            if (m_usage == StreamUsage || !needsCompaction(false))
+                return false;
+            
+            // blocks are copied within the GL if possible, otherwise the pages must be mapped
+            const VboState compactionState = m_state == VboMapped || !copyBuffersSupported() ? VboMapped : VboActive;
+            SetVboState setState(*this, compactionState);
+            
+            wxStopWatch watch;
+            while (compactStep(false)) {
+                if (watch.TimeInMicro().GetValue() >= timeBudget)
+                    return true;
+            }
             
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
 #endif
+            return false;
+        }
 
-            if (m_totalCapacity == m_freeCapacity || (m_last->free() && m_last->capacity() == m_freeCapacity)) return;
+        void Vbo::pack() {
+            if (m_usage == StreamUsage || !needsCompaction(true))
+                return;
+            
+            const VboState compactionState = m_state == VboMapped || !copyBuffersSupported() ? VboMapped : VboActive;
+            SetVboState setState(*this, compactionState);
+            while (compactStep(true));
             
-            // find first free block
-            VboBlock* block = m_first;
-            while (block != NULL && !block->free())
-                block = block->m_next;
-            while (block != NULL && block->m_next != NULL)
-                block = packBlock(*block);
-
 #ifdef _DEBUG_VBO
             checkBlockChain();
             checkFreeBlocks();
@@ -462,27 +962,53 @@ namespace TrenchBroom {
 
 #ifdef _DEBUG_VBO
         void Vbo::checkBlockChain() {
-            VboBlock* block = m_first;
-            VboBlock* previous = NULL;
-            assert(block != NULL && block->m_previous == NULL);
+            if (m_usage == StreamUsage)
+                return;
             
-            while (block != NULL) {
-                assert(&block->m_vbo == this);
-                previous = block;
-                block = block->m_next;
-                assert(block == NULL || block->m_previous == previous);
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                VboPage& page = **it;
+                VboBlock* block = page.first;
+                VboBlock* previous = NULL;
+                size_t address = 0;
+                size_t freeCapacity = 0;
+                size_t freeBlockCount = 0;
+                assert(block != NULL && block->m_previous == NULL);
+                
+                while (block != NULL) {
+                    assert(&block->m_vbo == this);
+                    assert(block->m_page == &page);
+                    assert(block->address() == address);
+                    assert(!block->free() || previous == NULL || !previous->free());
+                    if (block->free()) {
+                        freeCapacity += block->capacity();
+                        freeBlockCount++;
+                    }
+                    address += block->capacity();
+                    previous = block;
+                    block = block->m_next;
+                    assert(block == NULL || block->m_previous == previous);
+                }
+                
+                assert(previous == page.last);
+                assert(address == page.capacity);
+                assert(freeCapacity == page.freeCapacity);
+                assert(freeBlockCount == page.freeBlockCount);
             }
-            
-            assert(previous == m_last);
         }
         
         void Vbo::checkFreeBlocks() {
-            for (size_t i = 0; i < m_freeBlocks.size(); i++) {
-                VboBlock* block = m_freeBlocks[i];
-                assert(block->free());
-                if (i < m_freeBlocks.size() - 1)
-                    assert((block->capacity() < m_freeBlocks[i + 1]->capacity()) || 
-                           (block->capacity() == m_freeBlocks[i + 1]->capacity() && block->address() < m_freeBlocks[i + 1]->address()));
+            for (size_t i = 0; i < FirstLevelCount; i++) {
+                for (size_t j = 0; j < SecondLevelCount; j++) {
+                    assert((m_freeLists[i][j] != NULL) == ((m_secondLevelMaps[i] & (1u << j)) != 0));
+                    for (VboBlock* block = m_freeLists[i][j]; block != NULL; block = block->m_nextFree) {
+                        size_t firstLevel, secondLevel;
+                        sizeClass(block->capacity(), firstLevel, secondLevel);
+                        assert(block->free() && !block->m_page->evacuating);
+                        assert(firstLevel == i && secondLevel == j);
+                    }
+                }
+                assert((m_secondLevelMaps[i] != 0) == ((m_firstLevelMap & (1u << i)) != 0));
             }
         }
 #endif
@@ -490,5 +1016,27 @@ namespace TrenchBroom {
         bool Vbo::ownsBlock(VboBlock& block) {
             return &block.m_vbo == this;
         }
+        
+        Vbo::Statistics Vbo::statistics() const {
+            Statistics statistics;
+            statistics.pageCount = m_pages.size();
+            statistics.totalCapacity = m_totalCapacity;
+            statistics.usedCapacity = m_totalCapacity - m_freeCapacity;
+            
+            VboPage::List::const_iterator it, end;
+            for (it = m_pages.begin(), end = m_pages.end(); it != end; ++it) {
+                const VboPage& page = **it;
+                for (const VboBlock* block = page.first; block != NULL; block = block->m_next) {
+                    if (block->free()) {
+                        statistics.freeBlockCount++;
+                        statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, block->capacity());
+                    } else {
+                        statistics.usedBlockCount++;
+                    }
+                }
+            }
+            
+            return statistics;
+        }
     }
 }
@@ -38,6 +38,45 @@ namespace TrenchBroom {
     namespace Renderer {
         class VboBlock;
 
+        /**
+         * One GL buffer of a VBO. The blocks of a page are chained in the order of their addresses.
+         */
+        class VboPage {
+        public:
+            typedef std::vector<VboPage*> List;
+            
+            GLuint vboId;
+            size_t capacity;
+            size_t freeCapacity;
+            size_t freeBlockCount;
+            unsigned char* buffer;
+            VboBlock* first;
+            VboBlock* last;
+            bool evacuating;
+            
+            VboPage(size_t i_capacity) :
+            vboId(0),
+            capacity(i_capacity),
+            freeCapacity(i_capacity),
+            freeBlockCount(0),
+            buffer(NULL),
+            first(NULL),
+            last(NULL),
+            evacuating(false) {}
+        };
+        
+        /**
+         * Suballocates blocks from one or more GL buffers, which are called pages. Free blocks are kept in lists by
+         * their size class, so that a fitting block is found in constant time. If no block fits, a new page is added
+         * instead of copying the existing pages into a larger buffer. Since blocks never move while they are written,
+         * the fragmentation left behind by freed blocks is removed by calling compact between frames.
+         *
+         * A stream VBO is meant for geometry which is rebuilt every frame. Its blocks are allocated one after another
+         * from a ring buffer which is written without synchronization. The ring is split into segments which are
+         * guarded by fences, and an allocation only waits if it reaches a segment that the GPU has not finished
+         * reading. The blocks of a stream VBO must be written, drawn and freed in the frame they were allocated in,
+         * and endFrame must be called once every frame.
+         */
         class Vbo {
         public:
             typedef enum {
@@ -45,38 +84,122 @@ namespace TrenchBroom {
                 VboActive   = 1,
                 VboMapped   = 2
             } VboState;
+            
+            typedef enum {
+                StaticUsage,
+                StreamUsage
+            } VboUsage;
+            
+            class Statistics {
+            public:
+                size_t pageCount;
+                size_t totalCapacity;
+                size_t usedCapacity;
+                size_t usedBlockCount;
+                size_t freeBlockCount;
+                size_t largestFreeBlock;
+                
+                Statistics() :
+                pageCount(0),
+                totalCapacity(0),
+                usedCapacity(0),
+                usedBlockCount(0),
+                freeBlockCount(0),
+                largestFreeBlock(0) {}
+                
+                /**
+                 * Returns the fraction of the capacity which is used by blocks.
+                 */
+                inline float occupancy() const {
+                    return totalCapacity > 0 ? static_cast<float>(usedCapacity) / static_cast<float>(totalCapacity) : 0.0f;
+                }
+                
+                /**
+                 * Returns the fraction of the free capacity which is not part of the largest free block.
+                 */
+                inline float fragmentation() const {
+                    const size_t freeCapacity = totalCapacity - usedCapacity;
+                    return freeCapacity > 0 ? 1.0f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeCapacity) : 0.0f;
+                }
+            };
         private:
-            struct MemBlock {
-                typedef std::vector<MemBlock> List;
+            static const size_t SecondLevelBits = 3;
+            static const size_t SecondLevelCount = 1 << SecondLevelBits;
+            static const size_t SmallBlockBits = 7;
+            static const size_t SmallBlockSize = 1 << SmallBlockBits;
+            static const size_t FirstLevelCount = 32 - SmallBlockBits + 1;
+            
+            /**
+             * A range of a stream page which was allocated from without wrapping around. Its fence is inserted at the
+             * end of the frame, until then it is NULL.
+             */
+            class StreamSegment {
+            public:
+                typedef std::vector<StreamSegment> List;
                 
+                VboPage* page;
                 size_t start;
-                size_t length;
+                size_t end;
+                GLsync fence;
                 
-                MemBlock(size_t i_start, size_t i_length) :
+                StreamSegment(VboPage* i_page, size_t i_start, size_t i_end) :
+                page(i_page),
                 start(i_start),
-                length(i_length) {}
-                
-                MemBlock() :
-                start(0),
-                length(0) {}
+                end(i_end),
+                fence(NULL) {}
             };
 
             GLenum m_type;
+            VboUsage m_usage;
             size_t m_totalCapacity;
             size_t m_freeCapacity;
-            std::vector<VboBlock*> m_freeBlocks;
-            VboBlock* m_first;
-            VboBlock* m_last;
-            unsigned char* m_buffer;
-            GLuint m_vboId;
+            VboPage::List m_pages;
+            VboPage* m_activePage;
+            VboPage* m_evacuatingPage;
+            VboPage* m_compactingPage;
+            VboBlock* m_compactionCursor;
+            bool m_evacuationBlocked;
+            unsigned int m_firstLevelMap;
+            unsigned int m_secondLevelMaps[FirstLevelCount];
+            VboBlock* m_freeLists[FirstLevelCount][SecondLevelCount];
+            StreamSegment::List m_streamSegments;
+            size_t m_streamSegmentStart;
+            size_t m_streamHead;
             VboState m_state;
-            size_t findFreeBlockInRange(size_t address, size_t capacity, size_t start, size_t length);
-            size_t findFreeBlock(size_t address, size_t capacity);
+            
+            static void sizeClass(size_t capacity, size_t& firstLevel, size_t& secondLevel);
+            static bool copyBuffersSupported();
+            static bool mapRangeSupported();
+            static bool fencesSupported();
+            
+            VboBlock* findFreeBlock(size_t capacity);
             void insertFreeBlock(VboBlock& block);
             void removeFreeBlock(VboBlock& block);
-            void resizeVbo(size_t newCapacity);
-            void resizeBlock(VboBlock& block, size_t newCapacity);
-            VboBlock* packBlock(VboBlock& block);
+            void linkBlock(VboBlock& block, VboBlock* previous, VboBlock* next);
+            void unlinkBlock(VboBlock& block);
+            
+            void createPageBuffer(VboPage& page);
+            void bindPage(VboPage& page);
+            void mapPage(VboPage& page);
+            void addPage(size_t capacity);
+            void releasePage(VboPage& page);
+            void copyData(VboPage& source, size_t sourceAddress, VboPage& destination, size_t destinationAddress, size_t length);
+            
+            bool fragmented(const VboPage& page, bool full) const;
+            bool needsCompaction(bool full) const;
+            bool evacuationCandidate(const VboPage& page, bool full) const;
+            void startEvacuation(bool full);
+            void stopEvacuation();
+            bool evacuateBlock();
+            bool slideBlocks(bool full);
+            bool compactStep(bool full);
+            
+            void closeStreamSegment();
+            bool waitForStreamSegments(const VboPage& page, size_t start, size_t end);
+            void releaseStreamSegments(const VboPage& page);
+            void orphanPage(VboPage& page);
+            VboBlock* allocStreamBlock(size_t capacity);
+            void freeStreamBlock(VboBlock& block);
 #ifdef _DEBUG_VBO
             void checkBlockChain();
             void checkFreeBlocks();
@@ -87,23 +210,54 @@ namespace TrenchBroom {
             Vbo(const Vbo& other);
             void operator= (const Vbo& other);
         public:
-            Vbo(GLenum type, size_t capacity);
+            Vbo(GLenum type, size_t capacity, VboUsage usage = StaticUsage);
             ~Vbo();
             void activate();
             void deactivate();
             void map();
             void unmap();
             
+            /**
+             * Unbinds the element array which was bound by VboBlock::activateElements.
+             */
+            void deactivateElements();
+            
             inline VboState state() const {
                 return m_state;
             }
             
+            inline VboUsage usage() const {
+                return m_usage;
+            }
+            
+            /**
+             * Makes sure that a block of the given capacity, or several blocks of this total capacity, can be allocated
+             * without adding a page.
+             */
             void ensureFreeCapacity(size_t capacity);
             VboBlock* allocBlock(size_t capacity);
             VboBlock* freeBlock(VboBlock& block);
             void freeAllBlocks();
+            
+            /**
+             * Fences the geometry which was written into a stream VBO during this frame and releases the pages which
+             * were replaced by larger ones. Does nothing for a static VBO.
+             */
+            void endFrame();
+            
+            /**
+             * Moves blocks to remove the fragmentation of the pages and releases the pages which are no longer needed,
+             * until the given time in microseconds has passed. Must not be called while any block is being written.
+             * Returns true if there is more work to do.
+             */
+            bool compact(long timeBudget);
+            
+            /**
+             * Removes all fragmentation at once.
+             */
             void pack();
             bool ownsBlock(VboBlock& block);
+            Statistics statistics() const;
         };
 
         class SetVboState {
@@ -163,6 +317,7 @@ namespace TrenchBroom {
         class VboBlock {
         private:
             Vbo& m_vbo;
+            VboPage* m_page;
             void insertBetween(VboBlock* previousBlock, VboBlock* nextBlock);
             friend class Vbo;
 
@@ -171,15 +326,23 @@ namespace TrenchBroom {
             bool m_free;
             VboBlock* m_previous;
             VboBlock* m_next;
+            VboBlock* m_previousFree;
+            VboBlock* m_nextFree;
         public:
-            inline VboBlock(Vbo& vbo, size_t address, size_t capacity) :
+            inline VboBlock(Vbo& vbo, VboPage& page, size_t address, size_t capacity) :
             m_vbo(vbo),
+            m_page(&page),
             m_address(address),
             m_capacity(capacity),
             m_free(true),
             m_previous(NULL),
-            m_next(NULL) {}
+            m_next(NULL),
+            m_previousFree(NULL),
+            m_nextFree(NULL) {}
 
+            /**
+             * Returns the address of this block within its page. The address changes when the VBO is compacted.
+             */
             inline size_t address() const {
                 return m_address;
             }
@@ -192,43 +355,57 @@ namespace TrenchBroom {
                 return m_free;
             }
 
+            /**
+             * Binds the page of this block, which must be done before vertex attribute pointers into this block are
+             * set. The VBO must be active.
+             */
+            inline void activate() {
+                m_vbo.bindPage(*m_page);
+            }
+            
+            /**
+             * Binds the page of this block as the element array, so that indices can be read from this block. The VBO
+             * must be active.
+             */
+            void activateElements();
+
             inline size_t writeBuffer(const unsigned char* buffer, size_t offset, size_t length) {
                 assert(offset + length <= m_capacity);
-                memcpy(m_vbo.m_buffer + m_address + offset, buffer, length);
+                memcpy(m_page->buffer + m_address + offset, buffer, length);
                 return offset + length;
             }
 
             inline size_t writeByte(unsigned char b, size_t offset) {
                 assert(offset < m_capacity);
-                m_vbo.m_buffer[m_address + offset] = b;
+                m_page->buffer[m_address + offset] = b;
                 return offset + 1;
             }
 
             inline size_t writeFloat(float f, size_t offset) {
                 assert(offset + sizeof(float) <= m_capacity);
-                memcpy(m_vbo.m_buffer + m_address + offset, &f, sizeof(float));
+                memcpy(m_page->buffer + m_address + offset, &f, sizeof(float));
                 return offset + sizeof(float);
             }
 
             inline size_t writeUInt32(size_t i, size_t offset) {
                 assert(offset + sizeof(size_t) <= m_capacity);
-                memcpy(m_vbo.m_buffer + m_address + offset, &i, sizeof(size_t));
+                memcpy(m_page->buffer + m_address + offset, &i, sizeof(size_t));
                 return offset + sizeof(size_t);
             }
 
             inline size_t writeColor(const Color& color, size_t offset) {
                 assert(offset + 4 <= m_capacity);
-                m_vbo.m_buffer[m_address + offset + 0] = static_cast<unsigned char>(color.r() * 0xFF);
-                m_vbo.m_buffer[m_address + offset + 1] = static_cast<unsigned char>(color.g() * 0xFF);
-                m_vbo.m_buffer[m_address + offset + 2] = static_cast<unsigned char>(color.b() * 0xFF);
-                m_vbo.m_buffer[m_address + offset + 3] = static_cast<unsigned char>(color.a() * 0xFF);
+                m_page->buffer[m_address + offset + 0] = static_cast<unsigned char>(color.r() * 0xFF);
+                m_page->buffer[m_address + offset + 1] = static_cast<unsigned char>(color.g() * 0xFF);
+                m_page->buffer[m_address + offset + 2] = static_cast<unsigned char>(color.b() * 0xFF);
+                m_page->buffer[m_address + offset + 3] = static_cast<unsigned char>(color.a() * 0xFF);
                 return offset + 4;
             }
 
             template<class T>
             inline size_t writeVec(const T& vec, size_t offset) {
                 assert(offset + sizeof(T) <= m_capacity);
-                memcpy(m_vbo.m_buffer + m_address + offset, &vec, sizeof(T));
+                memcpy(m_page->buffer + m_address + offset, &vec, sizeof(T));
                 return offset + sizeof(T);
             }
 
@@ -236,19 +413,11 @@ namespace TrenchBroom {
             inline size_t writeVecs(const std::vector<T>& vecs, size_t offset) {
                 size_t size = static_cast<size_t>(vecs.size() * sizeof(T));
                 assert(offset + size <= m_capacity);
-                memcpy(m_vbo.m_buffer + m_address + offset, &(vecs[0]), size);
+                memcpy(m_page->buffer + m_address + offset, &(vecs[0]), size);
                 return offset + size;
             }
 
             void freeBlock();
-
-            inline int compare(size_t address, size_t capacity) {
-                if (m_capacity < capacity) return -1;
-                if (m_capacity > capacity) return 1;
-                if (m_address < address) return -1;
-                if (m_address > address) return 1;
-                return 0;
-            }
         };
 
 		class VboException : public std::exception {
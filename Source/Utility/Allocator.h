@@ -20,6 +20,8 @@
 #ifndef TrenchBroom_Allocator_h
 #define TrenchBroom_Allocator_h
 
+#include "Utility/Atomic.h"
+
 #include <cassert>
 #include <iostream>
 #include <limits>
@@ -113,10 +115,14 @@ namespace TrenchBroom {
                 static ChunkList chunks;
                 return chunks;
             }
+            
+            // guards the pool and the chunk lists, since brushes may be edited on worker threads
+            static volatile long s_locked;
         public:
 #ifdef _ENABLE_ALLOCATOR
             inline void* operator new(size_t size) {
                 assert(size == sizeof(T));
+                SpinLocker locker(s_locked);
 
                 if (!pool().empty()) {
                     T* t = pool().top();
@@ -149,6 +155,7 @@ namespace TrenchBroom {
 
             inline void operator delete(void* block) {
                 T* t = reinterpret_cast<T*>(block);
+                SpinLocker locker(s_locked);
 
                 size_t poolSize = PoolSize;
                 if (poolSize > 0 && pool().size() < poolSize) {
@@ -201,6 +208,9 @@ namespace TrenchBroom {
             }
 #endif
         };
+        
+        template <class T, size_t PoolSize, size_t BlocksPerChunk>
+        volatile long Allocator<T, PoolSize, BlocksPerChunk>::s_locked = 0;
     }
 }
 
@@ -0,0 +1,128 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_Atomic_h
+#define TrenchBroom_Atomic_h
+
+#if defined _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedIncrement)
+#pragma intrinsic(_InterlockedDecrement)
+#pragma intrinsic(_InterlockedExchange)
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Atomically increments the given value and returns the result.
+         */
+        inline long atomicIncrement(volatile long& value) {
+#if defined _MSC_VER
+            return _InterlockedIncrement(&value);
+#else
+            return __sync_add_and_fetch(&value, 1);
+#endif
+        }
+        
+        /**
+         * Atomically decrements the given value and returns the result.
+         */
+        inline long atomicDecrement(volatile long& value) {
+#if defined _MSC_VER
+            return _InterlockedDecrement(&value);
+#else
+            return __sync_sub_and_fetch(&value, 1);
+#endif
+        }
+        
+        /**
+         * Busy waits until the given flag can be changed from 0 to 1.
+         */
+        inline void spinLock(volatile long& flag) {
+#if defined _MSC_VER
+            while (_InterlockedExchange(&flag, 1) != 0)
+                while (flag != 0);
+#else
+            while (__sync_lock_test_and_set(&flag, 1) != 0)
+                while (flag != 0);
+#endif
+        }
+        
+        inline void spinUnlock(volatile long& flag) {
+#if defined _MSC_VER
+            _InterlockedExchange(&flag, 0);
+#else
+            __sync_lock_release(&flag);
+#endif
+        }
+        
+        /**
+         * A lock for very short critical sections which must not depend on wxWidgets, e.g. in the allocators of the
+         * model classes. Busy waits while the lock is held by another thread.
+         */
+        class SpinLock {
+        private:
+            volatile long m_locked;
+            
+            SpinLock(const SpinLock& other);
+            SpinLock& operator=(const SpinLock& other);
+            
+            friend class SpinLocker;
+        public:
+            SpinLock() :
+            m_locked(0) {}
+            
+            inline void lock() {
+                spinLock(m_locked);
+            }
+            
+            inline void unlock() {
+                spinUnlock(m_locked);
+            }
+        };
+        
+        class SpinLocker {
+        private:
+            volatile long& m_flag;
+            
+            SpinLocker(const SpinLocker& other);
+            SpinLocker& operator=(const SpinLocker& other);
+        public:
+            SpinLocker(SpinLock& lock) :
+            m_flag(lock.m_locked) {
+                spinLock(m_flag);
+            }
+            
+            /**
+             * Locks a plain flag. Unlike a SpinLock, a static flag of type long is zero initialized before any code
+             * runs, so it can guard data which is first used concurrently by several threads.
+             */
+            SpinLocker(volatile long& flag) :
+            m_flag(flag) {
+                spinLock(m_flag);
+            }
+            
+            ~SpinLocker() {
+                spinUnlock(m_flag);
+            }
+        };
+    }
+}
+
+#endif
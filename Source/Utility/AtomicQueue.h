@@ -0,0 +1,96 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_AtomicQueue_h
+#define TrenchBroom_AtomicQueue_h
+
+#include <cstddef>
+
+#if defined _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedCompareExchangePointer)
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * A lock free queue that any number of threads may push to while a single consumer takes all pushed nodes at
+         * once. The nodes are intrusive: T must have a public member T* next, which the queue owns while the node is
+         * enqueued. Since the consumer always takes the entire list, popping is not subject to the ABA problem.
+         */
+        template <class T>
+        class AtomicQueue {
+        private:
+            T* volatile m_head;
+            
+            inline static bool compareAndSwap(T* volatile* address, T* expected, T* desired) {
+#if defined _MSC_VER
+                return _InterlockedCompareExchangePointer(reinterpret_cast<void* volatile*>(address), desired, expected) == expected;
+#else
+                return __sync_bool_compare_and_swap(address, expected, desired);
+#endif
+            }
+            
+            AtomicQueue(const AtomicQueue& other);
+            AtomicQueue& operator=(const AtomicQueue& other);
+        public:
+            AtomicQueue() :
+            m_head(NULL) {}
+            
+            /**
+             * Pushes the given node. Returns true if the queue was empty before, which lets producers wake up the
+             * consumer only once per batch.
+             */
+            inline bool push(T* node) {
+                T* head;
+                do {
+                    head = m_head;
+                    node->next = head;
+                } while (!compareAndSwap(&m_head, head, node));
+                return head == NULL;
+            }
+            
+            /**
+             * Removes all nodes from the queue and returns them as a list linked by T::next in the order in which
+             * they were pushed. The caller takes ownership of the nodes.
+             */
+            inline T* popAll() {
+                T* head;
+                do {
+                    head = m_head;
+                } while (head != NULL && !compareAndSwap(&m_head, head, NULL));
+                
+                T* reversed = NULL;
+                while (head != NULL) {
+                    T* next = head->next;
+                    head->next = reversed;
+                    reversed = head;
+                    head = next;
+                }
+                return reversed;
+            }
+            
+            inline bool empty() const {
+                return m_head == NULL;
+            }
+        };
+    }
+}
+
+#endif
@@ -19,6 +19,10 @@
 
 #include "CommandProcessor.h"
 
+#include "Controller/SnapshotStore.h"
+#include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
+
 #include <algorithm>
 #include <cassert>
 
@@ -74,6 +78,15 @@ CommandProcessor::CommandProcessor(int maxCommandLevel) :
 wxCommandProcessor(maxCommandLevel),
 m_block(NULL) {}
 
+CommandProcessor::~CommandProcessor() {
+    // release all snapshot records before the snapshot store is destroyed
+    while (!m_groupStack.empty()) {
+        delete m_groupStack.top();
+        m_groupStack.pop();
+    }
+    ClearCommands();
+}
+
 void CommandProcessor::BeginGroup(wxCommandProcessor* wxCommandProc, const wxString& name) {
     CommandProcessor* commandProc = static_cast<CommandProcessor*>(wxCommandProc);
     commandProc->BeginGroup(name);
@@ -132,7 +145,7 @@ void CommandProcessor::EndGroup() {
         delete group;
     } else {
         if (m_groupStack.empty())
-            wxCommandProcessor::Store(group);
+            Store(group);
         else
             m_groupStack.top()->addCommand(group);
     }
@@ -154,6 +167,30 @@ void CommandProcessor::DiscardGroup() {
     delete group;
 }
 
+bool CommandProcessor::DoCommand(wxCommand& command) {
+    TrenchBroom::Utility::ScopedTimer timer("Command::Do");
+    return wxCommandProcessor::DoCommand(command);
+}
+
+bool CommandProcessor::UndoCommand(wxCommand& command) {
+    TrenchBroom::Utility::ScopedTimer timer("Command::Undo");
+    return wxCommandProcessor::UndoCommand(command);
+}
+
+void CommandProcessor::trimHistory() {
+    using namespace TrenchBroom;
+    
+    Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+    const size_t budget = static_cast<size_t>(std::max(prefs.getInt(Preferences::UndoMemoryBudget), 0)) * 1024 * 1024;
+    const size_t dropped = m_snapshotStore.trimHistory(*this, budget);
+    
+    Utility::Profiler::count("Undo::levels", static_cast<int64_t>(m_commands.GetCount()));
+    Utility::Profiler::count("Undo::snapshotBytes", static_cast<int64_t>(m_snapshotStore.memoryUsage()));
+    Utility::Profiler::count("Undo::snapshotRecords", static_cast<int64_t>(m_snapshotStore.recordCount()));
+    if (dropped > 0)
+        Utility::Profiler::count("Undo::droppedLevels", static_cast<int64_t>(dropped));
+}
+
 bool CommandProcessor::Submit(wxCommand* command, bool storeIt) {
     if (m_groupStack.empty())
         return wxCommandProcessor::Submit(command, storeIt);
@@ -163,3 +200,24 @@ bool CommandProcessor::Submit(wxCommand* command, bool storeIt) {
         m_groupStack.top()->addCommand(command);
     return result;
 }
+
+void CommandProcessor::Store(wxCommand* command) {
+    wxCommandProcessor::Store(command);
+    trimHistory();
+}
+
+bool CommandProcessor::canDropOldestLevel() const {
+    if (m_commands.GetCount() <= 1)
+        return false;
+    wxList::compatibility_iterator first = m_commands.GetFirst();
+    return !(first == m_currentCommand);
+}
+
+void CommandProcessor::dropOldestLevel() {
+    wxList::compatibility_iterator first = m_commands.GetFirst();
+    wxCommand* command = static_cast<wxCommand*>(first->GetData());
+    delete command;
+    m_commands.Erase(first);
+    if (m_lastSavedCommand && m_lastSavedCommand == first)
+        m_lastSavedCommand = wxList::compatibility_iterator();
+}
@@ -20,6 +20,8 @@
 #ifndef __TrenchBroom__CommandProcessor__
 #define __TrenchBroom__CommandProcessor__
 
+#include "Controller/SnapshotStore.h"
+
 #include <wx/cmdproc.h>
 
 #include <stack>
@@ -43,14 +45,25 @@ public:
     bool Undo();
 };
 
-class CommandProcessor : public wxCommandProcessor {
+class CommandProcessor : public wxCommandProcessor, public TrenchBroom::Controller::SnapshotHistory {
 protected:
     typedef std::stack<CompoundCommand*> GroupStack;
 
     GroupStack m_groupStack;
     wxCommand* m_block;
+    TrenchBroom::Controller::SnapshotStore m_snapshotStore;
+    
+    bool DoCommand(wxCommand& command);
+    bool UndoCommand(wxCommand& command);
+    
+    /**
+     * Drops the oldest undo levels until the undo snapshots of this document fit into the memory budget set in the
+     * preferences. The most recent command is always kept.
+     */
+    void trimHistory();
 public:
     CommandProcessor(int maxCommandLevel = -1);
+    ~CommandProcessor();
 
     static void BeginGroup(wxCommandProcessor* wxCommandProc, const wxString& name);
     static void EndGroup(wxCommandProcessor* wxCommandProc);
@@ -68,6 +81,17 @@ public:
     void RollbackGroup();
     void DiscardGroup();
     bool Submit(wxCommand* command, bool storeIt = true);
+    void Store(wxCommand* command);
+    
+    /**
+     * Returns the store which holds the undo snapshot records of this processor's document.
+     */
+    inline TrenchBroom::Controller::SnapshotStore& snapshotStore() {
+        return m_snapshotStore;
+    }
+    
+    bool canDropOldestLevel() const;
+    void dropOldestLevel();
 };
 
 #endif /* defined(__TrenchBroom__CommandProcessor__) */
@@ -19,84 +19,190 @@
 
 #include "Console.h"
 
-#include "IO/FileManager.h"
-
-#if defined __APPLE__
-#include "NSLog.h"
-#endif
+#include "Utility/LogWriter.h"
 
 #include <cstdarg>
-#include <fstream>
-#include <wx/datetime.h>
 #include <wx/wx.h>
 
 namespace TrenchBroom {
     namespace Utility {
+        /**
+         * Messages that only differ in numbers, such as line numbers, are considered to be repetitions.
+         */
+        static String repeatKey(const String& message) {
+            String key;
+            key.reserve(message.size());
+            bool previousWasDigit = false;
+            for (size_t i = 0; i < message.size(); i++) {
+                const char c = message[i];
+                const bool digit = c >= '0' && c <= '9';
+                if (!digit)
+                    key.push_back(c);
+                else if (!previousWasDigit)
+                    key.push_back('#');
+                previousWasDigit = digit;
+            }
+            return key;
+        }
+
+        static String formatCount(size_t count) {
+            StringStream digits;
+            digits << count;
+            const String str = digits.str();
+
+            String result;
+            for (size_t i = 0; i < str.size(); i++) {
+                if (i > 0 && (str.size() - i) % 3 == 0)
+                    result.push_back(',');
+                result.push_back(str[i]);
+            }
+            return result;
+        }
+
+        bool Console::suppressRepeated(const LogMessage& message, LogMessageList& summaries) {
+            const String key = repeatKey(message.string());
+
+            wxCriticalSectionLocker lock(m_repeatLock);
+            if (message.level() == m_repeatLevel && key == m_repeatKey) {
+                m_repeatCount++;
+                if (m_repeatCount > RepeatLimit) {
+                    m_repeatMessage = message.string();
+                    m_suppressedCount++;
+                    return true;
+                }
+                return false;
+            }
+
+            summarizeSuppressed(summaries);
+            m_repeatKey = key;
+            m_repeatLevel = message.level();
+            m_repeatCount = 1;
+            return false;
+        }
+
+        void Console::summarizeSuppressed(LogMessageList& summaries) {
+            if (m_suppressedCount == 0)
+                return;
+
+            StringStream summary;
+            summary << formatCount(m_suppressedCount) << (m_suppressedCount == 1 ? " more message" : " more messages") << " like '" << m_repeatMessage << "'";
+            summaries.push_back(LogMessage(m_repeatLevel, summary.str()));
+            m_suppressedCount = 0;
+        }
+
+        void Console::enqueue(const LogMessage& message) {
+            if (m_pending.push(new PendingMessage(message)))
+                wxWakeUpIdle();
+        }
+
         void Console::logToDebug(const LogMessage& message) {
             // wxLogDebug(message.string().c_str());
         }
 
-        void Console::logToConsole(const LogMessage& message) {
-            long start = m_textCtrl->GetLastPosition();
-            m_textCtrl->AppendText(message.string());
-            m_textCtrl->AppendText("\n");
-            long end = m_textCtrl->GetLastPosition();
-            switch (message.level()) {
-                case LLDebug:
-                    m_textCtrl->SetStyle(start, end, wxTextAttr(*wxLIGHT_GREY, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
-                    break;
-                case LLInfo:
-                    m_textCtrl->SetStyle(start, end, wxTextAttr(*wxWHITE, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
-                    break;
-                case LLWarn:
-                    m_textCtrl->SetStyle(start, end, wxTextAttr(*wxYELLOW, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
-                    break;
-                case LLError:
-                    m_textCtrl->SetStyle(start, end, wxTextAttr(*wxRED, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
-                    break;
+        void Console::logToConsole(const LogMessageList& messages) {
+            m_textCtrl->Freeze();
+
+            size_t first = 0;
+            while (first < messages.size()) {
+                const LogLevel level = messages[first].level();
+                String text;
+                size_t last = first;
+                while (last < messages.size() && messages[last].level() == level) {
+                    text += messages[last].string();
+                    text += "\n";
+                    last++;
+                }
+
+                long start = m_textCtrl->GetLastPosition();
+                m_textCtrl->AppendText(text);
+                long end = m_textCtrl->GetLastPosition();
+                switch (level) {
+                    case LLDebug:
+                        m_textCtrl->SetStyle(start, end, wxTextAttr(*wxLIGHT_GREY, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
+                        break;
+                    case LLInfo:
+                        m_textCtrl->SetStyle(start, end, wxTextAttr(*wxWHITE, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
+                        break;
+                    case LLWarn:
+                        m_textCtrl->SetStyle(start, end, wxTextAttr(*wxYELLOW, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
+                        break;
+                    case LLError:
+                        m_textCtrl->SetStyle(start, end, wxTextAttr(*wxRED, *wxBLACK)); // SetDefaultStyle doesn't work on OS X / Cocoa
+                        break;
+                }
+                first = last;
             }
+
+            m_textCtrl->Thaw();
         }
 
         void Console::logToFile(const LogMessage& message) {
-#if defined __APPLE__
-            NSLogWrapper(message.string());
-#else
-            IO::FileManager fileManager;
-            const String logDirectory = fileManager.logDirectory();
-            if (logDirectory.empty())
-                return;
-            if (!fileManager.exists(logDirectory))
-                fileManager.makeDirectory(logDirectory);
-            const String logFilePath = fileManager.appendPath(logDirectory, "TrenchBroom.log");
-            std::fstream logStream(logFilePath.c_str(), std::ios::out | std::ios::app);
-            if (logStream.is_open()) {
-                wxDateTime now = wxDateTime::Now();
-                logStream << wxGetProcessId() << " " << now.FormatISOCombined(' ') << ": " << message.string() << std::endl;
+            // without a writer, e.g. in command line tools, messages are not written to the log file
+            if (LogWriter::sharedWriter != NULL)
+                LogWriter::sharedWriter->write(message.string());
+        }
+
+        Console::Console() :
+        m_textCtrl(NULL),
+        m_repeatLevel(LLDebug),
+        m_repeatCount(0),
+        m_suppressedCount(0) {}
+
+        Console::~Console() {
+            PendingMessage* pending = m_pending.popAll();
+            while (pending != NULL) {
+                PendingMessage* next = pending->next;
+                delete pending;
+                pending = next;
             }
-#endif
         }
 
         void Console::setTextCtrl(wxTextCtrl* textCtrl) {
             m_textCtrl = textCtrl;
-            if (m_textCtrl != NULL) {
-                for (unsigned int i = 0; i < m_buffer.size(); i++) {
-                    const LogMessage& message = m_buffer[i];
-                    logToConsole(message);
-                }
-                m_buffer.clear();
+            if (m_textCtrl != NULL)
+                flush();
+        }
+
+        void Console::flush() {
+            LogMessageList summaries;
+            {
+                wxCriticalSectionLocker lock(m_repeatLock);
+                summarizeSuppressed(summaries);
+            }
+            for (size_t i = 0; i < summaries.size(); i++)
+                enqueue(summaries[i]);
+
+            if (m_textCtrl == NULL)
+                return;
+
+            PendingMessage* pending = m_pending.popAll();
+            if (pending == NULL)
+                return;
+
+            LogMessageList messages;
+            while (pending != NULL) {
+                messages.push_back(pending->message);
+                PendingMessage* next = pending->next;
+                delete pending;
+                pending = next;
             }
+            logToConsole(messages);
         }
 
         void Console::log(const LogMessage& message) {
             if (message.string().empty())
                 return;
 
+            // repetitions are only suppressed in the text control, the log file receives every message
             logToDebug(message);
             logToFile(message);
-            if (m_textCtrl != NULL)
-                logToConsole(message);
-            else
-                m_buffer.push_back(message);
+
+            LogMessageList summaries;
+            const bool suppressed = suppressRepeated(message, summaries);
+            for (size_t i = 0; i < summaries.size(); i++)
+                enqueue(summaries[i]);
+            if (!suppressed)
+                enqueue(message);
         }
 
         void Console::debug(const String& message) {
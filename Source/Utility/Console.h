@@ -20,9 +20,11 @@
 #ifndef __TrenchBroom__Console__
 #define __TrenchBroom__Console__
 
+#include "Utility/AtomicQueue.h"
 #include "Utility/String.h"
 
 #include <wx/textctrl.h>
+#include <wx/thread.h>
 
 #include <vector>
 
@@ -74,18 +76,56 @@ namespace TrenchBroom {
             
             typedef std::vector<LogMessage> LogMessageList;
 
-            LogMessageList m_buffer;
+            class PendingMessage {
+            public:
+                PendingMessage* next;
+                LogMessage message;
+                
+                PendingMessage(const LogMessage& i_message) :
+                next(NULL),
+                message(i_message) {}
+            };
+            
+            /**
+             * The number of consecutive messages that are shown in the text control before further messages which
+             * only differ in numbers are suppressed there. The log file still receives all of them.
+             */
+            static const size_t RepeatLimit = 5;
             
+            AtomicQueue<PendingMessage> m_pending;
             wxTextCtrl* m_textCtrl;
             
+            wxCriticalSection m_repeatLock;
+            String m_repeatKey;
+            String m_repeatMessage;
+            LogLevel m_repeatLevel;
+            size_t m_repeatCount;
+            size_t m_suppressedCount;
+            
+            bool suppressRepeated(const LogMessage& message, LogMessageList& summaries);
+            void summarizeSuppressed(LogMessageList& summaries);
+            void enqueue(const LogMessage& message);
+            
             void logToDebug(const LogMessage& message);
-            void logToConsole(const LogMessage& message);
+            void logToConsole(const LogMessageList& messages);
             void logToFile(const LogMessage& message);
         public:
-            Console() : m_textCtrl(NULL) {}
+            Console();
+            ~Console();
             
             void setTextCtrl(wxTextCtrl* textCtrl);
             
+            /**
+             * Appends all pending messages to the text control in a single update. Must be called on the main thread,
+             * usually once per idle event.
+             */
+            void flush();
+            
+            /**
+             * Logs the given message. May be called from any thread; the message is written to the log file on a
+             * background thread and appended to the text control on the next call to flush. Repeated messages are
+             * only suppressed in the text control.
+             */
             void log(const LogMessage& message);
             
             void debug(const String& message);
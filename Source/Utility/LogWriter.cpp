@@ -0,0 +1,105 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LogWriter.h"
+
+#include "IO/FileManager.h"
+
+#if defined __APPLE__
+#include "NSLog.h"
+#endif
+
+#include <wx/utils.h>
+
+namespace TrenchBroom {
+    namespace Utility {
+        LogWriter* LogWriter::sharedWriter = NULL;
+        
+        bool LogWriter::openStream() {
+            if (m_stream.is_open())
+                return true;
+            if (m_streamFailed)
+                return false;
+            
+            IO::FileManager fileManager;
+            const String logDirectory = fileManager.logDirectory();
+            if (!logDirectory.empty()) {
+                if (!fileManager.exists(logDirectory))
+                    fileManager.makeDirectory(logDirectory);
+                const String logFilePath = fileManager.appendPath(logDirectory, "TrenchBroom.log");
+                m_stream.open(logFilePath.c_str(), std::ios::out | std::ios::app);
+            }
+            
+            m_streamFailed = !m_stream.is_open();
+            return !m_streamFailed;
+        }
+        
+        void LogWriter::writeQueuedEntries() {
+            LogEntry* entry = m_queue.popAll();
+            if (entry == NULL)
+                return;
+            
+#if defined __APPLE__
+            while (entry != NULL) {
+                NSLogWrapper(entry->message);
+                LogEntry* next = entry->next;
+                delete entry;
+                entry = next;
+            }
+#else
+            const bool write = openStream();
+            while (entry != NULL) {
+                if (write)
+                    m_stream << m_processId << " " << entry->time.FormatISOCombined(' ') << ": " << entry->message << "\n";
+                LogEntry* next = entry->next;
+                delete entry;
+                entry = next;
+            }
+            if (write)
+                m_stream.flush();
+#endif
+        }
+        
+        wxThread::ExitCode LogWriter::Entry() {
+            while (!TestDestroy()) {
+                writeQueuedEntries();
+                Sleep(WriteInterval);
+            }
+            writeQueuedEntries();
+            return (wxThread::ExitCode)0;
+        }
+        
+        LogWriter::LogWriter() :
+        wxThread(wxTHREAD_JOINABLE),
+        m_streamFailed(false),
+        m_processId(wxGetProcessId()) {
+            Create();
+            Run();
+        }
+        
+        LogWriter::~LogWriter() {
+            // messages logged after shutdown are written synchronously here
+            writeQueuedEntries();
+        }
+        
+        void LogWriter::shutdown() {
+            Delete();
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__LogWriter__
+#define __TrenchBroom__LogWriter__
+
+#include "Utility/AtomicQueue.h"
+#include "Utility/String.h"
+
+#include <fstream>
+
+#include <wx/datetime.h>
+#include <wx/thread.h>
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Writes log messages to the log file on a background thread. Any thread may enqueue messages without
+         * blocking; the writer keeps the log file open and writes and flushes the queued messages in batches.
+         */
+        class LogWriter : public wxThread {
+        private:
+            class LogEntry {
+            public:
+                LogEntry* next;
+                wxDateTime time;
+                String message;
+                
+                LogEntry(const String& i_message) :
+                next(NULL),
+                time(wxDateTime::UNow()),
+                message(i_message) {}
+            };
+            
+            static const unsigned long WriteInterval = 100;
+            
+            AtomicQueue<LogEntry> m_queue;
+            std::ofstream m_stream;
+            bool m_streamFailed;
+            unsigned long m_processId;
+            
+            bool openStream();
+            void writeQueuedEntries();
+            
+            ExitCode Entry();
+        public:
+            static LogWriter* sharedWriter;
+            
+            LogWriter();
+            ~LogWriter();
+            
+            inline void write(const String& message) {
+                m_queue.push(new LogEntry(message));
+            }
+            
+            /**
+             * Stops the writer thread after it has written all remaining messages. Must be called before the writer
+             * is deleted.
+             */
+            void shutdown();
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__LogWriter__) */
@@ -235,6 +235,12 @@ namespace TrenchBroom {
                 return *this;
             }
             
+            inline Mat<T,R,C>& correct(const T epsilon = Math<T>::CorrectEpsilon) {
+                for (size_t c = 0; c < C; c++)
+                    v[c].correct(epsilon);
+                return *this;
+            }
+            
             inline const Mat<T,C,R> transposed() const {
                 Mat<T,C,R> result;
                 for (size_t c = 0; c < C; c++)
@@ -559,6 +565,33 @@ namespace TrenchBroom {
             return scalingMatrix(Vec<T,3>(f, f, f));
         }
 
+        /**
+         * Returns whether the given affine transformation only permutes and negates the coordinate axes before
+         * translating, that is, whether it is a translation combined with any number of rotations by multiples of 90
+         * degrees about the coordinate axes and mirrorings along them.
+         */
+        template <typename T>
+        inline bool axisPermutationMatrix(const Mat<T,4,4>& mat, const T epsilon = Math<T>::AlmostZero) {
+            bool rowUsed[3] = { false, false, false };
+            for (size_t c = 0; c < 3; c++) {
+                size_t ones = 0;
+                for (size_t r = 0; r < 3; r++) {
+                    const T value = std::abs(mat[c][r]);
+                    if (Math<T>::eq(value, static_cast<T>(1.0), epsilon)) {
+                        if (rowUsed[r])
+                            return false;
+                        rowUsed[r] = true;
+                        ones++;
+                    } else if (!Math<T>::zero(value, epsilon)) {
+                        return false;
+                    }
+                }
+                if (ones != 1 || !Math<T>::zero(mat[c][3], epsilon))
+                    return false;
+            }
+            return Math<T>::eq(mat[3][3], static_cast<T>(1.0), epsilon);
+        }
+
         template <typename T, size_t R, size_t C>
         const Mat<T,R,C> Mat<T,R,C>::Identity = Mat<T,R,C>().setIdentity();
 
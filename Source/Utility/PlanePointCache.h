@@ -0,0 +1,138 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_PlanePointCache_h
+#define TrenchBroom_PlanePointCache_h
+
+#include "Utility/Atomic.h"
+#include "Utility/FindPlanePoints.h"
+#include "Utility/UnorderedMap.h"
+#include "Utility/VecMath.h"
+
+#include <cstring>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Remembers the plane points found for planes, so that a plane which occurs on many brushes is only searched
+         * once. Only the results of searches which started without any given points may be stored, since these
+         * depend on nothing but the plane. The cache is split into shards with their own locks, so that it can be
+         * shared by the items of a parallel task.
+         */
+        class PlanePointCache {
+        private:
+            /**
+             * Planes are compared by their exact components, so the cached points are exactly those which a search
+             * for the plane would return, no matter which brush searched first.
+             */
+            class Key {
+            private:
+                float m_values[4];
+            public:
+                Key(const Planef& plane) {
+                    m_values[0] = plane.normal.x();
+                    m_values[1] = plane.normal.y();
+                    m_values[2] = plane.normal.z();
+                    m_values[3] = plane.distance;
+
+                    // 0 and -0 are the same plane component, but have different bits
+                    for (size_t i = 0; i < 4; i++)
+                        if (m_values[i] == 0.0f)
+                            m_values[i] = 0.0f;
+                }
+
+                inline size_t hash() const {
+                    size_t result = 0;
+                    for (size_t i = 0; i < 4; i++) {
+                        unsigned int bits;
+                        std::memcpy(&bits, &m_values[i], sizeof(bits));
+                        result = result * 31u + bits;
+                    }
+                    return result;
+                }
+
+                inline bool operator== (const Key& other) const {
+                    for (size_t i = 0; i < 4; i++)
+                        if (m_values[i] != other.m_values[i])
+                            return false;
+                    return true;
+                }
+            };
+
+            class KeyHash {
+            public:
+                inline size_t operator() (const Key& key) const {
+                    return key.hash();
+                }
+            };
+
+            class Entry {
+            public:
+                Vec3f points[3];
+            };
+
+            typedef std::tr1::unordered_map<Key, Entry, KeyHash> EntryMap;
+
+            class Shard {
+            public:
+                SpinLock lock;
+                EntryMap entries;
+            };
+
+            static const size_t ShardCount = 64;
+            Shard m_shards[ShardCount];
+
+            inline Shard& shard(const Key& key) {
+                // the low bits of the hash select the bucket within the shard
+                return m_shards[(key.hash() >> 8) % ShardCount];
+            }
+        public:
+            /**
+             * Copies the points cached for the given plane and returns true, or returns false if there are none.
+             */
+            inline bool find(const Planef& plane, PlanePoints& points) {
+                const Key key(plane);
+                Shard& s = shard(key);
+                SpinLocker locker(s.lock);
+
+                EntryMap::const_iterator it = s.entries.find(key);
+                if (it == s.entries.end())
+                    return false;
+                for (size_t i = 0; i < 3; i++)
+                    points[i] = it->second.points[i];
+                return true;
+            }
+
+            inline void insert(const Planef& plane, const PlanePoints& points) {
+                const Key key(plane);
+                Entry entry;
+                for (size_t i = 0; i < 3; i++)
+                    entry.points[i] = points[i];
+
+                Shard& s = shard(key);
+                SpinLocker locker(s.lock);
+                s.entries.insert(EntryMap::value_type(key, entry));
+            }
+        };
+    }
+}
+
+#endif
@@ -40,6 +40,7 @@ namespace TrenchBroom {
 
         const Preference<float> InfoOverlayFadeDistance = Preference<float>(                    "Renderer/Info overlay fade distance",                          400.0f);
         const Preference<float> SelectedInfoOverlayFadeDistance = Preference<float>(            "Renderer/Selected info overlay fade distance",                 400.0f);
+        const Preference<float> EntityModelLodDistance = Preference<float>(                     "Renderer/Entity model LOD distance",                           2048.0f);
         const Preference<int>   RendererFontSize = Preference<int>(                             "Renderer/Font size",                                           13);
         const Preference<float> RendererBrightness = Preference<float>(                         "Renderer/Brightness",                                          1.0f);
         const Preference<float> GridAlpha = Preference<float>(                                  "Renderer/Grid Alpha",                                          0.25f);
@@ -159,6 +160,8 @@ namespace TrenchBroom {
         const int               RendererInstancingModeForceOn       = 1;
         const int               RendererInstancingModeForceOff      = 2;
 
+        const Preference<int>   UndoMemoryBudget = Preference<int>(                             "General/Undo memory budget",                                   256);
+
         const Preference<KeyboardShortcut>  CameraMoveForward = Preference<KeyboardShortcut>(   "Controls/Camera/Move Forward",     KeyboardShortcut(View::CommandIds::Menu::ViewMoveCameraForward, 'W', KeyboardShortcut::SCAny, "Move Camera Forward"));
         const Preference<KeyboardShortcut>  CameraMoveBackward = Preference<KeyboardShortcut>(  "Controls/Camera/Move Backward",    KeyboardShortcut(View::CommandIds::Menu::ViewMoveCameraForward, 'S', KeyboardShortcut::SCAny, "Move Camera Backward"));
         const Preference<KeyboardShortcut>  CameraMoveLeft = Preference<KeyboardShortcut>(      "Controls/Camera/Move Left",        KeyboardShortcut(View::CommandIds::Menu::ViewMoveCameraForward, 'A', KeyboardShortcut::SCAny, "Move Camera Left"));
@@ -449,6 +452,9 @@ namespace TrenchBroom {
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToEntityTab, '1', KeyboardShortcut::SCAny, "Switch to Entity Inspector"));
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToFaceTab, '2', KeyboardShortcut::SCAny, "Switch to Face Inspector"));
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToViewTab, '3', KeyboardShortcut::SCAny, "Switch to View Inspector"));
+            viewMenu->addSeparator();
+            viewMenu->addCheckItem(KeyboardShortcut(View::CommandIds::Menu::ViewToggleShowProfiler, KeyboardShortcut::SCAny, "Show Profiler"));
+            viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewExportProfilerTrace, KeyboardShortcut::SCAny, "Export Profiler Trace..."));
             return menus;
         }
 
@@ -257,6 +257,7 @@ namespace TrenchBroom {
 
         extern const Preference<float>  InfoOverlayFadeDistance;
         extern const Preference<float>  SelectedInfoOverlayFadeDistance;
+        extern const Preference<float>  EntityModelLodDistance;
         extern const Preference<int>    RendererFontSize;
         extern const Preference<float>  RendererBrightness;
         extern const Preference<float>  GridAlpha;
@@ -363,6 +364,11 @@ namespace TrenchBroom {
         extern const int                RendererInstancingModeAutodetect;
         extern const int                RendererInstancingModeForceOn;
         extern const int                RendererInstancingModeForceOff;
+        
+        /**
+         * The number of megabytes which the undo history of a document may use before its oldest levels are dropped.
+         */
+        extern const Preference<int>    UndoMemoryBudget;
 
         extern const Preference<KeyboardShortcut>   CameraMoveForward;
         extern const Preference<KeyboardShortcut>   CameraMoveBackward;
@@ -0,0 +1,203 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+
+#if defined _MSC_VER
+#include <intrin.h>
+#define TB_THREAD_LOCAL __declspec(thread)
+#else
+#define TB_THREAD_LOCAL __thread
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        // the buffer of the current thread and the profiler it belongs to
+        static TB_THREAD_LOCAL void* currentBuffer = NULL;
+        static TB_THREAD_LOCAL Profiler* currentOwner = NULL;
+        
+        inline static void memoryBarrier() {
+#if defined _MSC_VER
+            _ReadWriteBarrier();
+#else
+            __sync_synchronize();
+#endif
+        }
+        
+        bool Profiler::s_enabled = false;
+        Profiler* Profiler::sharedProfiler = NULL;
+        
+        Profiler::ThreadBuffer& Profiler::threadBuffer() {
+            if (currentBuffer == NULL || currentOwner != this) {
+                ThreadBuffer* buffer = new ThreadBuffer(wxThread::GetCurrentId());
+                
+                wxCriticalSectionLocker lock(m_buffersLock);
+                m_buffers.push_back(buffer);
+                currentBuffer = buffer;
+                currentOwner = this;
+            }
+            return *static_cast<ThreadBuffer*>(currentBuffer);
+        }
+        
+        void Profiler::record(const char* name, EventType type, int64_t timestamp, int64_t value) {
+            ThreadBuffer& buffer = threadBuffer();
+            
+            const size_t index = buffer.head;
+            const size_t slot = index % ThreadBuffer::Capacity;
+            buffer.sequences[slot] = 2 * index + 1;
+            memoryBarrier();
+            
+            Event& event = buffer.events[slot];
+            event.name = name;
+            event.type = type;
+            event.threadId = buffer.threadId;
+            event.timestamp = timestamp;
+            event.value = value;
+            
+            // publish the event only after it has been written completely
+            memoryBarrier();
+            buffer.sequences[slot] = 2 * index + 2;
+            buffer.head = index + 1;
+        }
+        
+        Profiler::Profiler() :
+        m_windowStart(0),
+        m_windowCount(0) {
+            m_clock.Start();
+        }
+        
+        Profiler::~Profiler() {
+            wxCriticalSectionLocker lock(m_buffersLock);
+            ThreadBufferList::iterator it, end;
+            for (it = m_buffers.begin(), end = m_buffers.end(); it != end; ++it)
+                delete *it;
+            m_buffers.clear();
+        }
+        
+        void Profiler::setEnabled(bool enabled) {
+            s_enabled = enabled;
+        }
+        
+        int64_t Profiler::now() const {
+            return static_cast<int64_t>(m_clock.TimeInMicro().GetValue());
+        }
+        
+        void Profiler::recordTimer(const char* name, int64_t start) {
+            const int64_t end = now();
+            record(name, TimerEvent, start, end - start);
+        }
+        
+        void Profiler::collect() {
+            EventList events;
+            
+            {
+                wxCriticalSectionLocker lock(m_buffersLock);
+                ThreadBufferList::iterator it, end;
+                for (it = m_buffers.begin(), end = m_buffers.end(); it != end; ++it) {
+                    ThreadBuffer& buffer = **it;
+                    
+                    const size_t head = buffer.head;
+                    memoryBarrier();
+                    
+                    size_t first = buffer.tail;
+                    if (head > ThreadBuffer::Capacity && first < head - ThreadBuffer::Capacity)
+                        first = head - ThreadBuffer::Capacity;
+                    
+                    // the owning thread may overwrite a slot while it is copied, so a slot is only taken if it
+                    // holds the complete expected event both before and after copying it
+                    for (size_t i = first; i < head; i++) {
+                        const size_t slot = i % ThreadBuffer::Capacity;
+                        const size_t sequence = buffer.sequences[slot];
+                        memoryBarrier();
+                        const Event event = buffer.events[slot];
+                        memoryBarrier();
+                        if (sequence == 2 * i + 2 && buffer.sequences[slot] == sequence)
+                            events.push_back(event);
+                    }
+                    
+                    buffer.tail = head;
+                }
+            }
+            
+            EventList::const_iterator it, end;
+            for (it = events.begin(), end = events.end(); it != end; ++it) {
+                const Event& event = *it;
+                Statistic& statistic = m_currentStatistics[event.name];
+                statistic.type = event.type;
+                statistic.count++;
+                statistic.total += event.value;
+                statistic.max = std::max(statistic.max, event.value);
+                statistic.last = event.value;
+                
+                m_history.push_back(event);
+            }
+            
+            while (m_history.size() > MaxHistorySize)
+                m_history.pop_front();
+            
+            const int64_t time = now();
+            if (time - m_windowStart >= StatisticWindow) {
+                m_statistics.swap(m_currentStatistics);
+                m_currentStatistics.clear();
+                m_windowStart = time;
+                m_windowCount++;
+            }
+        }
+        
+        void Profiler::clear() {
+            collect();
+            m_history.clear();
+            m_currentStatistics.clear();
+            m_statistics.clear();
+            m_windowCount++;
+        }
+
+        bool Profiler::writeChromeTrace(const String& path) {
+            collect();
+            
+            std::fstream stream(path.c_str(), std::ios::out | std::ios::trunc);
+            if (!stream.is_open())
+                return false;
+            
+            stream << "{\"traceEvents\":[";
+            
+            EventHistory::const_iterator it, end;
+            for (it = m_history.begin(), end = m_history.end(); it != end; ++it) {
+                const Event& event = *it;
+                if (it != m_history.begin())
+                    stream << ",";
+                stream << "\n{\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << event.threadId << ",\"ts\":" << event.timestamp;
+                if (event.type == TimerEvent)
+                    stream << ",\"ph\":\"X\",\"dur\":" << event.value << "}";
+                else
+                    stream << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+            }
+            
+            stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            
+            const bool success = stream.good();
+            stream.close();
+            return success;
+        }
+    }
+}
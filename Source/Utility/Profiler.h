@@ -0,0 +1,193 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__Profiler__
+#define __TrenchBroom__Profiler__
+
+#include "Utility/String.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+#ifdef _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Collects timings and counters from the hot paths of the editor. Every thread records into its own ring
+         * buffer without taking any locks; the buffers are drained on the main thread by calling collect(). When the
+         * profiler is disabled, recording costs a single branch.
+         */
+        class Profiler {
+        public:
+            typedef enum {
+                TimerEvent,
+                CounterEvent
+            } EventType;
+            
+            class Event {
+            public:
+                const char* name;
+                EventType type;
+                unsigned long threadId;
+                int64_t timestamp;
+                int64_t value; // the duration for timers, in microseconds
+            };
+            
+            typedef std::vector<Event> EventList;
+            
+            class Statistic {
+            public:
+                EventType type;
+                size_t count;
+                int64_t total;
+                int64_t max;
+                int64_t last;
+                
+                Statistic() :
+                type(TimerEvent),
+                count(0),
+                total(0),
+                max(0),
+                last(0) {}
+            };
+            
+            typedef std::map<String, Statistic> StatisticMap;
+        private:
+            class ThreadBuffer {
+            public:
+                static const size_t Capacity = 0x2000;
+                
+                Event events[Capacity];
+                // 2n+1 while event n is being written to the slot, 2n+2 once it is complete
+                volatile size_t sequences[Capacity];
+                volatile size_t head; // number of events ever written by the owning thread
+                size_t tail;          // number of events already collected
+                unsigned long threadId;
+                
+                ThreadBuffer(unsigned long i_threadId) :
+                head(0),
+                tail(0),
+                threadId(i_threadId) {
+                    for (size_t i = 0; i < Capacity; i++)
+                        sequences[i] = 0;
+                }
+            };
+            
+            typedef std::vector<ThreadBuffer*> ThreadBufferList;
+            typedef std::deque<Event> EventHistory;
+            
+            static const size_t MaxHistorySize = 0x40000;
+            static const int64_t StatisticWindow = 1000000;
+            
+            static bool s_enabled;
+            
+            wxStopWatch m_clock;
+            wxCriticalSection m_buffersLock;
+            ThreadBufferList m_buffers;
+            
+            EventHistory m_history;
+            StatisticMap m_currentStatistics;
+            StatisticMap m_statistics;
+            int64_t m_windowStart;
+            size_t m_windowCount;
+            
+            ThreadBuffer& threadBuffer();
+            void record(const char* name, EventType type, int64_t timestamp, int64_t value);
+        public:
+            static Profiler* sharedProfiler;
+            
+            Profiler();
+            ~Profiler();
+            
+            inline static bool enabled() {
+                return s_enabled && sharedProfiler != NULL;
+            }
+            
+            static void setEnabled(bool enabled);
+            
+            /**
+             * Records the given value for the named counter. The name must be a string literal or otherwise outlive
+             * the profiler.
+             */
+            inline static void count(const char* name, int64_t value) {
+                if (enabled())
+                    sharedProfiler->record(name, CounterEvent, sharedProfiler->now(), value);
+            }
+            
+            int64_t now() const;
+            void recordTimer(const char* name, int64_t start);
+            
+            /**
+             * Moves the events recorded by all threads into the history and updates the statistics. Must only be
+             * called from the main thread.
+             */
+            void collect();
+            void clear();
+            
+            /**
+             * Returns the statistics of the last complete window of one second.
+             */
+            inline const StatisticMap& statistics() const {
+                return m_statistics;
+            }
+            
+            /**
+             * Returns the number of windows completed so far, which allows to detect changes of the statistics.
+             */
+            inline size_t windowCount() const {
+                return m_windowCount;
+            }
+            
+            /**
+             * Writes the recorded history in the Chrome trace event format, which can be opened in chrome://tracing.
+             */
+            bool writeChromeTrace(const String& path);
+        };
+        
+        class ScopedTimer {
+        private:
+            const char* m_name;
+            int64_t m_start;
+            
+            // prevent copying
+            ScopedTimer(const ScopedTimer& other);
+            void operator= (const ScopedTimer& other);
+        public:
+            ScopedTimer(const char* name) :
+            m_name(name),
+            m_start(Profiler::enabled() ? Profiler::sharedProfiler->now() : -1) {}
+            
+            ~ScopedTimer() {
+                if (m_start >= 0 && Profiler::enabled())
+                    Profiler::sharedProfiler->recordTimer(m_name, m_start);
+            }
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__Profiler__) */
@@ -59,6 +59,13 @@ namespace TrenchBroom {
             }
             
             virtual void setText(const String& text) = 0;
+
+            /**
+             * Returns whether the user asked to stop the operation whose progress is indicated.
+             */
+            virtual bool cancelled() const {
+                return false;
+            }
         };
     }
 }
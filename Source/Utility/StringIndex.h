@@ -0,0 +1,212 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_StringIndex_h
+#define TrenchBroom_StringIndex_h
+
+#include "Utility/String.h"
+#include "Utility/UnorderedMap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * Indexes the trigrams of a set of names so that the values whose names contain a given substring can be
+         * found without comparing the substring against every name. All comparisons are case insensitive.
+         */
+        template <typename Value>
+        class StringIndex {
+        public:
+            typedef std::tr1::unordered_set<Value> ValueSet;
+
+            /**
+             * The matches of an incremental search. As long as the index does not change and each pattern contains
+             * the previous one, as it does while the user types, the previous matches are narrowed down instead of
+             * querying the index again.
+             */
+            class Search {
+            private:
+                String m_pattern;
+                ValueSet m_matches;
+                unsigned int m_revision;
+                bool m_valid;
+            public:
+                Search() :
+                m_revision(0),
+                m_valid(false) {}
+
+                void update(const StringIndex& index, const String& pattern) {
+                    const String lowerPattern = toLower(pattern);
+                    if (m_valid && m_revision == index.revision()) {
+                        if (lowerPattern == m_pattern)
+                            return;
+                        if (!m_pattern.empty() && lowerPattern.find(m_pattern) != String::npos) {
+                            index.narrow(lowerPattern, m_matches);
+                            m_pattern = lowerPattern;
+                            return;
+                        }
+                    }
+
+                    m_matches.clear();
+                    if (!lowerPattern.empty())
+                        index.find(lowerPattern, m_matches);
+                    m_pattern = lowerPattern;
+                    m_revision = index.revision();
+                    m_valid = true;
+                }
+
+                inline bool matches(Value value) const {
+                    return m_pattern.empty() || m_matches.count(value) > 0;
+                }
+            };
+        private:
+            typedef unsigned int Trigram;
+            typedef std::vector<Trigram> TrigramList;
+            typedef std::vector<Value> ValueList;
+            typedef std::tr1::unordered_map<Trigram, ValueList> TrigramMap;
+            typedef std::tr1::unordered_map<Value, String> NameMap;
+
+            TrigramMap m_trigrams;
+            NameMap m_names;
+            unsigned int m_revision;
+
+            static void trigrams(const String& str, TrigramList& result) {
+                for (size_t i = 0; i + 2 < str.size(); i++) {
+                    const Trigram trigram = (static_cast<Trigram>(static_cast<unsigned char>(str[i])) << 16 |
+                                             static_cast<Trigram>(static_cast<unsigned char>(str[i + 1])) << 8 |
+                                             static_cast<Trigram>(static_cast<unsigned char>(str[i + 2])));
+                    result.push_back(trigram);
+                }
+                std::sort(result.begin(), result.end());
+                result.erase(std::unique(result.begin(), result.end()), result.end());
+            }
+        public:
+            StringIndex() :
+            m_revision(0) {}
+
+            inline unsigned int revision() const {
+                return m_revision;
+            }
+
+            inline size_t size() const {
+                return m_names.size();
+            }
+
+            void add(const String& name, Value value) {
+                assert(m_names.count(value) == 0);
+
+                const String lowerName = toLower(name);
+                m_names[value] = lowerName;
+
+                TrigramList nameTrigrams;
+                trigrams(lowerName, nameTrigrams);
+                for (size_t i = 0; i < nameTrigrams.size(); i++)
+                    m_trigrams[nameTrigrams[i]].push_back(value);
+                m_revision++;
+            }
+
+            void remove(Value value) {
+                typename NameMap::iterator nameIt = m_names.find(value);
+                if (nameIt == m_names.end())
+                    return;
+
+                TrigramList nameTrigrams;
+                trigrams(nameIt->second, nameTrigrams);
+                for (size_t i = 0; i < nameTrigrams.size(); i++) {
+                    typename TrigramMap::iterator trigramIt = m_trigrams.find(nameTrigrams[i]);
+                    assert(trigramIt != m_trigrams.end());
+
+                    ValueList& values = trigramIt->second;
+                    typename ValueList::iterator valueIt = std::find(values.begin(), values.end(), value);
+                    assert(valueIt != values.end());
+                    *valueIt = values.back();
+                    values.pop_back();
+                    if (values.empty())
+                        m_trigrams.erase(trigramIt);
+                }
+
+                m_names.erase(nameIt);
+                m_revision++;
+            }
+
+            void clear() {
+                m_trigrams.clear();
+                m_names.clear();
+                m_revision++;
+            }
+
+            /**
+             * Adds the values whose names contain the given lower case pattern to the given set. Only the values
+             * listed under the rarest trigram of the pattern are compared against it. Patterns shorter than a trigram
+             * are compared against every name.
+             */
+            void find(const String& pattern, ValueSet& result) const {
+                if (pattern.size() < 3) {
+                    typename NameMap::const_iterator it, end;
+                    for (it = m_names.begin(), end = m_names.end(); it != end; ++it)
+                        if (it->second.find(pattern) != String::npos)
+                            result.insert(it->first);
+                    return;
+                }
+
+                TrigramList patternTrigrams;
+                trigrams(pattern, patternTrigrams);
+
+                const ValueList* candidates = NULL;
+                for (size_t i = 0; i < patternTrigrams.size(); i++) {
+                    typename TrigramMap::const_iterator trigramIt = m_trigrams.find(patternTrigrams[i]);
+                    if (trigramIt == m_trigrams.end())
+                        return;
+                    if (candidates == NULL || trigramIt->second.size() < candidates->size())
+                        candidates = &trigramIt->second;
+                }
+
+                assert(candidates != NULL);
+                typename ValueList::const_iterator it, end;
+                for (it = candidates->begin(), end = candidates->end(); it != end; ++it) {
+                    typename NameMap::const_iterator nameIt = m_names.find(*it);
+                    assert(nameIt != m_names.end());
+                    if (nameIt->second.find(pattern) != String::npos)
+                        result.insert(*it);
+                }
+            }
+
+            /**
+             * Removes the values from the given set whose names do not contain the given lower case pattern.
+             */
+            void narrow(const String& pattern, ValueSet& values) const {
+                ValueList mismatches;
+                typename ValueSet::const_iterator it, end;
+                for (it = values.begin(), end = values.end(); it != end; ++it) {
+                    typename NameMap::const_iterator nameIt = m_names.find(*it);
+                    if (nameIt == m_names.end() || nameIt->second.find(pattern) == String::npos)
+                        mismatches.push_back(*it);
+                }
+
+                for (size_t i = 0; i < mismatches.size(); i++)
+                    values.erase(mismatches[i]);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerPool.h"
+
+#include "Utility/Atomic.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Utility {
+        WorkerPool* WorkerPool::sharedPool = NULL;
+        
+        wxThread::ExitCode WorkerPool::Worker::Entry() {
+            m_pool.workerLoop();
+            return (wxThread::ExitCode)0;
+        }
+        
+        WorkerPool::Worker::Worker(WorkerPool& pool) :
+        wxThread(wxTHREAD_JOINABLE),
+        m_pool(pool) {}
+        
+        void WorkerPool::runItems(ParallelTask& task, size_t count) {
+            // items are handed out one at a time, as their cost varies a lot
+            long index = atomicIncrement(m_nextIndex) - 1;
+            while (index >= 0 && static_cast<size_t>(index) < count) {
+                task.run(static_cast<size_t>(index));
+                index = atomicIncrement(m_nextIndex) - 1;
+            }
+        }
+        
+        void WorkerPool::workerLoop() {
+            unsigned long generation = 0;
+            while (true) {
+                ParallelTask* task = NULL;
+                size_t count = 0;
+                {
+                    wxMutexLocker lock(m_mutex);
+                    while (!m_shutdown && m_generation == generation)
+                        m_workAvailable.Wait();
+                    if (m_shutdown)
+                        return;
+                    
+                    generation = m_generation;
+                    if (m_task == NULL)
+                        continue; // woke up too late, the task is already done
+                    task = m_task;
+                    count = m_count;
+                    m_activeWorkers++;
+                }
+                
+                runItems(*task, count);
+                
+                {
+                    wxMutexLocker lock(m_mutex);
+                    m_activeWorkers--;
+                    if (m_activeWorkers == 0)
+                        m_workDone.Broadcast();
+                }
+            }
+        }
+        
+        WorkerPool::WorkerPool(size_t threadCount) :
+        m_workAvailable(m_mutex),
+        m_workDone(m_mutex),
+        m_task(NULL),
+        m_count(0),
+        m_nextIndex(0),
+        m_generation(0),
+        m_activeWorkers(0),
+        m_shutdown(false) {
+            if (threadCount == 0) {
+                const int cpuCount = wxThread::GetCPUCount();
+                threadCount = cpuCount > 1 ? static_cast<size_t>(cpuCount - 1) : 0;
+            }
+            
+            for (size_t i = 0; i < threadCount; i++) {
+                Worker* worker = new Worker(*this);
+                if (worker->Create() != wxTHREAD_NO_ERROR || worker->Run() != wxTHREAD_NO_ERROR) {
+                    delete worker;
+                    break;
+                }
+                m_workers.push_back(worker);
+            }
+        }
+        
+        WorkerPool::~WorkerPool() {
+            {
+                wxMutexLocker lock(m_mutex);
+                m_shutdown = true;
+                m_workAvailable.Broadcast();
+            }
+            
+            WorkerList::const_iterator it, end;
+            for (it = m_workers.begin(), end = m_workers.end(); it != end; ++it) {
+                Worker* worker = *it;
+                worker->Wait();
+                delete worker;
+            }
+            m_workers.clear();
+        }
+        
+        void WorkerPool::run(ParallelTask& task, size_t count) {
+            if (count == 0)
+                return;
+            
+            if (m_workers.empty() || count == 1) {
+                for (size_t i = 0; i < count; i++)
+                    task.run(i);
+                return;
+            }
+            
+            {
+                wxMutexLocker lock(m_mutex);
+                assert(m_task == NULL);
+                m_task = &task;
+                m_count = count;
+                m_nextIndex = 0;
+                m_generation++;
+                m_workAvailable.Broadcast();
+            }
+            
+            runItems(task, count);
+            
+            wxMutexLocker lock(m_mutex);
+            while (m_activeWorkers > 0)
+                m_workDone.Wait();
+            m_task = NULL;
+        }
+        
+        void WorkerPool::execute(ParallelTask& task, size_t count) {
+            if (sharedPool != NULL) {
+                sharedPool->run(task, count);
+            } else {
+                for (size_t i = 0; i < count; i++)
+                    task.run(i);
+            }
+        }
+    }
+}
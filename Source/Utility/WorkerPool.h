@@ -0,0 +1,91 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__WorkerPool__
+#define __TrenchBroom__WorkerPool__
+
+#include <cstddef>
+#include <vector>
+
+#include <wx/thread.h>
+
+namespace TrenchBroom {
+    namespace Utility {
+        /**
+         * A task which consists of a number of independent items, e.g. one per brush. The items may be run
+         * concurrently and in any order, so each item must only write to its own results. Items must not throw.
+         */
+        class ParallelTask {
+        public:
+            virtual ~ParallelTask() {}
+            virtual void run(size_t index) = 0;
+        };
+        
+        /**
+         * A fixed set of worker threads which run the items of parallel tasks. The calling thread takes part in the
+         * work, and run() only returns once all items are done. Must only be used from the main thread.
+         */
+        class WorkerPool {
+        private:
+            class Worker : public wxThread {
+            private:
+                WorkerPool& m_pool;
+            protected:
+                ExitCode Entry();
+            public:
+                Worker(WorkerPool& pool);
+            };
+            
+            typedef std::vector<Worker*> WorkerList;
+            
+            WorkerList m_workers;
+            wxMutex m_mutex;
+            wxCondition m_workAvailable;
+            wxCondition m_workDone;
+            
+            ParallelTask* m_task;
+            size_t m_count;
+            volatile long m_nextIndex;
+            unsigned long m_generation;
+            size_t m_activeWorkers;
+            bool m_shutdown;
+            
+            void runItems(ParallelTask& task, size_t count);
+            void workerLoop();
+        public:
+            static WorkerPool* sharedPool;
+            
+            /**
+             * Creates a pool with the given number of worker threads. If the number is 0, one thread less than
+             * there are processors is created, since the calling thread also works.
+             */
+            WorkerPool(size_t threadCount = 0);
+            ~WorkerPool();
+            
+            void run(ParallelTask& task, size_t count);
+            
+            /**
+             * Runs the given task on the shared pool, or on the calling thread if there is no shared pool.
+             */
+            static void execute(ParallelTask& task, size_t count);
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__WorkerPool__) */
@@ -26,11 +26,15 @@
 #include <wx/fs_mem.h>
 
 #include "IO/FileManager.h"
+#include "IO/GameFileSystem.h"
 #include "IO/Pak.h"
 #include "Model/Alias.h"
 #include "Model/Bsp.h"
 #include "Model/MapDocument.h"
 #include "Utility/DocManager.h"
+#include "Utility/LogWriter.h"
+#include "Utility/Profiler.h"
+#include "Utility/WorkerPool.h"
 #include "View/AboutDialog.h"
 #include "View/CommandIds.h"
 #include "View/EditorFrame.h"
@@ -212,9 +216,13 @@ bool AbstractApp::OnInit() {
     m_preferencesFrame = NULL;
 
     // initialize globals
+    TrenchBroom::Utility::LogWriter::sharedWriter = new TrenchBroom::Utility::LogWriter();
     TrenchBroom::IO::PakManager::sharedManager = new TrenchBroom::IO::PakManager();
+    TrenchBroom::IO::GameFileSystem::sharedFileSystem = new TrenchBroom::IO::GameFileSystem();
     TrenchBroom::Model::AliasManager::sharedManager = new TrenchBroom::Model::AliasManager();
     TrenchBroom::Model::BspManager::sharedManager = new TrenchBroom::Model::BspManager();
+    TrenchBroom::Utility::Profiler::sharedProfiler = new TrenchBroom::Utility::Profiler();
+    TrenchBroom::Utility::WorkerPool::sharedPool = new TrenchBroom::Utility::WorkerPool();
 
 	m_docManager = new DocManager();
     m_docManager->FileHistoryLoad(*wxConfig::Get());
@@ -256,12 +264,22 @@ int AbstractApp::OnExit() {
     wxDELETE(m_docManager);
     wxDELETE(m_helpController);
 
+    delete TrenchBroom::IO::GameFileSystem::sharedFileSystem;
+    TrenchBroom::IO::GameFileSystem::sharedFileSystem = NULL;
     delete TrenchBroom::IO::PakManager::sharedManager;
     TrenchBroom::IO::PakManager::sharedManager = NULL;
     delete TrenchBroom::Model::AliasManager::sharedManager;
     TrenchBroom::Model::AliasManager::sharedManager = NULL;
     delete TrenchBroom::Model::BspManager::sharedManager;
     TrenchBroom::Model::BspManager::sharedManager = NULL;
+    delete TrenchBroom::Utility::WorkerPool::sharedPool;
+    TrenchBroom::Utility::WorkerPool::sharedPool = NULL;
+    TrenchBroom::Utility::Profiler::setEnabled(false);
+    delete TrenchBroom::Utility::Profiler::sharedProfiler;
+    TrenchBroom::Utility::Profiler::sharedProfiler = NULL;
+    TrenchBroom::Utility::LogWriter::sharedWriter->shutdown();
+    delete TrenchBroom::Utility::LogWriter::sharedWriter;
+    TrenchBroom::Utility::LogWriter::sharedWriter = NULL;
 
     return wxApp::OnExit();
 }
@@ -88,7 +88,7 @@ namespace TrenchBroom {
             }
 
             inline bool intersectsY(float y, float height) const {
-                return bottom() >= y || top() <= y + height;
+                return bottom() >= y && top() <= y + height;
             }
         };
 
@@ -352,15 +352,26 @@ namespace TrenchBroom {
                 }
             }
 
+            /**
+             * Returns the index of the first row whose bottom is below the given y coordinate, or the
+             * number of rows if there is no such row. The rows are stacked from top to bottom, so this
+             * is a binary search.
+             */
             size_t indexOfRowAt(float y) const {
-                for (size_t i = 0; i < m_rows.size(); i++) {
-                    const Row& row = m_rows[i];
-                    const LayoutBounds& rowBounds = row.bounds();
-                    if (y < rowBounds.bottom())
-                        return i;
+                size_t first = 0;
+                size_t count = m_rows.size();
+                while (count > 0) {
+                    const size_t step = count / 2;
+                    const size_t index = first + step;
+                    if (m_rows[index].bounds().bottom() <= y) {
+                        first = index + 1;
+                        count -= step + 1;
+                    } else {
+                        count = step;
+                    }
                 }
                 
-                return m_rows.size();
+                return first;
             }
             
             bool rowAt(float y, const Row** result) const {
@@ -373,18 +384,16 @@ namespace TrenchBroom {
             }
             
             bool cellAt(float x, float y, const typename Row::Cell** result) const {
-                for (unsigned int i = 0; i < m_rows.size(); i++) {
-                    const Row& row = m_rows[i];
-                    const LayoutBounds& rowBounds = row.bounds();
-                    if (y > rowBounds.bottom())
-                        continue;
-                    else if (y < rowBounds.top())
-                        break;
-                    if (row.cellAt(x, y, result))
-                        return true;
-                }
-
-                return false;
+                size_t index = indexOfRowAt(y);
+                if (index > 0 && m_rows[index - 1].bounds().bottom() == y) // cells include their bottom edge
+                    index--;
+                if (index == m_rows.size())
+                    return false;
+                
+                const Row& row = m_rows[index];
+                if (y < row.bounds().top())
+                    return false;
+                return row.cellAt(x, y, result);
             }
 
             bool hitTest(float x, float y) const {
@@ -563,22 +572,40 @@ namespace TrenchBroom {
                 invalidate();
             }
 
-            bool cellAt(float x, float y, const typename Group::Row::Cell** result) {
+            /**
+             * Returns the index of the first group whose bottom is not above the given y coordinate, or
+             * the number of groups if there is no such group. Together with LayoutGroup::indexOfRowAt,
+             * this finds the first visible row without visiting the rows above it.
+             */
+            size_t indexOfGroupAt(float y) {
                 if (!m_valid)
                     validate();
-
-                for (unsigned int i = 0; i < m_groups.size(); i++) {
-                    const Group& group = m_groups[i];
-                    const LayoutBounds groupBounds = group.bounds();
-                    if (y > groupBounds.bottom())
-                        continue;
-                    else if (y < groupBounds.top())
-                        break;
-                    if (group.cellAt(x, y, result))
-                        return true;
+                
+                size_t first = 0;
+                size_t count = m_groups.size();
+                while (count > 0) {
+                    const size_t step = count / 2;
+                    const size_t index = first + step;
+                    if (m_groups[index].bounds().bottom() < y) {
+                        first = index + 1;
+                        count -= step + 1;
+                    } else {
+                        count = step;
+                    }
                 }
-
-                return false;
+                
+                return first;
+            }
+            
+            bool cellAt(float x, float y, const typename Group::Row::Cell** result) {
+                const size_t index = indexOfGroupAt(y);
+                if (index == m_groups.size())
+                    return false;
+                
+                const Group& group = m_groups[index];
+                if (y < group.bounds().top())
+                    return false;
+                return group.cellAt(x, y, result);
             }
 
             bool groupAt(float x, float y, Group* result) {
@@ -609,16 +636,7 @@ namespace TrenchBroom {
                 if (!m_valid)
                     validate();
 
-                size_t groupIndex = m_groups.size();
-                for (size_t i = 0; i < m_groups.size(); i++) {
-                    Group* candidate = &m_groups[i];
-                    const LayoutBounds groupBounds = candidate->bounds();
-                    if (y + m_rowMargin > groupBounds.bottom())
-                        continue;
-                    groupIndex = i;
-                    break;
-                }
-
+                size_t groupIndex = indexOfGroupAt(y + m_rowMargin);
                 if (groupIndex == m_groups.size())
                     return y;
                 
@@ -724,7 +742,7 @@ namespace TrenchBroom {
             }
             
             inline float outerMargin() const {
-                return m_outerMargin();
+                return m_outerMargin;
             }
             
             inline float groupMargin() const {
@@ -736,7 +754,7 @@ namespace TrenchBroom {
             }
             
             inline float cellMargin() const {
-                return m_cellMargin();
+                return m_cellMargin;
             }
         };
     }
@@ -127,6 +127,8 @@ namespace TrenchBroom {
                 static const int EditPrintFilePositions             = Lowest + 101;
                 static const int EditToggleAxisRestriction          = Lowest + 102;
                 static const int EditClipBySelected                 = Lowest + 103;
+                static const int ViewToggleShowProfiler             = Lowest + 104;
+                static const int ViewExportProfilerTrace            = Lowest + 105;
                 static const int Highest                            = Lowest + 199;
             }
             
@@ -156,6 +158,7 @@ namespace TrenchBroom {
                 static const int ShowHintBrushesCheckBoxId          = Lowest +  13;
                 static const int ShowLiquidBrushesCheckBoxId        = Lowest +  14;
                 static const int ShowTriggerBrushesCheckBoxId       = Lowest +  15;
+                static const int ShowOccludedCellsCheckBoxId        = Lowest +  16;
                 static const int Highest                            = Lowest +  99;
             }
             
@@ -176,6 +179,8 @@ namespace TrenchBroom {
                 static const int EnableAltMoveCheckBoxId            = Lowest +  13;
                 static const int MoveCameraInCursorDirCheckBoxId    = Lowest +  14;
                 static const int TextureBrowserIconSideChoiceId     = Lowest +  15;
+                static const int EntityModelLodSliderId             = Lowest +  16;
+                static const int EntityClassnameLodSliderId         = Lowest +  17;
                 static const int Highest                            = Lowest +  99;
             }
 
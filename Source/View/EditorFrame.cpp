@@ -283,6 +283,9 @@ namespace TrenchBroom {
                 m_focusMapCanvasOnIdle--;
             }
 
+            if (m_documentViewHolder.valid())
+                m_documentViewHolder.document().console().flush();
+
             // FIXME: Workaround for a bug in Ubuntu GTK where menus are not updated
             // This will be fixed in wxWidgets 2.9.5: http://trac.wxwidgets.org/ticket/14302
             // Unfortunately right now this leads to a crash after the "Navigate Up" item is invoked.
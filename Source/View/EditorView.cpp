@@ -61,6 +61,7 @@
 #include "Utility/Grid.h"
 #include "Utility/List.h"
 #include "Utility/Preferences.h"
+#include "Utility/Profiler.h"
 #include "View/AbstractApp.h"
 #include "View/CameraAnimation.h"
 #include "View/CommandIds.h"
@@ -75,6 +76,7 @@
 
 #include <wx/clipbrd.h>
 #include <wx/dataobj.h>
+#include <wx/filedlg.h>
 #include <wx/tokenzr.h>
 
 namespace TrenchBroom {
@@ -197,6 +199,8 @@ namespace TrenchBroom {
         EVT_MENU(CommandIds::Menu::ViewSwitchToEntityTab, EditorView::OnViewSwitchToEntityInspector)
         EVT_MENU(CommandIds::Menu::ViewSwitchToFaceTab, EditorView::OnViewSwitchToFaceInspector)
         EVT_MENU(CommandIds::Menu::ViewSwitchToViewTab, EditorView::OnViewSwitchToViewInspector)
+        EVT_MENU(CommandIds::Menu::ViewToggleShowProfiler, EditorView::OnViewToggleShowProfiler)
+        EVT_MENU(CommandIds::Menu::ViewExportProfilerTrace, EditorView::OnViewExportProfilerTrace)
 
         EVT_UPDATE_UI(wxID_SAVE, EditorView::OnUpdateMenuItem)
         EVT_UPDATE_UI(wxID_UNDO, EditorView::OnUpdateMenuItem)
@@ -1624,6 +1628,11 @@ namespace TrenchBroom {
         }
 
         void EditorView::OnEditNavigateUp(wxCommandEvent& event) {
+            if (inputController().dragging()) {
+                inputController().cancelDrag();
+                return;
+            }
+            
             if (!inputController().navigateUp()) {
                 wxCommand* command = Controller::ChangeEditStateCommand::deselectAll(mapDocument());
                 submit(command);
@@ -1811,6 +1820,25 @@ namespace TrenchBroom {
             inspector().switchToInspector(2);
         }
 
+        void EditorView::OnViewToggleShowProfiler(wxCommandEvent& event) {
+            const bool enable = !Utility::Profiler::enabled();
+            if (enable)
+                Utility::Profiler::sharedProfiler->clear();
+            Utility::Profiler::setEnabled(enable);
+            OnUpdate(this);
+        }
+
+        void EditorView::OnViewExportProfilerTrace(wxCommandEvent& event) {
+            wxFileDialog saveTraceDialog(NULL, wxT("Export profiler trace"), wxT(""), wxT("trace.json"), wxT("JSON files (*.json)|*.json"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+            if (saveTraceDialog.ShowModal() == wxID_OK) {
+                const String path = saveTraceDialog.GetPath().ToStdString();
+                if (Utility::Profiler::sharedProfiler->writeChromeTrace(path))
+                    console().info("Exported profiler trace to %s", path.c_str());
+                else
+                    console().error("Unable to export profiler trace to %s", path.c_str());
+            }
+        }
+
         void EditorView::OnUpdateMenuItem(wxUpdateUIEvent& event) {
             AbstractApp* app = static_cast<AbstractApp*>(wxTheApp);
             if (app->preferencesFrame() != NULL) {
@@ -1987,7 +2015,7 @@ namespace TrenchBroom {
                     event.Enable(true);
                     break;
                 case CommandIds::Menu::EditNavigateUp:
-                    event.Enable(editStateManager.selectionMode() != Model::EditStateManager::SMNone);
+                    event.Enable(inputController().dragging() || editStateManager.selectionMode() != Model::EditStateManager::SMNone);
                     break;
                 case CommandIds::Menu::EditShowMapProperties:
                     event.Enable(true);
@@ -2070,6 +2098,13 @@ namespace TrenchBroom {
                 case CommandIds::Menu::ViewSwitchToViewTab:
                     event.Enable(true);
                     break;
+                case CommandIds::Menu::ViewToggleShowProfiler:
+                    event.Enable(Utility::Profiler::sharedProfiler != NULL);
+                    event.Check(Utility::Profiler::enabled());
+                    break;
+                case CommandIds::Menu::ViewExportProfilerTrace:
+                    event.Enable(Utility::Profiler::sharedProfiler != NULL);
+                    break;
             }
         }
 
@@ -236,6 +236,8 @@ namespace TrenchBroom {
             void OnViewSwitchToEntityInspector(wxCommandEvent& event);
             void OnViewSwitchToFaceInspector(wxCommandEvent& event);
             void OnViewSwitchToViewInspector(wxCommandEvent& event);
+            void OnViewToggleShowProfiler(wxCommandEvent& event);
+            void OnViewExportProfilerTrace(wxCommandEvent& event);
             
             void OnUpdateMenuItem(wxUpdateUIEvent& event);
             
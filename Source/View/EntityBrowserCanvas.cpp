@@ -41,7 +41,7 @@
 namespace TrenchBroom {
     namespace View {
         void EntityBrowserCanvas::addEntityToLayout(Layout& layout, Model::PointEntityDefinition* definition, const Renderer::Text::FontDescriptor& font) {
-            if ((!m_hideUnused || definition->usageCount() > 0) && (m_filterText.empty() || Utility::containsString(definition->name(), m_filterText, false))) {
+            if ((!m_hideUnused || definition->usageCount() > 0) && m_search.matches(definition)) {
                 Renderer::Text::FontManager& fontManager =  m_documentViewHolder.document().sharedResources().fontManager();
                 const float maxCellWidth = layout.maxCellWidth();
                 const Renderer::Text::FontDescriptor actualFont = fontManager.selectFontSize(font, definition->name(), maxCellWidth, 5);
@@ -124,6 +124,7 @@ namespace TrenchBroom {
 
             Renderer::Text::FontDescriptor font(fontName, static_cast<unsigned int>(fontSize));
             IO::FileManager fileManager;
+            m_search.update(definitionManager.index(), m_filterText);
 
             if (m_group) {
                 Model::EntityDefinitionManager::EntityDefinitionGroups groups = definitionManager.groups(Model::EntityDefinition::PointEntity, m_sortOrder);
@@ -153,7 +154,7 @@ namespace TrenchBroom {
 
         void EntityBrowserCanvas::doRender(Layout& layout, float y, float height) {
             if (m_vbo == NULL)
-                m_vbo = new Renderer::Vbo(GL_ARRAY_BUFFER, 0xFFFF);
+                m_vbo = new Renderer::Vbo(GL_ARRAY_BUFFER, 0xFFFF, Renderer::Vbo::StreamUsage);
 
             Renderer::ShaderManager& shaderManager = m_documentViewHolder.document().sharedResources().shaderManager();
             Renderer::Text::FontManager& fontManager = m_documentViewHolder.document().sharedResources().fontManager();
@@ -325,6 +326,8 @@ namespace TrenchBroom {
                     font->deactivate();
                 }
             }
+            
+            m_vbo->endFrame();
         }
 
         bool EntityBrowserCanvas::dndEnabled() {
@@ -70,6 +70,7 @@ namespace TrenchBroom {
             bool m_hideUnused;
             Model::EntityDefinitionManager::SortOrder m_sortOrder;
             String m_filterText;
+            Model::EntityDefinitionIndex::Search m_search;
 
             void addEntityToLayout(Layout& layout, Model::PointEntityDefinition* definition, const Renderer::Text::FontDescriptor& font);
             void renderEntityBounds(Renderer::Transformation& transformation, Renderer::ShaderProgram& boundsProgram, const Model::PointEntityDefinition& definition, const BBoxf& rotatedBounds, const Vec3f& offset, float scaling);
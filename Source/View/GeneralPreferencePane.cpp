@@ -41,12 +41,17 @@ namespace TrenchBroom {
             static const int MinimumLabelWidth = 100;
         }
 
+        // the entity LOD distance sliders move in steps of this many units
+        static const float LodDistanceSliderStep = 128.0f;
+
         BEGIN_EVENT_TABLE(GeneralPreferencePane, wxPanel)
         EVT_BUTTON(CommandIds::GeneralPreferencePane::ChooseQuakePathButtonId, GeneralPreferencePane::OnChooseQuakePathClicked)
 
         EVT_COMMAND_SCROLL(CommandIds::GeneralPreferencePane::BrightnessSliderId, GeneralPreferencePane::OnViewSliderChanged)
         EVT_COMMAND_SCROLL(CommandIds::GeneralPreferencePane::GridAlphaSliderId, GeneralPreferencePane::OnViewSliderChanged)
         EVT_CHOICE(CommandIds::GeneralPreferencePane::GridModeChoiceId, GeneralPreferencePane::OnGridModeChoice)
+        EVT_COMMAND_SCROLL(CommandIds::GeneralPreferencePane::EntityModelLodSliderId, GeneralPreferencePane::OnViewSliderChanged)
+        EVT_COMMAND_SCROLL(CommandIds::GeneralPreferencePane::EntityClassnameLodSliderId, GeneralPreferencePane::OnViewSliderChanged)
         EVT_CHOICE(CommandIds::GeneralPreferencePane::InstancingModeModeChoiceId, GeneralPreferencePane::OnInstancingModeChoice)
         EVT_CHOICE(CommandIds::GeneralPreferencePane::TextureBrowserIconSideChoiceId, GeneralPreferencePane::OnTextureBrowserIconSizeChoice)
 
@@ -72,6 +77,8 @@ namespace TrenchBroom {
             m_brightnessSlider->SetValue(static_cast<int>(prefs.getFloat(Preferences::RendererBrightness) * 40.0f));
             m_gridAlphaSlider->SetValue(static_cast<int>(prefs.getFloat(Preferences::GridAlpha) * m_gridAlphaSlider->GetMax()));
             m_gridModeChoice->SetSelection(prefs.getBool(Preferences::GridCheckerboard) ? 1 : 0);
+            m_entityModelLodSlider->SetValue(static_cast<int>(prefs.getFloat(Preferences::EntityModelLodDistance) / LodDistanceSliderStep));
+            m_entityClassnameLodSlider->SetValue(static_cast<int>(prefs.getFloat(Preferences::InfoOverlayFadeDistance) / LodDistanceSliderStep));
 
             int instancingMode = prefs.getInt(Preferences::RendererInstancingMode);
             if (instancingMode == Preferences::RendererInstancingModeAutodetect)
@@ -147,6 +154,12 @@ namespace TrenchBroom {
             wxString gridModes[2] = {"Lines", "Checkerboard"};
             m_gridModeChoice = new wxChoice(viewBox, CommandIds::GeneralPreferencePane::GridModeChoiceId, wxDefaultPosition, wxDefaultSize, 2, gridModes);
 
+            wxStaticText* entityModelLodLabel = new wxStaticText(viewBox, wxID_ANY, wxT("Model distance"));
+            m_entityModelLodSlider = new wxSlider(viewBox, CommandIds::GeneralPreferencePane::EntityModelLodSliderId, 16, 1, 64, wxDefaultPosition, wxDefaultSize, wxSL_HORIZONTAL | wxSL_BOTTOM);
+            
+            wxStaticText* entityClassnameLodLabel = new wxStaticText(viewBox, wxID_ANY, wxT("Classname distance"));
+            m_entityClassnameLodSlider = new wxSlider(viewBox, CommandIds::GeneralPreferencePane::EntityClassnameLodSliderId, 3, 1, 64, wxDefaultPosition, wxDefaultSize, wxSL_HORIZONTAL | wxSL_BOTTOM);
+            
             wxStaticText* instancingModeFakeLabel = new wxStaticText(viewBox, wxID_ANY, wxT(""));
             wxStaticText* instancingModeLabel = new wxStaticText(viewBox, wxID_ANY, wxT("Use OpenGL instancing"));
             wxString instancingModes[3] = {"Autodetect", "Force on", "Force off"};
@@ -180,6 +193,10 @@ namespace TrenchBroom {
             innerSizer->Add(m_gridAlphaSlider, 0, wxEXPAND);
             innerSizer->Add(gridModeFakeLabel);
             innerSizer->Add(gridModeSizer);
+            innerSizer->Add(entityModelLodLabel);
+            innerSizer->Add(m_entityModelLodSlider, 0, wxEXPAND);
+            innerSizer->Add(entityClassnameLodLabel);
+            innerSizer->Add(m_entityClassnameLodSlider, 0, wxEXPAND);
             innerSizer->Add(instancingModeFakeLabel);
             innerSizer->Add(instancingModeSizer);
             innerSizer->Add(textureBrowserFakeLabel);
@@ -314,6 +331,20 @@ namespace TrenchBroom {
                     static_cast<TrenchBroomApp*>(wxTheApp)->UpdateAllViews(NULL, &preferenceChangeEvent);
                     break;
                 }
+                case CommandIds::GeneralPreferencePane::EntityModelLodSliderId: {
+                    prefs.setFloat(Preferences::EntityModelLodDistance, value * LodDistanceSliderStep);
+
+                    Controller::PreferenceChangeEvent preferenceChangeEvent(Preferences::EntityModelLodDistance);
+                    static_cast<TrenchBroomApp*>(wxTheApp)->UpdateAllViews(NULL, &preferenceChangeEvent);
+                    break;
+                }
+                case CommandIds::GeneralPreferencePane::EntityClassnameLodSliderId: {
+                    prefs.setFloat(Preferences::InfoOverlayFadeDistance, value * LodDistanceSliderStep);
+
+                    Controller::PreferenceChangeEvent preferenceChangeEvent(Preferences::InfoOverlayFadeDistance);
+                    static_cast<TrenchBroomApp*>(wxTheApp)->UpdateAllViews(NULL, &preferenceChangeEvent);
+                    break;
+                }
                 default:
                     break;
             }
@@ -39,6 +39,8 @@ namespace TrenchBroom {
             wxSlider* m_brightnessSlider;
             wxSlider* m_gridAlphaSlider;
             wxChoice* m_gridModeChoice;
+            wxSlider* m_entityModelLodSlider;
+            wxSlider* m_entityClassnameLodSlider;
             wxChoice* m_textureBrowserIconSizeChoice;
             wxChoice* m_instancingModeChoice;
             wxSlider* m_lookSpeedSlider;
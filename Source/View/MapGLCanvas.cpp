@@ -139,6 +139,7 @@ namespace TrenchBroom {
         m_documentViewHolder(documentViewHolder),
         m_glContext(new wxGLContext(this, documentViewHolder.document().sharedResources().sharedContext())),
         m_vbo(NULL),
+        m_streamVbo(NULL),
         m_inputController(new Controller::InputController(documentViewHolder)),
         m_overlayRenderer(NULL),
         m_hasFocus(false),
@@ -156,6 +157,8 @@ namespace TrenchBroom {
             m_overlayRenderer = NULL;
             delete m_vbo;
             m_vbo = NULL;
+            delete m_streamVbo;
+            m_streamVbo = NULL;
             wxDELETE(m_glContext);
         }
 
@@ -217,7 +220,9 @@ namespace TrenchBroom {
 
                 Renderer::ShaderManager& shaderManager = m_documentViewHolder.document().sharedResources().shaderManager();
                 Utility::Grid& grid = m_documentViewHolder.document().grid();
-				Renderer::RenderContext renderContext(view.camera(), view.filter(), shaderManager, grid, view.viewOptions(), inputController().inputState(), view.console());
+                if (m_streamVbo == NULL)
+                    m_streamVbo = new Renderer::Vbo(GL_ARRAY_BUFFER, 0xFFFF, Renderer::Vbo::StreamUsage);
+				Renderer::RenderContext renderContext(view.camera(), view.filter(), shaderManager, *m_streamVbo, grid, view.viewOptions(), inputController().inputState(), view.console());
 
                 // render the scene
 				view.renderer().render(renderContext);
@@ -229,8 +234,9 @@ namespace TrenchBroom {
 
                 // render overlays
                 if (m_overlayRenderer == NULL)
-                    m_overlayRenderer = new Renderer::OverlayRenderer();
+                    m_overlayRenderer = new Renderer::OverlayRenderer(m_documentViewHolder.document().sharedResources().fontManager());
                 m_overlayRenderer->render(renderContext, GetClientSize().x, GetClientSize().y);
+                m_streamVbo->endFrame();
 
                 // render focus rectangle
                 if (m_hasFocus) {
@@ -75,6 +75,7 @@ namespace TrenchBroom {
             
             wxGLContext* m_glContext;
             Renderer::Vbo* m_vbo;
+            Renderer::Vbo* m_streamVbo;
             Controller::InputController* m_inputController;
             Renderer::OverlayRenderer* m_overlayRenderer;
             
@@ -441,7 +441,8 @@ namespace TrenchBroom {
 
         void MapPropertiesDialog::OnIntFacePointsCheckBoxClicked(wxCommandEvent& event) {
             if (wxMessageBox(wxT("Changing this setting may change all brushes in your map and lead to leaks and other problems. You should only change this if your compiler cannot handle floating point coordinates.\n\n Are you sure you want to change this setting? This cannot be undone."), wxT("Force integer plane point coordinates"), wxYES_NO | wxICON_EXCLAMATION, this) == wxYES) {
-                m_document->setForceIntegerCoordinates(event.IsChecked());
+                if (!m_document->setForceIntegerCoordinates(event.IsChecked()))
+                    m_intFacePointsCheckBox->SetValue(!event.IsChecked());
             } else {
                 m_intFacePointsCheckBox->SetValue(!event.IsChecked());
             }
@@ -32,8 +32,13 @@ namespace TrenchBroom {
             m_dialog->Update(static_cast<int>(percent()));
         }
 
-        ProgressIndicatorDialog::ProgressIndicatorDialog() {
-            m_dialog = new wxProgressDialog("Progress", "Please wait...", 100, NULL, wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_SMOOTH);
+        ProgressIndicatorDialog::ProgressIndicatorDialog(bool cancellable, bool modal) {
+            int style = wxPD_AUTO_HIDE | wxPD_SMOOTH;
+            if (cancellable)
+                style |= wxPD_CAN_ABORT;
+            if (modal)
+                style |= wxPD_APP_MODAL;
+            m_dialog = new wxProgressDialog("Progress", "Please wait...", 100, NULL, style);
         }
         
         ProgressIndicatorDialog::~ProgressIndicatorDialog() {
@@ -48,5 +53,9 @@ namespace TrenchBroom {
         void ProgressIndicatorDialog::pulse() {
             m_dialog->Pulse();
         }
+
+        bool ProgressIndicatorDialog::cancelled() const {
+            return m_dialog->WasCancelled();
+        }
     }
 }
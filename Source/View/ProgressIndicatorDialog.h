@@ -33,11 +33,16 @@ namespace TrenchBroom {
             void doReset();
             void doUpdate();
         public:
-            ProgressIndicatorDialog();
+            /**
+             * Creates a dialog with a cancel button if cancellable is true. Unless the dialog is modal, the user can
+             * keep working with the application while it is shown.
+             */
+            ProgressIndicatorDialog(bool cancellable = false, bool modal = true);
             ~ProgressIndicatorDialog();
 
             void setText(const String& text);
             void pulse();
+            bool cancelled() const;
         };
     }
 }
@@ -40,6 +40,7 @@
 #include "View/EditorView.h"
 #include "View/TextureSelectedCommand.h"
 
+#include <algorithm>
 #include <cassert>
 
 using namespace TrenchBroom::VecMath;
@@ -47,11 +48,18 @@ using namespace TrenchBroom::VecMath;
 namespace TrenchBroom {
     namespace View {
         void TextureBrowserCanvas::addTextureToLayout(Layout& layout, Model::Texture* texture, const Renderer::Text::FontDescriptor& font) {
-            if ((!m_hideUnused || texture->usageCount() > 0) && (m_filterText.empty() || Utility::containsString(texture->name(), m_filterText, false))) {
-                Renderer::Text::FontManager& fontManager =  m_documentViewHolder.document().sharedResources().fontManager();
-                const float maxCellWidth = layout.maxCellWidth();
-                const Renderer::Text::FontDescriptor actualFont = fontManager.selectFontSize(font, texture->name(), maxCellWidth, 5);
-                const Vec2f actualSize = fontManager.font(actualFont)->measure(texture->name());
+            if ((!m_hideUnused || texture->usageCount() > 0) && m_search.matches(texture)) {
+                TextureTitleCache::iterator titleIt = m_titleCache.find(texture);
+                if (titleIt == m_titleCache.end()) {
+                    Renderer::Text::FontManager& fontManager =  m_documentViewHolder.document().sharedResources().fontManager();
+                    const float maxCellWidth = layout.maxCellWidth();
+                    const Renderer::Text::FontDescriptor actualFont = fontManager.selectFontSize(font, texture->name(), maxCellWidth, 5);
+                    Renderer::Text::TexturedFont* actualTexturedFont = fontManager.font(actualFont);
+                    const Vec2f actualSize = actualTexturedFont->measure(texture->name());
+                    const Vec2f::List titleVertices = actualTexturedFont->quads(texture->name(), false);
+                    titleIt = m_titleCache.insert(TextureTitleCache::value_type(texture, TextureTitle(actualFont, actualSize.x(), titleVertices))).first;
+                }
+                const TextureTitle& title = titleIt->second;
 
                 Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
                 const float scaleFactor = prefs.getFloat(Preferences::TextureBrowserIconSize);
@@ -60,7 +68,7 @@ namespace TrenchBroom {
 
                 Renderer::TextureRendererManager& textureRendererManager = m_documentViewHolder.document().sharedResources().textureRendererManager();
                 Renderer::TextureRenderer& textureRenderer = textureRendererManager.renderer(texture);
-                layout.addItem(TextureCellData(texture, &textureRenderer, actualFont), scaledTextureWidth, scaledTextureHeight, actualSize.x(), font.size() + 2.0f);
+                layout.addItem(TextureCellData(texture, &textureRenderer, title.fontDescriptor, title.vertices), scaledTextureWidth, scaledTextureHeight, title.width, font.size() + 2.0f);
             }
         }
 
@@ -87,6 +95,17 @@ namespace TrenchBroom {
             Renderer::Text::FontDescriptor font(fontName, static_cast<unsigned int>(fontSize));
             IO::FileManager fileManager;
 
+            const Model::TextureIndex& index = textureManager.index();
+            if (fontName != m_titleCacheFontName || font.size() != m_titleCacheFontSize ||
+                layout.maxCellWidth() != m_titleCacheCellWidth || index.revision() != m_titleCacheRevision) {
+                m_titleCache.clear();
+                m_titleCacheFontName = fontName;
+                m_titleCacheFontSize = font.size();
+                m_titleCacheCellWidth = layout.maxCellWidth();
+                m_titleCacheRevision = index.revision();
+            }
+            m_search.update(index, m_filterText);
+
             if (m_group) {
                 const Model::TextureCollectionList& collections = textureManager.collections();
                 for (size_t i = 0; i < collections.size(); i++) {
@@ -109,6 +128,28 @@ namespace TrenchBroom {
         }
 
         void TextureBrowserCanvas::doClear() {
+            m_titleCache.clear();
+        }
+
+        void TextureBrowserCanvas::collectVisibleCells(Layout& layout, float y, float height) {
+            m_visibleGroups.clear();
+            m_visibleCells.clear();
+
+            const float bottom = y + height;
+            for (size_t i = layout.indexOfGroupAt(y); i < layout.size(); i++) {
+                const Layout::Group& group = layout[i];
+                if (group.bounds().top() > bottom)
+                    break;
+                m_visibleGroups.push_back(&group);
+
+                for (size_t j = group.indexOfRowAt(y); j < group.size(); j++) {
+                    const Layout::Group::Row& row = group[j];
+                    if (row.bounds().top() > bottom)
+                        break;
+                    for (size_t k = 0; k < row.size(); k++)
+                        m_visibleCells.push_back(&row[k]);
+                }
+            }
         }
 
         void TextureBrowserCanvas::doRender(Layout& layout, float y, float height) {
@@ -134,173 +175,170 @@ namespace TrenchBroom {
             const Mat4f view = viewMatrix(Vec3f::NegZ, Vec3f::PosY) * translationMatrix(Vec3f(0.0f, 0.0f, 0.1f));
             Renderer::Transformation transformation(projection, view);
 
-            size_t visibleGroupCount = 0;
-            size_t visibleItemCount = 0;
+            collectVisibleCells(layout, y, height);
+
+            // keep the vertex lists of the fonts used so far so that their memory is reused
+            StringMap::iterator stringIt, stringEnd;
+            for (stringIt = m_stringVertices.begin(), stringEnd = m_stringVertices.end(); stringIt != stringEnd; ++stringIt)
+                stringIt->second.clear();
+            size_t stringVertexCount = 0;
+
+            for (size_t i = 0; i < m_visibleGroups.size(); i++) {
+                const Layout::Group& group = *m_visibleGroups[i];
+                Model::TextureCollection* collection = group.item();
+                if (collection != NULL && !collection->name().empty()) {
+                    const LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
+                    const Vec2f offset(titleBounds.left() + 2.0f, height - (titleBounds.top() - y) - titleBounds.height());
+
+                    Renderer::Text::TexturedFont* font = fontManager.font(defaultDescriptor);
+                    Vec2f::List titleVertices = font->quads(collection->name(), false, offset);
+                    Vec2f::List& vertices = m_stringVertices[defaultDescriptor];
+                    vertices.insert(vertices.end(), titleVertices.begin(), titleVertices.end());
+                    stringVertexCount += titleVertices.size() / 2;
+                }
+            }
 
-            typedef std::map<Renderer::Text::FontDescriptor, Vec2f::List> StringMap;
-            StringMap stringVertices;
+            for (size_t i = 0; i < m_visibleCells.size(); i++) {
+                const Layout::Group::Row::Cell& cell = *m_visibleCells[i];
+                const LayoutBounds titleBounds = cell.titleBounds();
 
-            for (unsigned int i = 0; i < layout.size(); i++) {
-                const Layout::Group& group = layout[i];
-                if (group.intersectsY(y, height)) {
-                    visibleGroupCount++;
-
-                    Model::TextureCollection* collection = group.item();
-                    if (collection != NULL && !collection->name().empty()) {
-                        const LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
-                        const Vec2f offset(titleBounds.left() + 2.0f, height - (titleBounds.top() - y) - titleBounds.height());
-
-                        Renderer::Text::TexturedFont* font = fontManager.font(defaultDescriptor);
-                        Vec2f::List titleVertices = font->quads(collection->name(), false, offset);
-                        Vec2f::List& vertices = stringVertices[defaultDescriptor];
-                        vertices.insert(vertices.end(), titleVertices.begin(), titleVertices.end());
-                    }
+                // the cached quads are at the origin, and the font rounds its offsets to whole pixels
+                const Vec2f offset(Math<float>::round(titleBounds.left() + 2.0f),
+                                   Math<float>::round(height - (titleBounds.top() - y) - titleBounds.height()));
 
-                    for (unsigned int j = 0; j < group.size(); j++) {
-                        const Layout::Group::Row& row = group[j];
-                        if (row.intersectsY(y, height)) {
-                            for (unsigned int k = 0; k < row.size(); k++) {
-                                visibleItemCount++;
-
-                                const Layout::Group::Row::Cell& cell = row[k];
-                                const LayoutBounds titleBounds = cell.titleBounds();
-                                const Vec2f offset(titleBounds.left() + 2.0f, height - (titleBounds.top() - y) - titleBounds.height());
-
-                                Renderer::Text::TexturedFont* font = fontManager.font(cell.item().fontDescriptor);
-                                Vec2f::List titleVertices = font->quads(cell.item().texture->name(), false, offset);
-                                Vec2f::List& vertices = stringVertices[cell.item().fontDescriptor];
-                                vertices.insert(vertices.end(), titleVertices.begin(), titleVertices.end());
-                            }
-                        }
-                    }
+                const Vec2f::List& titleVertices = cell.item().titleVertices;
+                Vec2f::List& vertices = m_stringVertices[cell.item().fontDescriptor];
+                for (size_t j = 0; j < titleVertices.size(); j += 2) {
+                    vertices.push_back(titleVertices[j] + offset);
+                    vertices.push_back(titleVertices[j + 1]);
                 }
+                stringVertexCount += titleVertices.size() / 2;
             }
 
-            if (visibleItemCount > 0) { // render borders
-                unsigned int vertexCount = static_cast<unsigned int>(4 * visibleItemCount);
-                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, vertexCount,
-                                                  Renderer::Attribute::position2f(),
-                                                  Renderer::Attribute::color4f());
+            if (!m_visibleCells.empty()) { // render borders
+                const size_t vertexCount = 4 * m_visibleCells.size();
+                if (m_borderArray == NULL || m_borderArray->vertexCapacity() < vertexCount) {
+                    const size_t capacity = m_borderArray == NULL ? vertexCount : std::max(vertexCount, 2 * m_borderArray->vertexCapacity());
+                    delete m_borderArray;
+                    m_borderArray = new Renderer::VertexArray(*m_vbo, GL_QUADS, capacity,
+                                                              Renderer::Attribute::position2f(),
+                                                              Renderer::Attribute::color4f());
+                }
 
                 Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
-                for (unsigned int i = 0; i < layout.size(); i++) {
-                    const Layout::Group& group = layout[i];
-                    if (group.intersectsY(y, height)) {
-                        for (unsigned int j = 0; j < group.size(); j++) {
-                            const Layout::Group::Row& row = group[j];
-                            if (row.intersectsY(y, height)) {
-                                for (unsigned int k = 0; k < row.size(); k++) {
-                                    const Layout::Group::Row::Cell& cell = row[k];
-
-                                    bool selected = cell.item().texture == m_selectedTexture;
-                                    bool inUse = cell.item().texture->usageCount() > 0;
-                                    bool overridden = cell.item().texture->overridden();
-
-                                    if (selected || inUse || overridden) {
-                                        const Color& color = selected ? prefs.getColor(Preferences::SelectedTextureColor) : (inUse ? prefs.getColor(Preferences::UsedTextureColor) : prefs.getColor(Preferences::OverriddenTextureColor));
-
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                        vertexArray.addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
-                                        vertexArray.addAttribute(color);
-                                    }
-                                }
-                            }
-                        }
+                m_borderArray->reset();
+                for (size_t i = 0; i < m_visibleCells.size(); i++) {
+                    const Layout::Group::Row::Cell& cell = *m_visibleCells[i];
+
+                    bool selected = cell.item().texture == m_selectedTexture;
+                    bool inUse = cell.item().texture->usageCount() > 0;
+                    bool overridden = cell.item().texture->overridden();
+
+                    if (selected || inUse || overridden) {
+                        const Color& color = selected ? prefs.getColor(Preferences::SelectedTextureColor) : (inUse ? prefs.getColor(Preferences::UsedTextureColor) : prefs.getColor(Preferences::OverriddenTextureColor));
+
+                        m_borderArray->addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
+                        m_borderArray->addAttribute(color);
+                        m_borderArray->addAttribute(Vec2f(cell.itemBounds().left() - 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
+                        m_borderArray->addAttribute(color);
+                        m_borderArray->addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().bottom() + 1.5f - y)));
+                        m_borderArray->addAttribute(color);
+                        m_borderArray->addAttribute(Vec2f(cell.itemBounds().right() + 1.5f, height - (cell.itemBounds().top() - 1.5f - y)));
+                        m_borderArray->addAttribute(color);
                     }
                 }
 
                 Renderer::SetVboState activateVbo(*m_vbo, Renderer::Vbo::VboActive);
                 Renderer::ActivateShader shader(shaderManager, Renderer::Shaders::TextureBrowserBorderShader);
-                vertexArray.render();
+                m_borderArray->render();
             }
 
             { // render textures
                 Renderer::ActivateShader shader(shaderManager, Renderer::Shaders::TextureBrowserShader);
                 shader.setUniformVariable("ApplyTinting", false);
                 shader.setUniformVariable("Brightness", prefs.getFloat(Preferences::RendererBrightness));
-                for (unsigned int i = 0; i < layout.size(); i++) {
-                    const Layout::Group& group = layout[i];
-                    if (group.intersectsY(y, height)) {
-                        for (unsigned int j = 0; j < group.size(); j++) {
-                            const Layout::Group::Row& row = group[j];
-                            if (row.intersectsY(y, height)) {
-                                for (unsigned int k = 0; k < row.size(); k++) {
-                                    const Layout::Group::Row::Cell& cell = row[k];
-                                    shader.setUniformVariable("GrayScale", cell.item().texture->overridden());
-                                    shader.setUniformVariable("Texture", 0);
-                                    cell.item().textureRenderer->activate();
-                                    glBegin(GL_QUADS);
-                                    glTexCoord2f(0.0f, 0.0f);
-                                    glVertex2f(cell.itemBounds().left(), height - (cell.itemBounds().top() - y));
-                                    glTexCoord2f(0.0f, 1.0f);
-                                    glVertex2f(cell.itemBounds().left(), height - (cell.itemBounds().bottom() - y));
-                                    glTexCoord2f(1.0f, 1.0f);
-                                    glVertex2f(cell.itemBounds().right(), height - (cell.itemBounds().bottom() - y));
-                                    glTexCoord2f(1.0f, 0.0f);
-                                    glVertex2f(cell.itemBounds().right(), height - (cell.itemBounds().top() - y));
-                                    glEnd();
-                                    cell.item().textureRenderer->deactivate();
-                                }
-                            }
-                        }
-                    }
+                for (size_t i = 0; i < m_visibleCells.size(); i++) {
+                    const Layout::Group::Row::Cell& cell = *m_visibleCells[i];
+                    shader.setUniformVariable("GrayScale", cell.item().texture->overridden());
+                    shader.setUniformVariable("Texture", 0);
+                    cell.item().textureRenderer->activate();
+                    glBegin(GL_QUADS);
+                    glTexCoord2f(0.0f, 0.0f);
+                    glVertex2f(cell.itemBounds().left(), height - (cell.itemBounds().top() - y));
+                    glTexCoord2f(0.0f, 1.0f);
+                    glVertex2f(cell.itemBounds().left(), height - (cell.itemBounds().bottom() - y));
+                    glTexCoord2f(1.0f, 1.0f);
+                    glVertex2f(cell.itemBounds().right(), height - (cell.itemBounds().bottom() - y));
+                    glTexCoord2f(1.0f, 0.0f);
+                    glVertex2f(cell.itemBounds().right(), height - (cell.itemBounds().top() - y));
+                    glEnd();
+                    cell.item().textureRenderer->deactivate();
                 }
             }
 
-            if (visibleGroupCount > 0) { // render group title background
-                unsigned int vertexCount = static_cast<unsigned int>(4 * visibleGroupCount);
-                Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, vertexCount,
-                                                  Renderer::Attribute::position2f());
+            if (!m_visibleGroups.empty()) { // render group title background
+                const size_t vertexCount = 4 * m_visibleGroups.size();
+                if (m_groupTitleArray == NULL || m_groupTitleArray->vertexCapacity() < vertexCount) {
+                    const size_t capacity = m_groupTitleArray == NULL ? vertexCount : std::max(vertexCount, 2 * m_groupTitleArray->vertexCapacity());
+                    delete m_groupTitleArray;
+                    m_groupTitleArray = new Renderer::VertexArray(*m_vbo, GL_QUADS, capacity,
+                                                                  Renderer::Attribute::position2f());
+                }
 
                 Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
-                for (unsigned int i = 0; i < layout.size(); i++) {
-                    const Layout::Group& group = layout[i];
-                    if (group.intersectsY(y, height)) {
-                        if (group.item() != NULL) {
-                            LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
-                            vertexArray.addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.top() - y)));
-                            vertexArray.addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.bottom() - y)));
-                            vertexArray.addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.bottom() - y)));
-                            vertexArray.addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.top() - y)));
-                        }
+                m_groupTitleArray->reset();
+                for (size_t i = 0; i < m_visibleGroups.size(); i++) {
+                    const Layout::Group& group = *m_visibleGroups[i];
+                    if (group.item() != NULL) {
+                        LayoutBounds titleBounds = layout.titleBoundsForVisibleRect(group, y, height);
+                        m_groupTitleArray->addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.top() - y)));
+                        m_groupTitleArray->addAttribute(Vec2f(titleBounds.left(), height - (titleBounds.bottom() - y)));
+                        m_groupTitleArray->addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.bottom() - y)));
+                        m_groupTitleArray->addAttribute(Vec2f(titleBounds.right(), height - (titleBounds.top() - y)));
                     }
                 }
 
                 Renderer::SetVboState activateVbo(*m_vbo, Renderer::Vbo::VboActive);
                 Renderer::ActivateShader shader(shaderManager, Renderer::Shaders::BrowserGroupShader);
                 shader.setUniformVariable("Color", prefs.getColor(Preferences::BrowserGroupBackgroundColor));
-                vertexArray.render();
+                m_groupTitleArray->render();
             }
 
-            if (!stringVertices.empty()) { // render strings
-                StringMap::iterator it, end;
-                for (it = stringVertices.begin(), end = stringVertices.end(); it != end; ++it) {
-                    const Renderer::Text::FontDescriptor& descriptor = it->first;
-                    Renderer::Text::TexturedFont* font = fontManager.font(descriptor);
-                    const Vec2f::List& vertices = it->second;
-
-                    unsigned int vertexCount = static_cast<unsigned int>(vertices.size() / 2);
-                    Renderer::VertexArray vertexArray(*m_vbo, GL_QUADS, vertexCount,
-                                                      Renderer::Attribute::position2f(),
-                                                      Renderer::Attribute::texCoord02f(), 0);
-
-                    Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
-                    vertexArray.addAttributes(vertices);
+            if (stringVertexCount > 0) { // render strings
+                if (m_stringArray == NULL || m_stringArray->vertexCapacity() < stringVertexCount) {
+                    const size_t capacity = m_stringArray == NULL ? stringVertexCount : std::max(stringVertexCount, 2 * m_stringArray->vertexCapacity());
+                    delete m_stringArray;
+                    m_stringArray = new Renderer::VertexArray(*m_vbo, GL_QUADS, capacity,
+                                                              Renderer::Attribute::position2f(),
+                                                              Renderer::Attribute::texCoord02f(), 0);
+                }
 
-                    Renderer::SetVboState activateVbo(*m_vbo, Renderer::Vbo::VboActive);
-                    Renderer::ActivateShader shader(shaderManager, Renderer::Shaders::TextShader);
-                    shader.setUniformVariable("Color", prefs.getColor(Preferences::BrowserTextColor));
-                    shader.setUniformVariable("Texture", 0);
+                Renderer::SetVboState mapVbo(*m_vbo, Renderer::Vbo::VboMapped);
+                m_stringArray->reset();
+                for (stringIt = m_stringVertices.begin(), stringEnd = m_stringVertices.end(); stringIt != stringEnd; ++stringIt) {
+                    const Vec2f::List& vertices = stringIt->second;
+                    if (!vertices.empty())
+                        m_stringArray->addAttributes(vertices);
+                }
 
-                    font->activate();
-                    vertexArray.render();
-                    font->deactivate();
+                Renderer::SetVboState activateVbo(*m_vbo, Renderer::Vbo::VboActive);
+                Renderer::ActivateShader shader(shaderManager, Renderer::Shaders::TextShader);
+                shader.setUniformVariable("Color", prefs.getColor(Preferences::BrowserTextColor));
+                shader.setUniformVariable("Texture", 0);
+
+                size_t index = 0;
+                m_stringArray->setup();
+                for (stringIt = m_stringVertices.begin(), stringEnd = m_stringVertices.end(); stringIt != stringEnd; ++stringIt) {
+                    const size_t vertexCount = stringIt->second.size() / 2;
+                    if (vertexCount > 0) {
+                        Renderer::Text::TexturedFont* font = fontManager.font(stringIt->first);
+                        font->activate();
+                        m_stringArray->renderPrimitives(index, vertexCount);
+                        font->deactivate();
+                        index += vertexCount;
+                    }
                 }
+                m_stringArray->cleanup();
             }
         }
 
@@ -336,11 +374,23 @@ namespace TrenchBroom {
         m_group(false),
         m_hideUnused(false),
         m_sortOrder(Model::TextureSortOrder::Name),
-        m_vbo() {}
+        m_vbo(NULL),
+        m_titleCacheFontSize(0),
+        m_titleCacheCellWidth(0.0f),
+        m_titleCacheRevision(0),
+        m_borderArray(NULL),
+        m_groupTitleArray(NULL),
+        m_stringArray(NULL) {}
 
         TextureBrowserCanvas::~TextureBrowserCanvas() {
             clear();
             m_selectedTexture = NULL;
+            delete m_borderArray;
+            m_borderArray = NULL;
+            delete m_groupTitleArray;
+            m_groupTitleArray = NULL;
+            delete m_stringArray;
+            m_stringArray = NULL;
             delete m_vbo;
             m_vbo = NULL;
         }
@@ -21,8 +21,14 @@
 #define __TrenchBroom__TextureBrowserCanvas__
 
 #include "Model/TextureManager.h"
+#include "Utility/VecMath.h"
 #include "View/CellLayoutGLCanvas.h"
 
+#include <map>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
+
 namespace TrenchBroom {
     namespace Model {
         class Texture;
@@ -39,6 +45,7 @@ namespace TrenchBroom {
         class ShaderProgram;
         class TextureRenderer;
         class Vbo;
+        class VertexArray;
     }
     
     namespace Utility {
@@ -55,15 +62,31 @@ namespace TrenchBroom {
             Model::Texture* texture;
             Renderer::TextureRenderer* textureRenderer;
             Renderer::Text::FontDescriptor fontDescriptor;
+            Vec2f::List titleVertices; // glyph quads of the texture name at the origin
             
-            TextureCellData(Model::Texture* i_texture, Renderer::TextureRenderer* i_textureRenderer, const Renderer::Text::FontDescriptor& i_fontDescriptor) :
+            TextureCellData(Model::Texture* i_texture, Renderer::TextureRenderer* i_textureRenderer, const Renderer::Text::FontDescriptor& i_fontDescriptor, const Vec2f::List& i_titleVertices) :
             texture(i_texture),
             textureRenderer(i_textureRenderer),
-            fontDescriptor(i_fontDescriptor) {}
+            fontDescriptor(i_fontDescriptor),
+            titleVertices(i_titleVertices) {}
+        };
+        
+        class TextureTitle {
+        public:
+            Renderer::Text::FontDescriptor fontDescriptor;
+            float width;
+            Vec2f::List vertices;
+            
+            TextureTitle(const Renderer::Text::FontDescriptor& i_fontDescriptor, float i_width, const Vec2f::List& i_vertices) :
+            fontDescriptor(i_fontDescriptor),
+            width(i_width),
+            vertices(i_vertices) {}
         };
         
         class TextureBrowserCanvas : public CellLayoutGLCanvas<TextureCellData, TextureGroupData> {
         protected:
+            typedef std::map<Model::Texture*, TextureTitle> TextureTitleCache;
+            
             DocumentViewHolder& m_documentViewHolder;
             Model::Texture* m_selectedTexture;
             
@@ -71,8 +94,32 @@ namespace TrenchBroom {
             bool m_hideUnused;
             Model::TextureSortOrder::Type m_sortOrder;
             String m_filterText;
+            Model::TextureIndex::Search m_search;
             Renderer::Vbo* m_vbo;
             
+            /**
+             * The fitted font, width and glyph quads of each texture name, so that the layout can be reloaded when
+             * the filter changes without measuring the names again. Valid only for the font, cell width and index
+             * revision below.
+             */
+            TextureTitleCache m_titleCache;
+            String m_titleCacheFontName;
+            unsigned int m_titleCacheFontSize;
+            float m_titleCacheCellWidth;
+            unsigned int m_titleCacheRevision;
+            
+            typedef std::vector<const Layout::Group*> GroupList;
+            typedef std::vector<const Layout::Group::Row::Cell*> CellList;
+            typedef std::map<Renderer::Text::FontDescriptor, Vec2f::List> StringMap;
+            
+            GroupList m_visibleGroups;
+            CellList m_visibleCells;
+            StringMap m_stringVertices;
+            Renderer::VertexArray* m_borderArray;
+            Renderer::VertexArray* m_groupTitleArray;
+            Renderer::VertexArray* m_stringArray;
+            
+            void collectVisibleCells(Layout& layout, float y, float height);
             void addTextureToLayout(Layout& layout, Model::Texture* texture, const Renderer::Text::FontDescriptor& font);
             virtual void doInitLayout(Layout& layout);
             virtual void doReloadLayout(Layout& layout);
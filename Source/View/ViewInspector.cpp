@@ -54,6 +54,7 @@ namespace TrenchBroom {
         EVT_CHECKBOX(CommandIds::ViewInspector::FaceShadingCheckBoxId, ViewInspector::OnFaceShadingChanged)
         // EVT_CHECKBOX(CommandIds::ViewInspector::FogCheckBoxId, ViewInspector::OnFogChanged)
         EVT_CHOICE(CommandIds::ViewInspector::LinkDisplayModeChoiceId, ViewInspector::OnLinkDisplayModeSelected)
+        EVT_CHECKBOX(CommandIds::ViewInspector::ShowOccludedCellsCheckBoxId, ViewInspector::OnShowOccludedCellsChanged)
         END_EVENT_TABLE()
 
         void ViewInspector::updateControls() {
@@ -88,6 +89,7 @@ namespace TrenchBroom {
             m_toggleFaceShading->SetValue(viewOptions.shadeFaces());
 //            m_toggleFog->SetValue(viewOptions.useFog());
             m_linkDisplayModeChoice->SetSelection(viewOptions.linkDisplayMode());
+            m_toggleOccludedCells->SetValue(viewOptions.showOccludedCells());
         }
 
         wxWindow* ViewInspector::createFilterBox() {
@@ -151,6 +153,9 @@ namespace TrenchBroom {
             wxString linkDisplayModes[4] = {wxT("All"), wxT("Connected"), wxT("Selected"), wxT("None")};
             m_linkDisplayModeChoice = new wxChoice(renderModeBox, CommandIds::ViewInspector::LinkDisplayModeChoiceId, wxDefaultPosition, wxDefaultSize, 4, linkDisplayModes);
             
+            wxStaticText* toggleOccludedCellsLabel = new wxStaticText(renderModeBox, wxID_ANY, wxT(""));
+            m_toggleOccludedCells = new wxCheckBox(renderModeBox, CommandIds::ViewInspector::ShowOccludedCellsCheckBoxId, wxT("Show occluded cells"));
+            
             wxFlexGridSizer* innerSizer = new wxFlexGridSizer(2, 0, LayoutConstants::ControlHorizontalMargin);
             innerSizer->Add(faceRenderModeLabel);
             innerSizer->Add(m_faceRenderModeChoice);
@@ -160,6 +165,8 @@ namespace TrenchBroom {
             innerSizer->Add(m_toggleFaceShading, 0, wxTOP, LayoutConstants::CheckBoxVerticalMargin);
             innerSizer->Add(linkDisplayModeLabel, 0, wxTOP, LayoutConstants::ControlVerticalMargin);
             innerSizer->Add(m_linkDisplayModeChoice, 0, wxTOP, LayoutConstants::ControlVerticalMargin);
+            innerSizer->Add(toggleOccludedCellsLabel, 0, wxTOP, LayoutConstants::ControlVerticalMargin);
+            innerSizer->Add(m_toggleOccludedCells, 0, wxTOP, LayoutConstants::ControlVerticalMargin);
 
             // creates 5 pixel border inside the static box
             wxSizer* outerSizer = new wxBoxSizer(wxVERTICAL);
@@ -286,5 +293,14 @@ namespace TrenchBroom {
             ViewOptions::LinkDisplayMode mode = static_cast<ViewOptions::LinkDisplayMode>(event.GetSelection());
             editorView.viewOptions().setLinkDisplayMode(mode);
         }
+        
+        void ViewInspector::OnShowOccludedCellsChanged(wxCommandEvent& event) {
+            if (!m_documentViewHolder.valid())
+                return;
+            
+            EditorView& editorView = m_documentViewHolder.view();
+            editorView.viewOptions().setShowOccludedCells(event.GetInt() != 0);
+            editorView.OnUpdate(NULL); // will just trigger a refresh
+        }
     }
 }
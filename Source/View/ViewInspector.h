@@ -50,6 +50,7 @@ namespace TrenchBroom {
             wxCheckBox* m_toggleFaceShading;
             // wxCheckBox* m_toggleFog;
             wxChoice* m_linkDisplayModeChoice;
+            wxCheckBox* m_toggleOccludedCells;
             
             void updateControls();
             
@@ -64,6 +65,7 @@ namespace TrenchBroom {
             void OnFaceShadingChanged(wxCommandEvent& event);
             // void OnFogChanged(wxCommandEvent& event);
             void OnLinkDisplayModeSelected(wxCommandEvent& event);
+            void OnShowOccludedCellsChanged(wxCommandEvent& event);
             
             DECLARE_EVENT_TABLE();
         };
@@ -55,6 +55,7 @@ namespace TrenchBroom {
             bool m_shadeFaces;
             bool m_useFog;
             LinkDisplayMode m_linkDisplayMode;
+            bool m_showOccludedCells;
         public:
             ViewOptions() :
             m_filterPattern(""),
@@ -73,7 +74,8 @@ namespace TrenchBroom {
             m_renderSelection(true),
             m_shadeFaces(true),
             m_useFog(false),
-            m_linkDisplayMode(LinkDisplayLocal) {}
+            m_linkDisplayMode(LinkDisplayLocal),
+            m_showOccludedCells(false) {}
 
             inline const String& filterPattern() const {
                 return m_filterPattern;
@@ -210,6 +212,17 @@ namespace TrenchBroom {
             inline void setLinkDisplayMode(LinkDisplayMode linkDisplayMode) {
                 m_linkDisplayMode = linkDisplayMode;
             }
+            
+            /**
+             * Whether the bounds of the brush geometry cells which are skipped by occlusion culling are shown.
+             */
+            inline bool showOccludedCells() const {
+                return m_showOccludedCells;
+            }
+            
+            inline void setShowOccludedCells(bool showOccludedCells) {
+                m_showOccludedCells = showOccludedCells;
+            }
         };
     }
 }
@@ -0,0 +1,202 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TrenchBroom_HandleGridTest_h
+#define TrenchBroom_HandleGridTest_h
+
+#include "TestSuite.h"
+#include "Controller/HandleGrid.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace TrenchBroom {
+    namespace Controller {
+        class HandleGridTest : public TestSuite<HandleGridTest> {
+        private:
+            static const float CellSize;
+            static const float Radius;
+            static const float ScalingFactor;
+            static const float MaxDistance;
+            
+            // the distance from the ray at which a handle at the given distance along the ray is just touched
+            inline static float coneRadius(float distance) {
+                const float k = Radius * ScalingFactor;
+                return distance * k / std::sqrt(1.0f - k * k);
+            }
+            
+            inline static HandleGrid createGrid(const Vec3f::List& handles) {
+                HandleGrid grid(CellSize);
+                for (size_t i = 0; i < handles.size(); i++)
+                    grid.add(handles[i]);
+                return grid;
+            }
+            
+            // checks that the grid returns every handle hit by the ray and that it returns no handle twice
+            inline static void assertFindsHits(const HandleGrid& grid, const Vec3f::List& handles, const Rayf& ray) {
+                Vec3f::List result;
+                grid.findHandles(ray, Radius, ScalingFactor, MaxDistance, result);
+                
+                for (size_t i = 0; i < result.size(); i++)
+                    assert(std::count(result.begin(), result.end(), result[i]) == 1);
+                
+                for (size_t i = 0; i < handles.size(); i++) {
+                    const float distance = ray.intersectWithSphere(handles[i], Radius, ScalingFactor, MaxDistance);
+                    if (!Math<float>::isnan(distance))
+                        assert(std::find(result.begin(), result.end(), handles[i]) != result.end());
+                }
+            }
+            
+            inline static bool contains(const Vec3f::List& list, const Vec3f& position) {
+                return std::find(list.begin(), list.end(), position) != list.end();
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&HandleGridTest::testConeEdge);
+                registerTestCase(&HandleGridTest::testOutsideCone);
+                registerTestCase(&HandleGridTest::testCellBoundaries);
+                registerTestCase(&HandleGridTest::testDiagonalCellBoundaries);
+                registerTestCase(&HandleGridTest::testNegativeDirection);
+            }
+        public:
+            void testConeEdge() {
+                const Rayf ray(Vec3f(8.0f, 8.0f, 8.0f), Vec3f::PosX);
+                
+                // just inside the cone at increasing distances, so that the handles lie in cells far off the ray
+                Vec3f::List handles;
+                const float distances[] = { 32.0f, 200.0f, 1000.0f, 3000.0f };
+                for (size_t i = 0; i < 4; i++) {
+                    const float offset = 0.99f * coneRadius(distances[i]);
+                    handles.push_back(ray.origin + Vec3f(distances[i], offset, 0.0f));
+                    handles.push_back(ray.origin + Vec3f(distances[i], -offset, 0.0f));
+                    handles.push_back(ray.origin + Vec3f(distances[i], 0.0f, offset));
+                    handles.push_back(ray.origin + Vec3f(distances[i], 0.0f, -offset));
+                }
+                
+                for (size_t i = 0; i < handles.size(); i++)
+                    assert(!Math<float>::isnan(ray.intersectWithSphere(handles[i], Radius, ScalingFactor, MaxDistance)));
+                
+                const HandleGrid grid = createGrid(handles);
+                Vec3f::List result;
+                grid.findHandles(ray, Radius, ScalingFactor, MaxDistance, result);
+                assert(result.size() == handles.size());
+                for (size_t i = 0; i < handles.size(); i++)
+                    assert(contains(result, handles[i]));
+                
+                assertFindsHits(grid, handles, ray);
+            }
+            
+            void testOutsideCone() {
+                const Rayf ray(Vec3f(8.0f, 8.0f, 8.0f), Vec3f::PosX);
+                
+                // well outside of the cone and more than a cell away from any cell visited near that distance
+                const Vec3f inside = ray.origin + Vec3f(500.0f, 0.5f * coneRadius(500.0f), 0.0f);
+                const Vec3f outside = ray.origin + Vec3f(500.0f, 3.0f * coneRadius(500.0f) + 2.0f * CellSize, 0.0f);
+                const Vec3f behind = ray.origin - Vec3f(500.0f, 0.0f, 0.0f);
+                
+                Vec3f::List handles;
+                handles.push_back(inside);
+                handles.push_back(outside);
+                handles.push_back(behind);
+                
+                const HandleGrid grid = createGrid(handles);
+                Vec3f::List result;
+                grid.findHandles(ray, Radius, ScalingFactor, MaxDistance, result);
+                assert(contains(result, inside));
+                assert(!contains(result, outside));
+                assert(!contains(result, behind));
+            }
+            
+            void testCellBoundaries() {
+                // the ray starts on a cell corner and every step of the walk ends on a cell boundary
+                const Rayf ray(Vec3f(0.0f, 0.0f, 0.0f), Vec3f::PosX);
+                
+                Vec3f::List handles;
+                for (int i = -2; i <= 40; i++) {
+                    const float x = i * CellSize;
+                    handles.push_back(Vec3f(x, 0.0f, 0.0f));
+                    handles.push_back(Vec3f(x, CellSize, 0.0f));
+                    handles.push_back(Vec3f(x, -CellSize, -CellSize));
+                    if (x > 0.0f) {
+                        const float offset = 0.99f * coneRadius(x);
+                        handles.push_back(Vec3f(x, offset, 0.0f));
+                        handles.push_back(Vec3f(x, 0.0f, -offset));
+                    }
+                }
+                
+                const HandleGrid grid = createGrid(handles);
+                assertFindsHits(grid, handles, ray);
+                
+                // every handle on the ray is found exactly once, although it lies on the boundary between two steps
+                Vec3f::List result;
+                grid.findHandles(ray, Radius, ScalingFactor, MaxDistance, result);
+                for (int i = 0; i <= 40; i++) {
+                    const Vec3f position(i * CellSize, 0.0f, 0.0f);
+                    assert(std::count(result.begin(), result.end(), position) == 1);
+                }
+            }
+            
+            void testDiagonalCellBoundaries() {
+                // the ray passes through cell corners, so each step touches several new cells at once
+                const Rayf ray(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f).normalized());
+                
+                Vec3f::List handles;
+                for (int i = 0; i <= 24; i++) {
+                    for (int j = -1; j <= 1; j++) {
+                        const float c = i * CellSize;
+                        handles.push_back(Vec3f(c, c, c + j * CellSize));
+                        if (j != 0)
+                            handles.push_back(Vec3f(c + j * CellSize, c, c));
+                    }
+                }
+                
+                const HandleGrid grid = createGrid(handles);
+                assertFindsHits(grid, handles, ray);
+            }
+            
+            void testNegativeDirection() {
+                // negative coordinates must be rounded down to the cell below, not towards zero
+                const Rayf ray(Vec3f(-1.0f, 0.5f, -0.5f), Vec3f::NegX);
+                
+                Vec3f::List handles;
+                for (int i = 0; i <= 40; i++) {
+                    const float x = -1.0f - i * CellSize;
+                    handles.push_back(Vec3f(x, 0.5f, -0.5f));
+                    handles.push_back(Vec3f(x + 1.0f, -CellSize, 0.0f));
+                    if (i > 0) {
+                        const float offset = 0.99f * coneRadius(i * CellSize);
+                        handles.push_back(Vec3f(x, 0.5f + offset, -0.5f));
+                        handles.push_back(Vec3f(x, 0.5f, -0.5f - offset));
+                    }
+                }
+                
+                const HandleGrid grid = createGrid(handles);
+                assertFindsHits(grid, handles, ray);
+            }
+        };
+        
+        const float HandleGridTest::CellSize = 64.0f;
+        const float HandleGridTest::Radius = 6.0f;
+        const float HandleGridTest::ScalingFactor = 0.02f;
+        const float HandleGridTest::MaxDistance = 4096.0f;
+    }
+}
+
+#endif
@@ -0,0 +1,210 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TrenchBroom_SnapshotStoreTest_h
+#define TrenchBroom_SnapshotStoreTest_h
+
+#include "TestSuite.h"
+#include "Controller/SnapshotStore.h"
+#include "Model/EntityProperty.h"
+
+#include <cassert>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Controller {
+        class SnapshotStoreTest : public TestSuite<SnapshotStoreTest> {
+        private:
+            typedef std::vector<PropertyRecord::Ptr> Level;
+            
+            // an undo history whose levels hold property records, the oldest level can be dropped unless it is the last
+            class TestHistory : public SnapshotHistory {
+            public:
+                std::deque<Level> levels;
+                
+                bool canDropOldestLevel() const {
+                    return levels.size() > 1;
+                }
+                
+                void dropOldestLevel() {
+                    levels.pop_front();
+                }
+            };
+            
+            inline static Model::PropertyList entityProperties(const String& origin) {
+                Model::PropertyList properties;
+                properties.push_back(Model::Property("classname", "light"));
+                properties.push_back(Model::Property("origin", origin));
+                properties.push_back(Model::Property("light", "300"));
+                return properties;
+            }
+            
+            inline static String origin(size_t x) {
+                std::stringstream str;
+                str << x << " 0 0";
+                return str.str();
+            }
+            
+            inline static bool equals(const PropertyRecord& record, const Model::PropertyList& properties) {
+                Model::PropertyList restored;
+                record.materialize(restored);
+                if (restored.size() != properties.size())
+                    return false;
+                for (size_t i = 0; i < restored.size(); i++)
+                    if (restored[i].key() != properties[i].key() || restored[i].value() != properties[i].value())
+                        return false;
+                return true;
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&SnapshotStoreTest::testDeltaChains);
+                registerTestCase(&SnapshotStoreTest::testDeltaWithRemovedAndReorderedProperties);
+                registerTestCase(&SnapshotStoreTest::testSharedRecords);
+                registerTestCase(&SnapshotStoreTest::testEvictIndependentLevels);
+                registerTestCase(&SnapshotStoreTest::testEvictSharedLevels);
+            }
+        public:
+            void testDeltaChains() {
+                SnapshotStore store;
+                std::vector<PropertyRecord::Ptr> records;
+                
+                for (size_t i = 0; i < 40; i++) {
+                    const Model::PropertyList properties = entityProperties(origin(i));
+                    records.push_back(store.propertyRecord(1, properties));
+                    assert(equals(*records.back(), properties));
+                    assert(records.back()->chainLength() <= 17);
+                }
+                
+                assert(records[0]->chainLength() == 1);
+                assert(records[1]->chainLength() == 2);
+                assert(records[16]->chainLength() == 17);
+                assert(records[17]->chainLength() == 1);
+                assert(records[18]->chainLength() == 2);
+                
+                // every record still materializes correctly while its successors exist
+                for (size_t i = 0; i < records.size(); i++)
+                    assert(equals(*records[i], entityProperties(origin(i))));
+                
+                // a delta only stores the changed property, so it is smaller than a full record
+                assert(records[1]->memorySize() < records[0]->memorySize());
+                
+                assert(store.recordCount() == records.size());
+                records.clear();
+                assert(store.recordCount() == 0);
+                assert(store.memoryUsage() == 0);
+            }
+            
+            void testDeltaWithRemovedAndReorderedProperties() {
+                SnapshotStore store;
+                
+                Model::PropertyList properties = entityProperties(origin(0));
+                PropertyRecord::Ptr full = store.propertyRecord(1, properties);
+                
+                properties.erase(properties.begin() + 2);
+                properties.push_back(Model::Property("target", "t1"));
+                PropertyRecord::Ptr removed = store.propertyRecord(1, properties);
+                assert(removed->chainLength() == 2);
+                assert(equals(*removed, properties));
+                
+                std::swap(properties[0], properties[1]);
+                PropertyRecord::Ptr reordered = store.propertyRecord(1, properties);
+                assert(reordered->chainLength() == 1);
+                assert(equals(*reordered, properties));
+            }
+            
+            void testSharedRecords() {
+                SnapshotStore store;
+                const Model::PropertyList properties = entityProperties(origin(0));
+                
+                PropertyRecord::Ptr first = store.propertyRecord(1, properties);
+                PropertyRecord::Ptr second = store.propertyRecord(1, properties);
+                assert(first.get() == second.get());
+                assert(store.recordCount() == 1);
+                
+                // records are cached per entity
+                PropertyRecord::Ptr other = store.propertyRecord(2, properties);
+                assert(other.get() != first.get());
+                assert(store.recordCount() == 2);
+                
+                // a delta keeps its base alive, so releasing the base frees nothing
+                PropertyRecord::Ptr delta = store.propertyRecord(1, entityProperties(origin(1)));
+                const size_t memoryUsage = store.memoryUsage();
+                first.reset();
+                second.reset();
+                assert(store.memoryUsage() == memoryUsage);
+                assert(equals(*delta, entityProperties(origin(1))));
+                
+                delta.reset();
+                other.reset();
+                assert(store.recordCount() == 0);
+                assert(store.memoryUsage() == 0);
+            }
+            
+            void testEvictIndependentLevels() {
+                SnapshotStore store;
+                TestHistory history;
+                
+                // every level holds a record of a different entity
+                for (unsigned int i = 0; i < 8; i++)
+                    history.levels.push_back(Level(1, store.propertyRecord(i, entityProperties(origin(i)))));
+                
+                const size_t levelSize = store.memoryUsage() / 8;
+                assert(store.trimHistory(history, 3 * levelSize) == 5);
+                assert(history.levels.size() == 3);
+                assert(store.memoryUsage() <= 3 * levelSize);
+                
+                assert(store.trimHistory(history, 0) == 2);
+                assert(history.levels.size() == 1);
+                
+                history.levels.clear();
+                assert(store.memoryUsage() == 0);
+            }
+            
+            void testEvictSharedLevels() {
+                SnapshotStore store;
+                TestHistory history;
+                
+                // every level changes the same entity, so each record is a delta against the record of the previous level
+                for (size_t i = 0; i < 8; i++)
+                    history.levels.push_back(Level(1, store.propertyRecord(1, entityProperties(origin(i)))));
+                
+                // dropping the oldest level frees nothing because its record is the base of the next level's record
+                const size_t memoryUsage = store.memoryUsage();
+                assert(store.trimHistory(history, 0) == 1);
+                assert(history.levels.size() == 7);
+                assert(store.memoryUsage() == memoryUsage);
+                
+                // levels which hold a record of an unchanged entity share it with the newer levels
+                history.levels.clear();
+                for (size_t i = 0; i < 4; i++)
+                    history.levels.push_back(Level(1, store.propertyRecord(2, entityProperties(origin(0)))));
+                assert(store.recordCount() == 1);
+                assert(store.trimHistory(history, 0) == 1);
+                assert(history.levels.size() == 3);
+                assert(store.recordCount() == 1);
+                
+                history.levels.clear();
+                assert(store.memoryUsage() == 0);
+            }
+        };
+    }
+}
+
+#endif
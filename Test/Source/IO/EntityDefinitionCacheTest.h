@@ -0,0 +1,237 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TrenchBroom_EntityDefinitionCacheTest_h
+#define TrenchBroom_EntityDefinitionCacheTest_h
+
+#include "TestSuite.h"
+#include "IO/EntityDefinitionCache.h"
+#include "IO/FileManager.h"
+#include "Model/EntityDefinition.h"
+#include "Utility/List.h"
+#include "Utility/String.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include <utime.h>
+
+namespace TrenchBroom {
+    namespace IO {
+        class EntityDefinitionCacheTest : public TestSuite<EntityDefinitionCacheTest> {
+        private:
+            static const time_t ModificationTime = 1000000000;
+            
+            String m_rootPath;
+            String m_cachePath;
+            String m_definitionPath;
+            Color m_defaultColor;
+            Model::EntityDefinitionList m_definitions;
+            
+            static void writeFile(const String& path, const String& contents, time_t modificationTime) {
+                {
+                    std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                    stream << contents;
+                }
+                
+                struct utimbuf times;
+                times.actime = modificationTime;
+                times.modtime = modificationTime;
+                const int result = utime(path.c_str(), &times);
+                assert(result == 0);
+            }
+            
+            static void deleteDirectory(const String& path) {
+                FileManager fileManager;
+                const StringList names = fileManager.directoryContents(path);
+                for (size_t i = 0; i < names.size(); i++) {
+                    const String childPath = fileManager.appendPath(path, names[i]);
+                    if (fileManager.isDirectory(childPath))
+                        deleteDirectory(childPath);
+                    else
+                        fileManager.deleteFile(childPath);
+                }
+                fileManager.deleteFile(path);
+            }
+            
+            bool readCache(Model::EntityDefinitionList& definitions) {
+                FileManager fileManager;
+                MappedFile::Ptr file = fileManager.mapFile(m_definitionPath);
+                assert(file.get() != NULL);
+                
+                EntityDefinitionCache cache(m_definitionPath, *file, m_cachePath, m_defaultColor);
+                return cache.read(definitions);
+            }
+            
+            String writeCache() {
+                FileManager fileManager;
+                MappedFile::Ptr file = fileManager.mapFile(m_definitionPath);
+                assert(file.get() != NULL);
+                
+                EntityDefinitionCache cache(m_definitionPath, *file, m_cachePath, m_defaultColor);
+                const bool success = cache.write(m_definitions);
+                assert(success);
+                
+                // the cache lives in the cache directory, not next to the definition file
+                assert(cache.cachePath().compare(0, m_cachePath.size(), m_cachePath) == 0);
+                assert(fileManager.exists(cache.cachePath()));
+                assert(!fileManager.exists(fileManager.appendExtension(m_definitionPath, EntityDefinitionCacheLayout::Extension)));
+                return cache.cachePath();
+            }
+            
+            static String readFile(const String& path) {
+                std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+                StringStream contents;
+                contents << stream.rdbuf();
+                return contents.str();
+            }
+            
+            static void replaceFile(const String& path, const String& contents) {
+                std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                stream.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&EntityDefinitionCacheTest::testWriteAndRead);
+                registerTestCase(&EntityDefinitionCacheTest::testRejectChangedSize);
+                registerTestCase(&EntityDefinitionCacheTest::testRejectChangedModificationTime);
+                registerTestCase(&EntityDefinitionCacheTest::testRejectCorruptedCount);
+                registerTestCase(&EntityDefinitionCacheTest::testRejectTruncatedCache);
+            }
+            
+            void setup() {
+                char rootPath[] = "/tmp/TrenchBroom-EntityDefinitionCacheTest-XXXXXX";
+                const char* result = mkdtemp(rootPath);
+                assert(result != NULL);
+                
+                FileManager fileManager;
+                m_rootPath = rootPath;
+                m_cachePath = fileManager.appendPath(m_rootPath, "cache");
+                m_definitionPath = fileManager.appendPath(m_rootPath, "test.def");
+                m_defaultColor = Color(0.5f, 0.5f, 0.5f, 1.0f);
+                writeFile(m_definitionPath, "/*QUAKED light (0 1 0) (-8 -8 -8) (8 8 8) START_OFF\n*/\n", ModificationTime);
+                
+                Model::PropertyDefinition::List lightProperties;
+                lightProperties.push_back(Model::PropertyDefinition::Ptr(new Model::IntegerPropertyDefinition("light", "Brightness", 300)));
+                Model::ChoicePropertyDefinition* style = new Model::ChoicePropertyDefinition("style", "Style", 0);
+                style->addOption("0", "Normal");
+                style->addOption("1", "Flicker");
+                lightProperties.push_back(Model::PropertyDefinition::Ptr(style));
+                
+                Model::ModelDefinition::List lightModels;
+                lightModels.push_back(Model::ModelDefinition::Ptr(new Model::ModelDefinition("progs/flame.mdl", 0, 1, "spawnflags", 1)));
+                m_definitions.push_back(new Model::PointEntityDefinition("light", Color(0.0f, 1.0f, 0.0f, 1.0f), BBoxf(Vec3f(-8.0f, -8.0f, -8.0f), Vec3f(8.0f, 8.0f, 8.0f)), "A light", lightProperties, lightModels));
+                
+                Model::PropertyDefinition::List doorProperties;
+                doorProperties.push_back(Model::PropertyDefinition::Ptr(new Model::StringPropertyDefinition("message", "Message", "Locked")));
+                m_definitions.push_back(new Model::BrushEntityDefinition("func_door", Color(0.0f, 0.5f, 0.8f, 1.0f), "A door", doorProperties));
+            }
+            
+            void teardown() {
+                Utility::deleteAll(m_definitions);
+                deleteDirectory(m_rootPath);
+            }
+        public:
+            void testWriteAndRead() {
+                Model::EntityDefinitionList definitions;
+                assert(!readCache(definitions));
+                
+                writeCache();
+                assert(readCache(definitions));
+                assert(definitions.size() == 2);
+                
+                assert(definitions[0]->type() == Model::EntityDefinition::PointEntity);
+                const Model::PointEntityDefinition& light = static_cast<const Model::PointEntityDefinition&>(*definitions[0]);
+                assert(light.name() == "light");
+                assert(light.description() == "A light");
+                assert(light.color() == Color(0.0f, 1.0f, 0.0f, 1.0f));
+                assert(light.bounds() == BBoxf(Vec3f(-8.0f, -8.0f, -8.0f), Vec3f(8.0f, 8.0f, 8.0f)));
+                assert(light.modelDefinitions().size() == 1);
+                assert(light.modelDefinitions()[0]->name() == "progs/flame.mdl");
+                assert(light.modelDefinitions()[0]->frameIndex() == 1);
+                assert(light.propertyDefinitions().size() == 2);
+                const Model::IntegerPropertyDefinition* brightness = dynamic_cast<const Model::IntegerPropertyDefinition*>(light.propertyDefinitions()[0].get());
+                assert(brightness != NULL && brightness->defaultValue() == 300);
+                const Model::ChoicePropertyDefinition* style = dynamic_cast<const Model::ChoicePropertyDefinition*>(light.propertyDefinitions()[1].get());
+                assert(style != NULL && style->options().size() == 2);
+                assert(style->options()[1].value() == "1" && style->options()[1].description() == "Flicker");
+                
+                assert(definitions[1]->type() == Model::EntityDefinition::BrushEntity);
+                assert(definitions[1]->name() == "func_door");
+                const Model::StringPropertyDefinition* message = dynamic_cast<const Model::StringPropertyDefinition*>(definitions[1]->propertyDefinitions()[0].get());
+                assert(message != NULL && message->defaultPropertyValue() == "Locked");
+                
+                Utility::deleteAll(definitions);
+            }
+            
+            void testRejectChangedSize() {
+                writeCache();
+                
+                // the modification time is restored, only the size differs
+                writeFile(m_definitionPath, "/*QUAKED light (0 1 0) (-16 -16 -16) (16 16 16) START_OFF\n*/\n", ModificationTime);
+                Model::EntityDefinitionList definitions;
+                assert(!readCache(definitions));
+                assert(definitions.empty());
+            }
+            
+            void testRejectChangedModificationTime() {
+                writeCache();
+                
+                // same size, but a different modification time
+                writeFile(m_definitionPath, "/*QUAKED light (0 1 0) (-4 -4 -4) (4 4 4) START_OFF\n*/\n", ModificationTime + 60);
+                Model::EntityDefinitionList definitions;
+                assert(!readCache(definitions));
+                assert(definitions.empty());
+            }
+            
+            void testRejectCorruptedCount() {
+                const String cachePath = writeCache();
+                
+                // the definition count follows the magic, the version, the path, the size, the modification time and the color
+                const size_t countOffset = EntityDefinitionCacheLayout::HeaderMagicLength + sizeof(uint32_t) + sizeof(uint32_t) + m_definitionPath.size() + sizeof(uint32_t) + sizeof(int64_t) + 4 * sizeof(float);
+                String contents = readFile(cachePath);
+                assert(contents.size() > countOffset + sizeof(uint32_t));
+                const uint32_t expectedCount = 2;
+                assert(std::memcmp(contents.data() + countOffset, &expectedCount, sizeof(uint32_t)) == 0);
+                
+                const uint32_t corruptedCount = 0xFFFFFFFF;
+                contents.replace(countOffset, sizeof(uint32_t), reinterpret_cast<const char*>(&corruptedCount), sizeof(uint32_t));
+                replaceFile(cachePath, contents);
+                
+                Model::EntityDefinitionList definitions;
+                assert(!readCache(definitions));
+                assert(definitions.empty());
+            }
+            
+            void testRejectTruncatedCache() {
+                const String cachePath = writeCache();
+                
+                const String contents = readFile(cachePath);
+                replaceFile(cachePath, contents.substr(0, contents.size() / 2));
+                
+                Model::EntityDefinitionList definitions;
+                assert(!readCache(definitions));
+                assert(definitions.empty());
+            }
+        };
+    }
+}
+
+#endif
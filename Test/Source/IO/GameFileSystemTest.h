@@ -0,0 +1,203 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TrenchBroom_GameFileSystemTest_h
+#define TrenchBroom_GameFileSystemTest_h
+
+#include "TestSuite.h"
+#include "IO/FileManager.h"
+#include "IO/GameFileSystem.h"
+#include "IO/Pak.h"
+#include "Utility/String.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace IO {
+        class GameFileSystemTest : public TestSuite<GameFileSystemTest> {
+        private:
+            typedef std::pair<String, String> PakFile;
+            typedef std::vector<PakFile> PakFileList;
+            
+            String m_rootPath;
+            String m_basePath;
+            String m_modPath;
+            
+            static void writeInt(std::ofstream& stream, size_t value) {
+                for (size_t i = 0; i < 4; i++)
+                    stream.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+            
+            static void writeFile(const String& path, const String& contents) {
+                std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary);
+                stream << contents;
+            }
+            
+            static void writePak(const String& path, const PakFileList& files) {
+                std::ofstream stream(path.c_str(), std::ios::out | std::ios::binary);
+                
+                size_t directoryAddress = 12;
+                for (size_t i = 0; i < files.size(); i++)
+                    directoryAddress += files[i].second.size();
+                
+                stream << PakLayout::HeaderMagic;
+                writeInt(stream, directoryAddress);
+                writeInt(stream, files.size() * PakLayout::EntryLength);
+                for (size_t i = 0; i < files.size(); i++)
+                    stream << files[i].second;
+                
+                size_t address = 12;
+                for (size_t i = 0; i < files.size(); i++) {
+                    String name = files[i].first;
+                    name.resize(PakLayout::EntryNameLength, '\0');
+                    stream.write(name.data(), static_cast<std::streamsize>(name.size()));
+                    writeInt(stream, address);
+                    writeInt(stream, files[i].second.size());
+                    address += files[i].second.size();
+                }
+            }
+            
+            static void deleteDirectory(const String& path) {
+                FileManager fileManager;
+                const StringList names = fileManager.directoryContents(path);
+                for (size_t i = 0; i < names.size(); i++) {
+                    const String childPath = fileManager.appendPath(path, names[i]);
+                    if (fileManager.isDirectory(childPath))
+                        deleteDirectory(childPath);
+                    else
+                        fileManager.deleteFile(childPath);
+                }
+                fileManager.deleteFile(path);
+            }
+            
+            static String contents(const FileView& view) {
+                assert(view.valid());
+                return String(view.begin(), view.end());
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&GameFileSystemTest::testPrecedenceWithinSearchPath);
+                registerTestCase(&GameFileSystemTest::testPrecedenceBetweenSearchPaths);
+                registerTestCase(&GameFileSystemTest::testSwitchSearchPaths);
+            }
+            
+            void setup() {
+                char rootPath[] = "/tmp/TrenchBroom-GameFileSystemTest-XXXXXX";
+                assert(mkdtemp(rootPath) != NULL);
+                
+                FileManager fileManager;
+                m_rootPath = rootPath;
+                m_basePath = fileManager.appendPath(m_rootPath, "id1");
+                m_modPath = fileManager.appendPath(m_rootPath, "mod");
+                fileManager.makeDirectory(m_basePath);
+                fileManager.makeDirectory(fileManager.appendPath(m_basePath, "gfx"));
+                fileManager.makeDirectory(m_modPath);
+                fileManager.makeDirectory(fileManager.appendPath(m_modPath, "progs"));
+                
+                PakFileList pak0;
+                pak0.push_back(PakFile("progs/player.mdl", "pak0 player"));
+                pak0.push_back(PakFile("progs/armor.mdl", "pak0 armor"));
+                pak0.push_back(PakFile("gfx/palette.lmp", "pak0 palette"));
+                writePak(fileManager.appendPath(m_basePath, "pak0.pak"), pak0);
+                
+                PakFileList pak1;
+                pak1.push_back(PakFile("progs/player.mdl", "pak1 player"));
+                pak1.push_back(PakFile("maps/start.bsp", "pak1 start"));
+                writePak(fileManager.appendPath(m_basePath, "pak1.pak"), pak1);
+                
+                writeFile(fileManager.appendPath(m_basePath, "gfx/palette.lmp"), "loose palette");
+                writeFile(fileManager.appendPath(m_modPath, "progs/player.mdl"), "mod player");
+                
+                if (PakManager::sharedManager == NULL)
+                    PakManager::sharedManager = new PakManager();
+            }
+            
+            void teardown() {
+                deleteDirectory(m_rootPath);
+            }
+        public:
+            void testPrecedenceWithinSearchPath() {
+                GameFileSystem fileSystem;
+                StringList searchPaths;
+                searchPaths.push_back(m_basePath);
+                
+                // later paks override earlier paks, and loose files override all paks
+                assert(contents(fileSystem.findFile("progs/player.mdl", searchPaths)) == "pak1 player");
+                assert(contents(fileSystem.findFile("progs/armor.mdl", searchPaths)) == "pak0 armor");
+                assert(contents(fileSystem.findFile("maps/start.bsp", searchPaths)) == "pak1 start");
+                assert(contents(fileSystem.findFile("gfx/palette.lmp", searchPaths)) == "loose palette");
+                
+                // paths are case insensitive and may use backslashes and leading slashes
+                assert(contents(fileSystem.findFile("/GFX\\Palette.lmp", searchPaths)) == "loose palette");
+                
+                assert(!fileSystem.findFile("progs/missing.mdl", searchPaths).valid());
+            }
+            
+            void testPrecedenceBetweenSearchPaths() {
+                GameFileSystem fileSystem;
+                StringList searchPaths;
+                searchPaths.push_back(m_basePath);
+                searchPaths.push_back(m_modPath);
+                
+                // later search paths override the loose files and paks of earlier ones
+                assert(contents(fileSystem.findFile("progs/player.mdl", searchPaths)) == "mod player");
+                assert(contents(fileSystem.findFile("progs/armor.mdl", searchPaths)) == "pak0 armor");
+                assert(contents(fileSystem.findFile("gfx/palette.lmp", searchPaths)) == "loose palette");
+                
+                StringList reversedSearchPaths;
+                reversedSearchPaths.push_back(m_modPath);
+                reversedSearchPaths.push_back(m_basePath);
+                assert(contents(fileSystem.findFile("progs/player.mdl", reversedSearchPaths)) == "pak1 player");
+            }
+            
+            void testSwitchSearchPaths() {
+                GameFileSystem fileSystem;
+                
+                StringList baseSearchPaths;
+                baseSearchPaths.push_back(m_basePath);
+                
+                StringList modSearchPaths;
+                modSearchPaths.push_back(m_basePath);
+                modSearchPaths.push_back(m_modPath);
+                
+                const FileView palette = fileSystem.findFile("gfx/palette.lmp", baseSearchPaths);
+                assert(contents(fileSystem.findFile("progs/player.mdl", baseSearchPaths)) == "pak1 player");
+                assert(contents(fileSystem.findFile("progs/player.mdl", modSearchPaths)) == "mod player");
+                assert(contents(fileSystem.findFile("progs/player.mdl", baseSearchPaths)) == "pak1 player");
+                
+                // the shared search path is not rebuilt, so its loose files are not mapped again
+                assert(fileSystem.findFile("gfx/palette.lmp", modSearchPaths).begin() == palette.begin());
+                assert(fileSystem.findFile("gfx/palette.lmp", baseSearchPaths).begin() == palette.begin());
+                
+                // files which are added after the search path was indexed are found after invalidating
+                FileManager fileManager;
+                writeFile(fileManager.appendPath(m_modPath, "progs/armor.mdl"), "mod armor");
+                assert(contents(fileSystem.findFile("progs/armor.mdl", modSearchPaths)) == "pak0 armor");
+                fileSystem.invalidate();
+                assert(contents(fileSystem.findFile("progs/armor.mdl", modSearchPaths)) == "mod armor");
+            }
+        };
+    }
+}
+
+#endif
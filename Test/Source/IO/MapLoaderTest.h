@@ -0,0 +1,148 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TrenchBroom_MapLoaderTest_h
+#define TrenchBroom_MapLoaderTest_h
+
+#include "TestSuite.h"
+#include "IO/FileManager.h"
+#include "IO/MapLoader.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Entity.h"
+#include "Model/Face.h"
+#include "Model/Map.h"
+#include "Utility/Console.h"
+#include "Utility/List.h"
+#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+namespace TrenchBroom {
+    namespace IO {
+        class MapLoaderTest : public TestSuite<MapLoaderTest> {
+        private:
+            class Listener : public MapParserListener {
+            public:
+                Model::EntityList entities;
+                Model::BrushList brushes;
+                
+                ~Listener() {
+                    Utility::deleteAll(brushes);
+                    Utility::deleteAll(entities);
+                }
+                
+                void entityBegun(Model::Entity* entity) {
+                    entities.push_back(entity);
+                }
+                
+                void propertyParsed(const String& key, const String& value) {
+                    entities.back()->setProperty(key, value);
+                }
+                
+                void brushParsed(Model::Brush* brush) {
+                    brushes.push_back(brush);
+                }
+                
+                void entityEnded(size_t firstLine, size_t lineCount) {}
+            };
+            
+            String m_mapPath;
+            
+            void load(const Model::Map& map, Listener& listener) {
+                FileManager fileManager;
+                MappedFile::Ptr file = fileManager.mapFile(m_mapPath);
+                assert(file.get() != NULL);
+                
+                Utility::Console console;
+                MapLoader* loader = new MapLoader(file, map.worldBounds(), console);
+                loader->finish();
+                assert(loader->finished());
+                loader->deliver(listener);
+                delete loader;
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&MapLoaderTest::testRebuildGeometryAfterLoaderIsDeleted);
+            }
+            
+            void setup() {
+                char mapPath[] = "/tmp/TrenchBroom-MapLoaderTest-XXXXXX";
+                const int fd = mkstemp(mapPath);
+                assert(fd >= 0);
+                close(fd);
+                m_mapPath = mapPath;
+                
+                std::ofstream stream(m_mapPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                stream << "{\n"
+                << "\"classname\" \"worldspawn\"\n"
+                << "{\n"
+                << "( -64 -64 -16 ) ( -64 -63 -16 ) ( -64 -64 -15 ) none 0 0 0 1 1\n"
+                << "( -64 -64 -16 ) ( -64 -64 -15 ) ( -63 -64 -16 ) none 0 0 0 1 1\n"
+                << "( -64 -64 -16 ) ( -63 -64 -16 ) ( -64 -63 -16 ) none 0 0 0 1 1\n"
+                << "( 64 64 16 ) ( 64 65 16 ) ( 65 64 16 ) none 0 0 0 1 1\n"
+                << "( 64 64 16 ) ( 65 64 16 ) ( 64 64 17 ) none 0 0 0 1 1\n"
+                << "( 64 64 16 ) ( 64 64 17 ) ( 64 65 16 ) none 0 0 0 1 1\n"
+                << "}\n"
+                << "}\n"
+                << "{\n"
+                << "\"classname\" \"light\"\n"
+                << "\"origin\" \"0 0 32\"\n"
+                << "}\n";
+            }
+            
+            void teardown() {
+                std::remove(m_mapPath.c_str());
+            }
+        public:
+            void testRebuildGeometryAfterLoaderIsDeleted() {
+                Model::Map map(BBoxf(Vec3f(-8192.0f, -8192.0f, -8192.0f), Vec3f(8192.0f, 8192.0f, 8192.0f)), false);
+                Listener listener;
+                load(map, listener);
+                
+                assert(listener.entities.size() == 2);
+                assert(listener.brushes.size() == 1);
+                
+                // the loaded objects must refer to the bounds of the map, which outlives the loader
+                for (size_t i = 0; i < listener.entities.size(); i++)
+                    assert(&listener.entities[i]->worldBounds() == &map.worldBounds());
+                
+                Model::Brush& brush = *listener.brushes.front();
+                assert(&brush.worldBounds() == &map.worldBounds());
+                
+                brush.rebuildGeometry();
+                assert(brush.closed());
+                assert(brush.faces().size() == 6);
+                assert(brush.vertices().size() == 8);
+                
+                Model::Face* face = new Model::Face(brush.worldBounds(), false, Vec3f(0.0f, 64.0f, 16.0f), Vec3f(64.0f, 64.0f, -16.0f), Vec3f(64.0f, 0.0f, 16.0f), "none");
+                assert(brush.clip(*face));
+                assert(brush.closed());
+                assert(brush.faces().size() == 7);
+                assert(map.worldBounds().contains(brush.bounds()));
+            }
+        };
+    }
+}
+
+#endif
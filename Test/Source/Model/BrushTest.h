@@ -0,0 +1,161 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TrenchBroom_BrushTest_h
+#define TrenchBroom_BrushTest_h
+
+#include "TestSuite.h"
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Face.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Model {
+        class BrushTest : public TestSuite<BrushTest> {
+        private:
+            BBoxf m_worldBounds;
+            
+            // a cube with one corner cut off so that not all faces are axis aligned
+            Brush* createBrush(bool forceIntegerFacePoints) {
+                Brush* brush = new Brush(m_worldBounds, false, BBoxf(Vec3f(0.0f, 0.0f, 0.0f), Vec3f(64.0f, 64.0f, 64.0f)), NULL);
+                Face* face = new Face(m_worldBounds, false, Vec3f(64.0f, 64.0f, 16.5f), Vec3f(64.0f, 20.0f, 64.0f), Vec3f(10.25f, 64.0f, 64.0f), "");
+                brush->clip(*face);
+                if (forceIntegerFacePoints)
+                    brush->setForceIntegerFacePoints(true);
+                assert(brush->faces().size() == 7);
+                return brush;
+            }
+            
+            inline static Vec3f windingNormal(const VertexList& vertices) {
+                return crossed(vertices[1]->position - vertices[0]->position, vertices[2]->position - vertices[0]->position);
+            }
+            
+            // checks that the geometry of the given brush is what a full rebuild from its faces would produce
+            inline static void assertMatchesRebuild(const Brush& brush) {
+                const Brush rebuilt(brush.worldBounds(), brush.forceIntegerFacePoints(), brush);
+                
+                assert(rebuilt.faces().size() == brush.faces().size());
+                assert(rebuilt.vertices().size() == brush.vertices().size());
+                assert(rebuilt.edges().size() == brush.edges().size());
+                assert(rebuilt.bounds().min.equals(brush.bounds().min, Math<float>::PointStatusEpsilon));
+                assert(rebuilt.bounds().max.equals(brush.bounds().max, Math<float>::PointStatusEpsilon));
+                
+                const VertexList& vertices = brush.vertices();
+                const VertexList& rebuiltVertices = rebuilt.vertices();
+                for (size_t i = 0; i < vertices.size(); i++) {
+                    bool found = false;
+                    for (size_t j = 0; j < rebuiltVertices.size() && !found; j++)
+                        found = rebuiltVertices[j]->position.equals(vertices[i]->position, Math<float>::PointStatusEpsilon);
+                    assert(found);
+                }
+                
+                // every side must lie in the plane of its face and be wound like the rebuilt side
+                for (size_t i = 0; i < brush.faces().size(); i++) {
+                    const Face& face = *brush.faces()[i];
+                    const Face& rebuiltFace = *rebuilt.faces()[i];
+                    assert(face.vertices().size() == rebuiltFace.vertices().size());
+                    for (size_t j = 0; j < face.vertices().size(); j++)
+                        assert(face.boundary().pointStatus(face.vertices()[j]->position) == PointStatus::PSInside);
+                    assert(windingNormal(face.vertices()).dot(windingNormal(rebuiltFace.vertices())) > 0.0f);
+                }
+            }
+            
+            inline static Mat4f quarterTurn(const Vec3f& axis, const Vec3f& center, Mat4f& vectorTransform) {
+                vectorTransform = rotationMatrix(Math<float>::PiOverTwo, axis);
+                vectorTransform.correct();
+                return translationMatrix(center) * vectorTransform * translationMatrix(-center);
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&BrushTest::testTranslate);
+                registerTestCase(&BrushTest::testQuarterTurn);
+                registerTestCase(&BrushTest::testMirror);
+                registerTestCase(&BrushTest::testArbitraryRotation);
+                registerTestCase(&BrushTest::testForceIntegerFacePoints);
+            }
+        public:
+            BrushTest() :
+            m_worldBounds(Vec3f(-4096.0f, -4096.0f, -4096.0f), Vec3f(4096.0f, 4096.0f, 4096.0f)) {}
+            
+            void testTranslate() {
+                Brush* brush = createBrush(false);
+                brush->transform(translationMatrix(Vec3f(16.0f, -32.0f, 8.0f)), Mat4f::Identity, false, false);
+                assertMatchesRebuild(*brush);
+                brush->transform(translationMatrix(Vec3f(0.25f, 0.5f, -3.0f)), Mat4f::Identity, false, false);
+                assertMatchesRebuild(*brush);
+                delete brush;
+            }
+            
+            void testQuarterTurn() {
+                Brush* brush = createBrush(false);
+                Mat4f vectorTransform;
+                const Mat4f pointTransform = quarterTurn(Vec3f::PosZ, Vec3f(8.0f, 24.0f, 0.0f), vectorTransform);
+                brush->transform(pointTransform, vectorTransform, false, false);
+                assertMatchesRebuild(*brush);
+                
+                const Mat4f pointTransform2 = quarterTurn(Vec3f::PosX, Vec3f(0.0f, 32.0f, 32.0f), vectorTransform);
+                brush->transform(pointTransform2, vectorTransform, false, false);
+                assertMatchesRebuild(*brush);
+                delete brush;
+            }
+            
+            void testMirror() {
+                Brush* brush = createBrush(false);
+                const Vec3f center(40.0f, 0.0f, 0.0f);
+                brush->transform(translationMatrix(center) * Mat4f::MirX * translationMatrix(-center), Mat4f::MirX, false, true);
+                assertMatchesRebuild(*brush);
+                delete brush;
+            }
+            
+            void testArbitraryRotation() {
+                Brush* brush = createBrush(false);
+                const Vec3f center(32.0f, 32.0f, 32.0f);
+                const Mat4f vectorTransform = rotationMatrix(Math<float>::radians(30.0f), Vec3f::PosZ) * rotationMatrix(Math<float>::radians(20.0f), Vec3f::PosX);
+                brush->transform(translationMatrix(center) * vectorTransform * translationMatrix(-center), vectorTransform, false, false);
+                assertMatchesRebuild(*brush);
+                delete brush;
+            }
+            
+            void testForceIntegerFacePoints() {
+                // the faces find new integer points after every transformation, which may move their planes
+                Brush* brush = createBrush(true);
+                brush->transform(translationMatrix(Vec3f(16.0f, -32.0f, 8.0f)), Mat4f::Identity, false, false);
+                assertMatchesRebuild(*brush);
+                
+                Mat4f vectorTransform;
+                const Mat4f pointTransform = quarterTurn(Vec3f::PosZ, Vec3f(3.0f, 5.0f, 0.0f), vectorTransform);
+                brush->transform(pointTransform, vectorTransform, false, false);
+                assertMatchesRebuild(*brush);
+                
+                const Mat4f pointTransform2 = quarterTurn(Vec3f::PosY, Vec3f(0.5f, 0.0f, 0.5f), vectorTransform);
+                brush->transform(pointTransform2, vectorTransform, false, false);
+                assertMatchesRebuild(*brush);
+                
+                const Mat4f rotation = rotationMatrix(Math<float>::radians(45.0f), Vec3f::PosZ);
+                brush->transform(rotation, rotation, false, false);
+                assertMatchesRebuild(*brush);
+                delete brush;
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+
+ This file is part of TrenchBroom.
+
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_OcclusionBufferTest_h
+#define TrenchBroom_OcclusionBufferTest_h
+
+#include "TestSuite.h"
+#include "Renderer/OcclusionBuffer.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class OcclusionBufferTest : public TestSuite<OcclusionBufferTest> {
+        private:
+            OcclusionBuffer m_buffer;
+            
+            // a camera at the origin which looks along the positive X axis
+            inline static Mat4f cameraMatrix() {
+                return perspectiveMatrix(90.0f, 1.0f, 8192.0f, static_cast<int>(OcclusionBuffer::Width), static_cast<int>(OcclusionBuffer::Height)) *
+                       viewMatrix(Vec3f::PosX, Vec3f::PosZ);
+            }
+            
+            inline static Vec3f::List quad(const Vec3f& v0, const Vec3f& v1, const Vec3f& v2, const Vec3f& v3) {
+                Vec3f::List vertices;
+                vertices.push_back(v0);
+                vertices.push_back(v1);
+                vertices.push_back(v2);
+                vertices.push_back(v3);
+                return vertices;
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&OcclusionBufferTest::testEmptyBuffer);
+                registerTestCase(&OcclusionBufferTest::testWall);
+                registerTestCase(&OcclusionBufferTest::testPartiallyCoveredBounds);
+                registerTestCase(&OcclusionBufferTest::testOccluderCrossingNearPlane);
+                registerTestCase(&OcclusionBufferTest::testSubPixelGapBetweenOccluders);
+            }
+            
+            void setup() {
+                m_buffer.reset(cameraMatrix());
+            }
+        public:
+            void testEmptyBuffer() {
+                m_buffer.rasterize();
+                
+                assert(m_buffer.visible(BBoxf(Vec3f(512.0f, 0.0f, 0.0f), 16.0f)));
+                assert(!m_buffer.visible(BBoxf(Vec3f(512.0f, 4096.0f, 0.0f), 16.0f)));
+                assert(m_buffer.visible(BBoxf(Vec3f(-512.0f, 0.0f, 0.0f), 16.0f)));
+            }
+            
+            void testWall() {
+                m_buffer.addOccluder(quad(Vec3f(256.0f, -1024.0f, -1024.0f),
+                                          Vec3f(256.0f, -1024.0f,  1024.0f),
+                                          Vec3f(256.0f,  1024.0f,  1024.0f),
+                                          Vec3f(256.0f,  1024.0f, -1024.0f)));
+                m_buffer.rasterize();
+                
+                assert(!m_buffer.visible(BBoxf(Vec3f(512.0f, 0.0f, 0.0f), 16.0f)));
+                assert(!m_buffer.visible(BBoxf(Vec3f(512.0f, 256.0f, 128.0f), 64.0f)));
+                assert(m_buffer.visible(BBoxf(Vec3f(128.0f, 0.0f, 0.0f), 16.0f)));
+                assert(m_buffer.visible(BBoxf(Vec3f(256.0f, 0.0f, 0.0f), 16.0f)));
+            }
+            
+            void testPartiallyCoveredBounds() {
+                m_buffer.addOccluder(quad(Vec3f(256.0f, -1024.0f, -1024.0f),
+                                          Vec3f(256.0f, -1024.0f,  1024.0f),
+                                          Vec3f(256.0f,     0.0f,  1024.0f),
+                                          Vec3f(256.0f,     0.0f, -1024.0f)));
+                m_buffer.rasterize();
+                
+                assert(!m_buffer.visible(BBoxf(Vec3f(512.0f, -256.0f, 0.0f), 16.0f)));
+                assert(m_buffer.visible(BBoxf(Vec3f(512.0f, 0.0f, 0.0f), 16.0f)));
+                assert(m_buffer.visible(BBoxf(Vec3f(512.0f, 256.0f, 0.0f), 16.0f)));
+            }
+            
+            void testOccluderCrossingNearPlane() {
+                // a floor which extends behind the camera
+                m_buffer.addOccluder(quad(Vec3f(-1024.0f, -1024.0f, -64.0f),
+                                          Vec3f(-1024.0f,  1024.0f, -64.0f),
+                                          Vec3f( 1024.0f,  1024.0f, -64.0f),
+                                          Vec3f( 1024.0f, -1024.0f, -64.0f)));
+                m_buffer.rasterize();
+                
+                assert(!m_buffer.visible(BBoxf(Vec3f(256.0f, 0.0f, -128.0f), 16.0f)));
+                assert(m_buffer.visible(BBoxf(Vec3f(256.0f, 0.0f, 0.0f), 16.0f)));
+            }
+            
+            void testSubPixelGapBetweenOccluders() {
+                // two walls with a gap of a third of a pixel between them
+                m_buffer.addOccluder(quad(Vec3f(256.0f, -1024.0f, -1024.0f),
+                                          Vec3f(256.0f, -1024.0f,  1024.0f),
+                                          Vec3f(256.0f,    -0.5f,  1024.0f),
+                                          Vec3f(256.0f,    -0.5f, -1024.0f)));
+                m_buffer.addOccluder(quad(Vec3f(256.0f,     0.5f, -1024.0f),
+                                          Vec3f(256.0f,     0.5f,  1024.0f),
+                                          Vec3f(256.0f,  1024.0f,  1024.0f),
+                                          Vec3f(256.0f,  1024.0f, -1024.0f)));
+                m_buffer.rasterize();
+                
+                assert(m_buffer.visible(BBoxf(Vec3f(512.0f, 0.0f, 0.0f), 16.0f)));
+                assert(!m_buffer.visible(BBoxf(Vec3f(512.0f, -256.0f, 0.0f), 16.0f)));
+                assert(!m_buffer.visible(BBoxf(Vec3f(512.0f, 256.0f, 0.0f), 16.0f)));
+            }
+        };
+    }
+}
+
+#endif
@@ -56,6 +56,7 @@ namespace TrenchBroom {
                 registerTestCase(&MatTest::testDeterminant2);
                 registerTestCase(&MatTest::testAdjoin);
                 registerTestCase(&MatTest::testAdjoint);
+                registerTestCase(&MatTest::testAxisPermutationMatrix);
             }
         public:
             void testInvert() {
@@ -388,6 +389,18 @@ namespace TrenchBroom {
                                -272.0f,  -72.0f,  104.0f,  192.0f);
                 assert(adjointMatrix(m1) == m2);
             }
+            
+            void testAxisPermutationMatrix() {
+                const Vec3f center(8.0f, 16.0f, 32.0f);
+                assert(axisPermutationMatrix(Mat4f::Identity));
+                assert(axisPermutationMatrix(translationMatrix(Vec3f(16.0f, -8.0f, 3.5f))));
+                assert(axisPermutationMatrix(Mat4f::MirX));
+                assert(axisPermutationMatrix(translationMatrix(center) * Mat4f::MirY * translationMatrix(-center)));
+                assert(axisPermutationMatrix(rotationMatrix(Math<float>::PiOverTwo, Vec3f::PosZ)));
+                assert(axisPermutationMatrix(rotationMatrix(Math<float>::Pi, Vec3f::PosX)));
+                assert(!axisPermutationMatrix(rotationMatrix(Math<float>::Pi / 4.0f, Vec3f::PosZ)));
+                assert(!axisPermutationMatrix(scalingMatrix(2.0f)));
+            }
         };
     }
 }
@@ -20,6 +20,13 @@
 #include <iostream>
 
 #include "TestSuite.h"
+#include "Controller/HandleGridTest.h"
+#include "Controller/SnapshotStoreTest.h"
+#include "IO/EntityDefinitionCacheTest.h"
+#include "IO/GameFileSystemTest.h"
+#include "IO/MapLoaderTest.h"
+#include "Model/BrushTest.h"
+#include "Renderer/OcclusionBufferTest.h"
 #include "Utility/FindIntegerPlanePointsTest.h"
 #include "Utility/MatTest.h"
 #include "Utility/PlaneTest.h"
@@ -37,6 +44,27 @@ int main(int argc, const char * argv[]) {
     VecMath::PlaneTest planeTest;
     planeTest.run();
     
+    Model::BrushTest brushTest;
+    brushTest.run();
+    
+    Renderer::OcclusionBufferTest occlusionBufferTest;
+    occlusionBufferTest.run();
+    
+    Controller::HandleGridTest handleGridTest;
+    handleGridTest.run();
+    
+    Controller::SnapshotStoreTest snapshotStoreTest;
+    snapshotStoreTest.run();
+    
+    IO::GameFileSystemTest gameFileSystemTest;
+    gameFileSystemTest.run();
+    
+    IO::EntityDefinitionCacheTest entityDefinitionCacheTest;
+    entityDefinitionCacheTest.run();
+    
+    IO::MapLoaderTest mapLoaderTest;
+    mapLoaderTest.run();
+    
     /*
     VecMath::FindIntegerPlanePointsTest planePointsTest;
     planePointsTest.run();
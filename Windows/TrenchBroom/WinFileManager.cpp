@@ -20,6 +20,7 @@
 #include "WinFileManager.h"
 
 #include <Windows.h>
+#include <Shlobj.h>
 #include <fstream>
 
 namespace TrenchBroom {
@@ -67,6 +68,18 @@ namespace TrenchBroom {
 			return appendPath(appDirectory(), "Resources");
 		}
 
+		String WinFileManager::cacheDirectory() {
+			TCHAR uLocalAppDataPathC[MAX_PATH] = L"";
+			if (FAILED(SHGetFolderPath(NULL, CSIDL_LOCAL_APPDATA, NULL, 0, uLocalAppDataPathC)))
+				return "";
+
+			char localAppDataPathC[MAX_PATH];
+			WideCharToMultiByte(CP_ACP, 0, uLocalAppDataPathC, -1, localAppDataPathC, MAX_PATH, NULL, NULL);
+
+			String localAppDataPath(localAppDataPathC);
+			return appendPath(appendPath(localAppDataPath, "TrenchBroom"), "Cache");
+		}
+
 		String WinFileManager::resolveFontPath(const String& fontName) {
 			TCHAR uWindowsPathC[MAX_PATH] = L"";
 			DWORD numChars = GetWindowsDirectory(uWindowsPathC, MAX_PATH - 1);